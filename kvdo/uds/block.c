@@ -50,8 +50,14 @@ int udsFlushBlockContext(UdsBlockContext context)
   return flushContext(context.id);
 }
 
-/**********************************************************************/
-int udsStartChunkOperation(UdsRequest *request)
+/**
+ * Check that a chunk operation is valid, and prepare it to be started.
+ *
+ * @param request  The operation
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+static int prepareChunkOperation(UdsRequest *request)
 {
   if (request->callback == NULL) {
     return UDS_CALLBACK_REQUIRED;
@@ -67,9 +73,34 @@ int udsStartChunkOperation(UdsRequest *request)
   }
   request->found = false;
   memset(request->private, 0, sizeof(request->private));
+  return UDS_SUCCESS;
+}
+
+/**********************************************************************/
+int udsStartChunkOperation(UdsRequest *request)
+{
+  int result = prepareChunkOperation(request);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
   return launchAllocatedClientRequest((Request *) request);
 }
 
+/**********************************************************************/
+int udsStartChunkOperations(UdsRequest **requests, unsigned int count)
+{
+  if (count > UDS_MAX_CHUNK_OPERATIONS) {
+    return UDS_REQUESTS_OUT_OF_RANGE;
+  }
+  for (unsigned int i = 0; i < count; i++) {
+    int result = prepareChunkOperation(requests[i]);
+    if (result != UDS_SUCCESS) {
+      return result;
+    }
+  }
+  return launchAllocatedClientRequests((Request **) requests, count);
+}
+
 /**********************************************************************/
 int udsGetBlockContextIndexStats(UdsBlockContext  context,
                                  UdsIndexStats   *stats)
@@ -126,6 +126,23 @@ static int bior_close(IORegion *region)
   return UDS_SUCCESS;
 }
 
+/*****************************************************************************/
+static int bior_getFileLocation(IORegion *region,
+                                off_t     offset,
+                                int      *fd,
+                                off_t    *fileOffset)
+{
+  BlockIORegion *bior = asBlockIORegion(region);
+
+  if ((offset < 0) || (offset > bior->end - bior->start)) {
+    return logErrorWithStringError(UDS_OUT_OF_RANGE,
+                                   "offset %zd exceeds limit of %zd",
+                                   offset, bior->end - bior->start);
+  }
+  return getRegionFileLocation(bior->parent, bior->start + offset, fd,
+                               fileOffset);
+}
+
 /*****************************************************************************/
 static int bior_getLimit(IORegion *region,
                          off_t    *limit)
@@ -315,15 +332,16 @@ int openBlockRegion(IORegion       *parent,
   if (result != UDS_SUCCESS) {
     return result;
   }
-  bior->common.clear        = bior_clear;
-  bior->common.close        = bior_close;
-  bior->common.getBestSize  = bior_getBestSize;
-  bior->common.getBlockSize = bior_getBlockSize;
-  bior->common.getDataSize  = bior_getDataSize;
-  bior->common.getLimit     = bior_getLimit;
-  bior->common.read         = bior_read;
-  bior->common.syncContents = bior_syncContents;
-  bior->common.write        = bior_write;
+  bior->common.clear           = bior_clear;
+  bior->common.close           = bior_close;
+  bior->common.getBestSize     = bior_getBestSize;
+  bior->common.getBlockSize    = bior_getBlockSize;
+  bior->common.getDataSize     = bior_getDataSize;
+  bior->common.getFileLocation = bior_getFileLocation;
+  bior->common.getLimit        = bior_getLimit;
+  bior->common.read            = bior_read;
+  bior->common.syncContents    = bior_syncContents;
+  bior->common.write           = bior_write;
   bior->parent    = parent;
   bior->access    = access;
   bior->blockSize = blockSize;
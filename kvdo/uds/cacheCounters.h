@@ -79,6 +79,13 @@ typedef struct cacheCounters {
   uint64_t              evictions;
   /** Number of cache entry invalidations due to chapter expiration */
   uint64_t              expirations;
+  /** Number of cache entries chosen for reuse by the replacement policy */
+  uint64_t              victims;
+  /** Number of cache entries examined while choosing them */
+  uint64_t              victimProbes;
+  /** Number of pages protected because they were read again soon after
+   *  being evicted */
+  uint64_t              promotions;
 
   // counters for the sparse chapter index cache
   /** Hit/miss counts for the sparse cache chapter probes */
@@ -107,6 +114,17 @@ typedef enum cacheResultKind {
  **/
 void addCacheCounters(CacheCounters *stats, const CacheCounters *addend);
 
+/**
+ * Compute the hit rate of page cache probes, counting probes for pages
+ * already queued for read as misses.
+ *
+ * @param counters  the cache counters
+ *
+ * @return the hit rate in tenths of a percent
+ **/
+unsigned int getPageCacheHitRate(const CacheCounters *counters)
+  __attribute__((warn_unused_result));
+
 /**
  * Increment one of the cache counters.
  *
@@ -55,6 +55,8 @@ struct udsConfiguration {
   unsigned int sparseSampleRate;
   /** Index Owner's nonce */
   UdsNonce     nonce;
+  /** The hash function the chunk names are computed with */
+  UdsChunkNameHash chunkNameHash;
 };
 
 /**
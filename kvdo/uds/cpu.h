@@ -23,6 +23,7 @@
 #define CPU_H
 
 #include "compiler.h"
+#include "cpuDefs.h"
 #include "typeDefs.h"
 
 /**
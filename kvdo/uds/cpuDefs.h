@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/uds-releases/gloria/kernelLinux/uds/cpuDefs.h#1 $
+ */
+
+#ifndef LINUX_KERNEL_CPU_DEFS_H
+#define LINUX_KERNEL_CPU_DEFS_H 1
+
+#ifdef __x86_64__
+#include <asm/cpufeature.h>
+#endif
+
+#include "compiler.h"
+#include "typeDefs.h"
+
+/**
+ * Whether code may be compiled for the BMI1 and BMI2 bit manipulation
+ * extensions with __attribute__((target)), to be selected at run time by
+ * cpuHasBitManipulation(). These instructions only use the general purpose
+ * registers, so no kernel_fpu_begin() is needed around them.
+ **/
+#if defined(__x86_64__) && defined(X86_FEATURE_BMI2)   \
+  && (defined(__clang__) || (__GNUC__ > 4)              \
+      || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#define HAVE_BIT_MANIPULATION_TARGET 1
+#else
+#define HAVE_BIT_MANIPULATION_TARGET 0
+#endif
+
+/**
+ * Check whether the CPU has the BMI1 and BMI2 bit manipulation extensions.
+ *
+ * @return true if code compiled for the extensions may be run
+ **/
+static INLINE bool cpuHasBitManipulation(void)
+{
+#if HAVE_BIT_MANIPULATION_TARGET
+  return boot_cpu_has(X86_FEATURE_BMI1) && boot_cpu_has(X86_FEATURE_BMI2);
+#else
+  return false;
+#endif
+}
+
+#endif /* LINUX_KERNEL_CPU_DEFS_H */
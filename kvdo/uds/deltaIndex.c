@@ -29,6 +29,7 @@
 #include "memoryAlloc.h"
 #include "permassert.h"
 #include "stringUtils.h"
+#include "threadOnce.h"
 #include "typeDefs.h"
 #include "uds.h"
 #include "zone.h"
@@ -540,6 +541,173 @@ static void setDelta(DeltaIndexEntry *deltaEntry, unsigned int delta)
   deltaEntry->entryBits = deltaEntry->valueBits + keyBits;
 }
 
+/**
+ * The largest number of value and minimal key code bits for which
+ * skipDeltaEntries() will decode entries.
+ **/
+enum { MAX_SKIP_HEADER_BITS = 48 };
+
+/**
+ * Decode the entries of a delta list which follow a delta index entry, for
+ * as long as their keys are less than a search key. This has the same
+ * effect as calling nextDeltaIndexEntry() until reaching the key, but keeps
+ * a 64 bit window of the list in a register, so several short entries are
+ * decoded from each fetch, and finds the end of each key code by counting
+ * trailing zeros in the window.
+ *
+ * Anything out of the ordinary (the end of the list, an entry which runs
+ * past it, or a key code longer than the window) is left to
+ * nextDeltaIndexEntry(), so that it is handled and reported exactly as it
+ * always has been.
+ *
+ * @param deltaEntry  The delta index entry, which is updated to describe
+ *                    either the first entry with a key not less than the
+ *                    search key or the last entry decoded before stopping
+ * @param key         The key being searched for
+ *
+ * @return true if the first entry with a key not less than the search key
+ *         was found
+ **/
+static INLINE bool skipDeltaEntries(DeltaIndexEntry *deltaEntry,
+                                    unsigned int     key)
+{
+  const DeltaMemory *deltaZone = deltaEntry->deltaZone;
+  const byte *memory = deltaZone->memory;
+  uint64_t listStart = getDeltaListStart(deltaEntry->deltaList);
+  unsigned int size = getDeltaListSize(deltaEntry->deltaList);
+  unsigned int headerBits = deltaEntry->valueBits + deltaZone->minBits;
+  unsigned int minKeyMask = (1 << deltaZone->minBits) - 1;
+  // A freshly fetched window has at least 57 bits, which must hold the
+  // value, the minimal key code, and the start of any longer key code.
+  if (headerBits > MAX_SKIP_HEADER_BITS) {
+    return false;
+  }
+
+  // The entry described by deltaEntry, before any have been decoded here.
+  unsigned int entryKey     = deltaEntry->key;
+  unsigned int entryDelta   = deltaEntry->delta;
+  unsigned int entryBits    = deltaEntry->entryBits;
+  bool         isCollision  = deltaEntry->isCollision;
+  uint32_t     offset       = deltaEntry->offset + entryBits;
+  uint64_t     window       = 0;
+  unsigned int windowBits   = 0;
+  bool         found        = false;
+  while (offset < size) {
+    if (windowBits < headerBits) {
+      uint64_t position = listStart + offset;
+      window = (getUInt64LE(memory + position / CHAR_BIT)
+                >> (position % CHAR_BIT));
+      windowBits = sizeof(uint64_t) * CHAR_BIT - position % CHAR_BIT;
+    }
+    unsigned int delta = (window >> deltaEntry->valueBits) & minKeyMask;
+    unsigned int keyBits = deltaZone->minBits;
+    if (delta >= deltaZone->minKeys) {
+      uint64_t code = window >> headerBits;
+      if (code == 0) {
+        // The key code runs past the window, so refetch from this entry.
+        uint64_t position = listStart + offset;
+        window = (getUInt64LE(memory + position / CHAR_BIT)
+                  >> (position % CHAR_BIT));
+        windowBits = sizeof(uint64_t) * CHAR_BIT - position % CHAR_BIT;
+        code = window >> headerBits;
+        if (code == 0) {
+          break;
+        }
+      }
+      unsigned int zeros = __builtin_ctzll(code);
+      keyBits += zeros + 1;
+      delta += zeros * deltaZone->incrKeys;
+    }
+
+    unsigned int bits = deltaEntry->valueBits + keyBits;
+    bool collision = (delta == 0) && (offset > 0);
+    if (unlikely(collision)) {
+      bits += COLLISION_BITS;
+    }
+    if (offset + bits > size) {
+      break;
+    }
+
+    entryKey    += delta;
+    entryDelta   = delta;
+    entryBits    = bits;
+    isCollision  = collision;
+    if (key <= entryKey) {
+      found = true;
+      break;
+    }
+
+    offset += bits;
+    if (bits < windowBits) {
+      window >>= bits;
+      windowBits -= bits;
+    } else {
+      windowBits = 0;
+    }
+  }
+
+  if (!found) {
+    // Back up to the last entry which was decoded.
+    offset -= entryBits;
+  }
+  deltaEntry->key         = entryKey;
+  deltaEntry->delta       = entryDelta;
+  deltaEntry->entryBits   = entryBits;
+  deltaEntry->isCollision = isCollision;
+  deltaEntry->offset      = offset;
+  return found;
+}
+
+/**********************************************************************/
+static bool skipDeltaEntriesGeneric(DeltaIndexEntry *deltaEntry,
+                                    unsigned int     key)
+{
+  return skipDeltaEntries(deltaEntry, key);
+}
+
+#if HAVE_BIT_MANIPULATION_TARGET
+/**
+ * The same as skipDeltaEntriesGeneric(), but compiled to use BMI1 and BMI2
+ * (TZCNT, SHRX and BZHI) for the shifts, masks and zero counts.
+ **/
+__attribute__((target("bmi,bmi2")))
+static bool skipDeltaEntriesBitManipulation(DeltaIndexEntry *deltaEntry,
+                                            unsigned int     key)
+{
+  return skipDeltaEntries(deltaEntry, key);
+}
+#endif /* HAVE_BIT_MANIPULATION_TARGET */
+
+static OnceState skipDeltaEntriesOnce = ONCE_STATE_INITIALIZER;
+static bool useBitManipulation = false;
+
+/**********************************************************************/
+static void selectSkipDeltaEntries(void)
+{
+  useBitManipulation = cpuHasBitManipulation();
+}
+
+/**
+ * Skip the entries of a delta list with keys less than a search key, using
+ * the fastest decoder this CPU supports.
+ *
+ * @param deltaEntry  The delta index entry to advance
+ * @param key         The key being searched for
+ *
+ * @return true if the first entry with a key not less than the search key
+ *         was found
+ **/
+static INLINE bool skipDeltaEntriesToKey(DeltaIndexEntry *deltaEntry,
+                                         unsigned int     key)
+{
+#if HAVE_BIT_MANIPULATION_TARGET
+  if (useBitManipulation) {
+    return skipDeltaEntriesBitManipulation(deltaEntry, key);
+  }
+#endif /* HAVE_BIT_MANIPULATION_TARGET */
+  return skipDeltaEntriesGeneric(deltaEntry, key);
+}
+
 //**********************************************************************
 //  External functions declared in deltaIndex.h
 //**********************************************************************
@@ -553,6 +721,8 @@ int initializeDeltaIndex(DeltaIndex *deltaIndex, unsigned int numZones,
     return UDS_INVALID_ARGUMENT;
   }
 
+  performOnce(&skipDeltaEntriesOnce, selectSkipDeltaEntries);
+
   int result = ALLOCATE(numZones, DeltaMemory, "Delta Index Zones",
                         &deltaIndex->deltaZones);
   if (result != UDS_SUCCESS) {
@@ -666,6 +836,8 @@ int initializeDeltaIndexPage(DeltaIndex *deltaIndex, DeltaMemory *deltaMemory,
     return UDS_INVALID_ARGUMENT;
   }
 
+  performOnce(&skipDeltaEntriesOnce, selectSkipDeltaEntries);
+
   deltaIndex->deltaZones   = deltaMemory;
   deltaIndex->numZones     = 1;
   deltaIndex->numLists     = numLists;
@@ -1181,6 +1353,26 @@ static void prefetchDeltaList(const DeltaMemory *deltaZone,
   prefetchRange(addr, size, false);
 }
 
+/**********************************************************************/
+void prefetchDeltaIndexList(const DeltaIndex *deltaIndex,
+                            unsigned int      listNumber,
+                            bool              contents)
+{
+  if (!deltaIndex->isMutable || (listNumber >= deltaIndex->numLists)) {
+    return;
+  }
+
+  unsigned int zoneNumber = getDeltaIndexZone(deltaIndex, listNumber);
+  const DeltaMemory *deltaZone = &deltaIndex->deltaZones[zoneNumber];
+  const DeltaList *deltaList
+    = &deltaZone->deltaLists[listNumber - deltaZone->firstList + 1];
+  if (contents) {
+    prefetchDeltaList(deltaZone, deltaList);
+  } else {
+    prefetchAddress(deltaList, false);
+  }
+}
+
 /**********************************************************************/
 int startDeltaIndexSearch(const DeltaIndex *deltaIndex,
                           unsigned int listNumber, unsigned int key,
@@ -1307,12 +1499,14 @@ int getDeltaIndexEntry(const DeltaIndex *deltaIndex, unsigned int listNumber,
   if (result != UDS_SUCCESS) {
     return result;
   }
-  do {
-    result = nextDeltaIndexEntry(deltaEntry);
-    if (result != UDS_SUCCESS) {
-      return result;
-    }
-  } while (!deltaEntry->atEnd && (key > deltaEntry->key));
+  if (!skipDeltaEntriesToKey(deltaEntry, key)) {
+    do {
+      result = nextDeltaIndexEntry(deltaEntry);
+      if (result != UDS_SUCCESS) {
+        return result;
+      }
+    } while (!deltaEntry->atEnd && (key > deltaEntry->key));
+  }
 
   result = rememberDeltaIndexOffset(deltaEntry);
   if (result != UDS_SUCCESS) {
@@ -25,5 +25,6 @@
 #define DESTRUCTOR     0 // No program destructors
 #define ENVIRONMENT    0 // No environment variables
 #define GRID           0 // No grid
+#define IO_URING       0 // No io_uring
 
 #endif /* LINUX_KERNEL_FEATURE_DEFS_H */
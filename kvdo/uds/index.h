@@ -147,6 +147,20 @@ void freeIndex(Index *index);
 int dispatchIndexRequest(Index *index, Request *request)
   __attribute__((warn_unused_result));
 
+/**
+ * Prefetch the master index memory which a batch of requests will search,
+ * so that the cache misses of the whole batch overlap instead of each
+ * request waiting for its own in turn. This is called by a zone thread
+ * before it dispatches the requests it has dequeued, in order.
+ *
+ * @param index     The index
+ * @param requests  The requests which are about to be dispatched
+ * @param count     The number of requests
+ **/
+void prefetchIndexRequests(Index         *index,
+                           Request *const requests[],
+                           unsigned int   count);
+
 /**
  * Internal helper to prepare the index for saving.
  *
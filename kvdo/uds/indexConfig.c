@@ -26,17 +26,39 @@
 #include "memoryAlloc.h"
 
 static const byte INDEX_CONFIG_MAGIC[]        = "ALBIC";
-static const byte INDEX_CONFIG_VERSION[]      = "06.02";
+static const byte INDEX_CONFIG_VERSION[]      = "06.03";
+static const byte INDEX_CONFIG_VERSION_6_02[] = "06.02";
 static const byte INDEX_CONFIG_VERSION_6_01[] = "06.01";
 
 enum {
   INDEX_CONFIG_MAGIC_LENGTH   = sizeof(INDEX_CONFIG_MAGIC) - 1,
-  INDEX_CONFIG_VERSION_LENGTH = sizeof(INDEX_CONFIG_VERSION) - 1
+  INDEX_CONFIG_VERSION_LENGTH = sizeof(INDEX_CONFIG_VERSION) - 1,
+  /** The encoded size of a version 6.02 config */
+  INDEX_CONFIG_6_02_SIZE      = 8 * sizeof(uint32_t) + sizeof(uint64_t),
+  /** The encoded size of a current config, which adds the chunk name hash */
+  INDEX_CONFIG_SIZE           = INDEX_CONFIG_6_02_SIZE + sizeof(uint32_t),
 };
 
+/**
+ * Check whether a config must be written in the current format, or can
+ * still be written as version 6.02. Configs which use the original chunk
+ * name hash are written as 6.02, so that an index which doesn't use the new
+ * field stays readable by older versions.
+ *
+ * @param config  The config to be written
+ *
+ * @return <code>true</code> if the config needs the current format
+ **/
+static bool needsCurrentVersion(UdsConfiguration config)
+{
+  return (config->chunkNameHash != UDS_CHUNK_NAME_MURMUR3);
+}
+
 /**********************************************************************/
 __attribute__((warn_unused_result))
-static int decodeIndexConfig(Buffer *buffer, UdsConfiguration config)
+static int decodeIndexConfig(Buffer           *buffer,
+                             UdsConfiguration  config,
+                             bool              hasChunkNameHash)
 {
   int result = getUInt32LEFromBuffer(buffer, &config->recordPagesPerChapter);
   if (result != UDS_SUCCESS) {
@@ -74,6 +96,15 @@ static int decodeIndexConfig(Buffer *buffer, UdsConfiguration config)
   if (result != UDS_SUCCESS) {
     return result;
   }
+  config->chunkNameHash = UDS_CHUNK_NAME_MURMUR3;
+  if (hasChunkNameHash) {
+    uint32_t hash;
+    result = getUInt32LEFromBuffer(buffer, &hash);
+    if (result != UDS_SUCCESS) {
+      return result;
+    }
+    config->chunkNameHash = hash;
+  }
   result = ASSERT_LOG_ONLY(contentLength(buffer) == 0,
                            "%zu bytes decoded of %zu expected",
                            bufferLength(buffer) - contentLength(buffer),
@@ -95,9 +126,13 @@ static int readVersion(BufferedReader    *reader,
   if (result != UDS_SUCCESS) {
     return logErrorWithStringError(result, "cannot read index config version");
   }
-  if (memcmp(INDEX_CONFIG_VERSION, buffer, INDEX_CONFIG_VERSION_LENGTH) == 0) {
+  bool current = (memcmp(INDEX_CONFIG_VERSION, buffer,
+                         INDEX_CONFIG_VERSION_LENGTH) == 0);
+  if (current || (memcmp(INDEX_CONFIG_VERSION_6_02, buffer,
+                         INDEX_CONFIG_VERSION_LENGTH) == 0)) {
     Buffer *buffer;
-    result = makeBuffer(sizeof(*conf), &buffer);
+    result = makeBuffer((current ? INDEX_CONFIG_SIZE : INDEX_CONFIG_6_02_SIZE),
+                        &buffer);
     if (result != UDS_SUCCESS) {
       return result;
     }
@@ -108,7 +143,7 @@ static int readVersion(BufferedReader    *reader,
       return logErrorWithStringError(result, "cannot read config data");
     }
     clearBuffer(buffer);
-    result = decodeIndexConfig(buffer, conf);
+    result = decodeIndexConfig(buffer, conf, current);
     freeBuffer(&buffer);
     if (result != UDS_SUCCESS) {
       return result;
@@ -135,6 +170,7 @@ static int readVersion(BufferedReader    *reader,
     conf->bytesPerPage            = oldConf.bytesPerPage;
     conf->sparseSampleRate        = oldConf.sparseSampleRate;
     conf->nonce                   = 0;
+    conf->chunkNameHash           = UDS_CHUNK_NAME_MURMUR3;
     if (versionPtr != NULL) {
       *versionPtr = "6.01";
     }
@@ -209,9 +245,15 @@ static int encodeIndexConfig(Buffer *buffer, UdsConfiguration config)
   if (result != UDS_SUCCESS) {
     return result;
   }
-  result = ASSERT_LOG_ONLY(contentLength(buffer) == sizeof(*config),
+  if (needsCurrentVersion(config)) {
+    result = putUInt32LEIntoBuffer(buffer, config->chunkNameHash);
+    if (result != UDS_SUCCESS) {
+      return result;
+    }
+  }
+  result = ASSERT_LOG_ONLY(contentLength(buffer) == bufferLength(buffer),
                            "%zu bytes encoded, of %zu expected",
-                           contentLength(buffer), sizeof(*config));
+                           contentLength(buffer), bufferLength(buffer));
   return result;
 }
 
@@ -224,13 +266,17 @@ int writeConfigContents(BufferedWriter   *writer,
   if (result != UDS_SUCCESS) {
     return result;
   }
-  result = writeToBufferedWriter(writer, INDEX_CONFIG_VERSION,
+  bool current = needsCurrentVersion(config);
+  result = writeToBufferedWriter(writer,
+                                 (current ? INDEX_CONFIG_VERSION
+                                  : INDEX_CONFIG_VERSION_6_02),
                                  INDEX_CONFIG_VERSION_LENGTH);
   if (result != UDS_SUCCESS) {
     return result;
   }
   Buffer *buffer;
-  result = makeBuffer(sizeof(*config), &buffer);
+  result = makeBuffer((current ? INDEX_CONFIG_SIZE : INDEX_CONFIG_6_02_SIZE),
+                      &buffer);
   if (result != UDS_SUCCESS) {
     return result;
   }
@@ -55,13 +55,24 @@ static INLINE IndexRouter *asIndexRouter(LocalIndexRouter *router)
 
 /**
  * This is the request processing function invoked by the zone's RequestQueue
- * worker thread.
+ * worker thread. It is handed whatever requests could be dequeued without
+ * waiting. The master index memory each of them will search is prefetched
+ * for the whole batch before they are executed, in order, so that the batch
+ * waits on memory about once rather than once per request.
  *
- * @param request  the request to be indexed or executed by the zone worker
+ * @param requests  the requests to be indexed or executed by the zone worker
+ * @param count     the number of requests
  **/
-static void executeZoneRequest(Request *request)
+static void executeZoneRequests(Request **requests, unsigned int count)
 {
-  request->router->methods->execute(request->router, request);
+  if (count > 1) {
+    LocalIndexRouter *router = asLocalIndexRouter(requests[0]->router);
+    prefetchIndexRequests(router->index, requests, count);
+  }
+  for (unsigned int i = 0; i < count; i++) {
+    Request *request = requests[i];
+    request->router->methods->execute(request->router, request);
+  }
 }
 
 /**
@@ -128,8 +139,8 @@ static int initializeLocalIndexQueues(LocalIndexRouter *router,
                                       const Geometry   *geometry)
 {
   for (unsigned int i = 0; i < router->zoneCount; i++) {
-    int result = makeRequestQueue("indexW", &executeZoneRequest,
-                              &router->zoneQueues[i]);
+    int result = makeBatchRequestQueue("indexW", &executeZoneRequests,
+                                       &router->zoneQueues[i]);
     if (result != UDS_SUCCESS) {
       return result;
     }
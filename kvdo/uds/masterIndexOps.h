@@ -115,6 +115,9 @@ struct masterIndex {
   int (*lookupMasterIndexSampledName)(const MasterIndex *masterIndex,
                                       const UdsChunkName *name,
                                       MasterIndexTriage *triage);
+  void (*prefetchMasterIndexName)(const MasterIndex *masterIndex,
+                                  const UdsChunkName *name,
+                                  bool contents);
   int (*restoreDeltaListToMasterIndex)(MasterIndex *masterIndex,
                                        const DeltaListSaveInfo *dlsi,
                                        const byte data[DELTA_LIST_MAX_BYTE_COUNT]);
@@ -387,6 +390,24 @@ static INLINE int lookupMasterIndexSampledName(const MasterIndex *masterIndex,
   return masterIndex->lookupMasterIndexSampledName(masterIndex, name, triage);
 }
 
+/**
+ * Prefetch the master index memory which getMasterIndexRecord() will touch
+ * for a chunk name. The zone thread which owns the name should call this
+ * for a batch of names with contents false, and then again with contents
+ * true, before looking any of them up, so that their cache misses overlap.
+ *
+ * @param masterIndex The master index
+ * @param name        The chunk name
+ * @param contents    False to fetch the delta list header, or true to fetch
+ *                    the delta list it locates
+ **/
+static INLINE void prefetchMasterIndexName(const MasterIndex *masterIndex,
+                                           const UdsChunkName *name,
+                                           bool contents)
+{
+  masterIndex->prefetchMasterIndexName(masterIndex, name, contents);
+}
+
 /**
  * Create a new record associated with a block name.
  *
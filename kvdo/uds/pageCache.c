@@ -31,6 +31,7 @@
 #include "indexConfig.h"
 #include "logger.h"
 #include "memoryAlloc.h"
+#include "numeric.h"
 #include "permassert.h"
 #include "recordPage.h"
 #include "stringUtils.h"
@@ -57,10 +58,10 @@ int assertPageInCache(PageCache *cache, CachedPage *page)
  * Clear a cache page.  Note: this does not clear readPending - a read could
  * still be pending and the read thread needs to be able to proceed and restart
  * the requests regardless. This page will still be marked invalid, but it
- * won't get reused (see getLeastRecentPage()) until the readPending flag
- * is cleared. This is a valid case, e.g. the chapter gets forgotten and
- * replaced with a new one in LRU.  Restarting the requests will lead them to
- * not find the records in the MI.
+ * won't get reused (see chooseVictimPage()) until the read completes and the
+ * page is returned to a replacement queue. This is a valid case, e.g. the
+ * chapter gets forgotten and replaced with a new one in LRU.  Restarting the
+ * requests will lead them to not find the records in the MI.
  *
  * @param cache   the cache
  * @param page    the cached page to clear
@@ -69,7 +70,108 @@ int assertPageInCache(PageCache *cache, CachedPage *page)
 static void clearPage(PageCache *cache, CachedPage *page)
 {
   page->physicalPage = cache->numIndexEntries;
-  WRITE_ONCE(page->lastUsed, 0);
+  WRITE_ONCE(page->referenced, false);
+}
+
+/**
+ * Remove a page from the replacement queue holding it, if any.
+ *
+ * @param cache  the cache
+ * @param page   the cached page to remove
+ **/
+static void removePageFromQueue(PageCache *cache, CachedPage *page)
+{
+  // We hold the readThreadsMutex.
+  if (page->queue == PAGE_QUEUE_NONE) {
+    return;
+  }
+
+  PageQueue *queue = &cache->queues[page->queue];
+  if (page->prev == VOLUME_CACHE_NO_PAGE) {
+    queue->head = page->next;
+  } else {
+    cache->cache[page->prev].next = page->next;
+  }
+  if (page->next == VOLUME_CACHE_NO_PAGE) {
+    queue->tail = page->prev;
+  } else {
+    cache->cache[page->next].prev = page->prev;
+  }
+  queue->size--;
+
+  page->queue = PAGE_QUEUE_NONE;
+  page->prev  = VOLUME_CACHE_NO_PAGE;
+  page->next  = VOLUME_CACHE_NO_PAGE;
+}
+
+/**
+ * Move a page to the newest end of a replacement queue.
+ *
+ * @param cache  the cache
+ * @param page   the cached page to move
+ * @param type   the queue to move it to
+ **/
+static void addPageToQueue(PageCache     *cache,
+                           CachedPage    *page,
+                           PageQueueType  type)
+{
+  // We hold the readThreadsMutex.
+  removePageFromQueue(cache, page);
+
+  PageQueue *queue = &cache->queues[type];
+  uint16_t   value = page - cache->cache;
+  page->queue = type;
+  page->prev  = queue->tail;
+  page->next  = VOLUME_CACHE_NO_PAGE;
+  if (queue->tail == VOLUME_CACHE_NO_PAGE) {
+    queue->head = value;
+  } else {
+    cache->cache[queue->tail].next = value;
+  }
+  queue->tail = value;
+  queue->size++;
+}
+
+/**
+ * Remember that a physical page was recently evicted from the probation
+ * queue, forgetting the oldest such page if there are too many.
+ *
+ * @param cache         the cache
+ * @param physicalPage  the physical page which was evicted
+ **/
+static void addGhost(PageCache *cache, unsigned int physicalPage)
+{
+  // We hold the readThreadsMutex.
+  unsigned int oldest = cache->ghostRing[cache->ghostRingNext];
+  if (oldest < cache->numIndexEntries) {
+    cache->ghosts[oldest / CHAR_BIT] &= ~(1 << (oldest % CHAR_BIT));
+  }
+  cache->ghostRing[cache->ghostRingNext] = physicalPage;
+  cache->ghostRingNext = (cache->ghostRingNext + 1) % cache->ghostRingSize;
+  cache->ghosts[physicalPage / CHAR_BIT] |= (1 << (physicalPage % CHAR_BIT));
+}
+
+/**
+ * Check whether a physical page was recently evicted from the probation
+ * queue, and forget it if so.  The page may remain in the ring of recently
+ * evicted pages, which at worst shortens the memory of a later eviction of
+ * the same page.
+ *
+ * @param cache         the cache
+ * @param physicalPage  the physical page being read into the cache
+ *
+ * @return <code>true</code> if the page was recently evicted
+ **/
+static bool removeGhost(PageCache *cache, unsigned int physicalPage)
+{
+  // We hold the readThreadsMutex.
+  byte *ghostByte = &cache->ghosts[physicalPage / CHAR_BIT];
+  byte  ghostBit  = 1 << (physicalPage % CHAR_BIT);
+  if ((*ghostByte & ghostBit) == 0) {
+    return false;
+  }
+  *ghostByte &= ~ghostBit;
+  return true;
 }
 
 /**
@@ -247,9 +349,9 @@ int findInvalidateAndMakeLeastRecent(PageCache          *cache,
     return result;
   }
 
-  // Move the cached page to the least recently used end of the list
-  // so it will be replaced before any page with valid data.
-  WRITE_ONCE(page->lastUsed, 0);
+  // Move the cached page to the free queue so it will be replaced before any
+  // page with valid data.
+  addPageToQueue(cache, page, PAGE_QUEUE_FREE);
 
   return UDS_SUCCESS;
 }
@@ -267,7 +369,17 @@ static int initializePageCache(PageCache      *cache,
   cache->numCacheEntries = chaptersInCache * geometry->recordPagesPerChapter;
   cache->readQueueMaxSize = readQueueMaxSize;
   cache->zoneCount = zoneCount;
-  atomic64_set(&cache->clock, 1);
+  // The 2Q paper recommends a probation queue of a quarter of the cache and
+  // remembering the evictions from it for half the cache size.
+  cache->probationTarget = maxUInt(cache->numCacheEntries / 4, 1);
+  cache->ghostRingSize = maxUInt(cache->numCacheEntries / 2, 1);
+  for (unsigned int i = 0; i < PAGE_QUEUE_COUNT; i++) {
+    cache->queues[i] = (PageQueue) {
+      .head = VOLUME_CACHE_NO_PAGE,
+      .tail = VOLUME_CACHE_NO_PAGE,
+      .size = 0,
+    };
+  }
 
   int result = ALLOCATE(readQueueMaxSize, QueuedRead,
                         "volume read queue", &cache->readQueue);
@@ -315,7 +427,25 @@ static int initializePageCache(PageCache      *cache,
   for (unsigned int i = 0; i < cache->numCacheEntries; i++) {
     CachedPage *page = &cache->cache[i];
     page->data = cache->data + (i * cache->geometry->bytesPerPage);
+    page->queue = PAGE_QUEUE_NONE;
     clearPage(cache, page);
+    addPageToQueue(cache, page, PAGE_QUEUE_FREE);
+  }
+
+  result = ALLOCATE((cache->numIndexEntries + CHAR_BIT - 1) / CHAR_BIT, byte,
+                    "page cache ghosts", &cache->ghosts);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  result = ALLOCATE(cache->ghostRingSize, unsigned int, "page cache ghost ring",
+                    &cache->ghostRing);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  for (unsigned int i = 0; i < cache->ghostRingSize; i++) {
+    cache->ghostRing[i] = cache->numIndexEntries;
   }
 
   return UDS_SUCCESS;
@@ -366,6 +496,8 @@ void freePageCache(PageCache *cache)
   if (cache == NULL) {
     return;
   }
+  FREE(cache->ghostRing);
+  FREE(cache->ghosts);
   FREE(cache->index);
   FREE(cache->data);
   FREE(cache->cache);
@@ -388,6 +520,8 @@ int invalidatePageCacheForChapter(PageCache          *cache,
   int result;
   for (unsigned int i = 0; i < pagesPerChapter; i++) {
     unsigned int physicalPage = 1 + (pagesPerChapter * chapter) + i;
+    // The chapter is being replaced, so its pages were not recently evicted.
+    removeGhost(cache, physicalPage);
     result = findInvalidateAndMakeLeastRecent(cache, physicalPage,
                                               cache->readQueue,
                                               reason, false);
@@ -400,51 +534,71 @@ int invalidatePageCacheForChapter(PageCache          *cache,
 }
 
 /*********************************************************************/
-void makePageMostRecent(PageCache *cache, CachedPage *page)
+void makePageMostRecent(PageCache  *cache __attribute__((unused)),
+                        CachedPage *page)
 {
   // ASSERTION: We are either a zone thread holding a searchPendingCounter,
   //            or we are any thread holding the readThreadsMutex.
-  if (atomic64_read(&cache->clock) != READ_ONCE(page->lastUsed)) {
-    WRITE_ONCE(page->lastUsed, atomic64_inc_return(&cache->clock));
+  if (!READ_ONCE(page->referenced)) {
+    WRITE_ONCE(page->referenced, true);
   }
 }
 
 /**
- * Get the least recent valid page from the cache.
+ * Choose the page in the cache to reuse for a read.  Pages holding no valid
+ * data are chosen first, then the oldest page in the probation queue if that
+ * queue is over its target size, and otherwise the first page in the
+ * protected queue not used since the replacement clock last passed it.
+ * Pages with pending reads are in no queue, so are never chosen.
  *
  * @param cache    the cache
- * @param pagePtr  a pointer to hold the new page (will be set to NULL
- *                 if the page was not found)
+ * @param pagePtr  a pointer to hold the chosen page
  *
  * @return UDS_SUCCESS or an error code
  **/
 __attribute__((warn_unused_result))
-static int getLeastRecentPage(PageCache *cache, CachedPage **pagePtr)
+static int chooseVictimPage(PageCache *cache, CachedPage **pagePtr)
 {
   // We hold the readThreadsMutex.
-  int oldestIndex = 0;
-  // Our first candidate is any page that does have a pending read.  We ensure
-  // above that there are more entries than read threads, so there must be one.
-  for (unsigned int i = 0;; i++) {
-    if (i >= cache->numCacheEntries) {
-      // This should never happen.
-      return ASSERT(false, "oldest page is not NULL");
-    }
-    if (!cache->cache[i].readPending) {
-      oldestIndex = i;
-      break;
+  cache->counters.victims++;
+
+  PageQueue *freeQueue = &cache->queues[PAGE_QUEUE_FREE];
+  if (freeQueue->size > 0) {
+    cache->counters.victimProbes++;
+    *pagePtr = &cache->cache[freeQueue->head];
+    return UDS_SUCCESS;
+  }
+
+  PageQueue *probationQueue = &cache->queues[PAGE_QUEUE_PROBATION];
+  PageQueue *protectedQueue = &cache->queues[PAGE_QUEUE_PROTECTED];
+  if ((probationQueue->size > cache->probationTarget)
+      || (protectedQueue->size == 0)) {
+    // We ensure above that there are more entries than read threads, so
+    // there must be a page which does not have a pending read.
+    int result = ASSERT((probationQueue->size > 0),
+                        "cache has a page without a pending read");
+    if (result != UDS_SUCCESS) {
+      return result;
     }
+    cache->counters.victimProbes++;
+    CachedPage *page = &cache->cache[probationQueue->head];
+    addGhost(cache, page->physicalPage);
+    *pagePtr = page;
+    return UDS_SUCCESS;
   }
-  // Now find the least recently used page that does not have a pending read.
-  for (unsigned int i = 0; i < cache->numCacheEntries; i++) {
-    if (!cache->cache[i].readPending
-        && (READ_ONCE(cache->cache[i].lastUsed)
-            <= READ_ONCE(cache->cache[oldestIndex].lastUsed))) {
-      oldestIndex = i;
+
+  // Zone threads may mark pages referenced again while the clock turns, so
+  // stop after one full revolution.
+  for (unsigned int i = 0;; i++) {
+    cache->counters.victimProbes++;
+    CachedPage *page = &cache->cache[protectedQueue->head];
+    if ((i >= protectedQueue->size) || !READ_ONCE(page->referenced)) {
+      *pagePtr = page;
+      return UDS_SUCCESS;
     }
+    WRITE_ONCE(page->referenced, false);
+    addPageToQueue(cache, page, PAGE_QUEUE_PROTECTED);
   }
-  *pagePtr = &cache->cache[oldestIndex];
-  return UDS_SUCCESS;
 }
 
 /***********************************************************************/
@@ -593,12 +747,12 @@ int selectVictimInCache(PageCache   *cache,
   }
 
   CachedPage *page = NULL;
-  int result = getLeastRecentPage(cache, &page);
+  int result = chooseVictimPage(cache, &page);
   if (result != UDS_SUCCESS) {
     return result;
   }
 
-  result = ASSERT((page != NULL), "least recent page was not NULL");
+  result = ASSERT((page != NULL), "victim page was not NULL");
   if (result != UDS_SUCCESS) {
     return result;
   }
@@ -611,6 +765,7 @@ int selectVictimInCache(PageCache   *cache,
     waitForPendingSearches(cache, page->physicalPage);
   }
 
+  removePageFromQueue(cache, page);
   page->readPending = true;
 
   *pagePtr = page;
@@ -651,7 +806,14 @@ int putPageInCache(PageCache    *cache,
     return result;
   }
 
-  makePageMostRecent(cache, page);
+  // A page read again soon after its eviction from the probation queue is
+  // used repeatedly, so protect it from bursts of pages which are not.
+  if (removeGhost(cache, physicalPage)) {
+    cache->counters.promotions++;
+    addPageToQueue(cache, page, PAGE_QUEUE_PROTECTED);
+  } else {
+    addPageToQueue(cache, page, PAGE_QUEUE_PROBATION);
+  }
 
   page->readPending = false;
 
@@ -691,6 +853,7 @@ void cancelPageInCache(PageCache    *cache,
   }
 
   clearPage(cache, page);
+  addPageToQueue(cache, page, PAGE_QUEUE_FREE);
   page->readPending = false;
 
   // Clear the page map for the new page. Will clear queued flag
@@ -83,8 +83,9 @@ enum {
 };
 
 struct requestQueue {
-  const char            *name;       // name of queue
-  RequestQueueProcessor *processOne; // function to process 1 request
+  const char                 *name;         // name of queue
+  RequestQueueProcessor      *processOne;   // function to process 1 request
+  RequestQueueBatchProcessor *processBatch; // or to process several
 
   FunnelQueue *mainQueue;       // new incoming requests
   FunnelQueue *retryQueue;      // old requests to retry first
@@ -109,6 +110,9 @@ struct requestQueue {
 
   /** the relative time at which to wake when waiting with a timeout */
   RelTime wakeRelTime;
+
+  /** the batch being handed to processBatch */
+  Request *batch[REQUEST_QUEUE_BATCH_SIZE];
 };
 
 /**
@@ -260,6 +264,28 @@ static Request *dequeueRequest(RequestQueue *queue)
   }
 }
 
+/**
+ * Process a request along with whichever requests following it can be
+ * dequeued without waiting, as one batch.
+ *
+ * @param queue    the queue being serviced
+ * @param request  the first request of the batch
+ **/
+static void processRequestBatch(RequestQueue *queue, Request *request)
+{
+  unsigned int count = 0;
+  queue->batch[count++] = request;
+  while (count < REQUEST_QUEUE_BATCH_SIZE) {
+    request = pollQueues(queue);
+    if (request == NULL) {
+      break;
+    }
+    queue->currentBatch += 1;
+    queue->batch[count++] = request;
+  }
+  queue->processBatch(queue->batch, count);
+}
+
 /**********************************************************************/
 static void requestQueueWorker(void *arg)
 {
@@ -267,18 +293,24 @@ static void requestQueueWorker(void *arg)
   logDebug("%s queue starting", queue->name);
   Request *request;
   while ((request = dequeueRequest(queue)) != NULL) {
-    queue->processOne(request);
+    if (queue->processBatch != NULL) {
+      processRequestBatch(queue, request);
+    } else {
+      queue->processOne(request);
+    }
   }
   logDebug("%s queue done", queue->name);
 }
 
 /**********************************************************************/
-static int initializeQueue(RequestQueue          *queue,
-                           const char            *queueName,
-                           RequestQueueProcessor *processOne)
+static int initializeQueue(RequestQueue               *queue,
+                           const char                 *queueName,
+                           RequestQueueProcessor      *processOne,
+                           RequestQueueBatchProcessor *processBatch)
 {
   queue->name            = queueName;
   queue->processOne      = processOne;
+  queue->processBatch    = processBatch;
   queue->alive           = true;
   queue->currentBatch    = 0;
   queue->waitNanoseconds = DEFAULT_WAIT_TIME;
@@ -308,9 +340,10 @@ static int initializeQueue(RequestQueue          *queue,
 }
 
 /**********************************************************************/
-int makeRequestQueue(const char             *queueName,
-                     RequestQueueProcessor  *processOne,
-                     RequestQueue          **queuePtr)
+static int allocateRequestQueue(const char                  *queueName,
+                                RequestQueueProcessor       *processOne,
+                                RequestQueueBatchProcessor  *processBatch,
+                                RequestQueue               **queuePtr)
 {
   RequestQueue *queue;
   int result = ALLOCATE(1, struct requestQueue, "request queue", &queue);
@@ -318,7 +351,7 @@ int makeRequestQueue(const char             *queueName,
     return result;
   }
 
-  result = initializeQueue(queue, queueName, processOne);
+  result = initializeQueue(queue, queueName, processOne, processBatch);
   if (result != UDS_SUCCESS) {
     requestQueueFinish(queue);
     return result;
@@ -328,6 +361,22 @@ int makeRequestQueue(const char             *queueName,
   return UDS_SUCCESS;
 }
 
+/**********************************************************************/
+int makeRequestQueue(const char             *queueName,
+                     RequestQueueProcessor  *processOne,
+                     RequestQueue          **queuePtr)
+{
+  return allocateRequestQueue(queueName, processOne, NULL, queuePtr);
+}
+
+/**********************************************************************/
+int makeBatchRequestQueue(const char                  *queueName,
+                          RequestQueueBatchProcessor  *processBatch,
+                          RequestQueue               **queuePtr)
+{
+  return allocateRequestQueue(queueName, NULL, processBatch, queuePtr);
+}
+
 /**********************************************************************/
 void requestQueueEnqueue(RequestQueue *queue, Request *request)
 {
@@ -345,6 +394,21 @@ void requestQueueEnqueue(RequestQueue *queue, Request *request)
   }
 }
 
+/**********************************************************************/
+void requestQueueEnqueueChain(RequestQueue *queue,
+                              Request      *first,
+                              Request      *last)
+{
+  bool unbatched = first->unbatched;
+  funnelQueuePutChain(queue->mainQueue, &first->requestQueueLink,
+                      &last->requestQueueLink);
+
+  // As in requestQueueEnqueue(), the queue operation acts as a read fence.
+  if (atomic_read(&queue->dormant) || unbatched) {
+    eventCountBroadcast(queue->workEvent);
+  }
+}
+
 /**********************************************************************/
 void requestQueueFinish(RequestQueue *queue)
 {
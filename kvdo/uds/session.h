@@ -78,6 +78,24 @@ typedef struct sessionGroup SessionGroup;
 int getSession(SessionGroup *group, SessionID id, Session **sessionPtr)
   __attribute__((warn_unused_result));
 
+/**
+ * Looks up a session ID, and if successful, returns the associated session
+ * with several references acquired at once, as for a batch of requests.
+ *
+ * @param group       Session group in which to look up the session
+ * @param id          Session ID to look up
+ * @param count       The number of references to acquire
+ * @param sessionPtr  Return pointer for the session on success
+ *
+ * @return            If the session ID was not found, the session group's
+ *                    'notFoundResult' value; otherwise, UDS_SUCCESS
+ **/
+int getSessionReferences(SessionGroup  *group,
+                         SessionID      id,
+                         unsigned int   count,
+                         Session      **sessionPtr)
+  __attribute__((warn_unused_result));
+
 /**
  * Returns the contents associated with the session.  NOTE: the caller must
  * hold a reference to the session.
@@ -96,6 +114,15 @@ SessionContents getSessionContents(Session *session)
  **/
 void releaseSession(Session *session);
 
+/**
+ * Releases several references to the session at once.  NOTE: the caller must
+ * hold that many references to the session.
+ *
+ * @param session  Session to release.
+ * @param count    The number of references to release
+ **/
+void releaseSessionReferences(Session *session, unsigned int count);
+
 /**
  * Wait until the session is idle.
  *
@@ -31,7 +31,9 @@
 /** General UDS block constants. */
 enum {
   /** The maximum metadata size for a block. */
-  UDS_MAX_BLOCK_DATA_SIZE = UDS_MAX_METADATA_SIZE
+  UDS_MAX_BLOCK_DATA_SIZE = UDS_MAX_METADATA_SIZE,
+  /** The most operations which may be started by one call. */
+  UDS_MAX_CHUNK_OPERATIONS = 32
 };
 
 /**
@@ -237,6 +239,26 @@ struct udsRequest {
  **/
 UDS_ATTR_WARN_UNUSED_RESULT
 int udsStartChunkOperation(UdsRequest *request);
+
+/**
+ * Start a batch of UDS index chunk operations.  Each request is set up and
+ * completed just as for #udsStartChunkOperation, but the requests bound for
+ * each index zone are handed to it together, which saves a cross-thread
+ * handoff and possibly a wakeup per request when many operations are being
+ * started at once.  The operations may complete in any order.
+ *
+ * If any request is invalid, or a context cannot be used, no operation is
+ * started and no callback will be invoked for any of the requests.
+ *
+ * @param [in] requests  The operations, set up as for
+ *                       #udsStartChunkOperation
+ * @param [in] count     The number of operations, at most
+ *                       #UDS_MAX_CHUNK_OPERATIONS
+ *
+ * @return              Either #UDS_SUCCESS or an error code
+ **/
+UDS_ATTR_WARN_UNUSED_RESULT
+int udsStartChunkOperations(UdsRequest **requests, unsigned int count);
 /** @} */
 
 /** @{ */
@@ -121,6 +121,19 @@ typedef struct udsIndexSession {
 typedef struct udsConfiguration *UdsConfiguration;
 typedef uint64_t UdsNonce;
 
+/**
+ * The hash functions with which chunk names may be computed. UDS does not
+ * compute chunk names itself, but an index records which function its names
+ * came from so that it is never used with names from a different one.
+ **/
+typedef enum {
+  /** MurmurHash3_x64_128, which every index created before this was known
+   *  used */
+  UDS_CHUNK_NAME_MURMUR3 = 0,
+  /** XXH3_128bits */
+  UDS_CHUNK_NAME_XXH3    = 1,
+} UdsChunkNameHash;
+
 /**
  * Index statistics
  *
@@ -270,6 +283,30 @@ void udsConfigurationSetNonce(UdsConfiguration conf, UdsNonce nonce);
 UDS_ATTR_WARN_UNUSED_RESULT
 UdsNonce udsConfigurationGetNonce(UdsConfiguration conf);
 
+/**
+ * Sets the hash function with which an index configuration's chunk names
+ * are computed.
+ *
+ * @param [in,out] conf  The configuration to change
+ * @param [in] hash      The chunk name hash function
+ *
+ * @return               Either #UDS_SUCCESS or an error code
+ **/
+UDS_ATTR_WARN_UNUSED_RESULT
+int udsConfigurationSetChunkNameHash(UdsConfiguration conf,
+                                     UdsChunkNameHash hash);
+
+/**
+ * Gets the hash function with which an index configuration's chunk names
+ * are computed.
+ *
+ * @param [in] conf  The configuration to check
+ *
+ * @return  The chunk name hash function
+ **/
+UDS_ATTR_WARN_UNUSED_RESULT
+UdsChunkNameHash udsConfigurationGetChunkNameHash(UdsConfiguration conf);
+
 /**
  * Sets an index configuration's checkpoint frequency.
  *
@@ -102,6 +102,7 @@ int udsInitializeConfiguration(UdsConfiguration    *userConfig,
   (*userConfig)->bytesPerPage            = DEFAULT_BYTES_PER_PAGE;
   (*userConfig)->sparseSampleRate        = DEFAULT_SPARSE_SAMPLE_RATE;
   (*userConfig)->nonce                   = 0;
+  (*userConfig)->chunkNameHash           = UDS_CHUNK_NAME_MURMUR3;
   return UDS_SUCCESS;
 }
 
@@ -146,6 +147,24 @@ UdsNonce udsConfigurationGetNonce(UdsConfiguration userConfig)
   return userConfig->nonce;
 }
 
+/**********************************************************************/
+int udsConfigurationSetChunkNameHash(UdsConfiguration userConfig,
+                                     UdsChunkNameHash hash)
+{
+  if ((hash != UDS_CHUNK_NAME_MURMUR3) && (hash != UDS_CHUNK_NAME_XXH3)) {
+    return logErrorWithStringError(UDS_INVALID_ARGUMENT,
+                                   "unknown chunk name hash %u", hash);
+  }
+  userConfig->chunkNameHash = hash;
+  return UDS_SUCCESS;
+}
+
+/**********************************************************************/
+UdsChunkNameHash udsConfigurationGetChunkNameHash(UdsConfiguration userConfig)
+{
+  return userConfig->chunkNameHash;
+}
+
 /**********************************************************************/
 int udsConfigurationSetCheckpointFrequency(
   UdsConfiguration userConfig,
@@ -31,6 +31,7 @@
 #include "uds-block.h"
 #include "uds-param.h"
 #include "util/funnelQueue.h"
+#include "xxhash/XXH3.h"
 
 /**********************************************************************/
 static int __init dedupeInit(void)
@@ -68,6 +69,8 @@ EXPORT_SYMBOL_GPL(udsConfigurationSetCheckpointFrequency);
 EXPORT_SYMBOL_GPL(udsConfigurationGetCheckpointFrequency);
 EXPORT_SYMBOL_GPL(udsConfigurationGetMemory);
 EXPORT_SYMBOL_GPL(udsConfigurationGetChaptersPerVolume);
+EXPORT_SYMBOL_GPL(udsConfigurationSetChunkNameHash);
+EXPORT_SYMBOL_GPL(udsConfigurationGetChunkNameHash);
 EXPORT_SYMBOL_GPL(udsFreeConfiguration);
 EXPORT_SYMBOL_GPL(udsGetVersion);
 EXPORT_SYMBOL_GPL(udsCreateLocalIndex);
@@ -82,6 +85,7 @@ EXPORT_SYMBOL_GPL(udsOpenBlockContext);
 EXPORT_SYMBOL_GPL(udsCloseBlockContext);
 EXPORT_SYMBOL_GPL(udsFlushBlockContext);
 EXPORT_SYMBOL_GPL(udsStartChunkOperation);
+EXPORT_SYMBOL_GPL(udsStartChunkOperations);
 EXPORT_SYMBOL_GPL(udsGetBlockContextIndexStats);
 EXPORT_SYMBOL_GPL(udsGetBlockContextStats);
 
@@ -135,6 +139,11 @@ EXPORT_SYMBOL_GPL(isFunnelQueueEmpty);
 EXPORT_SYMBOL_GPL(makeBuffer);
 EXPORT_SYMBOL_GPL(makeFunnelQueue);
 EXPORT_SYMBOL_GPL(MurmurHash3_x64_128);
+EXPORT_SYMBOL_GPL(MurmurHash3_x64_128_copy);
+EXPORT_SYMBOL_GPL(MurmurHash3_x64_128_finish);
+EXPORT_SYMBOL_GPL(MurmurHash3_x64_128_multi);
+EXPORT_SYMBOL_GPL(MurmurHash3_x64_128_start);
+EXPORT_SYMBOL_GPL(MurmurHash3_x64_128_zeros);
 EXPORT_SYMBOL_GPL(nowUsec);
 EXPORT_SYMBOL_GPL(peekByte);
 EXPORT_SYMBOL_GPL(putBoolean);
@@ -162,6 +171,11 @@ EXPORT_SYMBOL_GPL(skipForward);
 EXPORT_SYMBOL_GPL(uncompactedAmount);
 EXPORT_SYMBOL_GPL(unregisterAllocatingThread);
 EXPORT_SYMBOL_GPL(wrapBuffer);
+EXPORT_SYMBOL_GPL(XXH3_128bits);
+EXPORT_SYMBOL_GPL(XXH3_128bits_copy);
+EXPORT_SYMBOL_GPL(XXH3_128bits_finish);
+EXPORT_SYMBOL_GPL(XXH3_128bits_start);
+EXPORT_SYMBOL_GPL(XXH3_128bits_zeros);
 EXPORT_SYMBOL_GPL(zeroBytes);
 
 /**********************************************************************/
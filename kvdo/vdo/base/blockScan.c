@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/base/blockScan.c#1 $
+ */
+
+#include "blockScan.h"
+
+#include "numUtils.h"
+
+enum {
+  /** The size of the units MurmurHash3 hashes, and of every piece it takes */
+  MURMUR_UNIT_SIZE = 2 * sizeof(uint64_t),
+  /** The size of the stripes XXH3 hashes, and of every piece it takes */
+  XXH3_UNIT_SIZE   = 8 * sizeof(uint64_t),
+};
+
+/**
+ * Copy the leading zeroes of a buffer, stopping at the first 16-byte unit
+ * which is not all zeroes.
+ *
+ * @param destination  The buffer to copy to
+ * @param source       The buffer to copy from
+ * @param length       The length of the source, a multiple of 16 bytes
+ *
+ * @return The number of bytes copied, which are all zeroes
+ **/
+static unsigned int copyZeroPrefix(char         *destination,
+                                   const char   *source,
+                                   unsigned int  length)
+{
+  unsigned int offset = 0;
+
+  // Check 64 bytes at a time while that is possible.
+  while (offset + 8 * sizeof(uint64_t) <= length) {
+    const char *chunk = source + offset;
+    uint64_t or = (GET_UNALIGNED(uint64_t, chunk)
+                   | GET_UNALIGNED(uint64_t, chunk + 1 * sizeof(uint64_t))
+                   | GET_UNALIGNED(uint64_t, chunk + 2 * sizeof(uint64_t))
+                   | GET_UNALIGNED(uint64_t, chunk + 3 * sizeof(uint64_t))
+                   | GET_UNALIGNED(uint64_t, chunk + 4 * sizeof(uint64_t))
+                   | GET_UNALIGNED(uint64_t, chunk + 5 * sizeof(uint64_t))
+                   | GET_UNALIGNED(uint64_t, chunk + 6 * sizeof(uint64_t))
+                   | GET_UNALIGNED(uint64_t, chunk + 7 * sizeof(uint64_t)));
+    if (or != 0) {
+      break;
+    }
+    memset(destination + offset, 0, 8 * sizeof(uint64_t));
+    offset += 8 * sizeof(uint64_t);
+  }
+
+  // Narrow down to the first non-zero 16-byte unit.
+  while (offset < length) {
+    const char *unit = source + offset;
+    if ((GET_UNALIGNED(uint64_t, unit)
+         | GET_UNALIGNED(uint64_t, unit + sizeof(uint64_t))) != 0) {
+      break;
+    }
+    memset(destination + offset, 0, MURMUR_UNIT_SIZE);
+    offset += MURMUR_UNIT_SIZE;
+  }
+  return offset;
+}
+
+/**********************************************************************/
+void startBlockScan(BlockScan        *scan,
+                    char             *destination,
+                    UdsChunkNameHash  function,
+                    uint32_t          seed)
+{
+  *scan = (BlockScan) {
+    .start     = destination,
+    .next      = destination,
+    .function  = function,
+    .seed      = seed,
+    .allZeros  = true,
+    .streaming = true,
+  };
+  if (function == UDS_CHUNK_NAME_XXH3) {
+    scan->unitSize = XXH3_UNIT_SIZE;
+    XXH3_128bits_start(&scan->hash.xxh3);
+  } else {
+    scan->unitSize = MURMUR_UNIT_SIZE;
+    MurmurHash3_x64_128_start(&scan->hash.murmur, seed);
+  }
+}
+
+/**********************************************************************/
+void scanBlockSegment(BlockScan *scan, const char *source, unsigned int length)
+{
+  if (!scan->streaming || ((length % scan->unitSize) != 0)) {
+    // The incremental hash can't take this segment, so just copy the rest
+    // and check and hash the copy afterwards.
+    scan->streaming = false;
+    memcpy(scan->next, source, length);
+    scan->next += length;
+    return;
+  }
+
+  if (scan->allZeros) {
+    // Only whole units of zeroes can be hashed without reading them; the
+    // rest of a partial unit is copied again below.
+    unsigned int zeros = copyZeroPrefix(scan->next, source, length);
+    zeros -= zeros % scan->unitSize;
+    scan->zeroBytes += zeros;
+    scan->next      += zeros;
+    source          += zeros;
+    length          -= zeros;
+    if (length == 0) {
+      return;
+    }
+
+    scan->allZeros = false;
+    if (scan->function == UDS_CHUNK_NAME_XXH3) {
+      XXH3_128bits_zeros(&scan->hash.xxh3, scan->zeroBytes);
+    } else {
+      MurmurHash3_x64_128_zeros(&scan->hash.murmur, scan->zeroBytes);
+    }
+  }
+
+  if (scan->function == UDS_CHUNK_NAME_XXH3) {
+    XXH3_128bits_copy(&scan->hash.xxh3, source, scan->next, length);
+  } else {
+    MurmurHash3_x64_128_copy(&scan->hash.murmur, source, scan->next, length);
+  }
+  scan->next += length;
+}
+
+/**********************************************************************/
+bool finishBlockScan(BlockScan *scan, void *hash)
+{
+  unsigned int size = scan->next - scan->start;
+  if ((scan->function == UDS_CHUNK_NAME_XXH3) && (size <= XXH3_MIDSIZE_MAX)) {
+    // Incremental XXH3 only handles long keys.
+    scan->streaming = false;
+  }
+
+  if (!scan->streaming) {
+    if (isAllZeros(scan->start, size)) {
+      return true;
+    }
+    if (scan->function == UDS_CHUNK_NAME_XXH3) {
+      XXH3_128bits(scan->start, size, hash);
+    } else {
+      MurmurHash3_x64_128(scan->start, size, scan->seed, hash);
+    }
+    return false;
+  }
+
+  if (scan->allZeros) {
+    return true;
+  }
+  if (scan->function == UDS_CHUNK_NAME_XXH3) {
+    XXH3_128bits_finish(&scan->hash.xxh3, hash);
+  } else {
+    MurmurHash3_x64_128_finish(&scan->hash.murmur, hash);
+  }
+  return false;
+}
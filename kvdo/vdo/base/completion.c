@@ -42,6 +42,7 @@ static const char *VDO_COMPLETION_TYPE_NAMES[] = {
   "GENERATION_FLUSHED_COMPLETION",
   "HEARTBEAT_COMPLETION",
   "LOCK_COUNTER_COMPLETION",
+  "PACKER_COMPLETION",
   "PARTITION_COPY_COMPLETION",
   "READ_ONLY_MODE_COMPLETION",
   "READ_ONLY_REBUILD_COMPLETION",
@@ -151,6 +152,19 @@ void invokeCallback(VDOCompletion *completion)
   runCallback(completion);
 }
 
+/**********************************************************************/
+bool invokeCallbackDelayed(VDOCompletion *completion, uint64_t delay)
+{
+  if ((completion->enqueueable == NULL)
+      || (completion->layer->enqueueDelayed == NULL)) {
+    return false;
+  }
+
+  completion->requeue = false;
+  completion->layer->enqueueDelayed(completion->enqueueable, delay);
+  return true;
+}
+
 /**********************************************************************/
 void continueCompletion(VDOCompletion *completion, int result)
 {
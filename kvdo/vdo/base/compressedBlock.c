@@ -29,13 +29,21 @@ static const VersionNumber COMPRESSED_BLOCK_1_0 = {
   .minorVersion = 0,
 };
 
+static const VersionNumber COMPRESSED_BLOCK_2_0 = {
+  .majorVersion = 2,
+  .minorVersion = 0,
+};
+
 /**********************************************************************/
-void resetCompressedBlockHeader(CompressedBlockHeader *header)
+void resetCompressedBlock(CompressedBlock *block)
 {
+  CompressedBlockHeader *header = &block->header;
   STATIC_ASSERT(sizeof(header->fields) == sizeof(header->raw));
+  STATIC_ASSERT(COMPRESSION_CODEC_LZ4 == 0);
 
-  header->fields.version = packVersionNumber(COMPRESSED_BLOCK_1_0);
+  header->fields.version = packVersionNumber(COMPRESSED_BLOCK_2_0);
   memset(header->fields.sizes, 0, sizeof(header->fields.sizes));
+  memset(block->codecs, 0, sizeof(block->codecs));
 }
 
 /**********************************************************************/
@@ -45,31 +53,89 @@ getCompressedFragmentSize(const CompressedBlockHeader *header, byte slot)
   return getUInt16LE(header->fields.sizes[slot]);
 }
 
+/**
+ * Find the extent of the compression unit containing a slot of a version 2.0
+ * compressed block.
+ *
+ * @param [in]  block     the compressed block
+ * @param [in]  slot      the slot
+ * @param [out] headPtr   the slot holding the unit's data
+ * @param [out] blocksPtr the number of blocks in the unit
+ *
+ * @return VDO_SUCCESS or VDO_INVALID_FRAGMENT
+ **/
+static int findCompressionUnit(const CompressedBlock *block,
+                               byte                   slot,
+                               byte                  *headPtr,
+                               uint8_t               *blocksPtr)
+{
+  byte head = slot;
+  while (block->codecs[head] == COMPRESSED_UNIT_CONTINUATION) {
+    if (getCompressedFragmentSize(&block->header, head) != 0) {
+      return VDO_INVALID_FRAGMENT;
+    }
+
+    if (head == 0) {
+      return VDO_INVALID_FRAGMENT;
+    }
+
+    head--;
+  }
+
+  uint8_t blocks = 1;
+  while (((head + blocks) < MAX_COMPRESSION_SLOTS)
+         && (block->codecs[head + blocks] == COMPRESSED_UNIT_CONTINUATION)) {
+    blocks++;
+  }
+
+  *headPtr   = head;
+  *blocksPtr = blocks;
+  return VDO_SUCCESS;
+}
+
 /**********************************************************************/
-int getCompressedBlockFragment(BlockMappingState  mappingState,
-                               char              *buffer,
-                               BlockSize          blockSize,
-                               uint16_t          *fragmentOffset,
-                               uint16_t          *fragmentSize)
+int getCompressedBlockFragment(BlockMappingState   mappingState,
+                               char               *buffer,
+                               BlockSize           blockSize,
+                               CompressedFragment *fragment)
 {
   if (!isCompressed(mappingState)) {
     return VDO_INVALID_FRAGMENT;
   }
 
-  CompressedBlockHeader *header = (CompressedBlockHeader *) buffer;
-  VersionNumber version = unpackVersionNumber(header->fields.version);
-  if (!areSameVersion(version, COMPRESSED_BLOCK_1_0)) {
+  byte slot = getSlotFromState(mappingState);
+  if (slot >= MAX_COMPRESSION_SLOTS) {
     return VDO_INVALID_FRAGMENT;
   }
 
-  byte slot = getSlotFromState(mappingState);
-  if (slot >= MAX_COMPRESSION_SLOTS) {
+  CompressedBlockHeader *header = (CompressedBlockHeader *) buffer;
+  VersionNumber version = unpackVersionNumber(header->fields.version);
+  uint16_t offset;
+  CompressionCodec codec;
+  byte head = slot;
+  uint8_t unitBlocks = 1;
+  if (areSameVersion(version, COMPRESSED_BLOCK_1_0)) {
+    // Version 1.0 blocks predate codec tags; all their fragments are LZ4.
+    offset = sizeof(CompressedBlockHeader);
+    codec  = COMPRESSION_CODEC_LZ4;
+  } else if (areSameVersion(version, COMPRESSED_BLOCK_2_0)) {
+    CompressedBlock *block = (CompressedBlock *) buffer;
+    int result = findCompressionUnit(block, slot, &head, &unitBlocks);
+    if (result != VDO_SUCCESS) {
+      return result;
+    }
+
+    offset = offsetof(CompressedBlock, data);
+    codec  = block->codecs[head];
+    if (codec >= COMPRESSION_CODEC_COUNT) {
+      return VDO_INVALID_FRAGMENT;
+    }
+  } else {
     return VDO_INVALID_FRAGMENT;
   }
 
-  uint16_t compressedSize = getCompressedFragmentSize(header, slot);
-  uint16_t offset         = sizeof(CompressedBlockHeader);
-  for (unsigned int i = 0; i < slot; i++) {
+  uint16_t compressedSize = getCompressedFragmentSize(header, head);
+  for (unsigned int i = 0; i < head; i++) {
     offset += getCompressedFragmentSize(header, i);
     if (offset >= blockSize) {
       return VDO_INVALID_FRAGMENT;
@@ -80,18 +146,47 @@ int getCompressedBlockFragment(BlockMappingState  mappingState,
     return VDO_INVALID_FRAGMENT;
   }
 
-  *fragmentOffset = offset;
-  *fragmentSize   = compressedSize;
+  *fragment = (CompressedFragment) {
+    .offset     = offset,
+    .size       = compressedSize,
+    .codec      = codec,
+    .unitBlocks = unitBlocks,
+    .unitIndex  = slot - head,
+  };
   return VDO_SUCCESS;
 }
 
 /**********************************************************************/
-void putCompressedBlockFragment(CompressedBlock *block,
-                                unsigned int     fragment,
-                                uint16_t         offset,
-                                const char      *data,
-                                uint16_t         size)
+void putCompressedBlockFragment(CompressedBlock  *block,
+                                unsigned int      fragment,
+                                uint16_t          offset,
+                                const char       *data,
+                                uint16_t          size,
+                                CompressionCodec  codec)
 {
   storeUInt16LE(block->header.fields.sizes[fragment], size);
+  block->codecs[fragment] = codec;
   memcpy(&block->data[offset], data, size);
 }
+
+/**********************************************************************/
+void putCompressedBlockContinuation(CompressedBlock *block,
+                                    unsigned int     fragment)
+{
+  storeUInt16LE(block->header.fields.sizes[fragment], 0);
+  block->codecs[fragment] = COMPRESSED_UNIT_CONTINUATION;
+}
+
+/**********************************************************************/
+void finishCompressedBlock(CompressedBlock *block, size_t dataSize)
+{
+  for (unsigned int i = 0; i < MAX_COMPRESSION_SLOTS; i++) {
+    if (block->codecs[i] != COMPRESSION_CODEC_LZ4) {
+      return;
+    }
+  }
+
+  // Drop the codec table, moving the fragment data up to follow the header.
+  block->header.fields.version = packVersionNumber(COMPRESSED_BLOCK_1_0);
+  memmove(block->codecs, block->data, dataSize);
+}
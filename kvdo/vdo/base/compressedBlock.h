@@ -27,6 +27,11 @@
 
 /**
  * The header of a compressed block.
+ *
+ * A version 1.0 block consists of this header followed immediately by the
+ * fragment data, and every fragment in it was compressed with LZ4. A version
+ * 2.0 block follows this header with a table recording the codec of each
+ * fragment, and then the fragment data (see CompressedBlock).
  **/
 typedef union __attribute__((packed)) {
   struct __attribute__((packed)) {
@@ -50,42 +55,70 @@ typedef union __attribute__((packed)) {
 #endif
 } CompressedBlockHeader;
 
+enum {
+  /**
+   * Set in place of a codec for a slot which holds no data of its own, but
+   * stands for the next block of a multi-block compression unit. A unit is
+   * stored as a fragment holding the whole compressed unit, followed by one
+   * such slot for each additional block in the unit.
+   **/
+  COMPRESSED_UNIT_CONTINUATION = 0x80,
+};
+
 /**
- * The compressed block overlay.
+ * The compressed block overlay, in the version 2.0 layout used while a
+ * block is being packed.
  **/
 typedef struct {
   CompressedBlockHeader header;
+  /** The CompressionCodec of each fragment */
+  byte                  codecs[MAX_COMPRESSION_SLOTS];
   char                  data[];
 } __attribute__((packed)) CompressedBlock;
 
 /**
- * Initializes/resets a compressed block header.
+ * A description of the compressed data for one slot of a compressed block.
+ **/
+typedef struct {
+  /** The offset of the compressed data within the compressed block */
+  uint16_t         offset;
+  /** The size of the compressed data */
+  uint16_t         size;
+  /** The codec which compressed the data */
+  CompressionCodec codec;
+  /** The number of blocks compressed together in the data (usually 1) */
+  uint8_t          unitBlocks;
+  /** The position of the slot's block within the uncompressed data */
+  uint8_t          unitIndex;
+} CompressedFragment;
+
+/**
+ * Initializes/resets a compressed block for packing.
  *
- * @param header        the header
+ * @param block  the compressed block
  *
  * When done, the version number is set to the current version, and all
  * fragments are empty.
  **/
-void resetCompressedBlockHeader(CompressedBlockHeader *header);
+void resetCompressedBlock(CompressedBlock *block);
 
 /**
- * Get a reference to a compressed fragment from a compression block.
+ * Get a reference to a compressed fragment from a compression block. If the
+ * slot is part of a multi-block compression unit, the reference is to the
+ * fragment holding the whole unit.
  *
  * @param [in]  mappingState    the mapping state for the look up
  * @param [in]  buffer          buffer that contains compressed data
  * @param [in]  blockSize       size of a data block
- * @param [out] fragmentOffset  the offset of the fragment within a
- *                              compressed block
- * @param [out] fragmentSize    the size of the fragment
+ * @param [out] fragment        the description of the fragment
  *
  * @return If a valid compressed fragment is found, VDO_SUCCESS;
  *         otherwise, VDO_INVALID_FRAGMENT if the fragment is invalid.
  **/
-int getCompressedBlockFragment(BlockMappingState  mappingState,
-                               char              *buffer,
-                               BlockSize          blockSize,
-                               uint16_t          *fragmentOffset,
-                               uint16_t          *fragmentSize);
+int getCompressedBlockFragment(BlockMappingState   mappingState,
+                               char               *buffer,
+                               BlockSize           blockSize,
+                               CompressedFragment *fragment);
 
 /**
  * Copy a fragment into the compressed block.
@@ -95,13 +128,35 @@ int getCompressedBlockFragment(BlockMappingState  mappingState,
  * @param offset     the byte offset of the fragment in the data area
  * @param data       a pointer to the compressed data
  * @param size       the size of the data
+ * @param codec      the codec which compressed the data
  *
  * @note no bounds checking -- the data better fit without smashing other stuff
  **/
-void putCompressedBlockFragment(CompressedBlock *block,
-                                unsigned int     fragment,
-                                uint16_t         offset,
-                                const char      *data,
-                                uint16_t         size);
+void putCompressedBlockFragment(CompressedBlock  *block,
+                                unsigned int      fragment,
+                                uint16_t          offset,
+                                const char       *data,
+                                uint16_t          size,
+                                CompressionCodec  codec);
+
+/**
+ * Mark a slot of the compressed block as standing for the next block of the
+ * compression unit whose fragment is in a preceding slot.
+ *
+ * @param block      the compressed block
+ * @param fragment   the number of the slot
+ **/
+void putCompressedBlockContinuation(CompressedBlock *block,
+                                    unsigned int     fragment);
+
+/**
+ * Prepare a packed compressed block to be written. If every fragment in the
+ * block was compressed with LZ4, the block is rewritten in the version 1.0
+ * format, which older releases can also read.
+ *
+ * @param block     the compressed block
+ * @param dataSize  the number of bytes of fragment data in the block
+ **/
+void finishCompressedBlock(CompressedBlock *block, size_t dataSize);
 
 #endif // COMPRESSED_BLOCK_H
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/base/compressionHistory.c#1 $
+ */
+
+#include "compressionHistory.h"
+
+#include "logger.h"
+#include "memoryAlloc.h"
+
+#include "atomic.h"
+#include "constants.h"
+
+enum {
+  /** The number of regions tracked; more distant regions share entries */
+  REGION_COUNT          = 4096,
+  /** The number of compression attempts judged together */
+  HISTORY_WINDOW        = 32,
+  /** One write in this many to a bypassing region is compressed anyway */
+  PROBE_INTERVAL        = 16,
+  /** The most bypassing regions to log in a dump */
+  MAX_DUMPED_REGIONS    = 32,
+};
+
+/** The compression history of one region. */
+typedef struct {
+  /** The writes to the region which were eligible for compression */
+  Atomic64   hits;
+  /** The writes to the region which bypassed compression */
+  Atomic64   bypassed;
+  /** The attempts in the region which compressed well enough to be packed */
+  Atomic64   compressible;
+  /** The compression attempts in the current window */
+  Atomic32   attempts;
+  /** The attempts in the current window which did not compress */
+  Atomic32   failures;
+  /** The writes to the region since it began bypassing compression */
+  Atomic32   writes;
+  /** Whether writes to the region are bypassing compression */
+  AtomicBool bypassing;
+} CompressionRegion;
+
+struct compressionHistory {
+  /** The percentage of failed attempts at which a region is bypassed */
+  unsigned int      threshold;
+  /** The number of times a region began bypassing compression */
+  Atomic64          bypassesStarted;
+  /** The number of writes which bypassed compression */
+  Atomic64          blocksBypassed;
+  /** The number of writes compressed to probe a bypassing region */
+  Atomic64          probes;
+  /** The history of each region */
+  CompressionRegion regions[REGION_COUNT];
+};
+
+/**********************************************************************/
+int makeCompressionHistory(unsigned int          threshold,
+                           CompressionHistory  **historyPtr)
+{
+  CompressionHistory *history;
+  int result = ALLOCATE(1, CompressionHistory, __func__, &history);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  history->threshold = threshold;
+  *historyPtr        = history;
+  return VDO_SUCCESS;
+}
+
+/**********************************************************************/
+void freeCompressionHistory(CompressionHistory **historyPtr)
+{
+  FREE(*historyPtr);
+  *historyPtr = NULL;
+}
+
+/**
+ * Get the number of the region table entry which tracks a logical block.
+ *
+ * @param lbn  The logical block number
+ *
+ * @return The index of the entry for the block's region
+ **/
+static inline unsigned int getRegionIndex(LogicalBlockNumber lbn)
+{
+  return (lbn / BLOCK_MAP_ENTRIES_PER_PAGE) % REGION_COUNT;
+}
+
+/**********************************************************************/
+bool shouldBypassCompression(CompressionHistory *history,
+                             LogicalBlockNumber  lbn)
+{
+  if (history == NULL) {
+    return false;
+  }
+
+  CompressionRegion *region = &history->regions[getRegionIndex(lbn)];
+  atomicAdd64(&region->hits, 1);
+  if (!atomicLoadBool(&region->bypassing)) {
+    return false;
+  }
+
+  if ((atomicAdd32(&region->writes, 1) % PROBE_INTERVAL) == 0) {
+    // Compress this write to find out whether the region has recovered.
+    atomicAdd64(&history->probes, 1);
+    return false;
+  }
+
+  atomicAdd64(&region->bypassed, 1);
+  atomicAdd64(&history->blocksBypassed, 1);
+  return true;
+}
+
+/**********************************************************************/
+void recordCompressionResult(CompressionHistory *history,
+                             LogicalBlockNumber  lbn,
+                             bool                compressed)
+{
+  if (history == NULL) {
+    return;
+  }
+
+  CompressionRegion *region = &history->regions[getRegionIndex(lbn)];
+  if (compressed) {
+    atomicAdd64(&region->compressible, 1);
+  } else {
+    atomicAdd32(&region->failures, 1);
+  }
+
+  uint32_t attempts = atomicAdd32(&region->attempts, 1);
+  if ((attempts < HISTORY_WINDOW)
+      || !compareAndSwap32(&region->attempts, attempts, 0)) {
+    // The window isn't full, or another thread has just closed it.
+    return;
+  }
+
+  // Results recorded concurrently with closing the window may be counted in
+  // either window, which is good enough for a heuristic.
+  uint32_t failures = atomicLoad32(&region->failures);
+  atomicAdd32(&region->failures, -((int32_t) failures));
+  bool bypass = ((failures * 100) >= (attempts * history->threshold));
+  if (bypass == atomicLoadBool(&region->bypassing)) {
+    return;
+  }
+
+  if (bypass) {
+    atomicStore32(&region->writes, 0);
+    atomicAdd64(&history->bypassesStarted, 1);
+  }
+  atomicStoreBool(&region->bypassing, bypass);
+}
+
+/**
+ * Get the statistics of one region.
+ *
+ * @param history  The compression history
+ * @param index    The index of the region
+ *
+ * @return The statistics of the region
+ **/
+static CompressionRegionStatistics
+getRegionStatistics(const CompressionHistory *history, unsigned int index)
+{
+  const CompressionRegion *region = &history->regions[index];
+  return (CompressionRegionStatistics) {
+    .region       = index,
+    .hits         = relaxedLoad64(&region->hits),
+    .bypassed     = relaxedLoad64(&region->bypassed),
+    .compressible = relaxedLoad64(&region->compressible),
+  };
+}
+
+/**
+ * Add a region to the regions reported in the statistics if it is one of the
+ * busiest seen so far.
+ *
+ * @param stats        The statistics, whose regions are sorted by hits
+ * @param regionStats  The statistics of the region
+ **/
+static void reportRegion(CompressionBypassStatistics *stats,
+                         CompressionRegionStatistics  regionStats)
+{
+  unsigned int slot = COMPRESSION_REGIONS_REPORTED;
+  while ((slot > 0) && (stats->regions[slot - 1].hits < regionStats.hits)) {
+    if (slot < COMPRESSION_REGIONS_REPORTED) {
+      stats->regions[slot] = stats->regions[slot - 1];
+    }
+    slot--;
+  }
+
+  if (slot < COMPRESSION_REGIONS_REPORTED) {
+    stats->regions[slot] = regionStats;
+  }
+}
+
+/**
+ * Count the regions of a compression history which are bypassing compression.
+ *
+ * @param history  The compression history
+ *
+ * @return The number of bypassing regions
+ **/
+static uint64_t countBypassingRegions(const CompressionHistory *history)
+{
+  uint64_t count = 0;
+  for (unsigned int i = 0; i < REGION_COUNT; i++) {
+    if (relaxedLoadBool(&history->regions[i].bypassing)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**********************************************************************/
+void getCompressionBypassStatistics(const CompressionHistory    *history,
+                                    CompressionBypassStatistics *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+  if (history == NULL) {
+    return;
+  }
+
+  for (unsigned int i = 0; i < REGION_COUNT; i++) {
+    reportRegion(stats, getRegionStatistics(history, i));
+  }
+
+  stats->regionsBypassing = countBypassingRegions(history);
+  stats->bypassesStarted  = relaxedLoad64(&history->bypassesStarted);
+  stats->blocksBypassed   = relaxedLoad64(&history->blocksBypassed);
+  stats->probes           = relaxedLoad64(&history->probes);
+}
+
+/**********************************************************************/
+void dumpCompressionHistory(const CompressionHistory *history)
+{
+  if (history == NULL) {
+    return;
+  }
+
+  logInfo("Compression history: threshold=%u%% regionsBypassing=%" PRIu64
+          " bypassesStarted=%" PRIu64 " blocksBypassed=%" PRIu64
+          " probes=%" PRIu64, history->threshold,
+          countBypassingRegions(history),
+          relaxedLoad64(&history->bypassesStarted),
+          relaxedLoad64(&history->blocksBypassed),
+          relaxedLoad64(&history->probes));
+
+  unsigned int dumped = 0;
+  for (unsigned int i = 0; i < REGION_COUNT; i++) {
+    const CompressionRegion *region = &history->regions[i];
+    if (!relaxedLoadBool(&region->bypassing)) {
+      continue;
+    }
+
+    if (dumped++ == MAX_DUMPED_REGIONS) {
+      logInfo("  ...");
+      break;
+    }
+
+    CompressionRegionStatistics regionStats = getRegionStatistics(history, i);
+    logInfo("  region %u (lowest LBN %" PRIu64 ") bypassing: hits=%" PRIu64
+            " bypassed=%" PRIu64 " compressible=%" PRIu64 " writes=%u"
+            " window=%u/%u failed", i,
+            (uint64_t) i * BLOCK_MAP_ENTRIES_PER_PAGE, regionStats.hits,
+            regionStats.bypassed, regionStats.compressible,
+            relaxedLoad32(&region->writes),
+            relaxedLoad32(&region->failures),
+            relaxedLoad32(&region->attempts));
+  }
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/base/compressionHistory.h#1 $
+ */
+
+#ifndef COMPRESSION_HISTORY_H
+#define COMPRESSION_HISTORY_H
+
+#include "statistics.h"
+#include "types.h"
+
+/**
+ * A CompressionHistory tracks how well the data written to each region of
+ * the logical address space has been compressing, so that writes to regions
+ * whose data has stopped compressing can skip the compressor and the packer
+ * entirely. A region is the range of logical blocks covered by one block map
+ * leaf page; regions are hashed into a fixed table, so distant regions may
+ * occasionally share history.
+ *
+ * A region starts bypassing compression when too many of a window of recent
+ * attempts did not compress well enough to be packed. While it is bypassing,
+ * a regular fraction of its writes are still compressed as probes, and the
+ * region resumes compressing once a window of probes does better.
+ *
+ * All operations may be called concurrently from any thread.
+ **/
+typedef struct compressionHistory CompressionHistory;
+
+/**
+ * Make a compression history.
+ *
+ * @param [in]  threshold   The percentage of recent compression attempts in a
+ *                          region which must fail for the region to bypass
+ *                          compression; must be between 1 and 100
+ * @param [out] historyPtr  A pointer to hold the new history
+ *
+ * @return VDO_SUCCESS or an error
+ **/
+int makeCompressionHistory(unsigned int          threshold,
+                           CompressionHistory  **historyPtr)
+  __attribute__((warn_unused_result));
+
+/**
+ * Free a compression history and null out the reference to it.
+ *
+ * @param historyPtr  A pointer to the history to free
+ **/
+void freeCompressionHistory(CompressionHistory **historyPtr);
+
+/**
+ * Check whether a write should skip compression because the region it is in
+ * has not been compressing well.
+ *
+ * @param history  The compression history, which may be NULL if no history
+ *                 is being kept
+ * @param lbn      The logical block being written
+ *
+ * @return <code>true</code> if the write should not be compressed
+ **/
+bool shouldBypassCompression(CompressionHistory *history,
+                             LogicalBlockNumber  lbn)
+  __attribute__((warn_unused_result));
+
+/**
+ * Record the outcome of compressing a write.
+ *
+ * @param history     The compression history, which may be NULL if no
+ *                    history is being kept
+ * @param lbn         The logical block which was compressed
+ * @param compressed  Whether the block compressed well enough to be packed
+ **/
+void recordCompressionResult(CompressionHistory *history,
+                             LogicalBlockNumber  lbn,
+                             bool                compressed);
+
+/**
+ * Get the statistics of a compression history, including the counts of the
+ * regions with the most writes.
+ *
+ * @param [in]  history  The compression history, which may be NULL if no
+ *                       history is being kept
+ * @param [out] stats    The statistics to fill in
+ **/
+void getCompressionBypassStatistics(const CompressionHistory    *history,
+                                    CompressionBypassStatistics *stats);
+
+/**
+ * Dump the regions of a compression history which are bypassing compression
+ * to the log for debugging.
+ *
+ * @param history  The compression history, which may be NULL
+ **/
+void dumpCompressionHistory(const CompressionHistory *history);
+
+#endif /* COMPRESSION_HISTORY_H */
@@ -190,3 +190,59 @@ bool cancelCompression(DataVIO *dataVIO)
 
   return ((state.status == VIO_PACKING) && !state.mayNotCompress);
 }
+
+/**********************************************************************/
+void addToCompressionUnit(DataVIO *leader, DataVIO *member)
+{
+  CompressionState *unit = &leader->compression;
+  if (unit->unitBlocks == 0) {
+    unit->unitBlocks = 1;
+  }
+
+  DataVIO **tailPtr = &unit->unitNext;
+  while (*tailPtr != NULL) {
+    tailPtr = &(*tailPtr)->compression.unitNext;
+  }
+
+  member->compression.unitIndex  = unit->unitBlocks++;
+  member->compression.unitLeader = leader;
+  member->compression.unitNext   = NULL;
+  *tailPtr = member;
+}
+
+/**********************************************************************/
+void removeFromCompressionUnit(DataVIO *member)
+{
+  DataVIO  *leader    = member->compression.unitLeader;
+  DataVIO **memberPtr = &leader->compression.unitNext;
+  while (*memberPtr != member) {
+    memberPtr = &(*memberPtr)->compression.unitNext;
+  }
+
+  *memberPtr = member->compression.unitNext;
+  member->compression.unitLeader = NULL;
+  member->compression.unitNext   = NULL;
+}
+
+/**********************************************************************/
+DataVIO *removeFirstCompressionUnitMember(DataVIO *leader)
+{
+  DataVIO *member = leader->compression.unitNext;
+  if (member != NULL) {
+    removeFromCompressionUnit(member);
+  }
+  return member;
+}
+
+/**********************************************************************/
+uint8_t getCompressionUnitBlocks(const DataVIO *dataVIO)
+{
+  return ((dataVIO->compression.unitBlocks == 0)
+          ? 1 : dataVIO->compression.unitBlocks);
+}
+
+/**********************************************************************/
+bool isCompressionUnitMember(const DataVIO *dataVIO)
+{
+  return (dataVIO->compression.unitLeader != NULL);
+}
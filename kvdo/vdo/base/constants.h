@@ -60,6 +60,9 @@ enum {
   /** The maximum number of physical zones */
   MAX_PHYSICAL_ZONES                               = 16,
 
+  /** The maximum number of packer zones */
+  MAX_PACKER_ZONES                                 = 16,
+
   /** The base-2 logarithm of the maximum blocks in one slab */
   MAX_SLAB_BITS                                    = 23,
 
@@ -387,8 +387,8 @@ static void waitOnHashLock(HashLock *lock, DataVIO *dataVIO)
      * wait queue link isn't used for sending the message.
      */
     dataVIO->compression.lockHolder = lock->agent;
-    launchPackerCallback(dataVIO, removeLockHolderFromPacker,
-                         THIS_LOCATION("$F;cb=removeLockHolderFromPacker"));
+    launchLockHolderCallback(dataVIO, removeLockHolderFromPacker,
+                             THIS_LOCATION("$F;cb=removeLockHolderFromPacker"));
   }
 }
 
@@ -616,7 +616,11 @@ static void finishUpdating(VDOCompletion *completion)
 
   // UDS was updated successfully, so don't update again unless the
   // duplicate location changes due to rollover.
-  lock->updateAdvice = false;
+  lock->updateAdvice  = false;
+  lock->indexAnswered = agent->indexAnswered;
+  if (lock->indexAnswered) {
+    cacheAdvice(agent->hashZone, &lock->hash, lock->duplicate);
+  }
 
   if (hasWaiters(&lock->waiters)) {
     /*
@@ -660,6 +664,7 @@ static void startUpdating(HashLock *lock, DataVIO *agent)
   ASSERT_LOG_ONLY(lock->updateAdvice, "should only update advice if needed");
 
   agent->lastAsyncOperation = UPDATE_INDEX;
+  agent->indexAnswered      = false;
   setHashZoneCallback(agent, finishUpdating, THIS_LOCATION(NULL));
   dataVIOAsCompletion(agent)->layer->updateAlbireo(agent);
 }
@@ -878,6 +883,12 @@ static void finishVerifying(VDOCompletion *completion)
   }
 
   if (lock->verified) {
+    if (!lock->updateAdvice && lock->indexAnswered) {
+      // The index holds this advice, so writes of the same data may skip
+      // asking it again. Advice which came from the cache is not cached
+      // again, so that the name is still sent to the index now and then.
+      cacheAdvice(agent->hashZone, &lock->hash, lock->duplicate);
+    }
     /*
      * VERIFYING -> DEDUPING transition: The advice is for a true duplicate,
      * so start deduplicating against it, if references are available.
@@ -891,6 +902,7 @@ static void finishVerifying(VDOCompletion *completion)
      * the data will have to be written or compressed, but first the advice
      * PBN must be unlocked by the VERIFYING agent.
      */
+    forgetCachedAdvice(agent->hashZone, &lock->hash);
     lock->updateAdvice = true;
     startUnlocking(lock, agent);
   }
@@ -955,6 +967,7 @@ static void finishLocking(VDOCompletion *completion)
      * remembering to update UDS later with the new advice.
      */
     bumpHashZoneStaleAdviceCount(agent->hashZone);
+    forgetCachedAdvice(agent->hashZone, &lock->hash);
     lock->updateAdvice = true;
     startWriting(lock, agent);
     return;
@@ -1173,6 +1186,13 @@ static void finishWriting(HashLock *lock, DataVIO *agent)
     return;
   }
 
+  if (!lock->updateAdvice && lock->indexAnswered) {
+    // The block was written where the UDS query said it would be, so that is
+    // the advice UDS now holds for it. If UDS never answered the query, as
+    // when the request was shed or timed out, that isn't known.
+    cacheAdvice(agent->hashZone, &lock->hash, lock->duplicate);
+  }
+
   // There are no waiters and the agent has successfully written, so take a
   // step towards being able to release the hash lock (or just release it).
   if (lock->updateAdvice) {
@@ -1320,6 +1340,7 @@ static void finishQuerying(VDOCompletion *completion)
     return;
   }
 
+  lock->indexAnswered = agent->indexAnswered;
   if (agent->isDuplicate) {
     lock->duplicate = agent->duplicate;
     /*
@@ -1353,8 +1374,22 @@ static void startQuerying(HashLock *lock, DataVIO *dataVIO)
   setAgent(lock, dataVIO);
   setHashLockState(lock, HASH_LOCK_QUERYING);
 
+  ZonedPBN advice;
+  if (getCachedAdvice(dataVIO->hashZone, &lock->hash, &advice)) {
+    setDuplicateLocation(dataVIO, advice);
+    lock->duplicate = advice;
+    /*
+     * QUERYING -> LOCKING transition: Recently confirmed advice was cached,
+     * so skip the UDS query. The advice is verified just like advice from
+     * UDS, and if it proves stale, the lock will update UDS later.
+     */
+    startLocking(lock, dataVIO);
+    return;
+  }
+
   VDOCompletion *completion   = dataVIOAsCompletion(dataVIO);
   dataVIO->lastAsyncOperation = CHECK_FOR_DEDUPLICATION;
+  dataVIO->indexAnswered      = false;
   setHashZoneCallback(dataVIO, finishQuerying, THIS_LOCATION(NULL));
   completion->layer->checkForDuplication(dataVIO);
 }
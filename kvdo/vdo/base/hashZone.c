@@ -39,6 +39,13 @@
 
 enum {
   LOCK_POOL_CAPACITY = MAXIMUM_USER_VIOS,
+  /** The number of entries in each zone's advice cache (a power of two) */
+  ADVICE_CACHE_SIZE  = 4096,
+  /**
+   * The number of writes an advice cache entry may answer before the next
+   * is sent to the index, which refreshes the name in the index as well
+   **/
+  ADVICE_CACHE_REFRESH_HITS = 16,
 };
 
 /**
@@ -57,8 +64,29 @@ typedef struct atomicHashLockStatistics {
 
   /** Number of writes whose hash collided with an in-flight write */
   Atomic64 concurrentHashCollisions;
+
+  /** Number of index queries answered by the advice cache */
+  Atomic64 adviceCacheHits;
+
+  /** Number of index queries which had to be sent to the index */
+  Atomic64 adviceCacheMisses;
 } AtomicHashLockStatistics;
 
+/**
+ * An entry in the advice cache, remembering the location of a block which
+ * the index also holds as the advice for its chunk name.
+ **/
+typedef struct {
+  /** The chunk name of the block */
+  UdsChunkName name;
+  /** The location of the block */
+  ZonedPBN     location;
+  /** The number of hits since the index last confirmed the advice */
+  unsigned int hits;
+  /** True if the entry is in use */
+  bool         valid;
+} AdviceCacheEntry;
+
 struct hashZone {
   /** Which hash zone this is */
   ZoneCount zoneNumber;
@@ -77,6 +105,12 @@ struct hashZone {
 
   /** Array of all HashLocks */
   HashLock *lockArray;
+
+  /**
+   * A direct-mapped cache of recently confirmed dedupe advice, so that
+   * writes of hot duplicates need not query the index
+   **/
+  AdviceCacheEntry *adviceCache;
 };
 
 /**
@@ -102,6 +136,23 @@ static uint32_t hashKey(const void *key)
   return getUInt32LE(&name->name[4]);
 }
 
+/**
+ * Find the advice cache entry which may hold a chunk name.
+ *
+ * @param zone  The hash zone
+ * @param name  The chunk name
+ *
+ * @return The only entry in which the chunk name may be cached
+ **/
+static AdviceCacheEntry *getAdviceCacheEntry(const HashZone     *zone,
+                                             const UdsChunkName *name)
+{
+  // Use a fragment of the chunk name which isn't used by the zone selection
+  // or by the lock map.
+  uint32_t index = getUInt32LE(&name->name[12]) & (ADVICE_CACHE_SIZE - 1);
+  return &zone->adviceCache[index];
+}
+
 /**********************************************************************/
 static inline HashLock *asHashLock(RingNode *poolNode)
 {
@@ -145,6 +196,13 @@ int makeHashZone(VDO *vdo, ZoneCount zoneNumber, HashZone **zonePtr)
     pushRingNode(&zone->lockPool, &lock->poolNode);
   }
 
+  result = ALLOCATE(ADVICE_CACHE_SIZE, AdviceCacheEntry, "advice cache",
+                    &zone->adviceCache);
+  if (result != VDO_SUCCESS) {
+    freeHashZone(&zone);
+    return result;
+  }
+
   *zonePtr = zone;
   return VDO_SUCCESS;
 }
@@ -159,6 +217,7 @@ void freeHashZone(HashZone **zonePtr)
   HashZone *zone = *zonePtr;
   freePointerMap(&zone->hashLockMap);
   FREE(zone->lockArray);
+  FREE(zone->adviceCache);
   FREE(zone);
   *zonePtr = NULL;
 }
@@ -185,6 +244,8 @@ HashLockStatistics getHashZoneStatistics(const HashZone *zone)
     .concurrentDataMatches = relaxedLoad64(&atoms->concurrentDataMatches),
     .concurrentHashCollisions
       = relaxedLoad64(&atoms->concurrentHashCollisions),
+    .adviceCacheHits       = relaxedLoad64(&atoms->adviceCacheHits),
+    .adviceCacheMisses     = relaxedLoad64(&atoms->adviceCacheMisses),
   };
 }
 
@@ -310,6 +371,49 @@ static void dumpHashLock(const HashLock *lock)
           (void *) lock->agent);
 }
 
+/**********************************************************************/
+bool getCachedAdvice(HashZone           *zone,
+                     const UdsChunkName *name,
+                     ZonedPBN           *advice)
+{
+  AdviceCacheEntry *entry = getAdviceCacheEntry(zone, name);
+  if (!entry->valid
+      || (memcmp(&entry->name, name, sizeof(UdsChunkName)) != 0)
+      || (entry->hits >= ADVICE_CACHE_REFRESH_HITS)) {
+    // Even a hot name must go to the index now and then, since the index
+    // only keeps a name which it is asked about.
+    relaxedAdd64(&zone->statistics.adviceCacheMisses, 1);
+    return false;
+  }
+
+  entry->hits++;
+  relaxedAdd64(&zone->statistics.adviceCacheHits, 1);
+  *advice = entry->location;
+  return true;
+}
+
+/**********************************************************************/
+void cacheAdvice(HashZone           *zone,
+                 const UdsChunkName *name,
+                 ZonedPBN            location)
+{
+  AdviceCacheEntry *entry = getAdviceCacheEntry(zone, name);
+  entry->name     = *name;
+  entry->location = location;
+  entry->hits     = 0;
+  entry->valid    = true;
+}
+
+/**********************************************************************/
+void forgetCachedAdvice(HashZone *zone, const UdsChunkName *name)
+{
+  AdviceCacheEntry *entry = getAdviceCacheEntry(zone, name);
+  if (entry->valid
+      && (memcmp(&entry->name, name, sizeof(UdsChunkName)) == 0)) {
+    entry->valid = false;
+  }
+}
+
 /**********************************************************************/
 void bumpHashZoneValidAdviceCount(HashZone *zone)
 {
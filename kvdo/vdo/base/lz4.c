@@ -116,6 +116,16 @@
 #  define LZ4_FORCE_UNALIGNED_ACCESS 1
 #endif
 
+// LZ4_FAST_DECODE :
+// Decode short sequences with fixed-size word copies (16 bytes of literals, 24 bytes of match)
+// instead of length-driven copy loops, whenever both buffers have enough room left.
+// This is only a win where unaligned 64-bit loads and stores are cheap.
+// Define LZ4_NO_FAST_DECODE to build the general path alone, as the tests do to compare against it.
+#if LZ4_ARCH64 && (defined(__x86_64__) || defined(__aarch64__) || defined(LZ4_FORCE_UNALIGNED_ACCESS)) \
+  && !defined(LZ4_NO_FAST_DECODE)
+#  define LZ4_FAST_DECODE 1
+#endif
+
 // Define this parameter if your target system or compiler does not support hardware bit count
 #if defined(_MSC_VER) && defined(_WIN32_WCE)            // Visual Studio for Windows CE does not support Hardware bit count
 #  define LZ4_FORCE_SW_BITCOUNT
@@ -223,6 +233,10 @@ typedef struct _U64_S { U64 v; } U64_S;
 #define LASTLITERALS 5
 #define MFLIMIT (COPYLENGTH+MINMATCH)
 #define MINLENGTH (MFLIMIT+1)
+#define FASTLITERALS 16                                         // Literals copied by the fast decode path
+#define FASTMATCH 24                                            // Match bytes copied by the fast decode path
+#define FASTINPUT (FASTLITERALS+COPYLENGTH)                     // Input needed to try the fast decode path
+#define FASTOUTPUT (RUN_MASK-1+FASTMATCH+COPYLENGTH)            // Output room needed to try the fast decode path
 
 #define MAXD_LOG 16
 #define MAX_DISTANCE ((1 << MAXD_LOG) - 1)
@@ -821,6 +835,26 @@ int LZ4_uncompress_unknownOutputSize(
 
         // get runlength
         token = *ip++;
+#ifdef LZ4_FAST_DECODE
+        // Fast path: a short literal run and a short match, far from the end of both buffers,
+        // are copied with a fixed number of word copies. Anything else uses the general path.
+        length = token>>ML_BITS;
+        if ((length != RUN_MASK) && (ip+FASTINPUT <= iend) && (op+FASTOUTPUT <= oend))
+        {
+            A64(op) = A64(ip); A64(op+8) = A64(ip+8);
+            op += length; ip += length;
+
+            LZ4_READ_LITTLEENDIAN_16(ref,op,ip); ip+=2;
+            length = token&ML_MASK;
+            if ((length != ML_MASK) && (op-ref >= STEPSIZE) && (ref >= (BYTE* const)dest))
+            {
+                A64(op) = A64(ref); A64(op+8) = A64(ref+8); A64(op+16) = A64(ref+16);
+                op += length+MINMATCH;
+                continue;
+            }
+            goto _copy_match;
+        }
+#endif
         if ((length=(token>>ML_BITS)) == RUN_MASK) { int s=255; while ((ip<iend) && (s==255)) { s=*ip++; length += s; } }
 
         // copy literals
@@ -837,10 +871,14 @@ int LZ4_uncompress_unknownOutputSize(
 
         // get offset
         LZ4_READ_LITTLEENDIAN_16(ref,cpy,ip); ip+=2;
+        length = token&ML_MASK;
+#ifdef LZ4_FAST_DECODE
+_copy_match:
+#endif
         if (ref < (BYTE* const)dest) goto _output_error;   // Error : offset creates reference outside of destination buffer
 
         // get matchlength
-        if ((length=(token&ML_MASK)) == ML_MASK) { while (ip<iend) { int s = *ip++; length +=s; if (s==255) continue; break; } }
+        if (length == ML_MASK) { while (ip<iend) { int s = *ip++; length +=s; if (s==255) continue; break; } }
 
         // copy repeated sequence
         if (unlikely(op-ref<STEPSIZE))
@@ -32,6 +32,14 @@
 #include "vdo.h"
 #include "vdoInternal.h"
 
+/**
+ * The upper bounds, in microseconds, of all but the last bucket of the
+ * histogram of packer residence times.
+ **/
+static const uint64_t RESIDENCE_BUCKET_LIMITS[] = {
+  100, 1000, 10000, 100000, 1000000,
+};
+
 /**
  * Check that we are on the packer thread.
  *
@@ -44,6 +52,21 @@ static inline void assertOnPackerThread(Packer *packer, const char *caller)
                   "%s() called from packer thread", caller);
 }
 
+/**
+ * Convert a generic VDOCompletion to a Packer.
+ *
+ * @param completion  The completion to convert
+ *
+ * @return The completion as a Packer
+ **/
+__attribute__((warn_unused_result))
+static inline Packer *asPacker(VDOCompletion *completion)
+{
+  STATIC_ASSERT(offsetof(Packer, completion) == 0);
+  assertCompletionType(completion->type, PACKER_COMPLETION);
+  return (Packer *) completion;
+}
+
 /**********************************************************************/
 __attribute__((warn_unused_result))
 static inline InputBin *inputBinFromRingNode(RingNode *node)
@@ -179,6 +202,7 @@ static int makeOutputBin(Packer *packer, PhysicalLayer *layer)
   initializeRing(&output->ring);
   pushRingNode(&packer->outputBins, &output->ring);
   pushOutputBin(packer, output);
+  output->packer = packer;
 
   result = ALLOCATE_EXTENDED(CompressedBlock, packer->binDataSize, char,
                              "compressed block", &output->block);
@@ -213,9 +237,14 @@ static void freeOutputBin(OutputBin **binPtr)
 
 /**********************************************************************/
 int makePacker(PhysicalLayer       *layer,
+               ZoneCount            zoneNumber,
+               Packer              *nextPacker,
                BlockCount           inputBinCount,
                BlockCount           outputBinCount,
                const ThreadConfig  *threadConfig,
+               uint64_t             maxAge,
+               PackerAgePolicy      agePolicy,
+               bool                 codecTable,
                Packer             **packerPtr)
 {
   Packer *packer;
@@ -225,11 +254,40 @@ int makePacker(PhysicalLayer       *layer,
     return result;
   }
 
-  packer->threadID       = getPackerZoneThread(threadConfig);
-  packer->binDataSize    = VDO_BLOCK_SIZE - sizeof(CompressedBlockHeader);
+  result = initializeEnqueueableCompletion(&packer->completion,
+                                           PACKER_COMPLETION, layer);
+  if (result != VDO_SUCCESS) {
+    freePacker(&packer);
+    return result;
+  }
+
+  result = initializeEnqueueableCompletion(&packer->flushCompletion,
+                                           PACKER_COMPLETION, layer);
+  if (result != VDO_SUCCESS) {
+    freePacker(&packer);
+    return result;
+  }
+
+  result = initializeEnqueueableCompletion(&packer->ageCompletion,
+                                           PACKER_COMPLETION, layer);
+  if (result != VDO_SUCCESS) {
+    freePacker(&packer);
+    return result;
+  }
+
+  packer->zoneNumber     = zoneNumber;
+  packer->nextPacker     = nextPacker;
+  packer->threadID       = getPackerZoneThread(threadConfig, zoneNumber);
+  packer->codecTable     = codecTable;
+  packer->binDataSize    = (VDO_BLOCK_SIZE
+                            - (codecTable
+                               ? sizeof(CompressedBlock)
+                               : sizeof(CompressedBlockHeader)));
   packer->size           = inputBinCount;
   packer->maxSlots       = MAX_COMPRESSION_SLOTS;
   packer->outputBinCount = outputBinCount;
+  packer->maxAge         = maxAge;
+  packer->agePolicy      = agePolicy;
   initializeRing(&packer->inputBins);
   initializeRing(&packer->outputBins);
 
@@ -286,6 +344,9 @@ void freePacker(Packer **packerPtr)
     freeOutputBin(&output);
   }
 
+  destroyEnqueueable(&packer->completion);
+  destroyEnqueueable(&packer->flushCompletion);
+  destroyEnqueueable(&packer->ageCompletion);
   FREE(packer);
   *packerPtr = NULL;
 }
@@ -295,26 +356,39 @@ void freePacker(Packer **packerPtr)
  *
  * @param dataVIO  The DataVIO
  *
- * @return The Packer from the VDO to which the DataVIO belongs
+ * @return The packer zone to which the DataVIO has been sent
  **/
 static inline Packer *getPackerFromDataVIO(DataVIO *dataVIO)
 {
-  return getVDOFromDataVIO(dataVIO)->packer;
+  return dataVIO->compression.packer;
 }
 
 /**********************************************************************/
 bool isSufficientlyCompressible(DataVIO *dataVIO)
 {
   Packer *packer = getPackerFromDataVIO(dataVIO);
+  if (!packer->codecTable
+      && ((dataVIO->compression.codec != COMPRESSION_CODEC_LZ4)
+          || (getCompressionUnitBlocks(dataVIO) > 1))) {
+    // Without the codec table, only single LZ4 fragments can be recorded.
+    return false;
+  }
+
   return (dataVIO->compression.size < packer->binDataSize);
 }
 
 /**********************************************************************/
-ThreadID getPackerThreadID(Packer *packer)
+ThreadID getPackerThreadID(const Packer *packer)
 {
   return packer->threadID;
 }
 
+/**********************************************************************/
+Packer *getNextPacker(const Packer *packer)
+{
+  return packer->nextPacker;
+}
+
 /**********************************************************************/
 PackerStatistics getPackerStatistics(const Packer *packer)
 {
@@ -323,20 +397,38 @@ PackerStatistics getPackerStatistics(const Packer *packer)
    * packer thread. These are just statistics with no semantics that could
    * rely on memory order, so unfenced reads are sufficient.
    */
+  STATIC_ASSERT(COUNT_OF(RESIDENCE_BUCKET_LIMITS)
+                == (PACKER_RESIDENCE_BUCKET_COUNT - 1));
+  const Atomic64 *residence = packer->residence;
   return (PackerStatistics) {
     .compressedFragmentsWritten  = relaxedLoad64(&packer->fragmentsWritten),
     .compressedBlocksWritten     = relaxedLoad64(&packer->blocksWritten),
     .compressedFragmentsInPacker = relaxedLoad64(&packer->fragmentsPending),
+    .binsAgedOut                 = relaxedLoad64(&packer->binsAgedOut),
+    .residence                   = {
+      .under100us = relaxedLoad64(&residence[0]),
+      .under1ms   = relaxedLoad64(&residence[1]),
+      .under10ms  = relaxedLoad64(&residence[2]),
+      .under100ms = relaxedLoad64(&residence[3]),
+      .under1s    = relaxedLoad64(&residence[4]),
+      .atLeast1s  = relaxedLoad64(&residence[5]),
+    },
   };
 }
 
 /**
- * Abort packing a DataVIO.
+ * Abort packing a DataVIO, along with any members of the compression unit it
+ * leads.
  *
  * @param dataVIO     The DataVIO to abort
  **/
 static void abortPacking(DataVIO *dataVIO)
 {
+  DataVIO *member;
+  while ((member = removeFirstCompressionUnitMember(dataVIO)) != NULL) {
+    abortPacking(member);
+  }
+
   setCompressionDone(dataVIO);
   relaxedAdd64(&getPackerFromDataVIO(dataVIO)->fragmentsPending, -1);
   dataVIOAddTraceRecord(dataVIO, THIS_LOCATION(NULL));
@@ -356,6 +448,18 @@ static void continueVIOWithoutPacking(Waiter *waiter,
   abortPacking(waiterAsDataVIO(waiter));
 }
 
+/**
+ * Close the next packer zone. This callback is registered in
+ * checkFlushProgress().
+ *
+ * @param completion  The zone which has just closed as a completion
+ **/
+static void closeNextPacker(VDOCompletion *completion)
+{
+  Packer *packer = asPacker(completion);
+  closePacker(packer->nextPacker, completion->parent);
+}
+
 /**
  * This checks if all VIOs are out of the packer before finishing the
  * completion.
@@ -371,10 +475,21 @@ static void checkFlushProgress(Packer *packer)
   }
 
   packer->flushing = false;
-  if (packer->closeRequest != NULL) {
-    packer->closed = true;
+  if ((packer->closeRequest == NULL) || packer->closed) {
+    return;
+  }
+
+  packer->closed = true;
+  if (packer->nextPacker == NULL) {
+    // This is the last zone, so finish the close request.
     finishCompletion(packer->closeRequest, VDO_SUCCESS);
+    return;
   }
+
+  // This is not the last zone, so pass the close request on to the next.
+  launchCallbackWithParent(&packer->completion, closeNextPacker,
+                           packer->nextPacker->threadID,
+                           packer->closeRequest);
 }
 
 /**********************************************************************/
@@ -390,8 +505,8 @@ static void writePendingBatches(Packer *packer);
 __attribute__((warn_unused_result))
 static bool switchToPackerThread(VDOCompletion *completion)
 {
-  VIO      *vio      = asVIO(completion);
-  ThreadID  threadID = vio->vdo->packer->threadID;
+  OutputBin *bin      = completion->parent;
+  ThreadID   threadID = bin->packer->threadID;
   if (completion->callbackThreadID == threadID) {
     return true;
   }
@@ -443,8 +558,9 @@ static void completeOutputBin(VDOCompletion *completion)
                        vio->physical);
   }
 
-  Packer *packer = vio->vdo->packer;
-  finishOutputBin(packer, completion->parent);
+  OutputBin *bin    = completion->parent;
+  Packer    *packer = bin->packer;
+  finishOutputBin(packer, bin);
   writePendingBatches(packer);
   checkFlushProgress(packer);
 }
@@ -574,13 +690,15 @@ static void getNextBatch(Packer *packer, OutputBatch *batch)
 {
   BlockSize spaceRemaining = packer->binDataSize;
   batch->slotsUsed         = 0;
+  batch->dataVIOCount      = 0;
 
   DataVIO *dataVIO;
   while ((dataVIO = waiterAsDataVIO(getFirstWaiter(&packer->batchedDataVIOs)))
          != NULL) {
     // If there's not enough space for the next DataVIO, the batch is done.
+    SlotNumber slotsNeeded = getCompressionUnitBlocks(dataVIO);
     if ((dataVIO->compression.size > spaceRemaining)
-        || (batch->slotsUsed == packer->maxSlots)) {
+        || ((batch->slotsUsed + slotsNeeded) > packer->maxSlots)) {
       break;
     }
 
@@ -588,9 +706,38 @@ static void getNextBatch(Packer *packer, OutputBatch *batch)
     dequeueNextWaiter(&packer->batchedDataVIOs);
     batch->slots[batch->slotsUsed++]  = dataVIO;
     spaceRemaining                   -= dataVIO->compression.size;
+    batch->dataVIOCount++;
+
+    // Reserve the rest of the slots of a compression unit for its members.
+    for (SlotNumber i = 1; i < slotsNeeded; i++) {
+      batch->slots[batch->slotsUsed++] = NULL;
+    }
+    for (DataVIO *member = dataVIO->compression.unitNext;
+         member != NULL;
+         member = member->compression.unitNext) {
+      batch->dataVIOCount++;
+    }
   }
 }
 
+/**
+ * Add a DataVIO which has been put in a compressed block to the DataVIOs
+ * waiting for the block to be written.
+ *
+ * @param output   The output bin holding the compressed block
+ * @param dataVIO  The DataVIO
+ **/
+static void addToOutputBin(OutputBin *output, DataVIO *dataVIO)
+{
+  int result = enqueueDataVIO(&output->outgoing, dataVIO, THIS_LOCATION(NULL));
+  if (result != VDO_SUCCESS) {
+    abortPacking(dataVIO);
+    return;
+  }
+
+  output->slotsUsed += 1;
+}
+
 /**
  * Pack the next batch of compressed VIOs from the batched queue into an
  * output bin and write the output bin.
@@ -613,32 +760,39 @@ static bool writeNextBatch(Packer *packer, OutputBin *output)
 
   // If the batch contains only a single VIO, then we save nothing by saving
   // the compressed form. Continue processing the single VIO in the batch.
-  if (batch.slotsUsed == 1) {
+  if (batch.dataVIOCount == 1) {
     abortPacking(batch.slots[0]);
     return false;
   }
 
-  resetCompressedBlockHeader(&output->block->header);
+  resetCompressedBlock(output->block);
 
   size_t spaceUsed = 0;
   for (SlotNumber slot = 0; slot < batch.slotsUsed; slot++) {
     DataVIO *dataVIO = batch.slots[slot];
+    if (dataVIO == NULL) {
+      // This slot stands for a block of the unit in a preceding slot.
+      putCompressedBlockContinuation(output->block, slot);
+      continue;
+    }
+
     dataVIO->compression.slot = slot;
     putCompressedBlockFragment(output->block, slot, spaceUsed,
                                dataVIO->compression.data,
-                               dataVIO->compression.size);
+                               dataVIO->compression.size,
+                               dataVIO->compression.codec);
     spaceUsed += dataVIO->compression.size;
+    addToOutputBin(output, dataVIO);
 
-    int result = enqueueDataVIO(&output->outgoing, dataVIO,
-                                THIS_LOCATION(NULL));
-    if (result != VDO_SUCCESS) {
-      abortPacking(dataVIO);
-      continue;
+    // Each member of a compression unit maps to the slot for its own block.
+    DataVIO *member;
+    while ((member = removeFirstCompressionUnitMember(dataVIO)) != NULL) {
+      member->compression.slot = slot + member->compression.unitIndex;
+      addToOutputBin(output, member);
     }
-
-    output->slotsUsed += 1;
   }
 
+  finishCompressedBlock(output->block, spaceUsed);
   launchCompressedWrite(packer, output);
   return true;
 }
@@ -657,19 +811,96 @@ static void addToInputBin(InputBin *bin, DataVIO *dataVIO)
 }
 
 /**
- * Start a new batch of VIOs in an InputBin, moving the existing batch, if
- * any, to the queue of pending batched VIOs in the packer.
+ * Take any members of a compression unit whose compression has been canceled
+ * out of the unit, and put them in the canceled bin so that they can
+ * rendezvous with the canceling DataVIOs. The remaining members may be
+ * written compressed.
  *
  * @param packer  The packer
- * @param bin     The bin to prepare
+ * @param leader  The leader of the unit
  **/
-static void startNewBatch(Packer *packer, InputBin *bin)
+static void removeCanceledUnitMembers(Packer *packer, DataVIO *leader)
 {
-  // Move all the DataVIOs in the current batch to the batched queue so they
-  // will get packed into the next free output bin.
+  DataVIO *member = leader->compression.unitNext;
+  while (member != NULL) {
+    DataVIO *next = member->compression.unitNext;
+    member->compression.bin = NULL;
+    if (!mayWriteCompressedDataVIO(member)) {
+      removeFromCompressionUnit(member);
+      addToInputBin(packer->canceledBin, member);
+    }
+    member = next;
+  }
+}
+
+/**
+ * Break up the compression unit led by a DataVIO which will not be written
+ * compressed. Canceled members are left to rendezvous with their cancelers
+ * and the others continue without packing.
+ *
+ * @param packer  The packer
+ * @param leader  The leader of the unit
+ **/
+static void dissolveCompressionUnit(Packer *packer, DataVIO *leader)
+{
+  removeCanceledUnitMembers(packer, leader);
+
+  DataVIO *member;
+  while ((member = removeFirstCompressionUnitMember(leader)) != NULL) {
+    abortPacking(member);
+  }
+}
+
+/**
+ * Get the time a DataVIO has spent waiting in an input bin.
+ *
+ * @param arrival  When the DataVIO was put in the bin
+ * @param now      The current time
+ *
+ * @return The time waited, in microseconds
+ **/
+__attribute__((warn_unused_result))
+static uint64_t getBinResidence(AbsTime arrival, AbsTime now)
+{
+  int64_t residence = relTimeToMicroseconds(timeDifference(now, arrival));
+  return ((residence < 0) ? 0 : residence);
+}
+
+/**
+ * Record in the residence histogram how long a DataVIO waited in an input
+ * bin before leaving it.
+ *
+ * @param packer   The packer
+ * @param dataVIO  The DataVIO which is leaving its bin
+ * @param now      The current time
+ **/
+static void recordBinResidence(Packer *packer, DataVIO *dataVIO, AbsTime now)
+{
+  uint64_t residence = getBinResidence(dataVIO->compression.binArrival, now);
+  unsigned int bucket = 0;
+  while ((bucket < COUNT_OF(RESIDENCE_BUCKET_LIMITS))
+         && (residence >= RESIDENCE_BUCKET_LIMITS[bucket])) {
+    bucket++;
+  }
+
+  relaxedAdd64(&packer->residence[bucket], 1);
+}
+
+/**
+ * Empty an InputBin, moving the DataVIOs in its current batch to a queue.
+ * Any which have been canceled are moved to the canceled bin instead.
+ *
+ * @param packer  The packer
+ * @param bin     The bin to empty
+ * @param queue   The queue to which to move the batch
+ **/
+static void moveBatchToQueue(Packer *packer, InputBin *bin, WaitQueue *queue)
+{
+  AbsTime now = currentTime(CT_MONOTONIC);
   for (SlotNumber slot = 0; slot < bin->slotsUsed; slot++) {
     DataVIO *dataVIO = bin->incoming[slot];
     dataVIO->compression.bin = NULL;
+    recordBinResidence(packer, dataVIO, now);
 
     if (!mayWriteCompressedDataVIO(dataVIO)) {
       /*
@@ -677,12 +908,14 @@ static void startNewBatch(Packer *packer, InputBin *bin)
        * in the canceled bin so it can be rendezvous with the canceling
        * DataVIO.
        */
+      dissolveCompressionUnit(packer, dataVIO);
       addToInputBin(packer->canceledBin, dataVIO);
       continue;
     }
 
-    int result = enqueueDataVIO(&packer->batchedDataVIOs, dataVIO,
-                                THIS_LOCATION(NULL));
+    removeCanceledUnitMembers(packer, dataVIO);
+
+    int result = enqueueDataVIO(queue, dataVIO, THIS_LOCATION(NULL));
     if (result != VDO_SUCCESS) {
       // Impossible but we're required to check the result from enqueue.
       abortPacking(dataVIO);
@@ -690,8 +923,46 @@ static void startNewBatch(Packer *packer, InputBin *bin)
   }
 
   // The bin is now empty.
-  bin->slotsUsed = 0;
-  bin->freeSpace = packer->binDataSize;
+  bin->slotsUsed     = 0;
+  bin->fragmentSlots = 0;
+  bin->freeSpace     = packer->binDataSize;
+}
+
+/**
+ * Start a new batch of VIOs in an InputBin, moving the existing batch, if
+ * any, to the queue of pending batched VIOs in the packer.
+ *
+ * @param packer  The packer
+ * @param bin     The bin to prepare
+ **/
+static void startNewBatch(Packer *packer, InputBin *bin)
+{
+  // Move all the DataVIOs in the current batch to the batched queue so they
+  // will get packed into the next free output bin.
+  moveBatchToQueue(packer, bin, &packer->batchedDataVIOs);
+}
+
+/**********************************************************************/
+static void releaseAgedBins(VDOCompletion *completion);
+
+/**
+ * Arrange to check for input bins which have reached the maximum age, unless
+ * a check is already pending. If the layer can't delay the check, bins are
+ * only released as they fill or are flushed.
+ *
+ * @param packer  The packer
+ * @param delay   How long to wait before checking, in microseconds
+ **/
+static void scheduleAgeCheck(Packer *packer, uint64_t delay)
+{
+  if (packer->ageCheckScheduled) {
+    return;
+  }
+
+  setCallbackWithParent(&packer->ageCompletion, releaseAgedBins,
+                        packer->threadID, packer);
+  packer->ageCheckScheduled = invokeCallbackDelayed(&packer->ageCompletion,
+                                                    delay);
 }
 
 /**
@@ -707,15 +978,28 @@ static void addDataVIOToInputBin(Packer   *packer,
                                  DataVIO  *dataVIO)
 {
   // If the selected bin doesn't have room, start a new batch to make room.
-  if (bin->freeSpace < dataVIO->compression.size) {
+  SlotNumber slotsNeeded = getCompressionUnitBlocks(dataVIO);
+  if ((bin->freeSpace < dataVIO->compression.size)
+      || ((bin->fragmentSlots + slotsNeeded) > packer->maxSlots)) {
     startNewBatch(packer, bin);
   }
 
+  AbsTime now = currentTime(CT_MONOTONIC);
+  dataVIO->compression.binArrival = now;
+  if (bin->slotsUsed == 0) {
+    // This starts a new batch, so the bin's maximum age starts now.
+    bin->oldestArrival = now;
+    if (packer->maxAge > 0) {
+      scheduleAgeCheck(packer, packer->maxAge);
+    }
+  }
+
   addToInputBin(bin, dataVIO);
-  bin->freeSpace -= dataVIO->compression.size;
+  bin->freeSpace     -= dataVIO->compression.size;
+  bin->fragmentSlots += slotsNeeded;
 
   // If we happen to exactly fill the bin, start a new input batch.
-  if ((bin->slotsUsed == packer->maxSlots) || (bin->freeSpace == 0)) {
+  if ((bin->fragmentSlots >= packer->maxSlots) || (bin->freeSpace == 0)) {
     startNewBatch(packer, bin);
   }
 
@@ -769,11 +1053,19 @@ static void writePendingBatches(Packer *packer)
 __attribute__((warn_unused_result))
 static InputBin *selectInputBin(Packer *packer, DataVIO *dataVIO)
 {
+  // A compression unit with more blocks than a compressed block has slots
+  // can't be packed at all.
+  SlotNumber slotsNeeded = getCompressionUnitBlocks(dataVIO);
+  if (slotsNeeded > packer->maxSlots) {
+    return NULL;
+  }
+
   // First best fit: select the bin with the least free space that has enough
   // room for the compressed data in the DataVIO.
   InputBin *fullestBin = getFullestBin(packer);
   for (InputBin *bin = fullestBin; bin != NULL; bin = nextBin(packer, bin)) {
-    if (bin->freeSpace >= dataVIO->compression.size) {
+    if ((bin->freeSpace >= dataVIO->compression.size)
+        && ((bin->fragmentSlots + slotsNeeded) <= packer->maxSlots)) {
       return bin;
     }
   }
@@ -815,9 +1107,15 @@ void attemptPacking(DataVIO *dataVIO)
 
   /*
    * Increment whether or not this DataVIO will be packed or not since
-   * abortPacking() always decrements the counter.
+   * abortPacking() always decrements the counter. The same goes for the
+   * members of any compression unit this DataVIO leads.
    */
   relaxedAdd64(&packer->fragmentsPending, 1);
+  for (DataVIO *member = dataVIO->compression.unitNext;
+       member != NULL;
+       member = member->compression.unitNext) {
+    relaxedAdd64(&packer->fragmentsPending, 1);
+  }
 
   // If packing of this DataVIO is disallowed for administrative reasons, give
   // up before making any state changes.
@@ -845,6 +1143,19 @@ void attemptPacking(DataVIO *dataVIO)
     return;
   }
 
+  // The members of a compression unit wait in the packer with their leader.
+  DataVIO *member = dataVIO->compression.unitNext;
+  while (member != NULL) {
+    DataVIO *next = member->compression.unitNext;
+    if (mayBlockInPacker(member)) {
+      member->compression.bin = bin;
+    } else {
+      removeFromCompressionUnit(member);
+      abortPacking(member);
+    }
+    member = next;
+  }
+
   addDataVIOToInputBin(packer, bin, dataVIO);
   writePendingBatches(packer);
 }
@@ -872,6 +1183,79 @@ void flushPacker(Packer *packer)
   checkFlushProgress(packer);
 }
 
+/**
+ * Flush a packer on its own thread. This callback is registered in
+ * requestPackerFlush().
+ *
+ * @param completion  The packer's flush request completion
+ **/
+static void flushPackerCallback(VDOCompletion *completion)
+{
+  Packer *packer = completion->parent;
+  atomicStoreBool(&packer->flushRequested, false);
+  flushPacker(packer);
+}
+
+/**********************************************************************/
+void requestPackerFlush(Packer *packer)
+{
+  if (!compareAndSwapBool(&packer->flushRequested, false, true)) {
+    // A flush has already been requested and has not started yet.
+    return;
+  }
+
+  launchCallbackWithParent(&packer->flushCompletion, flushPackerCallback,
+                           packer->threadID, packer);
+}
+
+/**
+ * Release every input bin whose current batch has waited for at least the
+ * maximum age, and arrange to check again when the next remaining batch will
+ * reach it. This callback is registered in scheduleAgeCheck().
+ *
+ * @param completion  The packer's age check completion
+ **/
+static void releaseAgedBins(VDOCompletion *completion)
+{
+  Packer *packer = completion->parent;
+  assertOnPackerThread(packer, __func__);
+  packer->ageCheckScheduled = false;
+
+  WaitQueue abandoned;
+  initializeWaitQueue(&abandoned);
+  WaitQueue *releaseQueue
+    = ((packer->agePolicy == PACKER_AGE_POLICY_WRITE)
+       ? &packer->batchedDataVIOs : &abandoned);
+
+  AbsTime  now       = currentTime(CT_MONOTONIC);
+  uint64_t nextCheck = 0;
+  InputBin *bin      = getFullestBin(packer);
+  while (bin != NULL) {
+    InputBin *next = nextBin(packer, bin);
+    if (bin->slotsUsed > 0) {
+      uint64_t age = getBinResidence(bin->oldestArrival, now);
+      if (age >= packer->maxAge) {
+        moveBatchToQueue(packer, bin, releaseQueue);
+        relaxedAdd64(&packer->binsAgedOut, 1);
+        // An empty bin has the most free space, so it sorts last.
+        pushRingNode(&packer->inputBins, &bin->ring);
+      } else if ((nextCheck == 0) || ((packer->maxAge - age) < nextCheck)) {
+        nextCheck = packer->maxAge - age;
+      }
+    }
+    bin = next;
+  }
+
+  // Schedule the next check before any DataVIOs are continued, since they
+  // may re-enter the packer if they are continued on this thread.
+  if (nextCheck > 0) {
+    scheduleAgeCheck(packer, nextCheck);
+  }
+
+  writePendingBatches(packer);
+  notifyAllWaiters(&abandoned, continueVIOWithoutPacking, NULL);
+}
+
 /*
  * This method is only exposed for unit tests and should not normally be called
  * directly; use removeLockHolderFromPacker() instead.
@@ -881,6 +1265,16 @@ void removeFromPacker(DataVIO *dataVIO)
   InputBin *bin    = dataVIO->compression.bin;
   ASSERT_LOG_ONLY((bin != NULL), "DataVIO in packer has an input bin");
 
+  Packer *packer = getPackerFromDataVIO(dataVIO);
+  if (isCompressionUnitMember(dataVIO)) {
+    // The rest of the unit stays in its bin; this block's slot will go unused.
+    removeFromCompressionUnit(dataVIO);
+    dataVIO->compression.bin = NULL;
+    abortPacking(dataVIO);
+    checkFlushProgress(packer);
+    return;
+  }
+
   SlotNumber slot = dataVIO->compression.slot;
   bin->slotsUsed--;
   if (slot < bin->slotsUsed) {
@@ -891,12 +1285,14 @@ void removeFromPacker(DataVIO *dataVIO)
   dataVIO->compression.bin  = NULL;
   dataVIO->compression.slot = 0;
 
-  Packer *packer = getPackerFromDataVIO(dataVIO);
   if (bin != packer->canceledBin) {
-    bin->freeSpace += dataVIO->compression.size;
+    recordBinResidence(packer, dataVIO, currentTime(CT_MONOTONIC));
+    bin->freeSpace     += dataVIO->compression.size;
+    bin->fragmentSlots -= getCompressionUnitBlocks(dataVIO);
     insertInSortedList(packer, bin);
   }
 
+  dissolveCompressionUnit(packer, dataVIO);
   abortPacking(dataVIO);
   checkFlushProgress(packer);
 }
@@ -904,10 +1300,10 @@ void removeFromPacker(DataVIO *dataVIO)
 /**********************************************************************/
 void removeLockHolderFromPacker(VDOCompletion *completion)
 {
-  DataVIO *dataVIO = asDataVIO(completion);
-  assertInPackerZone(dataVIO);
+  DataVIO *dataVIO    = asDataVIO(completion);
+  DataVIO *lockHolder = dataVIO->compression.lockHolder;
+  assertInPackerZone(lockHolder);
 
-  DataVIO *lockHolder             = dataVIO->compression.lockHolder;
   dataVIO->compression.lockHolder = NULL;
   removeFromPacker(lockHolder);
 }
@@ -975,12 +1371,17 @@ static void dumpOutputBin(const OutputBin *bin)
 /**********************************************************************/
 void dumpPacker(const Packer *packer)
 {
-  logInfo("Packer");
+  logInfo("Packer %u", packer->zoneNumber);
   logInfo("  flushGeneration=%" PRIu64
           " flushing=%s closed=%s writingBatches=%s",
           packer->flushGeneration, boolToString(packer->flushing),
           boolToString(packer->closed), boolToString(packer->writingBatches));
 
+  logInfo("  maxAge=%" PRIu64 " agePolicy=%s ageCheckScheduled=%s",
+          packer->maxAge,
+          ((packer->agePolicy == PACKER_AGE_POLICY_WRITE)
+           ? "write" : "uncompressed"),
+          boolToString(packer->ageCheckScheduled));
   logInfo("  inputBinCount=%" PRIu64, packer->size);
   for (InputBin *bin = getFullestBin(packer);
        bin != NULL;
@@ -318,6 +318,17 @@ typedef void EnqueueableDestructor(Enqueueable **enqueueablePtr);
  **/
 typedef void Enqueuer(Enqueueable *enqueueable);
 
+/**
+ * A function to enqueue the Enqueueable object to run on the thread specified
+ * by its associated completion once a delay has passed. The delay may be
+ * rounded up to the granularity of the layer's timers. Only one delayed
+ * Enqueueable should be outstanding for any thread at a time.
+ *
+ * @param enqueueable  The object to be enqueued
+ * @param delay        The minimum time to wait, in microseconds
+ **/
+typedef void DelayedEnqueuer(Enqueueable *enqueueable, uint64_t delay);
+
 /**
  * A function to wait for an admin operation to complete. This function should
  * not be called from a base-code thread.
@@ -393,6 +404,7 @@ struct physicalLayer {
   EnqueueableCreator        *createEnqueueable;
   EnqueueableDestructor     *destroyEnqueueable;
   Enqueuer                  *enqueue;
+  DelayedEnqueuer           *enqueueDelayed;
   OperationWaiter           *waitForAdminOperation;
   OperationComplete         *completeAdminOperation;
 
@@ -30,13 +30,14 @@ struct threadConfig {
   ZoneCount    logicalZoneCount;
   ZoneCount    physicalZoneCount;
   ZoneCount    hashZoneCount;
+  ZoneCount    packerZoneCount;
   ThreadCount  baseThreadCount;
   ThreadID     adminThread;
   ThreadID     journalThread;
-  ThreadID     packerThread;
   ThreadID    *logicalThreads;
   ThreadID    *physicalThreads;
   ThreadID    *hashZoneThreads;
+  ThreadID    *packerThreads;
 };
 
 /**
@@ -47,6 +48,9 @@ struct threadConfig {
  * @param [in]  logicalZoneCount    The number of logical zones
  * @param [in]  physicalZoneCount   The number of physical zones
  * @param [in]  hashZoneCount       The number of hash zones
+ * @param [in]  packerZoneCount     The number of packer zones, which must be
+ *                                  at least one; this is ignored for a one
+ *                                  thread configuration
  * @param [out] configPtr           A pointer to hold the new thread
  *                                  configuration
  *
@@ -55,6 +59,7 @@ struct threadConfig {
 int makeThreadConfig(ZoneCount      logicalZoneCount,
                      ZoneCount      physicalZoneCount,
                      ZoneCount      hashZoneCount,
+                     ZoneCount      packerZoneCount,
                      ThreadConfig **configPtr)
   __attribute__((warn_unused_result));
 
@@ -162,16 +167,20 @@ static inline ThreadID getJournalZoneThread(const ThreadConfig *threadConfig)
 }
 
 /**
- * Get the thread id for the packer zone.
+ * Get the thread id for a given packer zone.
  *
  * @param threadConfig  the thread config
+ * @param packerZone    the number of the packer zone
  *
- * @return the thread id for the packer zone
+ * @return the thread id for the given zone
  **/
 __attribute__((warn_unused_result))
-static inline ThreadID getPackerZoneThread(const ThreadConfig *threadConfig)
+static inline ThreadID getPackerZoneThread(const ThreadConfig *threadConfig,
+                                           ZoneCount           packerZone)
 {
-  return threadConfig->packerThread;
+  ASSERT_LOG_ONLY((packerZone < threadConfig->packerZoneCount),
+                  "packer zone valid");
+  return threadConfig->packerThreads[packerZone];
 }
 
 /**
@@ -25,6 +25,7 @@
 #include "vdo.h"
 
 #include "atomic.h"
+#include "compressionHistory.h"
 #include "header.h"
 #include "packer.h"
 #include "readOnlyModeContextInternals.h"
@@ -79,10 +80,12 @@ struct vdo {
   /* The slab depot */
   SlabDepot            *depot;
 
-  /* The compressed-block packer */
-  Packer               *packer;
+  /* The compressed-block packer zones of this VDO */
+  Packer              **packers;
   /* Whether incoming data should be compressed */
   AtomicBool            compressing;
+  /* How well each logical region has been compressing, if tracked */
+  CompressionHistory   *compressionHistory;
 
   /* The handler for flush requests */
   Flusher              *flusher;
@@ -370,6 +373,18 @@ void assertOnLogicalZoneThread(const VDO  *vdo,
 HashZone *selectHashZone(const VDO *vdo, const UdsChunkName *name)
   __attribute__((warn_unused_result));
 
+/**
+ * Select the packer zone which will pack the compressed form of the block
+ * with a given chunk name.
+ *
+ * @param vdo   The VDO containing the packer zones
+ * @param name  The chunk name
+ *
+ * @return  The packer zone responsible for the chunk name
+ **/
+Packer *selectPacker(const VDO *vdo, const UdsChunkName *name)
+  __attribute__((warn_unused_result));
+
 /**
  * Get the physical zone responsible for a given physical block number of a
  * data block in this VDO instance, or of the zero block (for which a NULL
@@ -54,6 +54,20 @@ static const Header GEOMETRY_BLOCK_HEADER_4_0 = {
   },
   // Note: this size isn't just the payload size following the header, like it
   // is everywhere else in VDO.
+  .size = sizeof(GeometryBlock) - sizeof(uint8_t),
+};
+
+/**
+ * Version 5.0 adds the chunk name hash to the index config. It is only
+ * written for volumes which don't use the original hash, so that all other
+ * volumes can still be loaded by older versions.
+ **/
+static const Header GEOMETRY_BLOCK_HEADER_5_0 = {
+  .id = GEOMETRY_BLOCK,
+  .version = {
+    .majorVersion = 5,
+    .minorVersion = 0,
+  },
   .size = sizeof(GeometryBlock),
 };
 
@@ -89,12 +103,15 @@ static inline bool isLoadableReleaseVersion(ReleaseVersionNumber version)
 /**
  * Decode the on-disk representation of an index configuration from a buffer.
  *
- * @param buffer  A buffer positioned at the start of the encoding
- * @param config  The structure to receive the decoded fields
+ * @param buffer            A buffer positioned at the start of the encoding
+ * @param config            The structure to receive the decoded fields
+ * @param hasChunkNameHash  Whether the encoding includes the chunk name hash
  *
  * @return UDS_SUCCESS or an error
  **/
-static int decodeIndexConfig(Buffer *buffer, IndexConfig *config)
+static int decodeIndexConfig(Buffer      *buffer,
+                             IndexConfig *config,
+                             bool         hasChunkNameHash)
 {
   int result = getUInt32LEFromBuffer(buffer, &config->mem);
   if (result != VDO_SUCCESS) {
@@ -106,18 +123,31 @@ static int decodeIndexConfig(Buffer *buffer, IndexConfig *config)
     return result;
   }
 
-  return getBoolean(buffer, &config->sparse);
+  result = getBoolean(buffer, &config->sparse);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  if (!hasChunkNameHash) {
+    config->chunkNameHash = UDS_CHUNK_NAME_MURMUR3;
+    return VDO_SUCCESS;
+  }
+
+  return getByte(buffer, &config->chunkNameHash);
 }
 
 /**
  * Encode the on-disk representation of an index configuration into a buffer.
  *
- * @param config  The index configuration to encode
- * @param buffer  A buffer positioned at the start of the encoding
+ * @param config            The index configuration to encode
+ * @param buffer            A buffer positioned at the start of the encoding
+ * @param hasChunkNameHash  Whether to encode the chunk name hash
  *
  * @return UDS_SUCCESS or an error
  **/
-static int encodeIndexConfig(const IndexConfig *config, Buffer *buffer)
+static int encodeIndexConfig(const IndexConfig *config,
+                             Buffer            *buffer,
+                             bool               hasChunkNameHash)
 {
   int result = putUInt32LEIntoBuffer(buffer, config->mem);
   if (result != VDO_SUCCESS) {
@@ -129,7 +159,12 @@ static int encodeIndexConfig(const IndexConfig *config, Buffer *buffer)
     return result;
   }
 
-  return putBoolean(buffer, config->sparse);
+  result = putBoolean(buffer, config->sparse);
+  if ((result != VDO_SUCCESS) || !hasChunkNameHash) {
+    return result;
+  }
+
+  return putByte(buffer, config->chunkNameHash);
 }
 
 /**
@@ -171,12 +206,15 @@ static int encodeVolumeRegion(const VolumeRegion *region, Buffer *buffer)
 /**
  * Decode the on-disk representation of a volume geometry from a buffer.
  *
- * @param buffer    A buffer positioned at the start of the encoding
- * @param geometry  The structure to receive the decoded fields
+ * @param buffer            A buffer positioned at the start of the encoding
+ * @param geometry          The structure to receive the decoded fields
+ * @param hasChunkNameHash  Whether the encoding includes the chunk name hash
  *
  * @return UDS_SUCCESS or an error
  **/
-static int decodeVolumeGeometry(Buffer *buffer, VolumeGeometry *geometry)
+static int decodeVolumeGeometry(Buffer         *buffer,
+                                VolumeGeometry *geometry,
+                                bool            hasChunkNameHash)
 {
   int result = getUInt32LEFromBuffer(buffer, &geometry->releaseVersion);
   if (result != VDO_SUCCESS) {
@@ -200,18 +238,21 @@ static int decodeVolumeGeometry(Buffer *buffer, VolumeGeometry *geometry)
     }
   }
 
-  return decodeIndexConfig(buffer, &geometry->indexConfig);
+  return decodeIndexConfig(buffer, &geometry->indexConfig, hasChunkNameHash);
 }
 
 /**
  * Encode the on-disk representation of a volume geometry into a buffer.
  *
- * @param geometry  The geometry to encode
- * @param buffer    A buffer positioned at the start of the encoding
+ * @param geometry          The geometry to encode
+ * @param buffer            A buffer positioned at the start of the encoding
+ * @param hasChunkNameHash  Whether to encode the chunk name hash
  *
  * @return UDS_SUCCESS or an error
  **/
-static int encodeVolumeGeometry(const VolumeGeometry *geometry, Buffer *buffer)
+static int encodeVolumeGeometry(const VolumeGeometry *geometry,
+                                Buffer               *buffer,
+                                bool                  hasChunkNameHash)
 {
   int result = putUInt32LEIntoBuffer(buffer, geometry->releaseVersion);
   if (result != VDO_SUCCESS) {
@@ -235,7 +276,7 @@ static int encodeVolumeGeometry(const VolumeGeometry *geometry, Buffer *buffer)
     }
   }
 
-  return encodeIndexConfig(&geometry->indexConfig, buffer);
+  return encodeIndexConfig(&geometry->indexConfig, buffer, hasChunkNameHash);
 }
 
 /**
@@ -264,12 +305,17 @@ static int decodeGeometryBlock(Buffer *buffer, VolumeGeometry *geometry)
     return result;
   }
 
-  result = validateHeader(&GEOMETRY_BLOCK_HEADER_4_0, &header, true, __func__);
+  bool hasChunkNameHash = (header.version.majorVersion
+                           == GEOMETRY_BLOCK_HEADER_5_0.version.majorVersion);
+  result = validateHeader((hasChunkNameHash
+                           ? &GEOMETRY_BLOCK_HEADER_5_0
+                           : &GEOMETRY_BLOCK_HEADER_4_0),
+                          &header, true, __func__);
   if (result != VDO_SUCCESS) {
     return result;
   }
 
-  result = decodeVolumeGeometry(buffer, geometry);
+  result = decodeVolumeGeometry(buffer, geometry, hasChunkNameHash);
   if (result != VDO_SUCCESS) {
     return result;
   }
@@ -296,18 +342,23 @@ static int encodeGeometryBlock(const VolumeGeometry *geometry, Buffer *buffer)
     return result;
   }
 
-  result = encodeHeader(&GEOMETRY_BLOCK_HEADER_4_0, buffer);
+  bool hasChunkNameHash
+    = (geometry->indexConfig.chunkNameHash != UDS_CHUNK_NAME_MURMUR3);
+  const Header *header = (hasChunkNameHash
+                          ? &GEOMETRY_BLOCK_HEADER_5_0
+                          : &GEOMETRY_BLOCK_HEADER_4_0);
+  result = encodeHeader(header, buffer);
   if (result != VDO_SUCCESS) {
     return result;
   }
 
-  result = encodeVolumeGeometry(geometry, buffer);
+  result = encodeVolumeGeometry(geometry, buffer, hasChunkNameHash);
   if (result != VDO_SUCCESS) {
     return result;
   }
 
   // Leave the CRC for the caller to compute and encode.
-  return ASSERT(GEOMETRY_BLOCK_HEADER_4_0.size
+  return ASSERT(header->size
                 == (contentLength(buffer) + sizeof(CRC32Checksum)),
                 "should have decoded up to the geometry checksum");
 }
@@ -524,6 +575,13 @@ int indexConfigToUdsConfiguration(IndexConfig      *indexConfig,
 
   udsConfigurationSetSparse(udsConfiguration, indexConfig->sparse);
 
+  result = udsConfigurationSetChunkNameHash(udsConfiguration,
+                                            indexConfig->chunkNameHash);
+  if (result != UDS_SUCCESS) {
+    udsFreeConfiguration(udsConfiguration);
+    return logErrorWithStringError(result, "error setting chunk name hash");
+  }
+
   uint32_t cfreq = indexConfig->checkpointFrequency;
   result = udsConfigurationSetCheckpointFrequency(udsConfiguration, cfreq);
   if (result != UDS_SUCCESS) {
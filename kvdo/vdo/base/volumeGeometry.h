@@ -30,6 +30,8 @@ struct indexConfig {
   uint32_t mem;
   uint32_t checkpointFrequency;
   bool     sparse;
+  /** The UdsChunkNameHash of the chunk names; only encoded since 5.0 */
+  uint8_t  chunkNameHash;
 } __attribute__((packed));
 
 typedef enum {
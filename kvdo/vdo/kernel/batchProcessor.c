@@ -21,7 +21,11 @@
 
 #include "batchProcessor.h"
 
+#include <linux/hrtimer.h>
+#include <linux/version.h>
+
 #include "memoryAlloc.h"
+#include "timeUtils.h"
 
 #include "constants.h"
 
@@ -78,6 +82,14 @@ struct batchProcessor {
   BatchProcessorCallback  callback;
   void                   *closure;
   KernelLayer            *layer;
+  /* Deadline mode only: the number of objects which triggers processing */
+  unsigned int            batchSize;
+  /* Deadline mode only: the longest time to wait for a batch to fill */
+  ktime_t                 maxDelay;
+  /* Deadline mode only: the number of objects added but not yet fetched */
+  atomic_t                pending;
+  /* Deadline mode only: fires when the first pending object is too old */
+  struct hrtimer          timer;
 };
 
 static void scheduleBatchProcessing(BatchProcessor *batch);
@@ -93,6 +105,11 @@ static void scheduleBatchProcessing(BatchProcessor *batch);
 static void batchProcessorWork(KvdoWorkItem *item)
 {
   BatchProcessor *batch = container_of(item, BatchProcessor, workItem);
+  if (batch->batchSize > 0) {
+    // Whatever is queued is about to be processed, so the deadline for it
+    // no longer matters.
+    hrtimer_try_to_cancel(&batch->timer);
+  }
   spin_lock(&batch->consumerLock);
   while (!isFunnelQueueEmpty(batch->queue)) {
     batch->callback(batch, batch->closure);
@@ -149,11 +166,39 @@ static void scheduleBatchProcessing(BatchProcessor *batch)
   }
 }
 
-/**********************************************************************/
-int makeBatchProcessor(KernelLayer             *layer,
-                       BatchProcessorCallback   callback,
-                       void                    *closure,
-                       BatchProcessor         **batchPtr)
+/**
+ * Schedule processing when the first pending object of a deadline batch
+ * processor has waited as long as it may.
+ *
+ * @param timer  The timer embedded in the BatchProcessor
+ *
+ * @return HRTIMER_NORESTART
+ **/
+static enum hrtimer_restart batchDeadlineExpired(struct hrtimer *timer)
+{
+  BatchProcessor *batch = container_of(timer, BatchProcessor, timer);
+  if (atomic_read(&batch->pending) > 0) {
+    scheduleBatchProcessing(batch);
+  }
+  return HRTIMER_NORESTART;
+}
+
+/**
+ * Allocate and initialize a batch processor.
+ *
+ * @param [in]  layer     The kernel layer data, used to enqueue work items
+ * @param [in]  callback  A function to process the accumulated objects
+ * @param [in]  closure   A private data pointer for use by the callback
+ * @param [in]  action    The CPU queue action code for the processing work
+ * @param [out] batchPtr  Where to store the pointer to the new object
+ *
+ * @return   UDS_SUCCESS or an error code
+ **/
+static int allocateBatchProcessor(KernelLayer             *layer,
+                                  BatchProcessorCallback   callback,
+                                  void                    *closure,
+                                  unsigned int             action,
+                                  BatchProcessor         **batchPtr)
 {
   BatchProcessor *batch;
 
@@ -169,7 +214,7 @@ int makeBatchProcessor(KernelLayer             *layer,
 
   spin_lock_init(&batch->consumerLock);
   setupWorkItem(&batch->workItem, batchProcessorWork,
-                (KvdoWorkFunction) callback, CPU_Q_ACTION_COMPLETE_KVIO);
+                (KvdoWorkFunction) callback, action);
   atomic_set(&batch->state, BATCH_PROCESSOR_IDLE);
   batch->callback = callback;
   batch->closure  = closure;
@@ -179,11 +224,64 @@ int makeBatchProcessor(KernelLayer             *layer,
   return UDS_SUCCESS;
 }
 
+/**********************************************************************/
+int makeBatchProcessor(KernelLayer             *layer,
+                       BatchProcessorCallback   callback,
+                       void                    *closure,
+                       unsigned int             action,
+                       BatchProcessor         **batchPtr)
+{
+  return allocateBatchProcessor(layer, callback, closure, action, batchPtr);
+}
+
+/**********************************************************************/
+int makeDeadlineBatchProcessor(KernelLayer             *layer,
+                               BatchProcessorCallback   callback,
+                               void                    *closure,
+                               unsigned int             action,
+                               unsigned int             batchSize,
+                               unsigned int             maxDelay,
+                               BatchProcessor         **batchPtr)
+{
+  BatchProcessor *batch;
+  int result = allocateBatchProcessor(layer, callback, closure, action,
+                                      &batch);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  batch->batchSize = max(batchSize, 1U);
+  batch->maxDelay  = ns_to_ktime((uint64_t) maxDelay * NSEC_PER_USEC);
+  atomic_set(&batch->pending, 0);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,13,0)
+  hrtimer_setup(&batch->timer, batchDeadlineExpired, CLOCK_MONOTONIC,
+                HRTIMER_MODE_REL);
+#else
+  hrtimer_init(&batch->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+  batch->timer.function = batchDeadlineExpired;
+#endif
+
+  *batchPtr = batch;
+  return UDS_SUCCESS;
+}
+
 /**********************************************************************/
 void addToBatchProcessor(BatchProcessor *batch, KvdoWorkItem *item)
 {
+  if (batch->batchSize == 0) {
+    funnelQueuePut(batch->queue, &item->workQueueEntryLink);
+    scheduleBatchProcessing(batch);
+    return;
+  }
+
+  item->enqueueTime = currentTime(CT_MONOTONIC);
   funnelQueuePut(batch->queue, &item->workQueueEntryLink);
-  scheduleBatchProcessing(batch);
+  int pending = atomic_inc_return(&batch->pending);
+  if (pending >= (int) batch->batchSize) {
+    scheduleBatchProcessing(batch);
+  } else if (pending == 1) {
+    hrtimer_start(&batch->timer, batch->maxDelay, HRTIMER_MODE_REL);
+  }
 }
 
 /**********************************************************************/
@@ -194,6 +292,9 @@ KvdoWorkItem *nextBatchItem(BatchProcessor *batch)
     return NULL;
   }
 
+  if (batch->batchSize > 0) {
+    atomic_dec(&batch->pending);
+  }
   return container_of(fqEntry, KvdoWorkItem, workQueueEntryLink);
 }
 
@@ -208,6 +309,9 @@ void freeBatchProcessor(BatchProcessor **batchPtr)
 {
   BatchProcessor *batch = *batchPtr;
   if (batch) {
+    if (batch->batchSize > 0) {
+      hrtimer_cancel(&batch->timer);
+    }
     memoryFence();
     BUG_ON(atomic_read(&batch->state) == BATCH_PROCESSOR_ENQUEUED);
     freeFunnelQueue(batch->queue);
@@ -52,6 +52,7 @@ typedef void (*BatchProcessorCallback)(BatchProcessor *batch, void *closure);
  * @param [in]  layer     The kernel layer data, used to enqueue work items
  * @param [in]  callback  A function to process the accumulated objects
  * @param [in]  closure   A private data pointer for use by the callback
+ * @param [in]  action    The CPU queue action code for the processing work
  * @param [out] batchPtr  Where to store the pointer to the new object
  *
  * @return   UDS_SUCCESS or an error code
@@ -59,8 +60,38 @@ typedef void (*BatchProcessorCallback)(BatchProcessor *batch, void *closure);
 int makeBatchProcessor(KernelLayer             *layer,
                        BatchProcessorCallback   callback,
                        void                    *closure,
+                       unsigned int             action,
                        BatchProcessor         **batchPtr);
 
+/**
+ * Creates a batch-processor control structure which defers running the
+ * callback until either a full batch of objects has accumulated or a
+ * deadline has passed since the first object of the batch was added,
+ * whichever comes first. The callback should process at most batchSize
+ * objects per invocation.
+ *
+ * Each object added has the enqueueTime field of its work item set, so
+ * that the callback can measure how long the batch took to fill.
+ *
+ * @param [in]  layer      The kernel layer data, used to enqueue work items
+ * @param [in]  callback   A function to process the accumulated objects
+ * @param [in]  closure    A private data pointer for use by the callback
+ * @param [in]  action     The CPU queue action code for the processing work
+ * @param [in]  batchSize  The number of objects which triggers processing
+ * @param [in]  maxDelay   The longest time, in microseconds, to wait for a
+ *                         batch to fill
+ * @param [out] batchPtr   Where to store the pointer to the new object
+ *
+ * @return   UDS_SUCCESS or an error code
+ **/
+int makeDeadlineBatchProcessor(KernelLayer             *layer,
+                               BatchProcessorCallback   callback,
+                               void                    *closure,
+                               unsigned int             action,
+                               unsigned int             batchSize,
+                               unsigned int             maxDelay,
+                               BatchProcessor         **batchPtr);
+
 /**
  * Adds an object to the processing queue.
  *
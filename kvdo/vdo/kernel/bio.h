@@ -26,6 +26,8 @@
 #include <linux/blkdev.h>
 #include <linux/version.h>
 
+#include "uds.h"
+
 #include "kernelTypes.h"
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3,14,0)
@@ -40,6 +42,27 @@
  **/
 void bioCopyDataIn(BIO *bio, char *dataPtr);
 
+/**
+ * Copy the bio data to a char array, checking whether the data are all
+ * zeroes and, if they are not, computing their hash. The hash is computed
+ * in the same pass as the copy, and only starts at the first non-zero data,
+ * so copying a zero block costs no more than checking it.
+ *
+ * @param [in]  bio       The bio to copy the data from
+ * @param [in]  dataPtr   The local array to copy the data to
+ * @param [in]  function  The hash function to use
+ * @param [in]  seed      The seed for the hash, if it is MurmurHash3
+ * @param [out] hash      Where to store the 16-byte hash, which is only
+ *                        computed if the data are not all zeroes
+ *
+ * @return true if the bio's data are all zeroes
+ **/
+bool bioCopyDataInAndHash(BIO              *bio,
+                          char             *dataPtr,
+                          UdsChunkNameHash  function,
+                          uint32_t          seed,
+                          void             *hash);
+
 /**
  * Copy a char array to the bio data.
  *
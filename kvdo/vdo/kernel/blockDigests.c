@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/kernel/blockDigests.c#1 $
+ */
+
+#include "blockDigests.h"
+
+#include <crypto/hash.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/version.h>
+
+#include "logger.h"
+#include "memoryAlloc.h"
+
+#include "constants.h"
+#include "statusCodes.h"
+
+/** The crypto API name of the digest algorithm. */
+static const char *DIGEST_ALGORITHM = "sha256";
+
+enum {
+  /**
+   * The number of locks protecting the entries; entry i is protected by
+   * lock (i % BLOCK_DIGEST_LOCKS), so neighbouring blocks, which tend to be
+   * written together, use different locks.
+   **/
+  BLOCK_DIGEST_LOCKS = 64,
+};
+
+typedef struct {
+  /** The block described, or ZERO_BLOCK if the entry is empty */
+  PhysicalBlockNumber pbn;
+  /** The digest of the block's contents */
+  BlockDigest         digest;
+} BlockDigestEntry;
+
+struct blockDigests {
+  /** The transform computing the digests */
+  struct crypto_shash *tfm;
+  /** The number of entries */
+  unsigned int         capacity;
+  /** The locks protecting the entries */
+  spinlock_t           locks[BLOCK_DIGEST_LOCKS];
+  /** The entries, indexed by PBN modulo the capacity */
+  BlockDigestEntry    *entries;
+};
+
+/**********************************************************************/
+int makeBlockDigests(unsigned int capacity, BlockDigests **tablePtr)
+{
+  if ((capacity == 0) || (capacity > MAX_BLOCK_DIGESTS)) {
+    return logErrorWithStringError(VDO_BAD_CONFIGURATION,
+                                   "block digest capacity %u is not between"
+                                   " 1 and %u", capacity, MAX_BLOCK_DIGESTS);
+  }
+
+  BlockDigests *table;
+  int result = ALLOCATE(1, BlockDigests, "block digests", &table);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  result = ALLOCATE(capacity, BlockDigestEntry, "block digest entries",
+                    &table->entries);
+  if (result != VDO_SUCCESS) {
+    freeBlockDigests(&table);
+    return result;
+  }
+
+  table->tfm = crypto_alloc_shash(DIGEST_ALGORITHM, 0, 0);
+  if (IS_ERR(table->tfm)) {
+    logError("cannot allocate shash transform for \"%s\": %ld",
+             DIGEST_ALGORITHM, PTR_ERR(table->tfm));
+    table->tfm = NULL;
+    freeBlockDigests(&table);
+    return VDO_BAD_CONFIGURATION;
+  }
+
+  logInfo("using block digest %s (driver %s) for %u blocks",
+          DIGEST_ALGORITHM,
+          crypto_tfm_alg_driver_name(crypto_shash_tfm(table->tfm)),
+          capacity);
+  table->capacity = capacity;
+  for (unsigned int i = 0; i < BLOCK_DIGEST_LOCKS; i++) {
+    spin_lock_init(&table->locks[i]);
+  }
+
+  *tablePtr = table;
+  return VDO_SUCCESS;
+}
+
+/**********************************************************************/
+void freeBlockDigests(BlockDigests **tablePtr)
+{
+  BlockDigests *table = *tablePtr;
+  if (table == NULL) {
+    return;
+  }
+
+  if (table->tfm != NULL) {
+    crypto_free_shash(table->tfm);
+  }
+  FREE(table->entries);
+  FREE(table);
+  *tablePtr = NULL;
+}
+
+/**********************************************************************/
+bool computeBlockDigest(BlockDigests *table,
+                        const char   *block,
+                        BlockDigest  *digest)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,8,0)
+  return (crypto_shash_tfm_digest(table->tfm, block, VDO_BLOCK_SIZE,
+                                  digest->bytes) == 0);
+#else
+  // A descriptor on the stack would not fit in our frame size limit.
+  struct shash_desc *desc
+    = kmalloc(sizeof(*desc) + crypto_shash_descsize(table->tfm), GFP_NOIO);
+  if (desc == NULL) {
+    return false;
+  }
+
+  desc->tfm = table->tfm;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,2,0)
+  desc->flags = 0;
+#endif
+  int result = crypto_shash_digest(desc, block, VDO_BLOCK_SIZE, digest->bytes);
+  kzfree(desc);
+  return (result == 0);
+#endif
+}
+
+/**
+ * Get the entry and lock for a physical block.
+ *
+ * @param [in]  table     The table
+ * @param [in]  pbn       The physical block number
+ * @param [out] lockPtr   A pointer to hold the lock protecting the entry
+ *
+ * @return The entry which would hold the block's digest
+ **/
+static BlockDigestEntry *getEntry(BlockDigests         *table,
+                                  PhysicalBlockNumber   pbn,
+                                  spinlock_t          **lockPtr)
+{
+  unsigned int index = pbn % table->capacity;
+  *lockPtr = &table->locks[index % BLOCK_DIGEST_LOCKS];
+  return &table->entries[index];
+}
+
+/**********************************************************************/
+void recordBlockDigest(BlockDigests        *table,
+                       PhysicalBlockNumber  pbn,
+                       const BlockDigest   *digest)
+{
+  spinlock_t       *lock;
+  BlockDigestEntry *entry = getEntry(table, pbn, &lock);
+  unsigned long     flags;
+  spin_lock_irqsave(lock, flags);
+  entry->pbn    = pbn;
+  entry->digest = *digest;
+  spin_unlock_irqrestore(lock, flags);
+}
+
+/**********************************************************************/
+void forgetBlockDigest(BlockDigests *table, PhysicalBlockNumber pbn)
+{
+  spinlock_t       *lock;
+  BlockDigestEntry *entry = getEntry(table, pbn, &lock);
+  unsigned long     flags;
+  spin_lock_irqsave(lock, flags);
+  if (entry->pbn == pbn) {
+    entry->pbn = ZERO_BLOCK;
+  }
+  spin_unlock_irqrestore(lock, flags);
+}
+
+/**********************************************************************/
+BlockDigestMatch matchBlockDigest(BlockDigests        *table,
+                                  PhysicalBlockNumber  pbn,
+                                  const BlockDigest   *digest)
+{
+  spinlock_t       *lock;
+  BlockDigestEntry *entry = getEntry(table, pbn, &lock);
+  BlockDigestMatch  match = BLOCK_DIGEST_UNKNOWN;
+  unsigned long     flags;
+  spin_lock_irqsave(lock, flags);
+  if (entry->pbn == pbn) {
+    match = ((memcmp(&entry->digest, digest, sizeof(BlockDigest)) == 0)
+             ? BLOCK_DIGEST_MATCH : BLOCK_DIGEST_MISMATCH);
+  }
+  spin_unlock_irqrestore(lock, flags);
+  return match;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/kernel/blockDigests.h#1 $
+ */
+
+#ifndef BLOCK_DIGESTS_H
+#define BLOCK_DIGESTS_H
+
+#include "kernelTypes.h"
+
+/**
+ * A BlockDigests table remembers a SHA-256 digest of the contents of
+ * recently written or verified uncompressed physical blocks, so that dedupe
+ * advice pointing at one of them can be verified by comparing digests
+ * instead of reading the block back.
+ *
+ * The table is direct-mapped on the physical block number and only holds
+ * digests which are known to describe what is on storage: an entry is
+ * recorded when a data write completes successfully (or when a verify read
+ * matches), and is dropped as soon as any other write to that block is
+ * submitted. A block with no entry is simply verified by reading it, as
+ * before.
+ *
+ * Entries may be recorded from bio completion, so all operations are safe
+ * to call from interrupt context, except for computeBlockDigest(), which
+ * must be called from a CPU queue thread.
+ **/
+
+enum {
+  /** The size of a block digest in bytes */
+  BLOCK_DIGEST_SIZE = 32,
+  /** The most block digests a table may hold */
+  MAX_BLOCK_DIGESTS = 1 << 24,
+};
+
+typedef struct {
+  byte bytes[BLOCK_DIGEST_SIZE];
+} BlockDigest;
+
+typedef enum {
+  /** The table has no digest for the block */
+  BLOCK_DIGEST_UNKNOWN = 0,
+  /** The block is known to have the given digest */
+  BLOCK_DIGEST_MATCH,
+  /** The block is known to have some other digest */
+  BLOCK_DIGEST_MISMATCH,
+} BlockDigestMatch;
+
+/**
+ * Create a block digest table.
+ *
+ * @param [in]  capacity  The number of blocks whose digests may be held
+ * @param [out] tablePtr  A pointer to hold the new table
+ *
+ * @return VDO_SUCCESS or an error
+ **/
+int makeBlockDigests(unsigned int capacity, BlockDigests **tablePtr)
+  __attribute__((warn_unused_result));
+
+/**
+ * Free a block digest table and null out the reference to it.
+ *
+ * @param tablePtr  The reference to the table to free
+ **/
+void freeBlockDigests(BlockDigests **tablePtr);
+
+/**
+ * Compute the digest of a data block.
+ *
+ * @param [in]  table   The table whose digest algorithm is to be used
+ * @param [in]  block   The block to digest, VDO_BLOCK_SIZE bytes long
+ * @param [out] digest  The digest of the block
+ *
+ * @return <code>true</code> if the digest was computed
+ **/
+bool computeBlockDigest(BlockDigests *table,
+                        const char   *block,
+                        BlockDigest  *digest)
+  __attribute__((warn_unused_result));
+
+/**
+ * Record the digest of what is now stored in a physical block.
+ *
+ * @param table   The table
+ * @param pbn     The physical block number
+ * @param digest  The digest of the block's contents
+ **/
+void recordBlockDigest(BlockDigests        *table,
+                       PhysicalBlockNumber  pbn,
+                       const BlockDigest   *digest);
+
+/**
+ * Forget any digest recorded for a physical block, because the block is
+ * about to be overwritten.
+ *
+ * @param table  The table
+ * @param pbn    The physical block number
+ **/
+void forgetBlockDigest(BlockDigests *table, PhysicalBlockNumber pbn);
+
+/**
+ * Check a digest against the digest recorded for a physical block.
+ *
+ * @param table   The table
+ * @param pbn     The physical block number
+ * @param digest  The digest to check
+ *
+ * @return Whether the block is known to match the digest, known not to
+ *         match it, or neither
+ **/
+BlockDigestMatch matchBlockDigest(BlockDigests        *table,
+                                  PhysicalBlockNumber  pbn,
+                                  const BlockDigest   *digest)
+  __attribute__((warn_unused_result));
+
+#endif /* BLOCK_DIGESTS_H */
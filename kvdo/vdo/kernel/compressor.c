@@ -0,0 +1,805 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/kernel/compressor.c#1 $
+ */
+
+#include "compressor.h"
+
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+#include <crypto/acompress.h>
+#include <linux/scatterlist.h>
+#endif
+
+#include "logger.h"
+#include "memoryAlloc.h"
+
+#include "atomic.h"
+#include "constants.h"
+#include "deflate.h"
+#include "lz4.h"
+#include "statusCodes.h"
+
+#include "workQueue.h"
+
+const char *DEFAULT_COMPRESSOR_NAME = "lz4";
+
+/** The prefix of a specification naming a crypto API algorithm. */
+static const char ACOMP_PREFIX[] = "acomp:";
+
+/** The name of the built-in software deflate compressor. */
+static const char DEFLATE_COMPRESSOR_NAME[] = "deflate";
+
+typedef enum {
+  COMPRESSOR_LZ4 = 0,
+  COMPRESSOR_DEFLATE,
+  COMPRESSOR_ACOMP,
+} CompressorType;
+
+/** The crypto API algorithm name of each codec. */
+static const char *CODEC_NAMES[COMPRESSION_CODEC_COUNT] = {
+  [COMPRESSION_CODEC_LZ4]     = "lz4",
+  [COMPRESSION_CODEC_DEFLATE] = "deflate",
+  [COMPRESSION_CODEC_ZSTD]    = "zstd",
+};
+
+enum {
+  /** The number of consecutive bytes read at each entropy sampling point */
+  ENTROPY_SAMPLE_READ_SIZE = 16,
+  /** The distance between entropy sampling points */
+  ENTROPY_SAMPLE_INTERVAL  = 128,
+  /** The number of distinct byte values */
+  BYTE_VALUE_COUNT         = 256,
+};
+
+/** The state a compressor keeps for each CPU thread which uses it. */
+typedef struct {
+  /** LZ4 context data, if the backend is the built-in LZ4 compressor */
+  char         *lz4Context;
+  /** Deflate context data, if the backend is the built-in deflate compressor */
+  char         *deflateContext;
+  /** Context data for uncompressing deflate fragments inline */
+  char         *inflateContext;
+  /** The uncompressed data of a multi-block compression unit */
+  char         *unitData;
+  /** A copy of the compressed form of the unit in unitData */
+  char         *unitFragment;
+  /** The size of the compressed unit, or zero if unitData is not valid */
+  unsigned int  unitFragmentSize;
+  /** The number of blocks in the unit in unitData */
+  unsigned int  unitBlocks;
+} CompressorThread;
+
+struct compressor {
+  /** The kind of backend */
+  CompressorType        type;
+  /** The codec used to compress new data */
+  CompressionCodec      codec;
+  /** The specification string this compressor was made from */
+  char                 *name;
+  /** The number of CPU threads which may use the compressor */
+  unsigned int          threadCount;
+  /** The per-thread state, one per CPU thread */
+  CompressorThread     *threads;
+  /** The index of the next per-thread state to hand out */
+  Atomic32              threadIndex;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+  /**
+   * The crypto API transform for each codec, if available. The transform
+   * for the compressing codec is only present for the acomp backend; LZ4
+   * and deflate fragments are otherwise uncompressed inline.
+   **/
+  struct crypto_acomp  *acomp[COMPRESSION_CODEC_COUNT];
+#endif
+};
+
+struct compressorRequest {
+  /** The compressor this request is issued to */
+  Compressor           *compressor;
+  /** The function to call when the current operation completes */
+  CompressorCallback   *callback;
+  /** The context for the callback */
+  void                 *context;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+  /** The crypto API request for each available transform */
+  struct acomp_req     *acompRequests[COMPRESSION_CODEC_COUNT];
+  /** The crypto API request for the current operation */
+  struct acomp_req     *acompRequest;
+  /** Scatterlists describing the source and destination buffers */
+  struct scatterlist    source;
+  struct scatterlist    destination;
+#endif
+};
+
+/**
+ * Parse a compressor specification string.
+ *
+ * @param [in]  spec      The specification
+ * @param [out] typePtr   A pointer to hold the compressor type
+ * @param [out] codecPtr  A pointer to hold the codec used for compression
+ *
+ * @return <code>true</code> if the specification is valid
+ **/
+static bool parseCompressorSpec(const char       *spec,
+                                CompressorType   *typePtr,
+                                CompressionCodec *codecPtr)
+{
+  if (strcmp(spec, DEFAULT_COMPRESSOR_NAME) == 0) {
+    *typePtr  = COMPRESSOR_LZ4;
+    *codecPtr = COMPRESSION_CODEC_LZ4;
+    return true;
+  }
+
+  if (strcmp(spec, DEFLATE_COMPRESSOR_NAME) == 0) {
+    *typePtr  = COMPRESSOR_DEFLATE;
+    *codecPtr = COMPRESSION_CODEC_DEFLATE;
+    return true;
+  }
+
+  size_t prefixLength = sizeof(ACOMP_PREFIX) - 1;
+  if (strncmp(spec, ACOMP_PREFIX, prefixLength) != 0) {
+    return false;
+  }
+
+  // Only algorithms with a codec ID can be used, since every fragment
+  // written must record how to uncompress it.
+  for (CompressionCodec codec = 0; codec < COMPRESSION_CODEC_COUNT; codec++) {
+    if (strcmp(spec + prefixLength, CODEC_NAMES[codec]) == 0) {
+      *typePtr  = COMPRESSOR_ACOMP;
+      *codecPtr = codec;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**********************************************************************/
+bool isValidCompressorSpec(const char *spec)
+{
+  CompressorType   type;
+  CompressionCodec codec;
+  return parseCompressorSpec(spec, &type, &codec);
+}
+
+/**
+ * Allocate the per-thread state of a compressor.
+ *
+ * @param compressor   The compressor
+ * @param threadCount  The number of CPU threads which may use it
+ *
+ * @return VDO_SUCCESS or an error
+ **/
+static int makeCompressorThreads(Compressor *compressor,
+                                 unsigned int threadCount)
+{
+  int result = ALLOCATE(threadCount, CompressorThread, "compressor threads",
+                        &compressor->threads);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  compressor->threadCount = threadCount;
+  for (unsigned int i = 0; i < threadCount; i++) {
+    CompressorThread *thread = &compressor->threads[i];
+    if (compressor->type == COMPRESSOR_LZ4) {
+      result = ALLOCATE(LZ4_context_size(), char, "LZ4 context",
+                        &thread->lz4Context);
+      if (result != VDO_SUCCESS) {
+        return result;
+      }
+    }
+
+    if (compressor->type == COMPRESSOR_DEFLATE) {
+      result = ALLOCATE(getDeflateContextSize(), char, "deflate context",
+                        &thread->deflateContext);
+      if (result != VDO_SUCCESS) {
+        return result;
+      }
+    }
+
+    result = ALLOCATE(getInflateContextSize(), char, "inflate context",
+                      &thread->inflateContext);
+    if (result != VDO_SUCCESS) {
+      return result;
+    }
+
+    result = ALLOCATE(MAX_COMPRESSION_UNIT_BLOCKS * VDO_BLOCK_SIZE, char,
+                      "compression unit data", &thread->unitData);
+    if (result != VDO_SUCCESS) {
+      return result;
+    }
+
+    result = ALLOCATE(VDO_BLOCK_SIZE, char, "compression unit fragment",
+                      &thread->unitFragment);
+    if (result != VDO_SUCCESS) {
+      return result;
+    }
+  }
+
+  return VDO_SUCCESS;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+/**
+ * Allocate the crypto API transforms needed by a compressor.
+ *
+ * @param compressor  The compressor
+ *
+ * @return VDO_SUCCESS or an error
+ **/
+static int makeAcompTransforms(Compressor *compressor)
+{
+  for (CompressionCodec codec = 0; codec < COMPRESSION_CODEC_COUNT; codec++) {
+    bool required = ((compressor->type == COMPRESSOR_ACOMP)
+                     && (codec == compressor->codec));
+    if (!required
+        && ((codec == COMPRESSION_CODEC_LZ4)
+            || (codec == COMPRESSION_CODEC_DEFLATE))) {
+      // LZ4 and deflate fragments can always be uncompressed inline.
+      continue;
+    }
+
+    struct crypto_acomp *acomp = crypto_alloc_acomp(CODEC_NAMES[codec], 0, 0);
+    if (IS_ERR(acomp)) {
+      if (required) {
+        logError("cannot allocate acomp transform for \"%s\": %ld",
+                 CODEC_NAMES[codec], PTR_ERR(acomp));
+        return VDO_BAD_CONFIGURATION;
+      }
+
+      // This codec won't be readable, but it may never have been used.
+      logInfo("no acomp transform for \"%s\"; its fragments will not be"
+              " readable", CODEC_NAMES[codec]);
+      continue;
+    }
+
+    compressor->acomp[codec] = acomp;
+    if (required) {
+      logInfo("using compressor %s (driver %s)", CODEC_NAMES[codec],
+              crypto_tfm_alg_driver_name(crypto_acomp_tfm(acomp)));
+    }
+  }
+
+  return VDO_SUCCESS;
+}
+#endif
+
+/**********************************************************************/
+int makeCompressor(const char    *spec,
+                   unsigned int   threadCount,
+                   Compressor   **compressorPtr)
+{
+  CompressorType   type;
+  CompressionCodec codec;
+  if (!parseCompressorSpec(spec, &type, &codec)) {
+    return logErrorWithStringError(VDO_BAD_CONFIGURATION,
+                                   "unknown compressor \"%s\"", spec);
+  }
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4,10,0)
+  if (type == COMPRESSOR_ACOMP) {
+    return logErrorWithStringError(VDO_BAD_CONFIGURATION,
+                                   "compressor \"%s\" requires the crypto"
+                                   " acomp interface", spec);
+  }
+#endif
+
+  Compressor *compressor;
+  int result = ALLOCATE(1, Compressor, "compressor", &compressor);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  compressor->type  = type;
+  compressor->codec = codec;
+  result = duplicateString(spec, "compressor name", &compressor->name);
+  if (result != VDO_SUCCESS) {
+    freeCompressor(&compressor);
+    return result;
+  }
+
+  result = makeCompressorThreads(compressor, threadCount);
+  if (result != VDO_SUCCESS) {
+    freeCompressor(&compressor);
+    return result;
+  }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+  result = makeAcompTransforms(compressor);
+  if (result != VDO_SUCCESS) {
+    freeCompressor(&compressor);
+    return result;
+  }
+#endif
+
+  *compressorPtr = compressor;
+  return VDO_SUCCESS;
+}
+
+/**********************************************************************/
+void freeCompressor(Compressor **compressorPtr)
+{
+  Compressor *compressor = *compressorPtr;
+  if (compressor == NULL) {
+    return;
+  }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+  for (CompressionCodec codec = 0; codec < COMPRESSION_CODEC_COUNT; codec++) {
+    if (compressor->acomp[codec] != NULL) {
+      crypto_free_acomp(compressor->acomp[codec]);
+    }
+  }
+#endif
+
+  if (compressor->threads != NULL) {
+    for (unsigned int i = 0; i < compressor->threadCount; i++) {
+      FREE(compressor->threads[i].lz4Context);
+      FREE(compressor->threads[i].deflateContext);
+      FREE(compressor->threads[i].inflateContext);
+      FREE(compressor->threads[i].unitData);
+      FREE(compressor->threads[i].unitFragment);
+    }
+    FREE(compressor->threads);
+  }
+
+  FREE(compressor->name);
+  FREE(compressor);
+  *compressorPtr = NULL;
+}
+
+/**********************************************************************/
+const char *getCompressorName(const Compressor *compressor)
+{
+  return compressor->name;
+}
+
+/**********************************************************************/
+bool isCompressorAsynchronous(const Compressor *compressor)
+{
+  return (compressor->type == COMPRESSOR_ACOMP);
+}
+
+/**********************************************************************/
+CompressionCodec getCompressorCodec(const Compressor *compressor)
+{
+  return compressor->codec;
+}
+
+/**********************************************************************/
+int makeCompressorRequest(Compressor         *compressor,
+                          CompressorRequest **requestPtr)
+{
+  CompressorRequest *request;
+  int result = ALLOCATE(1, CompressorRequest, "compressor request", &request);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  request->compressor = compressor;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+  for (CompressionCodec codec = 0; codec < COMPRESSION_CODEC_COUNT; codec++) {
+    if (compressor->acomp[codec] == NULL) {
+      continue;
+    }
+
+    request->acompRequests[codec]
+      = acomp_request_alloc(compressor->acomp[codec]);
+    if (request->acompRequests[codec] == NULL) {
+      freeCompressorRequest(&request);
+      return -ENOMEM;
+    }
+  }
+#endif
+
+  *requestPtr = request;
+  return VDO_SUCCESS;
+}
+
+/**********************************************************************/
+void freeCompressorRequest(CompressorRequest **requestPtr)
+{
+  CompressorRequest *request = *requestPtr;
+  if (request == NULL) {
+    return;
+  }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+  for (CompressionCodec codec = 0; codec < COMPRESSION_CODEC_COUNT; codec++) {
+    if (request->acompRequests[codec] != NULL) {
+      acomp_request_free(request->acompRequests[codec]);
+    }
+  }
+#endif
+
+  FREE(request);
+  *requestPtr = NULL;
+}
+
+/**
+ * Get the compressor's state for the current CPU queue thread, assigning one
+ * if this thread has not used the compressor before.
+ *
+ * @param compressor  The compressor
+ *
+ * @return The state for this thread
+ **/
+static CompressorThread *getCompressorThread(Compressor *compressor)
+{
+  CompressorThread *thread = getWorkQueuePrivateData();
+  if (unlikely(thread == NULL)) {
+    uint32_t index = atomicAdd32(&compressor->threadIndex, 1) - 1;
+    BUG_ON(index >= compressor->threadCount);
+    thread = &compressor->threads[index];
+    setWorkQueuePrivateData(thread);
+  }
+  return thread;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+/**
+ * Report the result of a finished acomp operation to the requestor.
+ *
+ * @param request  The request which finished
+ * @param error    The result of the operation
+ **/
+static void finishAcompRequest(CompressorRequest *request, int error)
+{
+  int size = ((error == 0) ? (int) request->acompRequest->dlen : error);
+  request->callback(request->context, size);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6,3,0)
+/**
+ * Callback from the crypto API when an acomp operation completes.
+ *
+ * @param data   The CompressorRequest
+ * @param error  The result of the operation
+ **/
+static void acompCallback(void *data, int error)
+{
+  CompressorRequest *request = data;
+#else
+/**
+ * Callback from the crypto API when an acomp operation completes.
+ *
+ * @param asyncRequest  The crypto API request
+ * @param error         The result of the operation
+ **/
+static void acompCallback(struct crypto_async_request *asyncRequest, int error)
+{
+  CompressorRequest *request = asyncRequest->data;
+#endif
+  if (error == -EINPROGRESS) {
+    // A backlogged request has been accepted by the driver; the real
+    // completion will follow.
+    return;
+  }
+
+  finishAcompRequest(request, error);
+}
+
+/**
+ * Submit an operation through the crypto acomp interface.
+ *
+ * @param request          The request to submit
+ * @param codec            The codec of the transform to use
+ * @param compress         <code>true</code> to compress, <code>false</code>
+ *                         to uncompress
+ * @param source           The input buffer
+ * @param sourceSize       The size of the input
+ * @param destination      The output buffer
+ * @param destinationSize  The size of the output buffer
+ **/
+static void submitAcompRequest(CompressorRequest *request,
+                               CompressionCodec   codec,
+                               bool               compress,
+                               char              *source,
+                               unsigned int       sourceSize,
+                               char              *destination,
+                               unsigned int       destinationSize)
+{
+  struct acomp_req *acompRequest = request->acompRequests[codec];
+  request->acompRequest = acompRequest;
+  sg_init_one(&request->source, source, sourceSize);
+  sg_init_one(&request->destination, destination, destinationSize);
+  acomp_request_set_params(acompRequest, &request->source,
+                           &request->destination, sourceSize,
+                           destinationSize);
+  acomp_request_set_callback(acompRequest, CRYPTO_TFM_REQ_MAY_BACKLOG,
+                             acompCallback, request);
+
+  int result = (compress
+                ? crypto_acomp_compress(acompRequest)
+                : crypto_acomp_decompress(acompRequest));
+  if ((result == -EINPROGRESS) || (result == -EBUSY)) {
+    // The callback will be invoked when the operation completes.
+    return;
+  }
+
+  finishAcompRequest(request, result);
+}
+#endif
+
+/**********************************************************************/
+void compressBuffer(CompressorRequest  *request,
+                    char               *source,
+                    unsigned int        sourceSize,
+                    char               *destination,
+                    unsigned int        destinationSize,
+                    CompressorCallback *callback,
+                    void               *context)
+{
+  Compressor *compressor = request->compressor;
+  request->callback = callback;
+  request->context  = context;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+  if (compressor->type == COMPRESSOR_ACOMP) {
+    submitAcompRequest(request, compressor->codec, true, source, sourceSize,
+                       destination, destinationSize);
+    return;
+  }
+#endif
+
+  CompressorThread *thread = getCompressorThread(compressor);
+  int size;
+  if (compressor->type == COMPRESSOR_DEFLATE) {
+    size = deflateCompress(thread->deflateContext, source, sourceSize,
+                           destination, destinationSize);
+  } else {
+    size = LZ4_compress_ctx_limitedOutput(thread->lz4Context,
+                                          source, destination, sourceSize,
+                                          destinationSize);
+  }
+  callback(context, size);
+}
+
+/**
+ * Uncompress a fragment on the calling thread using a built-in codec.
+ *
+ * @param compressor       The compressor
+ * @param codec            The codec which produced the fragment, which must
+ *                         be LZ4 or deflate
+ * @param source           The compressed data
+ * @param sourceSize       The size of the compressed data
+ * @param destination      The buffer to hold the uncompressed data
+ * @param destinationSize  The size of the destination buffer
+ *
+ * @return The size of the uncompressed data, or a value less than or equal
+ *         to zero if the fragment is invalid
+ **/
+static int uncompressInline(Compressor       *compressor,
+                            CompressionCodec  codec,
+                            char             *source,
+                            unsigned int      sourceSize,
+                            char             *destination,
+                            unsigned int      destinationSize)
+{
+  if (codec == COMPRESSION_CODEC_DEFLATE) {
+    CompressorThread *thread = getCompressorThread(compressor);
+    return deflateUncompress(thread->inflateContext, source, sourceSize,
+                             destination, destinationSize);
+  }
+
+  return LZ4_uncompress_unknownOutputSize(source, destination, sourceSize,
+                                          destinationSize);
+}
+
+/**
+ * Check whether fragments of a codec can be uncompressed inline.
+ *
+ * @param codec  The codec
+ *
+ * @return <code>true</code> if uncompressInline() supports the codec
+ **/
+static inline bool isInlineCodec(CompressionCodec codec)
+{
+  return ((codec == COMPRESSION_CODEC_LZ4)
+          || (codec == COMPRESSION_CODEC_DEFLATE));
+}
+
+/**********************************************************************/
+void uncompressBuffer(CompressorRequest  *request,
+                      CompressionCodec    codec,
+                      char               *source,
+                      unsigned int        sourceSize,
+                      char               *destination,
+                      unsigned int        destinationSize,
+                      CompressorCallback *callback,
+                      void               *context)
+{
+  request->callback = callback;
+  request->context  = context;
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0)
+  if (request->acompRequests[codec] != NULL) {
+    submitAcompRequest(request, codec, false, source, sourceSize,
+                       destination, destinationSize);
+    return;
+  }
+#endif
+
+  if (!isInlineCodec(codec)) {
+    logErrorWithStringError(VDO_INVALID_FRAGMENT,
+                            "no transform to uncompress %s fragment",
+                            CODEC_NAMES[codec]);
+    callback(context, -EINVAL);
+    return;
+  }
+
+  int size = uncompressInline(request->compressor, codec, source, sourceSize,
+                              destination, destinationSize);
+  callback(context, size);
+}
+
+/**********************************************************************/
+bool canCompressUnits(const Compressor *compressor)
+{
+  return ((compressor->type == COMPRESSOR_LZ4)
+          || (compressor->type == COMPRESSOR_DEFLATE));
+}
+
+/**********************************************************************/
+void compressUnit(CompressorRequest  *request,
+                  char * const       *blocks,
+                  unsigned int        blockCount,
+                  char               *destination,
+                  unsigned int        destinationSize,
+                  CompressorCallback *callback,
+                  void               *context)
+{
+  CompressorThread *thread = getCompressorThread(request->compressor);
+  BUG_ON(!canCompressUnits(request->compressor)
+         || (blockCount > MAX_COMPRESSION_UNIT_BLOCKS));
+
+  // The unit buffer is about to be overwritten, so forget what it held.
+  thread->unitFragmentSize = 0;
+  for (unsigned int i = 0; i < blockCount; i++) {
+    memcpy(thread->unitData + (i * VDO_BLOCK_SIZE), blocks[i],
+           VDO_BLOCK_SIZE);
+  }
+
+  compressBuffer(request, thread->unitData, blockCount * VDO_BLOCK_SIZE,
+                 destination, destinationSize, callback, context);
+}
+
+/**
+ * Check whether a thread's unit buffer already holds the uncompressed form
+ * of a compressed unit.
+ *
+ * @param thread      The compressor thread state
+ * @param source      The compressed unit
+ * @param sourceSize  The size of the compressed unit
+ * @param unitBlocks  The number of blocks in the unit
+ *
+ * @return <code>true</code> if the unit need not be uncompressed again
+ **/
+static bool isUnitCached(const CompressorThread *thread,
+                         const char             *source,
+                         unsigned int            sourceSize,
+                         unsigned int            unitBlocks)
+{
+  return ((thread->unitFragmentSize == sourceSize)
+          && (thread->unitBlocks == unitBlocks)
+          && (memcmp(thread->unitFragment, source, sourceSize) == 0));
+}
+
+/**********************************************************************/
+void uncompressUnitBlock(CompressorRequest  *request,
+                         CompressionCodec    codec,
+                         char               *source,
+                         unsigned int        sourceSize,
+                         unsigned int        unitBlocks,
+                         unsigned int        unitIndex,
+                         char               *destination,
+                         CompressorCallback *callback,
+                         void               *context)
+{
+  if (!isInlineCodec(codec)
+      || (unitBlocks > MAX_COMPRESSION_UNIT_BLOCKS)
+      || (unitIndex >= unitBlocks)
+      || (sourceSize == 0)
+      || (sourceSize > VDO_BLOCK_SIZE)) {
+    logErrorWithStringError(VDO_INVALID_FRAGMENT,
+                            "cannot uncompress block %u of %u block %s unit",
+                            unitIndex, unitBlocks, CODEC_NAMES[codec]);
+    callback(context, -EINVAL);
+    return;
+  }
+
+  CompressorThread *thread = getCompressorThread(request->compressor);
+  if (!isUnitCached(thread, source, sourceSize, unitBlocks)) {
+    thread->unitFragmentSize = 0;
+    int unitSize = unitBlocks * VDO_BLOCK_SIZE;
+    int size = uncompressInline(request->compressor, codec, source,
+                                sourceSize, thread->unitData, unitSize);
+    if (size != unitSize) {
+      callback(context, -EINVAL);
+      return;
+    }
+
+    // Keep the uncompressed unit to serve reads of its other blocks.
+    memcpy(thread->unitFragment, source, sourceSize);
+    thread->unitFragmentSize = sourceSize;
+    thread->unitBlocks       = unitBlocks;
+  }
+
+  memcpy(destination, thread->unitData + (unitIndex * VDO_BLOCK_SIZE),
+         VDO_BLOCK_SIZE);
+  callback(context, VDO_BLOCK_SIZE);
+}
+
+/**
+ * Compute log2(n^4), an integer base-2 logarithm with two extra bits of
+ * precision.
+ *
+ * @param n  The value
+ *
+ * @return The scaled logarithm
+ **/
+static inline unsigned int log2Scaled(uint64_t n)
+{
+  return ilog2(n * n * n * n);
+}
+
+/**********************************************************************/
+unsigned int getSampledEntropy(const char *buffer, unsigned int size)
+{
+  /*
+   * Byte counts are kept small so that this can run on the deep stack of a
+   * bio submitter. A count only saturates for a byte value making up over
+   * half of the sample from a 4K block, which overstates the entropy of an
+   * already very compressible block by at most about six percent.
+   */
+  uint8_t counts[BYTE_VALUE_COUNT];
+  memset(counts, 0, sizeof(counts));
+
+  unsigned int sampleSize = 0;
+  for (unsigned int offset = 0;
+       offset + ENTROPY_SAMPLE_READ_SIZE <= size;
+       offset += ENTROPY_SAMPLE_INTERVAL) {
+    const byte *sample = (const byte *) buffer + offset;
+    for (unsigned int i = 0; i < ENTROPY_SAMPLE_READ_SIZE; i++) {
+      counts[sample[i]] += (counts[sample[i]] != UINT8_MAX);
+    }
+    sampleSize += ENTROPY_SAMPLE_READ_SIZE;
+  }
+
+  if (sampleSize == 0) {
+    return 0;
+  }
+
+  // Shannon entropy: the sum over all byte values of p * log2(1 / p), which
+  // is (count / sampleSize) * (log2(sampleSize) - log2(count)).
+  unsigned int sizeLog = log2Scaled(sampleSize);
+  uint64_t     entropy = 0;
+  for (unsigned int value = 0; value < BYTE_VALUE_COUNT; value++) {
+    if (counts[value] > 0) {
+      entropy += counts[value] * (sizeLog - log2Scaled(counts[value]));
+    }
+  }
+
+  // The maximum entropy is 8 bits per byte, or log2Scaled(2) per bit.
+  unsigned int maxEntropy = 8 * log2Scaled(2);
+  return (unsigned int) div_u64(entropy * 100, sampleSize * maxEntropy);
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/kernel/compressor.h#1 $
+ */
+
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include "blockMappingState.h"
+#include "kernelTypes.h"
+
+/**
+ * A Compressor encapsulates the engine used to compress data blocks and to
+ * uncompress fragments read back from compressed blocks. Three kinds of
+ * backend are supported:
+ *
+ * The built-in LZ4 backend, which runs synchronously on the calling CPU
+ * queue thread using one LZ4 context per CPU thread. This is the default.
+ *
+ * The built-in deflate backend, which also runs synchronously, and which
+ * writes raw deflate streams that hardware deflate engines can read (and
+ * reads theirs), so a volume may move between hosts with and without such
+ * engines.
+ *
+ * An asynchronous backend which submits requests through the Linux crypto
+ * acomp interface, so that compression may be offloaded to hardware engines
+ * (or to any software acomp driver, such as "deflate" or "lz4"). Requests
+ * complete in whatever context the driver chooses.
+ *
+ * The backend is named by a compressor specification string: "lz4" for the
+ * built-in LZ4 backend, "deflate" for the built-in deflate backend, or
+ * "acomp:<algorithm>" for the crypto API backend, where the algorithm must be
+ * one with a CompressionCodec ("lz4", "deflate", or "zstd") so that the
+ * fragments it produces can be tagged.
+ **/
+
+/** The name of the default compressor backend. */
+extern const char *DEFAULT_COMPRESSOR_NAME;
+
+enum {
+  /**
+   * The most blocks which may be compressed together as one unit; each
+   * block in a unit needs its own slot in the compressed block.
+   **/
+  MAX_COMPRESSION_UNIT_BLOCKS = MAX_COMPRESSION_SLOTS,
+};
+
+/**
+ * A function to call when a compression or uncompression request completes.
+ * This may be invoked from interrupt context.
+ *
+ * @param context  The context supplied when the request was started
+ * @param size     The number of bytes produced, or a value less than or
+ *                 equal to zero if the operation failed
+ **/
+typedef void CompressorCallback(void *context, int size);
+
+/**
+ * Check whether a compressor specification string is well-formed. This
+ * does not check whether the named algorithm is actually available.
+ *
+ * @param spec  The compressor specification string
+ *
+ * @return <code>true</code> if the specification can be parsed
+ **/
+bool isValidCompressorSpec(const char *spec)
+  __attribute__((warn_unused_result));
+
+/**
+ * Create a compressor.
+ *
+ * @param [in]  spec           The compressor specification string
+ * @param [in]  threadCount    The number of CPU threads which may use the
+ *                             compressor concurrently
+ * @param [out] compressorPtr  A pointer to hold the new compressor
+ *
+ * @return VDO_SUCCESS or an error
+ **/
+int makeCompressor(const char    *spec,
+                   unsigned int   threadCount,
+                   Compressor   **compressorPtr)
+  __attribute__((warn_unused_result));
+
+/**
+ * Free a compressor and null out the reference to it.
+ *
+ * @param compressorPtr  The reference to the compressor to free
+ **/
+void freeCompressor(Compressor **compressorPtr);
+
+/**
+ * Get the specification string which was used to create a compressor.
+ *
+ * @param compressor  The compressor
+ *
+ * @return The compressor's name
+ **/
+const char *getCompressorName(const Compressor *compressor)
+  __attribute__((warn_unused_result));
+
+/**
+ * Check whether a compressor may complete requests asynchronously.
+ *
+ * @param compressor  The compressor
+ *
+ * @return <code>true</code> if requests may complete after the call which
+ *         started them has returned
+ **/
+bool isCompressorAsynchronous(const Compressor *compressor)
+  __attribute__((warn_unused_result));
+
+/**
+ * Get the codec a compressor uses to compress data.
+ *
+ * @param compressor  The compressor
+ *
+ * @return The codec which must be recorded for fragments it produces
+ **/
+CompressionCodec getCompressorCodec(const Compressor *compressor)
+  __attribute__((warn_unused_result));
+
+/**
+ * Create the per-requestor state needed to issue operations to a
+ * compressor. A request may only have one operation outstanding at a time.
+ *
+ * @param [in]  compressor  The compressor the request will be issued to
+ * @param [out] requestPtr  A pointer to hold the new request
+ *
+ * @return VDO_SUCCESS or an error
+ **/
+int makeCompressorRequest(Compressor         *compressor,
+                          CompressorRequest **requestPtr)
+  __attribute__((warn_unused_result));
+
+/**
+ * Free a compressor request and null out the reference to it.
+ *
+ * @param requestPtr  The reference to the request to free
+ **/
+void freeCompressorRequest(CompressorRequest **requestPtr);
+
+/**
+ * Compress a buffer. For a synchronous compressor, the callback will have
+ * been invoked before this function returns. The source and destination
+ * buffers must be directly mapped kernel memory.
+ *
+ * @param request          The request to use
+ * @param source           The data to compress
+ * @param sourceSize       The size of the data to compress
+ * @param destination      The buffer to hold the compressed data
+ * @param destinationSize  The size of the destination buffer
+ * @param callback         The function to call when compression is done
+ * @param context          The context to pass to the callback
+ **/
+void compressBuffer(CompressorRequest  *request,
+                    char               *source,
+                    unsigned int        sourceSize,
+                    char               *destination,
+                    unsigned int        destinationSize,
+                    CompressorCallback *callback,
+                    void               *context);
+
+/**
+ * Uncompress a buffer. Fragments of any codec may be uncompressed, whatever
+ * codec the compressor uses for compression, provided a transform for that
+ * codec was available when the compressor was made. If the operation is done
+ * synchronously, the callback will have been invoked before this function
+ * returns. The source and destination buffers must be directly mapped
+ * kernel memory.
+ *
+ * @param request          The request to use
+ * @param codec            The codec which produced the compressed data
+ * @param source           The compressed data
+ * @param sourceSize       The size of the compressed data
+ * @param destination      The buffer to hold the uncompressed data
+ * @param destinationSize  The size of the destination buffer
+ * @param callback         The function to call when uncompression is done
+ * @param context          The context to pass to the callback
+ **/
+void uncompressBuffer(CompressorRequest  *request,
+                      CompressionCodec    codec,
+                      char               *source,
+                      unsigned int        sourceSize,
+                      char               *destination,
+                      unsigned int        destinationSize,
+                      CompressorCallback *callback,
+                      void               *context);
+
+/**
+ * Check whether a compressor can compress several blocks as one unit.
+ *
+ * @param compressor  The compressor
+ *
+ * @return <code>true</code> if compressUnit() may be used
+ **/
+bool canCompressUnits(const Compressor *compressor)
+  __attribute__((warn_unused_result));
+
+/**
+ * Compress several blocks together as a single stream. This may only be
+ * used with a compressor for which canCompressUnits() is true, and the
+ * callback will have been invoked before this function returns.
+ *
+ * @param request          The request to use
+ * @param blocks           The blocks to compress, in order
+ * @param blockCount       The number of blocks, at most
+ *                         MAX_COMPRESSION_UNIT_BLOCKS
+ * @param destination      The buffer to hold the compressed data
+ * @param destinationSize  The size of the destination buffer
+ * @param callback         The function to call when compression is done
+ * @param context          The context to pass to the callback
+ **/
+void compressUnit(CompressorRequest  *request,
+                  char * const       *blocks,
+                  unsigned int        blockCount,
+                  char               *destination,
+                  unsigned int        destinationSize,
+                  CompressorCallback *callback,
+                  void               *context);
+
+/**
+ * Uncompress one block of a multi-block compression unit. The most recently
+ * uncompressed unit is kept for each CPU thread, so reading the other blocks
+ * of the same unit does not uncompress it again. The callback will have been
+ * invoked before this function returns.
+ *
+ * @param request      The request to use
+ * @param codec        The codec which produced the compressed unit
+ * @param source       The compressed unit
+ * @param sourceSize   The size of the compressed unit
+ * @param unitBlocks   The number of blocks in the unit
+ * @param unitIndex    The position in the unit of the block to uncompress
+ * @param destination  The buffer, one block long, to hold the block
+ * @param callback     The function to call when uncompression is done
+ * @param context      The context to pass to the callback
+ **/
+void uncompressUnitBlock(CompressorRequest  *request,
+                         CompressionCodec    codec,
+                         char               *source,
+                         unsigned int        sourceSize,
+                         unsigned int        unitBlocks,
+                         unsigned int        unitIndex,
+                         char               *destination,
+                         CompressorCallback *callback,
+                         void               *context);
+
+/**
+ * Estimate the Shannon entropy of a buffer from a sparse sample of its
+ * contents. This is much cheaper than a compression attempt, and is used to
+ * skip compressing data which is almost certainly incompressible, such as
+ * data which is already compressed or encrypted.
+ *
+ * @param buffer  The data to examine
+ * @param size    The size of the data
+ *
+ * @return The estimated entropy as a percentage of the maximum of eight bits
+ *         per byte
+ **/
+unsigned int getSampledEntropy(const char *buffer, unsigned int size)
+  __attribute__((warn_unused_result));
+
+#endif /* COMPRESSOR_H */
@@ -25,17 +25,21 @@
 #include "logger.h"
 #include "memoryAlloc.h"
 #include "murmur/MurmurHash3.h"
+#include "timeUtils.h"
+#include "xxhash/XXH3.h"
 
 #include "dataVIO.h"
 #include "compressedBlock.h"
+#include "compressionState.h"
 #include "hashLock.h"
-#include "lz4.h"
 
 #include "bio.h"
+#include "compressor.h"
 #include "dedupeIndex.h"
 #include "kvdoFlush.h"
 #include "kvio.h"
 #include "ioSubmitter.h"
+#include "readCache.h"
 #include "vdoCommon.h"
 #include "verify.h"
 
@@ -48,6 +52,22 @@ enum {
                                 % PAGE_SIZE))
 };
 
+/** The seed for the MurmurHash3 of a data block which is its chunk name */
+static const uint32_t CHUNK_NAME_SEED = 0x62ea60be;
+
+/**
+ * Get the hash function with which the chunk names of a layer's data blocks
+ * are computed, which is fixed when the VDO is formatted.
+ *
+ * @param layer  The kernel layer
+ *
+ * @return The chunk name hash function
+ **/
+static inline UdsChunkNameHash getChunkNameHash(KernelLayer *layer)
+{
+  return layer->geometry.indexConfig.chunkNameHash;
+}
+
 /**
  * Alter the write-access permission to a page of memory, so that
  * objects in the free pool may no longer be modified.
@@ -226,8 +246,9 @@ void kvdoCompleteDataKVIO(VDOCompletion *completion)
 }
 
 /**
- * Copy the uncompressed data from a compressed block read into the user
- * bio which requested the read.
+ * Copy the uncompressed data from a compressed block read, or the data from
+ * a block read through the read cache, into the user bio which requested
+ * the read.
  *
  * @param workItem  The DataKVIO which requested the read
  **/
@@ -256,7 +277,8 @@ static void copyReadBlockData(KvdoWorkItem *workItem)
 }
 
 /**
- * Finish reading data for a compressed block.
+ * Finish reading data for a compressed block, or for a block read through
+ * the read cache.
  *
  * @param dataKVIO  The DataKVIO which requested the read
  **/
@@ -306,6 +328,27 @@ static void resetUserBio(BIO *bio, int error)
 #endif
 }
 
+/**
+ * Finish uncompressing the data that's just been read and then call back the
+ * requesting DataKVIO. Implements CompressorCallback.
+ *
+ * @param context  The DataKVIO requesting the data
+ * @param size     The size of the uncompressed data, or an error
+ **/
+static void finishUncompressingReadBlock(void *context, int size)
+{
+  DataKVIO  *dataKVIO  = context;
+  ReadBlock *readBlock = &dataKVIO->readBlock;
+  if (size == VDO_BLOCK_SIZE) {
+    readBlock->data = dataKVIO->scratchBlock;
+  } else {
+    logDebug("%s: uncompress error %d", __func__, size);
+    readBlock->status = VDO_INVALID_FRAGMENT;
+  }
+
+  readBlock->callback(dataKVIO);
+}
+
 /**
  * Uncompress the data that's just been read and then call back the requesting
  * DataKVIO.
@@ -320,12 +363,11 @@ static void uncompressReadBlock(KvdoWorkItem *workItem)
 
   // The DataKVIO's scratch block will be used to contain the
   // uncompressed data.
-  uint16_t fragmentOffset, fragmentSize;
+  CompressedFragment fragment;
   char *compressedData = readBlock->data;
   int result = getCompressedBlockFragment(readBlock->mappingState,
                                           compressedData, blockSize,
-                                          &fragmentOffset,
-                                          &fragmentSize);
+                                          &fragment);
   if (result != VDO_SUCCESS) {
     logDebug("%s: frag err %d", __func__, result);
     readBlock->status = result;
@@ -333,17 +375,18 @@ static void uncompressReadBlock(KvdoWorkItem *workItem)
     return;
   }
 
-  char *fragment = compressedData + fragmentOffset;
-  int size = LZ4_uncompress_unknownOutputSize(fragment, dataKVIO->scratchBlock,
-                                              fragmentSize, blockSize);
-  if (size == blockSize) {
-    readBlock->data = dataKVIO->scratchBlock;
-  } else {
-    logDebug("%s: lz4 error", __func__);
-    readBlock->status = VDO_INVALID_FRAGMENT;
+  char *fragmentData = compressedData + fragment.offset;
+  if (fragment.unitBlocks > 1) {
+    uncompressUnitBlock(dataKVIO->compressorRequest, fragment.codec,
+                        fragmentData, fragment.size, fragment.unitBlocks,
+                        fragment.unitIndex, dataKVIO->scratchBlock,
+                        finishUncompressingReadBlock, dataKVIO);
+    return;
   }
 
-  readBlock->callback(dataKVIO);
+  uncompressBuffer(dataKVIO->compressorRequest, fragment.codec, fragmentData,
+                   fragment.size, dataKVIO->scratchBlock, blockSize,
+                   finishUncompressingReadBlock, dataKVIO);
 }
 
 /**
@@ -367,6 +410,118 @@ static void completeRead(DataKVIO *dataKVIO, int result)
   readBlock->callback(dataKVIO);
 }
 
+/**
+ * Get the list of compressed block reads in progress which would include a
+ * read of a given block.
+ *
+ * @param layer  The kernel layer
+ * @param pbn    The physical block number
+ *
+ * @return The list of reads
+ **/
+static struct hlist_head *getCompressedReads(KernelLayer         *layer,
+                                             PhysicalBlockNumber  pbn)
+{
+  return &layer->compressedReads[pbn % COMPRESSED_READ_BUCKETS];
+}
+
+/**
+ * Make a DataKVIO wait for a read of the same compressed block which is
+ * already in progress, or if there is none, record that its own read is in
+ * progress.
+ *
+ * @param dataKVIO  The DataKVIO whose read block has been prepared
+ *
+ * @return <code>true</code> if the DataKVIO is waiting for another read
+ **/
+static bool joinCompressedRead(DataKVIO *dataKVIO)
+{
+  KernelLayer       *layer     = getLayerFromDataKVIO(dataKVIO);
+  ReadBlock         *readBlock = &dataKVIO->readBlock;
+  struct hlist_head *reads     = getCompressedReads(layer, readBlock->pbn);
+  unsigned long      flags;
+  spin_lock_irqsave(&layer->compressedReadLock, flags);
+  for (struct hlist_node *node = reads->first; node != NULL;
+       node = node->next) {
+    ReadBlock *read = hlist_entry(node, ReadBlock, inProgressNode);
+    if (read->pbn == readBlock->pbn) {
+      readBlock->nextWaiter = read->waiters;
+      read->waiters         = dataKVIO;
+      spin_unlock_irqrestore(&layer->compressedReadLock, flags);
+      atomic64_inc(&layer->compressedReadsCoalesced);
+      return true;
+    }
+  }
+
+  readBlock->waiters = NULL;
+  hlist_add_head(&readBlock->inProgressNode, reads);
+  spin_unlock_irqrestore(&layer->compressedReadLock, flags);
+  return false;
+}
+
+/**
+ * Finish a read of a compressed block, giving each DataKVIO which waited
+ * for it a copy of the block, from which it will uncompress its own
+ * fragment.
+ *
+ * @param dataKVIO  The DataKVIO which did the read
+ * @param result    The result of the read operation
+ **/
+static void finishCompressedRead(DataKVIO *dataKVIO, int result)
+{
+  KernelLayer   *layer     = getLayerFromDataKVIO(dataKVIO);
+  ReadBlock     *readBlock = &dataKVIO->readBlock;
+  unsigned long  flags;
+  spin_lock_irqsave(&layer->compressedReadLock, flags);
+  hlist_del(&readBlock->inProgressNode);
+  DataKVIO *waiter   = readBlock->waiters;
+  readBlock->waiters = NULL;
+  spin_unlock_irqrestore(&layer->compressedReadLock, flags);
+
+  while (waiter != NULL) {
+    DataKVIO *next = waiter->readBlock.nextWaiter;
+    if (result == VDO_SUCCESS) {
+      memcpy(waiter->readBlock.buffer, readBlock->buffer, VDO_BLOCK_SIZE);
+    }
+    waiter->readBlock.data = waiter->readBlock.buffer;
+    completeRead(waiter, result);
+    waiter = next;
+  }
+}
+
+/**
+ * Finish a read from the device, on a CPU thread since it copies the block:
+ * cache the block, give a copy to each DataKVIO waiting on a read of the same
+ * compressed block, and then uncompress the data or call back the DataKVIO
+ * which did the read.
+ *
+ * @param workItem  The DataKVIO which did the read
+ **/
+static void finishReadFromDevice(KvdoWorkItem *workItem)
+{
+  DataKVIO  *dataKVIO  = workItemAsDataKVIO(workItem);
+  ReadBlock *readBlock = &dataKVIO->readBlock;
+  ReadCache *readCache = getLayerFromDataKVIO(dataKVIO)->readCache;
+  int        result    = readBlock->status;
+  if ((result == VDO_SUCCESS) && (readCache != NULL)) {
+    cacheBlock(readCache, readBlock->pbn, readBlock->buffer);
+  }
+
+  if (!isCompressed(readBlock->mappingState)) {
+    readBlock->callback(dataKVIO);
+    return;
+  }
+
+  finishCompressedRead(dataKVIO, result);
+  if (result == VDO_SUCCESS) {
+    // This is already the thread completeRead() would send it to.
+    uncompressReadBlock(workItem);
+    return;
+  }
+
+  readBlock->callback(dataKVIO);
+}
+
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4,4,0)
 /**
  * Callback for a bio doing a read.
@@ -390,10 +545,58 @@ static void readBioCallback(BIO *bio, int result)
   dataKVIOAddTraceRecord(dataKVIO, THIS_LOCATION(NULL));
   countCompletedBios(bio);
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4,4,0)
-  completeRead(dataKVIO, getBioResult(bio));
-#else
-  completeRead(dataKVIO, result);
+  int result = getBioResult(bio);
 #endif
+  if ((kvio->layer->readCache == NULL)
+      && !isCompressed(dataKVIO->readBlock.mappingState)) {
+    completeRead(dataKVIO, result);
+    return;
+  }
+
+  // The block must be copied, which may not be done here since bio
+  // completion can run in interrupt context.
+  dataKVIO->readBlock.status = result;
+  launchDataKVIOOnCPUQueue(dataKVIO, finishReadFromDevice, NULL,
+                           CPU_Q_ACTION_COMPRESS_BLOCK);
+}
+
+/**
+ * Read a block from the device into the read block buffer of a DataKVIO.
+ *
+ * @param dataKVIO  The DataKVIO whose read block has been prepared
+ * @param action    The bio queue action
+ **/
+static void readBlockFromDevice(DataKVIO *dataKVIO, BioQAction action)
+{
+  KernelLayer *layer = getLayerFromDataKVIO(dataKVIO);
+  BUG_ON(getBIOFromDataKVIO(dataKVIO)->bi_private != &dataKVIO->kvio);
+  // Read the data directly from the device using the read bio.
+  BIO *bio = dataKVIO->readBlock.bio;
+  resetBio(bio, layer);
+  setBioSector(bio, blockToSector(layer, dataKVIO->readBlock.pbn));
+  setBioOperationRead(bio);
+  bio->bi_end_io = readBioCallback;
+  submitBio(bio, action);
+}
+
+/**
+ * Prepare the read block of a DataKVIO for a read.
+ *
+ * @param dataKVIO      The DataKVIO
+ * @param location      The physical block number to read from
+ * @param mappingState  The mapping state of the block to read
+ * @param callback      The function to call when the read is done
+ **/
+static void prepareReadBlock(DataKVIO            *dataKVIO,
+                             PhysicalBlockNumber  location,
+                             BlockMappingState    mappingState,
+                             DataKVIOCallback     callback)
+{
+  ReadBlock *readBlock    = &dataKVIO->readBlock;
+  readBlock->callback     = callback;
+  readBlock->status       = VDO_SUCCESS;
+  readBlock->mappingState = mappingState;
+  readBlock->pbn          = location;
 }
 
 /**********************************************************************/
@@ -408,19 +611,24 @@ void kvdoReadBlock(DataVIO             *dataVIO,
   DataKVIO    *dataKVIO  = dataVIOAsDataKVIO(dataVIO);
   ReadBlock   *readBlock = &dataKVIO->readBlock;
   KernelLayer *layer     = getLayerFromDataKVIO(dataKVIO);
+  prepareReadBlock(dataKVIO, location, mappingState, callback);
+  if (layer->readCache != NULL) {
+    if (copyCachedBlock(layer->readCache, location, readBlock->buffer)) {
+      atomic64_inc(&layer->readCacheHits);
+      readBlock->data = readBlock->buffer;
+      completeRead(dataKVIO, VDO_SUCCESS);
+      return;
+    }
+    atomic64_inc(&layer->readCacheMisses);
+  }
 
-  readBlock->callback     = callback;
-  readBlock->status       = VDO_SUCCESS;
-  readBlock->mappingState = mappingState;
+  // Concurrent readers of the fragments of one compressed block, which are
+  // usually reading data which was written together, share a single read.
+  if (isCompressed(mappingState) && joinCompressedRead(dataKVIO)) {
+    return;
+  }
 
-  BUG_ON(getBIOFromDataKVIO(dataKVIO)->bi_private != &dataKVIO->kvio);
-  // Read the data directly from the device using the read bio.
-  BIO *bio = readBlock->bio;
-  resetBio(bio, layer);
-  setBioSector(bio, blockToSector(layer, location));
-  setBioOperationRead(bio);
-  bio->bi_end_io = readBioCallback;
-  submitBio(bio, action);
+  readBlockFromDevice(dataKVIO, action);
 }
 
 /**********************************************************************/
@@ -438,6 +646,28 @@ void kvdoReadDataVIO(DataVIO *dataVIO)
 
   KVIO *kvio = dataVIOAsKVIO(dataVIO);
   BIO  *bio  = kvio->bio;
+  ReadCache *readCache = kvio->layer->readCache;
+  if (readCache != NULL) {
+    DataKVIO *dataKVIO = dataVIOAsDataKVIO(dataVIO);
+    if (copyCachedBlockToBio(readCache, dataVIO->mapped.pbn, bio)) {
+      // The data is already where the read would have put it.
+      atomic64_inc(&kvio->layer->readCacheHits);
+      if (dataKVIO->isPartial) {
+        kvdoEnqueueDataVIOCallback(dataKVIO);
+      } else {
+        kvdoAcknowledgeDataVIO(dataVIO);
+      }
+      return;
+    }
+
+    // Read through the read block buffer, so that the block can be cached.
+    atomic64_inc(&kvio->layer->readCacheMisses);
+    prepareReadBlock(dataKVIO, dataVIO->mapped.pbn, dataVIO->mapped.state,
+                     readDataKVIOReadBlockCallback);
+    readBlockFromDevice(dataKVIO, BIO_Q_ACTION_DATA);
+    return;
+  }
+
   bio->bi_end_io = resetUserBio;
   setBioSector(bio, blockToSector(kvio->layer, dataVIO->mapped.pbn));
   submitBio(bio, BIO_Q_ACTION_DATA);
@@ -480,6 +710,46 @@ void kvdoAcknowledgeDataVIO(DataVIO *dataVIO)
   }
 }
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,4,0)
+/**
+ * Complete a data block write, recording the digest of what is now stored
+ * in the block if it has already been computed.
+ *
+ * @param bio   The bio to complete
+ **/
+static void completeDataWriteBio(BIO *bio)
+#else
+/**
+ * Complete a data block write, recording the digest of what is now stored
+ * in the block if it has already been computed.
+ *
+ * @param bio   The bio to complete
+ * @param error Possible error from underlying block device
+ **/
+static void completeDataWriteBio(BIO *bio, int error)
+#endif
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,4,0)
+  int error = getBioResult(bio);
+#endif
+  DataKVIO *dataKVIO = kvioAsDataKVIO((KVIO *) bio->bi_private);
+  if (error == 0) {
+    if (dataKVIO->hasDigest) {
+      recordBlockDigest(getLayerFromDataKVIO(dataKVIO)->blockDigests,
+                        dataKVIO->dataVIO.newMapped.pbn, &dataKVIO->digest);
+    } else {
+      // The digest will be recorded once the block has been hashed.
+      dataKVIO->isWritten = true;
+    }
+  }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,4,0)
+  completeAsyncBio(bio);
+#else
+  completeAsyncBio(bio, error);
+#endif
+}
+
 /**********************************************************************/
 void kvdoWriteDataVIO(DataVIO *dataVIO)
 {
@@ -489,6 +759,14 @@ void kvdoWriteDataVIO(DataVIO *dataVIO)
 
   KVIO *kvio  = dataVIOAsKVIO(dataVIO);
   BIO  *bio   = kvio->bio;
+  if (kvio->layer->readCache != NULL) {
+    invalidateCachedBlock(kvio->layer->readCache, dataVIO->newMapped.pbn);
+  }
+  if (kvio->layer->blockDigests != NULL) {
+    // Whatever digest the block had no longer describes it.
+    forgetBlockDigest(kvio->layer->blockDigests, dataVIO->newMapped.pbn);
+    bio->bi_end_io = completeDataWriteBio;
+  }
   setBioOperationWrite(bio);
   setBioSector(bio, blockToSector(kvio->layer, dataVIO->newMapped.pbn));
   submitBio(bio, BIO_Q_ACTION_DATA);
@@ -533,31 +811,25 @@ void kvdoCopyDataVIO(DataVIO *source, DataVIO *destination)
                  dataVIOAsDataKVIO(source)->dataBlock);
 }
 
-/**********************************************************************/
-static void kvdoCompressWork(KvdoWorkItem *item)
+/**
+ * Record the result of compressing a DataKVIO's data block and continue
+ * processing the DataVIO. Implements CompressorCallback.
+ *
+ * @param context  The DataKVIO which was compressed
+ * @param size     The size of the compressed data, or an error
+ **/
+static void finishCompressingDataKVIO(void *context, int size)
 {
-  DataKVIO    *dataKVIO = workItemAsDataKVIO(item);
-  KernelLayer *layer    = getLayerFromDataKVIO(dataKVIO);
-  dataKVIOAddTraceRecord(dataKVIO, THIS_LOCATION(NULL));
-
-  char *context = getWorkQueuePrivateData();
-  if (unlikely(context == NULL)) {
-    uint32_t index = atomicAdd32(&layer->compressionContextIndex, 1) - 1;
-    BUG_ON(index >= layer->deviceConfig->threadCounts.cpuThreads);
-    context = layer->compressionContext[index];
-    setWorkQueuePrivateData(context);
-  }
-
-  int size = LZ4_compress_ctx_limitedOutput(context, dataKVIO->dataBlock,
-                                            dataKVIO->scratchBlock,
-                                            VDO_BLOCK_SIZE,
-                                            VDO_BLOCK_SIZE);
-  DataVIO *dataVIO = &dataKVIO->dataVIO;
+  DataKVIO *dataKVIO = context;
+  DataVIO  *dataVIO  = &dataKVIO->dataVIO;
   if (size > 0) {
     // The scratch block will be used to contain the compressed data.
-    dataVIO->compression.data = dataKVIO->scratchBlock;
-    dataVIO->compression.size = size;
+    dataVIO->compression.data  = dataKVIO->scratchBlock;
+    dataVIO->compression.size  = size;
+    dataVIO->compression.codec
+      = getCompressorCodec(getLayerFromDataKVIO(dataKVIO)->compressor);
   } else {
+    atomic64_inc(&getLayerFromDataKVIO(dataKVIO)->compressionFailures);
     // Use block size plus one as an indicator for uncompressible data.
     dataVIO->compression.size = VDO_BLOCK_SIZE + 1;
   }
@@ -565,6 +837,185 @@ static void kvdoCompressWork(KvdoWorkItem *item)
   kvdoEnqueueDataVIOCallback(dataKVIO);
 }
 
+/**
+ * Check whether a DataKVIO's data block looks too random to be worth
+ * compressing, based on the entropy of a sample of its bytes.
+ *
+ * @param dataKVIO  The DataKVIO to check
+ *
+ * @return <code>true</code> if compression should not be attempted
+ **/
+static bool isLikelyIncompressible(DataKVIO *dataKVIO)
+{
+  unsigned int threshold
+    = getLayerFromDataKVIO(dataKVIO)->deviceConfig->compressionThreshold;
+  if (threshold == 0) {
+    return false;
+  }
+
+  unsigned int entropy
+    = (dataKVIO->hasSampledEntropy
+       ? dataKVIO->sampledEntropy
+       : getSampledEntropy(dataKVIO->dataBlock, VDO_BLOCK_SIZE));
+  return (entropy >= threshold);
+}
+
+/**
+ * Send a DataKVIO on without compressing it if its data block looks too
+ * random to be worth compressing.
+ *
+ * @param dataKVIO  The DataKVIO to check
+ *
+ * @return <code>true</code> if the DataKVIO was sent on uncompressed
+ **/
+static bool rejectIncompressibleDataKVIO(DataKVIO *dataKVIO)
+{
+  if (!isLikelyIncompressible(dataKVIO)) {
+    return false;
+  }
+
+  atomic64_inc(&getLayerFromDataKVIO(dataKVIO)->compressionEarlyRejects);
+  dataKVIO->dataVIO.compression.size = VDO_BLOCK_SIZE + 1;
+  kvdoEnqueueDataVIOCallback(dataKVIO);
+  return true;
+}
+
+/**
+ * Compress a DataKVIO's data block on its own.
+ *
+ * @param dataKVIO  The DataKVIO to compress
+ **/
+static void compressDataKVIO(DataKVIO *dataKVIO)
+{
+  compressBuffer(dataKVIO->compressorRequest, dataKVIO->dataBlock,
+                 VDO_BLOCK_SIZE, dataKVIO->scratchBlock, VDO_BLOCK_SIZE,
+                 finishCompressingDataKVIO, dataKVIO);
+}
+
+/**********************************************************************/
+static void kvdoCompressWork(KvdoWorkItem *item)
+{
+  DataKVIO *dataKVIO = workItemAsDataKVIO(item);
+  dataKVIOAddTraceRecord(dataKVIO, THIS_LOCATION(NULL));
+  if (rejectIncompressibleDataKVIO(dataKVIO)) {
+    return;
+  }
+
+  compressDataKVIO(dataKVIO);
+}
+
+/**
+ * A run of DataKVIOs for logically adjacent blocks being compressed as one
+ * unit.
+ **/
+typedef struct {
+  /** The DataKVIOs, in logical block order; the first leads the unit */
+  DataKVIO     **members;
+  /** The number of DataKVIOs in the unit */
+  unsigned int   count;
+} CompressionUnit;
+
+/**
+ * Record the result of compressing a run of DataKVIOs as a unit and continue
+ * processing the unit's leader, which carries the other members with it.
+ * Implements CompressorCallback.
+ *
+ * @param context  The CompressionUnit which was compressed
+ * @param size     The size of the compressed unit, or an error
+ **/
+static void finishCompressingUnit(void *context, int size)
+{
+  CompressionUnit *unit = context;
+  if (size <= 0) {
+    // The unit doesn't fit in one compressed block, so compress each block
+    // on its own instead.
+    for (unsigned int i = 0; i < unit->count; i++) {
+      compressDataKVIO(unit->members[i]);
+    }
+    return;
+  }
+
+  DataKVIO *leader    = unit->members[0];
+  DataVIO  *leaderVIO = &leader->dataVIO;
+  leaderVIO->compression.data  = leader->scratchBlock;
+  leaderVIO->compression.size  = size;
+  leaderVIO->compression.codec
+    = getCompressorCodec(getLayerFromDataKVIO(leader)->compressor);
+  for (unsigned int i = 1; i < unit->count; i++) {
+    DataVIO *memberVIO = &unit->members[i]->dataVIO;
+    memberVIO->compression.size = 0;
+    addToCompressionUnit(leaderVIO, memberVIO);
+  }
+
+  kvdoEnqueueDataVIOCallback(leader);
+}
+
+/**
+ * Compress the DataKVIOs in a batch, compressing each run of DataKVIOs for
+ * logically adjacent blocks together as one unit. The whole unit must fit in
+ * a single compressed block, so it need only be uncompressed once to read
+ * any or all of its blocks.
+ *
+ * @param batch      The batch processor, which is locked
+ * @param dataKVIOs  The DataKVIOs in the batch
+ * @param count      The number of DataKVIOs in the batch
+ * @param unitLimit  The most blocks to put in one unit
+ **/
+static void compressDataKVIOUnits(BatchProcessor  *batch,
+                                  DataKVIO       **dataKVIOs,
+                                  unsigned int     count,
+                                  unsigned int     unitLimit)
+{
+  // Send on the blocks not worth compressing, and sort the rest by logical
+  // block number so that adjacent blocks are next to each other.
+  unsigned int candidates = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    DataKVIO *dataKVIO = dataKVIOs[i];
+    dataKVIOAddTraceRecord(dataKVIO, THIS_LOCATION(NULL));
+    if (rejectIncompressibleDataKVIO(dataKVIO)) {
+      continue;
+    }
+
+    LogicalBlockNumber lbn = dataKVIO->dataVIO.logical.lbn;
+    unsigned int j = candidates++;
+    for (; (j > 0) && (dataKVIOs[j - 1]->dataVIO.logical.lbn > lbn); j--) {
+      dataKVIOs[j] = dataKVIOs[j - 1];
+    }
+    dataKVIOs[j] = dataKVIO;
+  }
+
+  for (unsigned int start = 0; start < candidates;) {
+    unsigned int length = 1;
+    while (((start + length) < candidates) && (length < unitLimit)
+           && (dataKVIOs[start + length]->dataVIO.logical.lbn
+               == (dataKVIOs[start + length - 1]->dataVIO.logical.lbn + 1))) {
+      length++;
+    }
+
+    if (length == 1) {
+      compressDataKVIO(dataKVIOs[start]);
+    } else {
+      CompressionUnit unit = {
+        .members = &dataKVIOs[start],
+        .count   = length,
+      };
+      char *blocks[MAX_COMPRESSION_UNIT_BLOCKS];
+      for (unsigned int i = 0; i < length; i++) {
+        blocks[i] = dataKVIOs[start + i]->dataBlock;
+      }
+
+      DataKVIO *leader = dataKVIOs[start];
+      compressUnit(leader->compressorRequest, blocks, length,
+                   leader->scratchBlock,
+                   VDO_BLOCK_SIZE - sizeof(CompressedBlock),
+                   finishCompressingUnit, &unit);
+    }
+
+    start += length;
+    condReschedBatchProcessor(batch);
+  }
+}
+
 /**********************************************************************/
 void kvdoCompressDataVIO(DataVIO *dataVIO)
 {
@@ -585,8 +1036,54 @@ void kvdoCompressDataVIO(DataVIO *dataVIO)
     return;
   }
 
-  launchDataKVIOOnCPUQueue(dataKVIO, kvdoCompressWork, NULL,
-                           CPU_Q_ACTION_COMPRESS_BLOCK);
+  // Send runs of consecutive DataKVIOs to the same batcher so that each
+  // batcher fills up rather than all of them trickling along.
+  KernelLayer  *layer     = getLayerFromDataKVIO(dataKVIO);
+  unsigned int  batchSize = layer->deviceConfig->compressionBatchSize;
+  uint32_t      sequence
+    = atomicAdd32(&layer->compressionBatchSequence, 1) - 1;
+  uint32_t      index     = ((sequence / batchSize)
+                             % layer->compressionBatcherCount);
+  setupKVIOWork(dataKVIOAsKVIO(dataKVIO), kvdoCompressWork, NULL,
+                CPU_Q_ACTION_COMPRESS_BLOCK);
+  addToBatchProcessor(layer->compressionBatchers[index],
+                      workItemFromDataKVIO(dataKVIO));
+}
+
+/**********************************************************************/
+void compressDataKVIOBatch(BatchProcessor *batch, void *closure)
+{
+  KernelLayer  *layer     = closure;
+  unsigned int  batchSize = layer->deviceConfig->compressionBatchSize;
+  unsigned int  count     = 0;
+  DataKVIO     *dataKVIOs[COMPRESSION_BATCH_SIZE_LIMIT];
+
+  KvdoWorkItem *item;
+  while ((count < batchSize) && ((item = nextBatchItem(batch)) != NULL)) {
+    if (count == 0) {
+      enterHistogramSample(layer->compressionBatchFillTimeHistogram,
+                           (currentTime(CT_MONOTONIC) - item->enqueueTime)
+                           / 1000);
+    }
+    item->enqueueTime = 0;
+    dataKVIOs[count++] = workItemAsDataKVIO(item);
+  }
+
+  if (count == 0) {
+    return;
+  }
+
+  enterHistogramSample(layer->compressionBatchSizeHistogram, count);
+  unsigned int unitLimit = layer->deviceConfig->compressionUnit;
+  if ((unitLimit > 1) && canCompressUnits(layer->compressor)) {
+    compressDataKVIOUnits(batch, dataKVIOs, count, unitLimit);
+    return;
+  }
+
+  for (unsigned int i = 0; i < count; i++) {
+    kvdoCompressWork(workItemFromDataKVIO(dataKVIOs[i]));
+    condReschedBatchProcessor(batch);
+  }
 }
 
 /**
@@ -616,6 +1113,10 @@ static int makeDataKVIO(KernelLayer *layer, BIO *bio, DataKVIO **dataKVIOPtr)
   memset(&kvio->enqueueable, 0, sizeof(KvdoEnqueueable));
   memset(&dataKVIO->dedupeContext.pendingList, 0, sizeof(struct list_head));
   memset(&dataKVIO->dataVIO, 0, sizeof(DataVIO));
+  dataKVIO->isHashed          = false;
+  dataKVIO->hasSampledEntropy = false;
+  dataKVIO->hasDigest         = false;
+  dataKVIO->isWritten         = false;
   kvio->bioToSubmit = NULL;
   bio_list_init(&kvio->biosMerged);
 
@@ -629,6 +1130,38 @@ static int makeDataKVIO(KernelLayer *layer, BIO *bio, DataKVIO **dataKVIOPtr)
   return VDO_SUCCESS;
 }
 
+/**
+ * Copy the data of a full-block write into a DataKVIO's data block, and do
+ * everything else which needs to read all of the data in the same pass while
+ * it is in cache: check whether it is all zeroes, and if not, compute the
+ * chunk name and, if the block might be compressed, sample its entropy.
+ *
+ * @param layer     The kernel layer
+ * @param dataKVIO  The DataKVIO for the write
+ * @param bio       The bio holding the data being written
+ **/
+static void scanDataKVIOOnArrival(KernelLayer *layer,
+                                  DataKVIO    *dataKVIO,
+                                  BIO         *bio)
+{
+  DataVIO *dataVIO = &dataKVIO->dataVIO;
+  dataVIO->isZeroBlock = bioCopyDataInAndHash(bio, dataKVIO->dataBlock,
+                                              getChunkNameHash(layer),
+                                              CHUNK_NAME_SEED,
+                                              &dataVIO->chunkName);
+  if (dataVIO->isZeroBlock) {
+    return;
+  }
+
+  dataKVIO->isHashed = true;
+  if ((layer->deviceConfig->compressionThreshold > 0)
+      && getKVDOCompressing(&layer->kvdo)) {
+    dataKVIO->sampledEntropy
+      = getSampledEntropy(dataKVIO->dataBlock, VDO_BLOCK_SIZE);
+    dataKVIO->hasSampledEntropy = true;
+  }
+}
+
 /**
  * Creates a new DataVIO structure. A DataVIO represents a single logical
  * block of data. It is what most VDO operations work with. This function also
@@ -693,10 +1226,9 @@ static int kvdoCreateKVIOFromBio(KernelLayer  *layer,
        */
       memset(dataKVIO->dataBlock, 0, VDO_BLOCK_SIZE);
     } else if (bio_data_dir(bio) == WRITE) {
-      dataKVIO->dataVIO.isZeroBlock = bioIsZeroData(bio);
       // Copy the bio data to a char array so that we can continue to use
       // the data after we acknowledge the bio.
-      bioCopyDataIn(bio, dataKVIO->dataBlock);
+      scanDataKVIOOnArrival(layer, dataKVIO, bio);
     }
   }
 
@@ -856,7 +1388,44 @@ int kvdoLaunchDataKVIOFromBio(KernelLayer *layer,
 }
 
 /**
- * Hash a DataKVIO and set its chunk name.
+ * Finish hashing a DataKVIO whose chunk name has been computed, and send it
+ * on its way.
+ *
+ * @param dataKVIO  The DataKVIO which has been hashed
+ **/
+static void finishHashingDataKVIO(DataKVIO *dataKVIO)
+{
+  dataKVIO->dedupeContext.chunkName = &dataKVIO->dataVIO.chunkName;
+  kvdoEnqueueDataVIOCallback(dataKVIO);
+}
+
+/**
+ * Compute the strong digest of a DataKVIO's data block if the layer keeps
+ * block digests. If the block has already been written (as it is by a
+ * synchronous write), the digest is recorded for its new physical block;
+ * the DataKVIO still holds its logical lock and its reference to that
+ * block, so the block can't have been reused in the meantime.
+ *
+ * @param dataKVIO  The DataKVIO to digest
+ **/
+static void digestDataKVIO(DataKVIO *dataKVIO)
+{
+  BlockDigests *blockDigests = getLayerFromDataKVIO(dataKVIO)->blockDigests;
+  if (blockDigests == NULL) {
+    return;
+  }
+
+  dataKVIO->hasDigest = computeBlockDigest(blockDigests, dataKVIO->dataBlock,
+                                           &dataKVIO->digest);
+  if (dataKVIO->hasDigest && dataKVIO->isWritten) {
+    recordBlockDigest(blockDigests, dataKVIO->dataVIO.newMapped.pbn,
+                      &dataKVIO->digest);
+  }
+}
+
+/**
+ * Hash a DataKVIO and set its chunk name, unless that was done when the
+ * data was copied in, and compute its strong digest if needed.
  *
  * @param item  The DataKVIO to be hashed
  **/
@@ -866,19 +1435,91 @@ static void kvdoHashDataWork(KvdoWorkItem *item)
   DataVIO  *dataVIO  = &dataKVIO->dataVIO;
   dataVIOAddTraceRecord(dataVIO, THIS_LOCATION(NULL));
 
-  MurmurHash3_x64_128(dataKVIO->dataBlock, VDO_BLOCK_SIZE, 0x62ea60be,
-                      &dataVIO->chunkName);
-  dataKVIO->dedupeContext.chunkName = &dataVIO->chunkName;
-
-  kvdoEnqueueDataVIOCallback(dataKVIO);
+  if (!dataKVIO->isHashed) {
+    KernelLayer *layer = getLayerFromDataKVIO(dataKVIO);
+    if (getChunkNameHash(layer) == UDS_CHUNK_NAME_XXH3) {
+      XXH3_128bits(dataKVIO->dataBlock, VDO_BLOCK_SIZE, &dataVIO->chunkName);
+    } else {
+      MurmurHash3_x64_128(dataKVIO->dataBlock, VDO_BLOCK_SIZE,
+                          CHUNK_NAME_SEED, &dataVIO->chunkName);
+    }
+  }
+  digestDataKVIO(dataKVIO);
+  finishHashingDataKVIO(dataKVIO);
 }
 
 /**********************************************************************/
 void kvdoHashDataVIO(DataVIO *dataVIO)
 {
   dataVIOAddTraceRecord(dataVIO, THIS_LOCATION(NULL));
-  launchDataKVIOOnCPUQueue(dataVIOAsDataKVIO(dataVIO), kvdoHashDataWork, NULL,
-                           CPU_Q_ACTION_HASH_BLOCK);
+  DataKVIO    *dataKVIO = dataVIOAsDataKVIO(dataVIO);
+  KernelLayer *layer    = getLayerFromDataKVIO(dataKVIO);
+  if (dataKVIO->isHashed) {
+    // The chunk name was computed when the data was copied in.
+    if (layer->blockDigests == NULL) {
+      finishHashingDataKVIO(dataKVIO);
+    } else {
+      // The strong digest is too costly to compute on this thread.
+      launchDataKVIOOnCPUQueue(dataKVIO, kvdoHashDataWork, NULL,
+                               CPU_Q_ACTION_HASH_BLOCK);
+    }
+    return;
+  }
+
+  if (getChunkNameHash(layer) != UDS_CHUNK_NAME_MURMUR3) {
+    // Only MurmurHash3 has a multi-buffer form worth batching for.
+    launchDataKVIOOnCPUQueue(dataKVIO, kvdoHashDataWork, NULL,
+                             CPU_Q_ACTION_HASH_BLOCK);
+    return;
+  }
+
+  // Send runs of consecutive DataKVIOs to the same batcher so that a full
+  // set of lanes for the multi-buffer hash tends to accumulate on one.
+  uint32_t sequence = atomicAdd32(&layer->hashBatchSequence, 1) - 1;
+  uint32_t index    = ((sequence / MURMUR_MULTI_LANES)
+                       % layer->hashBatcherCount);
+  setupKVIOWork(dataKVIOAsKVIO(dataKVIO), kvdoHashDataWork, NULL,
+                CPU_Q_ACTION_HASH_BLOCK);
+  addToBatchProcessor(layer->hashBatchers[index],
+                      workItemFromDataKVIO(dataKVIO));
+}
+
+/**********************************************************************/
+void hashDataKVIOBatch(BatchProcessor *batch,
+                       void           *closure __attribute__((unused)))
+{
+  DataKVIO     *dataKVIOs[MURMUR_MULTI_LANES];
+  unsigned int  count = 0;
+  KvdoWorkItem *item;
+  while ((count < MURMUR_MULTI_LANES)
+         && ((item = nextBatchItem(batch)) != NULL)) {
+    dataKVIOs[count++] = workItemAsDataKVIO(item);
+  }
+
+  if (count < MURMUR_MULTI_LANES) {
+    // Not enough blocks are waiting to fill every lane; hashing them one at a
+    // time is cheaper than hashing padding.
+    for (unsigned int i = 0; i < count; i++) {
+      kvdoHashDataWork(workItemFromDataKVIO(dataKVIOs[i]));
+    }
+    condReschedBatchProcessor(batch);
+    return;
+  }
+
+  const void *blocks[MURMUR_MULTI_LANES];
+  void       *names[MURMUR_MULTI_LANES];
+  for (unsigned int i = 0; i < MURMUR_MULTI_LANES; i++) {
+    dataVIOAddTraceRecord(&dataKVIOs[i]->dataVIO, THIS_LOCATION(NULL));
+    blocks[i] = dataKVIOs[i]->dataBlock;
+    names[i]  = &dataKVIOs[i]->dataVIO.chunkName;
+  }
+
+  MurmurHash3_x64_128_multi(blocks, VDO_BLOCK_SIZE, CHUNK_NAME_SEED, names);
+  for (unsigned int i = 0; i < MURMUR_MULTI_LANES; i++) {
+    digestDataKVIO(dataKVIOs[i]);
+    finishHashingDataKVIO(dataKVIOs[i]);
+  }
+  condReschedBatchProcessor(batch);
 }
 
 /**********************************************************************/
@@ -934,6 +1575,7 @@ static void freePooledDataKVIO(void *poolData, void *data)
     freeBio(dataKVIO->readBlock.bio, layer);
   }
 
+  freeCompressorRequest(&dataKVIO->compressorRequest);
   FREE(dataKVIO->readBlock.buffer);
   FREE(dataKVIO->dataBlock);
   FREE(dataKVIO->scratchBlock);
@@ -1007,6 +1649,15 @@ static int allocatePooledDataKVIO(KernelLayer *layer, DataKVIO **dataKVIOPtr)
                                    "DataKVIO scratch allocation failure");
   }
 
+  result = makeCompressorRequest(layer->compressor,
+                                 &dataKVIO->compressorRequest);
+  if (result != VDO_SUCCESS) {
+    freePooledDataKVIO(layer, dataKVIO);
+    return logErrorWithStringError(result,
+                                   "DataKVIO compressor request allocation"
+                                   " failure");
+  }
+
   *dataKVIOPtr = dataKVIO;
   return VDO_SUCCESS;
 }
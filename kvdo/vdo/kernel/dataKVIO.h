@@ -22,6 +22,7 @@
 #ifndef DATA_KVIO_H
 #define DATA_KVIO_H
 
+#include "blockDigests.h"
 #include "dataVIO.h"
 #include "kvio.h"
 #include "uds-block.h"
@@ -76,10 +77,27 @@ typedef struct {
    * the data must be uncompressed.
    **/
   BlockMappingState    mappingState;
+  /**
+   * The physical block being read, so that it can be cached.
+   **/
+  PhysicalBlockNumber  pbn;
   /**
    * The result code of the read attempt.
    **/
   int                  status;
+  /**
+   * The entry for this read in the layer's compressed reads in progress,
+   * if it is the read of a compressed block which others may wait for.
+   **/
+  struct hlist_node    inProgressNode;
+  /**
+   * The DataKVIOs waiting for this read of a compressed block.
+   **/
+  DataKVIO            *waiters;
+  /**
+   * The next DataKVIO waiting for the same read as this one.
+   **/
+  DataKVIO            *nextWaiter;
 } ReadBlock;
 
 struct dataKVIO {
@@ -112,6 +130,20 @@ struct dataKVIO {
   BIO               *dataBlockBio;
   /** A block used as output during compression or uncompression. */
   char              *scratchBlock;
+  /** The state for issuing compression or uncompression operations. */
+  CompressorRequest *compressorRequest;
+  /** Whether the chunk name was computed while copying the data in. */
+  bool               isHashed;
+  /** Whether the sampled entropy was measured while copying the data in. */
+  bool               hasSampledEntropy;
+  /** The sampled entropy of the data block, if hasSampledEntropy is set. */
+  unsigned int       sampledEntropy;
+  /** Whether the strong digest of the data block has been computed. */
+  bool               hasDigest;
+  /** Whether the data block has been written to its new physical block. */
+  bool               isWritten;
+  /** The strong digest of the data block, if hasDigest is set. */
+  BlockDigest        digest;
 };
 
 /**
@@ -341,6 +373,31 @@ int kvdoLaunchDataKVIOFromBio(KernelLayer *layer,
  **/
 void returnDataKVIOBatchToPool(BatchProcessor *batch, void *closure);
 
+/**
+ * Compress a batch of DataKVIOs. At most one batch's worth of DataKVIOs will
+ * be taken from the batch processor per call, so that an asynchronous
+ * compressor sees them as a single burst of submissions.
+ *
+ * <p>Implements BatchProcessorCallback.
+ *
+ * @param batch    The batch processor
+ * @param closure  The kernel layer
+ **/
+void compressDataKVIOBatch(BatchProcessor *batch, void *closure);
+
+/**
+ * Hash a batch of DataKVIOs. Whenever enough DataKVIOs are waiting, a full
+ * set of them is taken and their blocks are hashed together with the
+ * multi-buffer MurmurHash3, which produces the same chunk names as hashing
+ * each block on its own but keeps more of the CPU busy.
+ *
+ * <p>Implements BatchProcessorCallback.
+ *
+ * @param batch    The batch processor
+ * @param closure  The kernel layer
+ **/
+void hashDataKVIOBatch(BatchProcessor *batch, void *closure);
+
 /**
  * Implements DataVIOZeroer.
  *
@@ -34,9 +34,9 @@ Jiffies albireoTimeoutJiffies = 0;
 static Jiffies minAlbireoTimerJiffies = 0;
 
 /**********************************************************************/
-Jiffies getAlbireoTimeout(Jiffies startJiffies)
+Jiffies getAlbireoTimeout(Jiffies startJiffies, Jiffies timeoutJiffies)
 {
-  return maxULong(startJiffies + albireoTimeoutJiffies,
+  return maxULong(startJiffies + timeoutJiffies,
                   jiffies + minAlbireoTimerJiffies);
 }
 
@@ -301,11 +301,14 @@ extern unsigned int minAlbireoTimerInterval;
  * Calculate the actual end of a timer, taking into account the absolute
  * start time and the present time.
  *
- * @param startJiffies  The absolute start time, in jiffies
+ * @param startJiffies    The absolute start time, in jiffies
+ * @param timeoutJiffies  The timeout, in jiffies, which is the albireo
+ *                        timeout interval or, when the index has been
+ *                        answering faster, less
  *
  * @return the absolute end time for the timer, in jiffies
  **/
-Jiffies getAlbireoTimeout(Jiffies startJiffies);
+Jiffies getAlbireoTimeout(Jiffies startJiffies, Jiffies timeoutJiffies);
 
 /**
  * Set the interval from submission until switching to fast path and
@@ -27,6 +27,9 @@
 #include "memoryAlloc.h"
 #include "stringUtils.h"
 
+#include "blockDigests.h"
+#include "readCache.h"
+#include "compressor.h"
 #include "vdoStringUtils.h"
 
 #include "constants.h"
@@ -38,7 +41,14 @@ enum {
   BIO_ROTATION_INTERVAL_LIMIT = 1024,
   LOGICAL_THREAD_COUNT_LIMIT  = 60,
   PHYSICAL_THREAD_COUNT_LIMIT = 16,  
+  PACKER_THREAD_COUNT_LIMIT   = 16,
   THREAD_COUNT_LIMIT          = 100,
+  // Limits used when parsing compression batching parameters
+  COMPRESSION_BATCH_DELAY_LIMIT = 10000,
+  // Limit used when parsing the compression entropy and bypass thresholds
+  COMPRESSION_THRESHOLD_LIMIT   = 100,
+  // Limit used when parsing the packer bin age deadline, in microseconds
+  PACKER_MAX_AGE_LIMIT          = 1000000,
   // XXX The bio-submission queue configuration defaults are temporarily
   // still being defined here until the new runtime-based thread
   // configuration has been fully implemented for managed VDO devices.
@@ -244,6 +254,19 @@ static int processOneThreadConfigSpec(const char        *threadParamType,
     }
     config->physicalZones = count;
     return VDO_SUCCESS;
+  } else if (strcmp(threadParamType, "packer") == 0) {
+    if (count == 0) {
+      logError("thread config string error:"
+               " at least one 'packer' thread required");
+      return -EINVAL;
+    } else if (count > PACKER_THREAD_COUNT_LIMIT) {
+      logError("thread config string error: at most %d 'packer' threads"
+               " are allowed",
+               PACKER_THREAD_COUNT_LIMIT);
+      return -EINVAL;
+    }
+    config->packerZones = count;
+    return VDO_SUCCESS;
   } else {
     // Handle other thread count parameters
     if (count > THREAD_COUNT_LIMIT) {
@@ -327,7 +350,7 @@ static int parseOneThreadConfigSpec(const char        *spec,
  *
  * The configuration string should contain one or more comma-separated specs
  * of the form "typename=number"; the supported type names are "cpu", "ack",
- * "bio", "bioRotationInterval", "logical", "physical", and "hash".
+ * "bio", "bioRotationInterval", "logical", "physical", "hash", and "packer".
  *
  * If an error occurs during parsing of a single key/value pair, we deem
  * it serious enough to stop further parsing. 
@@ -397,7 +420,71 @@ static int processOneKeyValuePair(const char   *key,
     }
     config->maxDiscardBlocks = value;
     return VDO_SUCCESS;
-  } 
+  } else if (strcmp(key, "compressionBatch") == 0) {
+    if ((value == 0) || (value > COMPRESSION_BATCH_SIZE_LIMIT)) {
+      logError("optional parameter error: 'compressionBatch' must be"
+               " between 1 and %d", COMPRESSION_BATCH_SIZE_LIMIT);
+      return -EINVAL;
+    }
+    config->compressionBatchSize = value;
+    return VDO_SUCCESS;
+  } else if (strcmp(key, "compressionBatchDelay") == 0) {
+    if (value > COMPRESSION_BATCH_DELAY_LIMIT) {
+      logError("optional parameter error: 'compressionBatchDelay' cannot be"
+               " more than %d microseconds", COMPRESSION_BATCH_DELAY_LIMIT);
+      return -EINVAL;
+    }
+    config->compressionBatchDelay = value;
+    return VDO_SUCCESS;
+  } else if (strcmp(key, "compressionThreshold") == 0) {
+    if (value > COMPRESSION_THRESHOLD_LIMIT) {
+      logError("optional parameter error: 'compressionThreshold' cannot be"
+               " more than %d percent", COMPRESSION_THRESHOLD_LIMIT);
+      return -EINVAL;
+    }
+    config->compressionThreshold = value;
+    return VDO_SUCCESS;
+  } else if (strcmp(key, "compressionUnit") == 0) {
+    if ((value == 0) || (value > MAX_COMPRESSION_UNIT_BLOCKS)) {
+      logError("optional parameter error: 'compressionUnit' must be"
+               " between 1 and %d blocks", MAX_COMPRESSION_UNIT_BLOCKS);
+      return -EINVAL;
+    }
+    config->compressionUnit = value;
+    return VDO_SUCCESS;
+  } else if (strcmp(key, "compressionBypass") == 0) {
+    if (value > COMPRESSION_THRESHOLD_LIMIT) {
+      logError("optional parameter error: 'compressionBypass' cannot be"
+               " more than %d percent", COMPRESSION_THRESHOLD_LIMIT);
+      return -EINVAL;
+    }
+    config->compressionBypass = value;
+    return VDO_SUCCESS;
+  } else if (strcmp(key, "packerMaxAge") == 0) {
+    if (value > PACKER_MAX_AGE_LIMIT) {
+      logError("optional parameter error: 'packerMaxAge' cannot be"
+               " more than %d microseconds", PACKER_MAX_AGE_LIMIT);
+      return -EINVAL;
+    }
+    config->packerMaxAge = value;
+    return VDO_SUCCESS;
+  } else if (strcmp(key, "strongHashBlocks") == 0) {
+    if (value > MAX_BLOCK_DIGESTS) {
+      logError("optional parameter error: 'strongHashBlocks' cannot be"
+               " more than %d blocks", MAX_BLOCK_DIGESTS);
+      return -EINVAL;
+    }
+    config->strongHashBlocks = value;
+    return VDO_SUCCESS;
+  } else if (strcmp(key, "readCacheBlocks") == 0) {
+    if (value > MAX_READ_CACHE_BLOCKS) {
+      logError("optional parameter error: 'readCacheBlocks' cannot be"
+               " more than %d blocks", MAX_READ_CACHE_BLOCKS);
+      return -EINVAL;
+    }
+    config->readCacheBlocks = value;
+    return VDO_SUCCESS;
+  }
   // Handles unknown key names
   return processOneThreadConfigSpec(key, value, &config->threadCounts);
 }
@@ -416,6 +503,30 @@ static int parseOneKeyValuePair(const char   *key,
 				const char   *value,
                                 DeviceConfig *config)
 {
+  // Non-integer optional parameters
+  if (strcmp(key, "compressor") == 0) {
+    if (!isValidCompressorSpec(value)) {
+      logError("optional parameter error: unknown compressor \"%s\"",
+               value);
+      return -EINVAL;
+    }
+    FREE(config->compressorName);
+    config->compressorName = NULL;
+    return duplicateString(value, "compressor name",
+                           &config->compressorName);
+  } else if (strcmp(key, "packerAgePolicy") == 0) {
+    if (strcmp(value, "write") == 0) {
+      config->packerAgePolicy = PACKER_AGE_POLICY_WRITE;
+    } else if (strcmp(value, "uncompressed") == 0) {
+      config->packerAgePolicy = PACKER_AGE_POLICY_UNCOMPRESSED;
+    } else {
+      logError("optional parameter error: unknown packer age policy \"%s\"",
+               value);
+      return -EINVAL;
+    }
+    return VDO_SUCCESS;
+  }
+
   unsigned int count;
   int result = stringToUInt(value, &count);
   if (result != UDS_SUCCESS) {
@@ -468,7 +579,7 @@ static int parseKeyValuePairs(int            argc,
  * the thread configuration. The configuration string should contain
  * one or more comma-separated specs of the form "typename=number"; the 
  * supported type names are "cpu", "ack", "bio", "bioRotationInterval", 
- * "logical", "physical", and "hash".
+ * "logical", "physical", "hash", and "packer".
  *
  * For V2 configurations and beyond, there could be any number of
  * arguments. They should contain one or more key/value pairs
@@ -564,8 +675,24 @@ int parseDeviceConfig(int                argc,
     .logicalZones        = 0,
     .physicalZones       = 0,
     .hashZones           = 0,
+    .packerZones         = 1,
   };
-  config->maxDiscardBlocks = 1;
+  config->maxDiscardBlocks      = 1;
+  config->compressionBatchSize  = DEFAULT_COMPRESSION_BATCH_SIZE;
+  config->compressionBatchDelay = DEFAULT_COMPRESSION_BATCH_DELAY;
+  config->compressionThreshold  = DEFAULT_COMPRESSION_THRESHOLD;
+  config->compressionUnit       = DEFAULT_COMPRESSION_UNIT;
+  config->compressionBypass     = DEFAULT_COMPRESSION_BYPASS;
+  config->packerMaxAge          = 0;
+  config->packerAgePolicy       = PACKER_AGE_POLICY_WRITE;
+  config->strongHashBlocks      = 0;
+  config->readCacheBlocks       = 0;
+  result = duplicateString(DEFAULT_COMPRESSOR_NAME, "compressor name",
+                           &config->compressorName);
+  if (result != VDO_SUCCESS) {
+    handleParseError(&config, errorPtr, "Could not populate string");
+    return VDO_BAD_CONFIGURATION;
+  }
 
   struct dm_arg_set argSet;
 
@@ -721,6 +848,7 @@ void freeDeviceConfig(DeviceConfig **configPtr)
   }
 
   FREE(config->poolName);
+  FREE(config->compressorName);
   FREE(config->parentDeviceName);
   FREE(config->originalString);
 
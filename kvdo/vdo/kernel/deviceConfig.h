@@ -36,8 +36,33 @@ typedef struct {
   int logicalZones;
   int physicalZones;
   int hashZones;
+  int packerZones;
 } __attribute__((packed)) ThreadCountConfig;
 
+enum {
+  /** The default number of DataKVIOs gathered into one compression batch */
+  DEFAULT_COMPRESSION_BATCH_SIZE  = 16,
+  /** The default time, in microseconds, to wait for a batch to fill */
+  DEFAULT_COMPRESSION_BATCH_DELAY = 50,
+  /** The largest permitted compression batch */
+  COMPRESSION_BATCH_SIZE_LIMIT    = 64,
+  /**
+   * The default sampled entropy, as a percentage of eight bits per byte, at
+   * or above which a block is not worth attempting to compress
+   **/
+  DEFAULT_COMPRESSION_THRESHOLD   = 95,
+  /**
+   * The default largest number of logically adjacent blocks to compress
+   * together as one unit; one means each block is compressed on its own
+   **/
+  DEFAULT_COMPRESSION_UNIT        = 1,
+  /**
+   * The default percentage of recent compression attempts in a logical
+   * region which must fail for writes to the region to skip compression
+   **/
+  DEFAULT_COMPRESSION_BYPASS      = 90,
+};
+
 typedef uint32_t TableVersion;
 
 typedef struct {
@@ -56,6 +81,16 @@ typedef struct {
   char              *poolName;
   ThreadCountConfig  threadCounts;
   BlockCount         maxDiscardBlocks;
+  char              *compressorName;
+  unsigned int       compressionBatchSize;
+  unsigned int       compressionBatchDelay;
+  unsigned int       compressionThreshold;
+  unsigned int       compressionUnit;
+  unsigned int       compressionBypass;
+  unsigned int       packerMaxAge;
+  PackerAgePolicy    packerAgePolicy;
+  unsigned int       strongHashBlocks;
+  unsigned int       readCacheBlocks;
 } DeviceConfig;
 
 /**
@@ -30,6 +30,7 @@
 #include "threadConfig.h"
 #include "vdo.h"
 
+#include "compressor.h"
 #include "dedupeIndex.h"
 #include "deviceRegistry.h"
 #include "dump.h"
@@ -596,14 +597,23 @@ static int vdoInitialize(struct dm_target *ti,
   logDebug("MD RAID5 mode          = %s", (config->mdRaid5ModeEnabled
                                            ? "on" : "off"));
   logDebug("Write policy           = %s", getConfigWritePolicyString(config));
+  logDebug("Packer maximum age     = %u usec (%s)", config->packerMaxAge,
+           ((config->packerAgePolicy == PACKER_AGE_POLICY_WRITE)
+            ? "write" : "uncompressed"));
+  logDebug("Compression bypass     = %u%%", config->compressionBypass);
+  logDebug("Strong hash blocks     = %u", config->strongHashBlocks);
+  logDebug("Read cache blocks      = %u", config->readCacheBlocks);
 
   // The threadConfig will be copied by the VDO if it's successfully
   // created.
   VDOLoadConfig loadConfig = {
-    .cacheSize    = config->cacheSize,
-    .threadConfig = NULL,
-    .writePolicy  = config->writePolicy,
-    .maximumAge   = config->blockMapMaximumAge,
+    .cacheSize                  = config->cacheSize,
+    .threadConfig               = NULL,
+    .writePolicy                = config->writePolicy,
+    .maximumAge                 = config->blockMapMaximumAge,
+    .packerMaxAge               = config->packerMaxAge,
+    .packerAgePolicy            = config->packerAgePolicy,
+    .compressionBypassThreshold = config->compressionBypass,
   };
 
   char        *failureReason;
@@ -623,6 +633,12 @@ static int vdoInitialize(struct dm_target *ti,
   // VDOLoadConfig.
   setLoadConfigFromGeometry(&layer->geometry, &loadConfig);
 
+  // Compressed blocks holding only single LZ4 fragments can be written in
+  // the version 1.0 format, which has no codec table to make room for.
+  loadConfig.compressedCodecTable
+    = ((getCompressorCodec(layer->compressor) != COMPRESSION_CODEC_LZ4)
+       || (config->compressionUnit > 1));
+
   if (config->cacheSize < (2 * MAXIMUM_USER_VIOS
                    * loadConfig.threadConfig->logicalZoneCount)) {
     logWarning("Insufficient block map cache for logical zones");
@@ -29,13 +29,14 @@
 #include "memoryAlloc.h"
 #include "murmur/MurmurHash3.h"
 
-#include "lz4.h"
 #include "releaseVersions.h"
 #include "volumeGeometry.h"
 #include "statistics.h"
 #include "vdo.h"
 
 #include "bio.h"
+#include "blockDigests.h"
+#include "compressor.h"
 #include "dataKVIO.h"
 #include "dedupeIndex.h"
 #include "deviceConfig.h"
@@ -45,6 +46,7 @@
 #include "kvdoFlush.h"
 #include "kvio.h"
 #include "poolSysfs.h"
+#include "readCache.h"
 #include "statusProcfs.h"
 #include "stringUtils.h"
 #include "verify.h"
@@ -594,6 +596,118 @@ static int makeDedupeBioSet(KernelLayer *layer)
   return VDO_SUCCESS;
 }
 
+/**
+ * Create the batch processors which gather DataKVIOs for compression, and
+ * the histograms describing the batches.
+ *
+ * @param layer  The kernel layer
+ *
+ * @return VDO_SUCCESS or an error
+ **/
+static int makeCompressionBatchers(KernelLayer *layer)
+{
+  DeviceConfig *config = layer->deviceConfig;
+  layer->compressionBatchSizeHistogram
+    = makeLinearHistogram(&layer->wqDirectory, "compression_batch_size",
+                          "Compression Batch Size", "batches",
+                          "data blocks", NULL,
+                          COMPRESSION_BATCH_SIZE_LIMIT + 1);
+  layer->compressionBatchFillTimeHistogram
+    = makeLogarithmicHistogram(&layer->wqDirectory,
+                               "compression_batch_fill_time",
+                               "Compression Batch Fill Time", "batches",
+                               "wait time", "microseconds", 7);
+  if ((layer->compressionBatchSizeHistogram == NULL)
+      || (layer->compressionBatchFillTimeHistogram == NULL)) {
+    return -ENOMEM;
+  }
+
+  unsigned int count = config->threadCounts.cpuThreads;
+  int result = ALLOCATE(count, BatchProcessor *, "compression batchers",
+                        &layer->compressionBatchers);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  layer->compressionBatcherCount = count;
+  for (unsigned int i = 0; i < count; i++) {
+    result = makeDeadlineBatchProcessor(layer, compressDataKVIOBatch, layer,
+                                        CPU_Q_ACTION_COMPRESS_BLOCK,
+                                        config->compressionBatchSize,
+                                        config->compressionBatchDelay,
+                                        &layer->compressionBatchers[i]);
+    if (result != UDS_SUCCESS) {
+      return result;
+    }
+  }
+
+  return VDO_SUCCESS;
+}
+
+/**
+ * Free the compression batch processors and their histograms.
+ *
+ * @param layer  The kernel layer
+ **/
+static void freeCompressionBatchers(KernelLayer *layer)
+{
+  if (layer->compressionBatchers != NULL) {
+    for (unsigned int i = 0; i < layer->compressionBatcherCount; i++) {
+      freeBatchProcessor(&layer->compressionBatchers[i]);
+    }
+    FREE(layer->compressionBatchers);
+    layer->compressionBatchers = NULL;
+  }
+  freeHistogram(&layer->compressionBatchSizeHistogram);
+  freeHistogram(&layer->compressionBatchFillTimeHistogram);
+}
+
+/**
+ * Create the batch processors which gather DataKVIOs to be hashed together.
+ * These do not wait for a batch to fill, so hashing is never delayed.
+ *
+ * @param layer  The kernel layer
+ *
+ * @return VDO_SUCCESS or an error
+ **/
+static int makeHashBatchers(KernelLayer *layer)
+{
+  unsigned int count = layer->deviceConfig->threadCounts.cpuThreads;
+  int result = ALLOCATE(count, BatchProcessor *, "hash batchers",
+                        &layer->hashBatchers);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  layer->hashBatcherCount = count;
+  for (unsigned int i = 0; i < count; i++) {
+    result = makeBatchProcessor(layer, hashDataKVIOBatch, layer,
+                                CPU_Q_ACTION_HASH_BLOCK,
+                                &layer->hashBatchers[i]);
+    if (result != UDS_SUCCESS) {
+      return result;
+    }
+  }
+
+  return VDO_SUCCESS;
+}
+
+/**
+ * Free the hashing batch processors.
+ *
+ * @param layer  The kernel layer
+ **/
+static void freeHashBatchers(KernelLayer *layer)
+{
+  if (layer->hashBatchers != NULL) {
+    for (unsigned int i = 0; i < layer->hashBatcherCount; i++) {
+      freeBatchProcessor(&layer->hashBatchers[i]);
+    }
+    FREE(layer->hashBatchers);
+    layer->hashBatchers = NULL;
+  }
+}
+
 /**********************************************************************/
 int makeKernelLayer(uint64_t        startingSector,
                     unsigned int    instance,
@@ -682,6 +796,7 @@ int makeKernelLayer(uint64_t        startingSector,
   layer->common.freeVIO                  = kvdoFreeVIO;
   layer->common.completeFlush            = kvdoCompleteFlush;
   layer->common.enqueue                  = kvdoEnqueue;
+  layer->common.enqueueDelayed           = kvdoEnqueueDelayed;
   layer->common.waitForAdminOperation    = waitForSyncOperation;
   layer->common.completeAdminOperation   = kvdoCompleteSyncOperation;
   layer->common.getCurrentThreadID       = kvdoGetCurrentThreadID;
@@ -704,6 +819,10 @@ int makeKernelLayer(uint64_t        startingSector,
 
   spin_lock_init(&layer->flushLock);
   mutex_init(&layer->statsMutex);
+  spin_lock_init(&layer->compressedReadLock);
+  for (unsigned int i = 0; i < COMPRESSED_READ_BUCKETS; i++) {
+    INIT_HLIST_HEAD(&layer->compressedReads[i]);
+  }
   bio_list_init(&layer->waitingFlushes);
 
   result = addLayerToDeviceRegistry(config->poolName, layer);
@@ -719,6 +838,7 @@ int makeKernelLayer(uint64_t        startingSector,
   result = makeThreadConfig(config->threadCounts.logicalZones,
                             config->threadCounts.physicalZones,
                             config->threadCounts.hashZones,
+                            config->threadCounts.packerZones,
                             threadConfigPointer);
   if (result != VDO_SUCCESS) {
     *reason = "Cannot create thread configuration";
@@ -726,13 +846,16 @@ int makeKernelLayer(uint64_t        startingSector,
     return result;
   }
 
-  logInfo("zones: %d logical, %d physical, %d hash; base threads: %d",
+  logInfo("zones: %d logical, %d physical, %d hash, %d packer;"
+          " base threads: %d",
           config->threadCounts.logicalZones,
           config->threadCounts.physicalZones,
           config->threadCounts.hashZones,
+          (*threadConfigPointer)->packerZoneCount,
           (*threadConfigPointer)->baseThreadCount);
 
   result = makeBatchProcessor(layer, returnDataKVIOBatchToPool, layer,
+                              CPU_Q_ACTION_COMPLETE_KVIO,
                               &layer->dataKVIOReleaser);
   if (result != UDS_SUCCESS) {
     *reason = "Cannot allocate KVIO-freeing batch processor";
@@ -740,6 +863,22 @@ int makeKernelLayer(uint64_t        startingSector,
     return result;
   }
 
+  // Compression batching
+  result = makeCompressionBatchers(layer);
+  if (result != VDO_SUCCESS) {
+    *reason = "Cannot allocate compression batch processors";
+    freeKernelLayer(layer);
+    return result;
+  }
+
+  // Hash batching
+  result = makeHashBatchers(layer);
+  if (result != VDO_SUCCESS) {
+    *reason = "Cannot allocate hash batch processors";
+    freeKernelLayer(layer);
+    return result;
+  }
+
   // Spare KVDOFlush, so that we will always have at least one available
   result = makeKVDOFlush(&layer->spareKVDOFlush);
   if (result != UDS_SUCCESS) {
@@ -781,24 +920,35 @@ int makeKernelLayer(uint64_t        startingSector,
     return result;
   }
 
-  // Compression context storage
-  result = ALLOCATE(config->threadCounts.cpuThreads, char *, "LZ4 context",
-                    &layer->compressionContext);
+  // Compressor
+  result = makeCompressor(config->compressorName,
+                          config->threadCounts.cpuThreads,
+                          &layer->compressor);
   if (result != VDO_SUCCESS) {
-    *reason = "cannot allocate LZ4 context";
+    *reason = "Cannot initialize compressor";
     freeKernelLayer(layer);
     return result;
   }
-  for (int i = 0; i < config->threadCounts.cpuThreads; i++) {
-    result = ALLOCATE(LZ4_context_size(), char, "LZ4 context",
-                      &layer->compressionContext[i]);
+
+  // Block digests
+  if (config->strongHashBlocks > 0) {
+    result = makeBlockDigests(config->strongHashBlocks, &layer->blockDigests);
     if (result != VDO_SUCCESS) {
-      *reason = "cannot allocate LZ4 context";
+      *reason = "Cannot initialize block digests";
       freeKernelLayer(layer);
       return result;
     }
   }
 
+  // Read cache
+  if (config->readCacheBlocks > 0) {
+    result = makeReadCache(config->readCacheBlocks, &layer->readCache);
+    if (result != VDO_SUCCESS) {
+      *reason = "Cannot initialize read cache";
+      freeKernelLayer(layer);
+      return result;
+    }
+  }
 
   /*
    * Part 3 - Do initializations that depend upon other previous
@@ -933,6 +1083,45 @@ int prepareToModifyKernelLayer(KernelLayer       *layer,
     return VDO_PARAMETER_MISMATCH;
   }
 
+  if (strcmp(config->compressorName, extantConfig->compressorName) != 0) {
+    *errorPtr = "Compressor cannot change";
+    return VDO_PARAMETER_MISMATCH;
+  }
+
+  if ((config->compressionBatchSize != extantConfig->compressionBatchSize)
+      || (config->compressionBatchDelay
+          != extantConfig->compressionBatchDelay)) {
+    *errorPtr = "Compression batching cannot change";
+    return VDO_PARAMETER_MISMATCH;
+  }
+
+  if (config->compressionUnit != extantConfig->compressionUnit) {
+    // The packer's bins were sized for the compressed block format.
+    *errorPtr = "Compression unit cannot change";
+    return VDO_PARAMETER_MISMATCH;
+  }
+
+  if ((config->packerMaxAge != extantConfig->packerMaxAge)
+      || (config->packerAgePolicy != extantConfig->packerAgePolicy)) {
+    *errorPtr = "Packer age limit cannot change";
+    return VDO_PARAMETER_MISMATCH;
+  }
+
+  if (config->compressionBypass != extantConfig->compressionBypass) {
+    *errorPtr = "Compression bypass threshold cannot change";
+    return VDO_PARAMETER_MISMATCH;
+  }
+
+  if (config->strongHashBlocks != extantConfig->strongHashBlocks) {
+    *errorPtr = "Strong hash block count cannot change";
+    return VDO_PARAMETER_MISMATCH;
+  }
+
+  if (config->readCacheBlocks != extantConfig->readCacheBlocks) {
+    *errorPtr = "Read cache block count cannot change";
+    return VDO_PARAMETER_MISMATCH;
+  }
+
   // Below here are the actions to take when a non-immutable property changes.
 
   if (config->writePolicy != extantConfig->writePolicy) {
@@ -1060,18 +1249,17 @@ void freeKernelLayer(KernelLayer *layer)
     // fall through
 
   case LAYER_SIMPLE_THINGS_INITIALIZED:
-    if (layer->compressionContext != NULL) {
-      for (int i = 0; i < layer->deviceConfig->threadCounts.cpuThreads; i++) {
-        FREE(layer->compressionContext[i]);
-      }
-      FREE(layer->compressionContext);
-    }
+    freeCompressor(&layer->compressor);
+    freeBlockDigests(&layer->blockDigests);
+    freeReadCache(&layer->readCache);
     if (layer->dedupeIndex != NULL) {
       finishDedupeIndex(layer->dedupeIndex);
     }
     FREE(layer->spareKVDOFlush);
     layer->spareKVDOFlush = NULL;
     freeBatchProcessor(&layer->dataKVIOReleaser);
+    freeCompressionBatchers(layer);
+    freeHashBatchers(layer);
     removeLayerFromDeviceRegistry(layer->deviceConfig->poolName);
     break;
 
@@ -46,7 +46,9 @@
 #include "workQueue.h"
 
 enum {
-  VDO_SECTORS_PER_BLOCK = (VDO_BLOCK_SIZE >> SECTOR_SHIFT)
+  VDO_SECTORS_PER_BLOCK   = (VDO_BLOCK_SIZE >> SECTOR_SHIFT),
+  /** The number of lists of compressed block reads in progress */
+  COMPRESSED_READ_BUCKETS = 256,
 };
 
 typedef enum {
@@ -145,9 +147,18 @@ struct kernelLayer {
    * CPU-intensive, non-blocking work.
    **/
   KvdoWorkQueue          *cpuQueue;
-  /** N blobs of context data for LZ4 code, one per CPU thread. */
-  char                  **compressionContext;
-  Atomic32                compressionContextIndex;
+  /** The engine used to compress and uncompress data blocks. */
+  Compressor             *compressor;
+  /** The digests of recently written blocks, if strong hashing is enabled */
+  BlockDigests           *blockDigests;
+  /** Copies of recently read data blocks, if the read cache is enabled */
+  ReadCache              *readCache;
+  /**
+   * The compressed block reads in progress, hashed by PBN, which later
+   * reads of the same blocks wait for instead of reading them again.
+   **/
+  spinlock_t              compressedReadLock;
+  struct hlist_head       compressedReads[COMPRESSED_READ_BUCKETS];
   /** Optional work queue for calling bio_endio. */
   KvdoWorkQueue          *bioAckQueue;
   /** Underlying block device info. */
@@ -163,6 +174,13 @@ struct kernelLayer {
   atomic64_t              biosCompleted;
   atomic64_t              dedupeContextBusy;
   atomic64_t              flushOut;
+  atomic64_t              compressionEarlyRejects;
+  atomic64_t              compressionFailures;
+  atomic64_t              verifyReads;
+  atomic64_t              verifyReadsAvoided;
+  atomic64_t              readCacheHits;
+  atomic64_t              readCacheMisses;
+  atomic64_t              compressedReadsCoalesced;
   AtomicBioStats          biosIn;
   AtomicBioStats          biosInPartial;
   AtomicBioStats          biosOut;
@@ -194,6 +212,17 @@ struct kernelLayer {
   void                   *procfsPrivate;
   /* For returning batches of DataKVIOs to their pool */
   BatchProcessor         *dataKVIOReleaser;
+  /* For gathering DataKVIOs into compression batches, one per CPU thread */
+  BatchProcessor        **compressionBatchers;
+  unsigned int            compressionBatcherCount;
+  Atomic32                compressionBatchSequence;
+  /* Sizes of compression batches, and how long each one took to fill */
+  Histogram              *compressionBatchSizeHistogram;
+  Histogram              *compressionBatchFillTimeHistogram;
+  /* For gathering DataKVIOs to hash together, one per CPU thread */
+  BatchProcessor        **hashBatchers;
+  unsigned int            hashBatcherCount;
+  Atomic32                hashBatchSequence;
 
   // Administrative operations
   /* The object used to wait for administrative operations to complete */
@@ -82,6 +82,20 @@ typedef struct {
   uint64_t dedupeAdviceTimeouts;
   /** Number of flush requests submitted to the storage device */
   uint64_t flushOut;
+  /** Number of blocks not compressed because a sample looked random */
+  uint64_t compressionEarlyRejects;
+  /** Number of compression attempts which failed to shrink the block */
+  uint64_t compressionFailures;
+  /** Number of dedupe candidates verified by reading the block */
+  uint64_t verifyReads;
+  /** Number of dedupe candidates verified by block digest without a read */
+  uint64_t verifyReadsAvoided;
+  /** Number of data block reads served by the read cache */
+  uint64_t readCacheHits;
+  /** Number of data block reads which missed the read cache */
+  uint64_t readCacheMisses;
+  /** Number of compressed block reads which waited for another read */
+  uint64_t compressedReadsCoalesced;
   /** Logical block size */
   uint64_t logicalBlockSize;
   /** Bios submitted into VDO from above */
@@ -41,6 +41,9 @@ typedef int64_t TimeoutJiffies;
 
 typedef struct atomicBioStats AtomicBioStats;
 typedef struct bio            BIO;
+typedef struct blockDigests   BlockDigests;
+typedef struct compressor     Compressor;
+typedef struct compressorRequest CompressorRequest;
 typedef struct dataKVIO       DataKVIO;
 typedef struct dedupeContext  DedupeContext;
 typedef struct dedupeIndex    DedupeIndex;
@@ -51,6 +54,7 @@ typedef struct kvdoFlush      KVDOFlush;
 typedef struct kvdoWorkItem   KvdoWorkItem;
 typedef struct kvdoWorkQueue  KvdoWorkQueue;
 typedef struct kvio           KVIO;
+typedef struct readCache      ReadCache;
 
 typedef void (*KVIOCallback)(KVIO *kvio);
 typedef void (*DataKVIOCallback)(DataKVIO *dataKVIO);
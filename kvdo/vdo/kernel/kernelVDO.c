@@ -254,7 +254,7 @@ bool setKVDOCompressing(KVDO *kvdo, bool enableCompression)
   VDOCompressData data;
   data.enable = enableCompression;
   performKVDOOperation(kvdo, setCompressingWork, &data,
-                       getPackerZoneThread(getThreadConfig(kvdo->vdo)),
+                       getPackerZoneThread(getThreadConfig(kvdo->vdo), 0),
                        &compressWait);
   return data.wasEnabled;
 }
@@ -476,8 +476,19 @@ static void kvdoEnqueueWork(KvdoWorkItem *workItem)
   runCallback(kvdoEnqueueable->enqueueable.completion);
 }
 
-/**********************************************************************/
-void kvdoEnqueue(Enqueueable *enqueueable)
+/**
+ * Prepare the work item of an Enqueueable to run its completion's callback,
+ * and find the thread on which the callback must run.
+ *
+ * @param [in]  enqueueable  The Enqueueable object containing the completion
+ *                           pointer
+ * @param [out] threadPtr    A pointer to hold the thread which should run the
+ *                           work item
+ *
+ * @return The prepared work item
+ **/
+static KvdoWorkItem *prepareEnqueueable(Enqueueable  *enqueueable,
+                                        KVDOThread  **threadPtr)
 {
   KvdoEnqueueable *kvdoEnqueueable = container_of(enqueueable,
                                                   KvdoEnqueueable,
@@ -498,8 +509,25 @@ void kvdoEnqueue(Enqueueable *enqueueable)
   setupWorkItem(&kvdoEnqueueable->workItem, kvdoEnqueueWork,
                 (KvdoWorkFunction) enqueueable->completion->callback,
                 REQ_Q_ACTION_COMPLETION);
-  enqueueKVDOThreadWork(&layer->kvdo.threads[threadID],
-                        &kvdoEnqueueable->workItem);
+  *threadPtr = &layer->kvdo.threads[threadID];
+  return &kvdoEnqueueable->workItem;
+}
+
+/**********************************************************************/
+void kvdoEnqueue(Enqueueable *enqueueable)
+{
+  KVDOThread   *thread;
+  KvdoWorkItem *item = prepareEnqueueable(enqueueable, &thread);
+  enqueueKVDOThreadWork(thread, item);
+}
+
+/**********************************************************************/
+void kvdoEnqueueDelayed(Enqueueable *enqueueable, uint64_t delay)
+{
+  KVDOThread   *thread;
+  KvdoWorkItem *item = prepareEnqueueable(enqueueable, &thread);
+  enqueueWorkQueueDelayed(thread->requestQueue, item,
+                          jiffies + usecs_to_jiffies(delay));
 }
 
 /**********************************************************************/
@@ -262,6 +262,16 @@ void enqueueKVIO(KVIO             *kvio,
  **/
 void kvdoEnqueue(Enqueueable *enqueueable);
 
+/**
+ * Enqueue an arbitrary completion for execution on its indicated thread
+ * once a delay has passed. The delay is rounded up to a whole number of
+ * jiffies.
+ *
+ * @param enqueueable  The Enqueueable object containing the completion pointer
+ * @param delay        The minimum time to wait, in microseconds
+ **/
+void kvdoEnqueueDelayed(Enqueueable *enqueueable, uint64_t delay);
+
 /**
  * Get the base-code thread index for the current execution context.
  *
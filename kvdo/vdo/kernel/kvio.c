@@ -30,6 +30,8 @@
 #include "waitQueue.h"
 
 #include "bio.h"
+#include "blockDigests.h"
+#include "readCache.h"
 #include "ioSubmitter.h"
 #include "kvdoFlush.h"
 
@@ -110,6 +112,12 @@ void kvdoWriteCompressedBlock(AllocatingVIO *allocatingVIO)
     = allocatingVIOAsCompressedWriteKVIO(allocatingVIO);
   KVIO *kvio = compressedWriteKVIOAsKVIO(compressedWriteKVIO);
   BIO  *bio  = kvio->bio;
+  if (kvio->layer->readCache != NULL) {
+    invalidateCachedBlock(kvio->layer->readCache, kvio->vio->physical);
+  }
+  if (kvio->layer->blockDigests != NULL) {
+    forgetBlockDigest(kvio->layer->blockDigests, kvio->vio->physical);
+  }
   resetBio(bio, kvio->layer);
   setBioOperationWrite(bio);
   setBioSector(bio, blockToSector(kvio->layer, kvio->vio->physical));
@@ -153,6 +161,14 @@ void kvdoSubmitMetadataVIO(VIO *vio)
     vioAddTraceRecord(vio, THIS_LOCATION("$F;io=writeMeta"));
   }
 
+  // Block map pages are allocated from the same slabs as data blocks.
+  if (isWriteVIO(vio) && (kvio->layer->readCache != NULL)) {
+    invalidateCachedBlock(kvio->layer->readCache, vio->physical);
+  }
+  if (isWriteVIO(vio) && (kvio->layer->blockDigests != NULL)) {
+    forgetBlockDigest(kvio->layer->blockDigests, vio->physical);
+  }
+
   if (vioRequiresFlushAfter(vio)) {
     setBioOperationFlagFua(bio);
   }
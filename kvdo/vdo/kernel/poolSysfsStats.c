@@ -321,6 +321,193 @@ static PoolStatsAttribute poolStatsPackerCompressedFragmentsInPackerAttr = {
   .show  = poolStatsPackerCompressedFragmentsInPackerShow,
 };
 
+/**********************************************************************/
+/** Number of bins released because they reached the maximum age */
+static ssize_t poolStatsPackerBinsAgedOutShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.packer.binsAgedOut);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsPackerBinsAgedOutAttr = {
+  .attr  = { .name = "packer_bins_aged_out", .mode = 0444, },
+  .show  = poolStatsPackerBinsAgedOutShow,
+};
+
+/**********************************************************************/
+/** Number of fragments which waited less than 100 microseconds */
+static ssize_t poolStatsPackerResidenceUnder100usShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.packer.residence.under100us);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsPackerResidenceUnder100usAttr = {
+  .attr  = { .name = "packer_residence_under100us", .mode = 0444, },
+  .show  = poolStatsPackerResidenceUnder100usShow,
+};
+
+/**********************************************************************/
+/** Number of fragments which waited less than 1 millisecond */
+static ssize_t poolStatsPackerResidenceUnder1msShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.packer.residence.under1ms);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsPackerResidenceUnder1msAttr = {
+  .attr  = { .name = "packer_residence_under1ms", .mode = 0444, },
+  .show  = poolStatsPackerResidenceUnder1msShow,
+};
+
+/**********************************************************************/
+/** Number of fragments which waited less than 10 milliseconds */
+static ssize_t poolStatsPackerResidenceUnder10msShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.packer.residence.under10ms);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsPackerResidenceUnder10msAttr = {
+  .attr  = { .name = "packer_residence_under10ms", .mode = 0444, },
+  .show  = poolStatsPackerResidenceUnder10msShow,
+};
+
+/**********************************************************************/
+/** Number of fragments which waited less than 100 milliseconds */
+static ssize_t poolStatsPackerResidenceUnder100msShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.packer.residence.under100ms);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsPackerResidenceUnder100msAttr = {
+  .attr  = { .name = "packer_residence_under100ms", .mode = 0444, },
+  .show  = poolStatsPackerResidenceUnder100msShow,
+};
+
+/**********************************************************************/
+/** Number of fragments which waited less than 1 second */
+static ssize_t poolStatsPackerResidenceUnder1sShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.packer.residence.under1s);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsPackerResidenceUnder1sAttr = {
+  .attr  = { .name = "packer_residence_under1s", .mode = 0444, },
+  .show  = poolStatsPackerResidenceUnder1sShow,
+};
+
+/**********************************************************************/
+/** Number of fragments which waited 1 second or more */
+static ssize_t poolStatsPackerResidenceAtLeast1sShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.packer.residence.atLeast1s);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsPackerResidenceAtLeast1sAttr = {
+  .attr  = { .name = "packer_residence_at_least1s", .mode = 0444, },
+  .show  = poolStatsPackerResidenceAtLeast1sShow,
+};
+
+/**********************************************************************/
+/** Number of logical regions currently bypassing compression */
+static ssize_t poolStatsCompressionBypassRegionsBypassingShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.compressionBypass.regionsBypassing);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsCompressionBypassRegionsBypassingAttr = {
+  .attr  = { .name = "compression_bypass_regions_bypassing", .mode = 0444, },
+  .show  = poolStatsCompressionBypassRegionsBypassingShow,
+};
+
+/**********************************************************************/
+/** Number of times a region began bypassing compression */
+static ssize_t poolStatsCompressionBypassBypassesStartedShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.compressionBypass.bypassesStarted);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsCompressionBypassBypassesStartedAttr = {
+  .attr  = { .name = "compression_bypass_bypasses_started", .mode = 0444, },
+  .show  = poolStatsCompressionBypassBypassesStartedShow,
+};
+
+/**********************************************************************/
+/** Number of writes which bypassed compression */
+static ssize_t poolStatsCompressionBypassBlocksBypassedShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.compressionBypass.blocksBypassed);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsCompressionBypassBlocksBypassedAttr = {
+  .attr  = { .name = "compression_bypass_blocks_bypassed", .mode = 0444, },
+  .show  = poolStatsCompressionBypassBlocksBypassedShow,
+};
+
+/**********************************************************************/
+/** Number of writes compressed to probe a bypassing region */
+static ssize_t poolStatsCompressionBypassProbesShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.compressionBypass.probes);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsCompressionBypassProbesAttr = {
+  .attr  = { .name = "compression_bypass_probes", .mode = 0444, },
+  .show  = poolStatsCompressionBypassProbesShow,
+};
+
 /**********************************************************************/
 /** The total number of slabs from which blocks may be allocated */
 static ssize_t poolStatsAllocatorSlabCountShow(KernelLayer *layer, char *buf)
@@ -1035,6 +1222,40 @@ static PoolStatsAttribute poolStatsHashLockConcurrentHashCollisionsAttr = {
   .show  = poolStatsHashLockConcurrentHashCollisionsShow,
 };
 
+/**********************************************************************/
+/** Number of index queries answered by the advice cache */
+static ssize_t poolStatsHashLockAdviceCacheHitsShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.hashLock.adviceCacheHits);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsHashLockAdviceCacheHitsAttr = {
+  .attr  = { .name = "hash_lock_advice_cache_hits", .mode = 0444, },
+  .show  = poolStatsHashLockAdviceCacheHitsShow,
+};
+
+/**********************************************************************/
+/** Number of index queries which had to be sent to the index */
+static ssize_t poolStatsHashLockAdviceCacheMissesShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKVDOStatistics(&layer->kvdo, &layer->vdoStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->vdoStatsStorage.hashLock.adviceCacheMisses);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsHashLockAdviceCacheMissesAttr = {
+  .attr  = { .name = "hash_lock_advice_cache_misses", .mode = 0444, },
+  .show  = poolStatsHashLockAdviceCacheMissesShow,
+};
+
 /**********************************************************************/
 /** number of times VDO got an invalid dedupe advice PBN from UDS */
 static ssize_t poolStatsErrorsInvalidAdvicePBNCountShow(KernelLayer *layer, char *buf)
@@ -1171,6 +1392,125 @@ static PoolStatsAttribute poolStatsFlushOutAttr = {
   .show  = poolStatsFlushOutShow,
 };
 
+/**********************************************************************/
+/** Number of blocks not compressed because a sample looked random */
+static ssize_t poolStatsCompressionEarlyRejectsShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKernelStats(layer, &layer->kernelStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->kernelStatsStorage.compressionEarlyRejects);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsCompressionEarlyRejectsAttr = {
+  .attr  = { .name = "compression_early_rejects", .mode = 0444, },
+  .show  = poolStatsCompressionEarlyRejectsShow,
+};
+
+/**********************************************************************/
+/** Number of compression attempts which failed to shrink the block */
+static ssize_t poolStatsCompressionFailuresShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKernelStats(layer, &layer->kernelStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->kernelStatsStorage.compressionFailures);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsCompressionFailuresAttr = {
+  .attr  = { .name = "compression_failures", .mode = 0444, },
+  .show  = poolStatsCompressionFailuresShow,
+};
+
+/**********************************************************************/
+/** Number of dedupe candidates verified by reading the block */
+static ssize_t poolStatsVerifyReadsShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKernelStats(layer, &layer->kernelStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->kernelStatsStorage.verifyReads);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsVerifyReadsAttr = {
+  .attr  = { .name = "verify_reads", .mode = 0444, },
+  .show  = poolStatsVerifyReadsShow,
+};
+
+/**********************************************************************/
+/** Number of dedupe candidates verified by block digest without a read */
+static ssize_t poolStatsVerifyReadsAvoidedShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKernelStats(layer, &layer->kernelStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->kernelStatsStorage.verifyReadsAvoided);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsVerifyReadsAvoidedAttr = {
+  .attr  = { .name = "verify_reads_avoided", .mode = 0444, },
+  .show  = poolStatsVerifyReadsAvoidedShow,
+};
+
+/**********************************************************************/
+/** Number of data block reads served by the read cache */
+static ssize_t poolStatsReadCacheHitsShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKernelStats(layer, &layer->kernelStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->kernelStatsStorage.readCacheHits);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsReadCacheHitsAttr = {
+  .attr  = { .name = "read_cache_hits", .mode = 0444, },
+  .show  = poolStatsReadCacheHitsShow,
+};
+
+/**********************************************************************/
+/** Number of data block reads which missed the read cache */
+static ssize_t poolStatsReadCacheMissesShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKernelStats(layer, &layer->kernelStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->kernelStatsStorage.readCacheMisses);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsReadCacheMissesAttr = {
+  .attr  = { .name = "read_cache_misses", .mode = 0444, },
+  .show  = poolStatsReadCacheMissesShow,
+};
+
+/**********************************************************************/
+/** Number of compressed block reads which waited for another read */
+static ssize_t poolStatsCompressedReadsCoalescedShow(KernelLayer *layer, char *buf)
+{
+  ssize_t retval;
+  mutex_lock(&layer->statsMutex);
+  getKernelStats(layer, &layer->kernelStatsStorage);
+  retval = sprintf(buf, "%" PRIu64 "\n", layer->kernelStatsStorage.compressedReadsCoalesced);
+  mutex_unlock(&layer->statsMutex);
+  return retval;
+}
+
+static PoolStatsAttribute poolStatsCompressedReadsCoalescedAttr = {
+  .attr  = { .name = "compressed_reads_coalesced", .mode = 0444, },
+  .show  = poolStatsCompressedReadsCoalescedShow,
+};
+
 /**********************************************************************/
 /** Logical block size */
 static ssize_t poolStatsLogicalBlockSizeShow(KernelLayer *layer, char *buf)
@@ -2531,6 +2871,17 @@ struct attribute *poolStatsAttrs[] = {
   &poolStatsPackerCompressedFragmentsWrittenAttr.attr,
   &poolStatsPackerCompressedBlocksWrittenAttr.attr,
   &poolStatsPackerCompressedFragmentsInPackerAttr.attr,
+  &poolStatsPackerBinsAgedOutAttr.attr,
+  &poolStatsPackerResidenceUnder100usAttr.attr,
+  &poolStatsPackerResidenceUnder1msAttr.attr,
+  &poolStatsPackerResidenceUnder10msAttr.attr,
+  &poolStatsPackerResidenceUnder100msAttr.attr,
+  &poolStatsPackerResidenceUnder1sAttr.attr,
+  &poolStatsPackerResidenceAtLeast1sAttr.attr,
+  &poolStatsCompressionBypassRegionsBypassingAttr.attr,
+  &poolStatsCompressionBypassBypassesStartedAttr.attr,
+  &poolStatsCompressionBypassBlocksBypassedAttr.attr,
+  &poolStatsCompressionBypassProbesAttr.attr,
   &poolStatsAllocatorSlabCountAttr.attr,
   &poolStatsAllocatorSlabsOpenedAttr.attr,
   &poolStatsAllocatorSlabsReopenedAttr.attr,
@@ -2573,6 +2924,8 @@ struct attribute *poolStatsAttrs[] = {
   &poolStatsHashLockDedupeAdviceStaleAttr.attr,
   &poolStatsHashLockConcurrentDataMatchesAttr.attr,
   &poolStatsHashLockConcurrentHashCollisionsAttr.attr,
+  &poolStatsHashLockAdviceCacheHitsAttr.attr,
+  &poolStatsHashLockAdviceCacheMissesAttr.attr,
   &poolStatsErrorsInvalidAdvicePBNCountAttr.attr,
   &poolStatsErrorsNoSpaceErrorCountAttr.attr,
   &poolStatsErrorsReadOnlyErrorCountAttr.attr,
@@ -2581,6 +2934,13 @@ struct attribute *poolStatsAttrs[] = {
   &poolStatsMaxVIOsAttr.attr,
   &poolStatsDedupeAdviceTimeoutsAttr.attr,
   &poolStatsFlushOutAttr.attr,
+  &poolStatsCompressionEarlyRejectsAttr.attr,
+  &poolStatsCompressionFailuresAttr.attr,
+  &poolStatsVerifyReadsAttr.attr,
+  &poolStatsVerifyReadsAvoidedAttr.attr,
+  &poolStatsReadCacheHitsAttr.attr,
+  &poolStatsReadCacheMissesAttr.attr,
+  &poolStatsCompressedReadsCoalescedAttr.attr,
   &poolStatsLogicalBlockSizeAttr.attr,
   &poolStatsBiosInReadAttr.attr,
   &poolStatsBiosInWriteAttr.attr,
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/kernel/readCache.c#1 $
+ */
+
+#include "readCache.h"
+
+#include <linux/spinlock.h>
+
+#include "logger.h"
+#include "memoryAlloc.h"
+
+#include "constants.h"
+#include "statusCodes.h"
+
+#include "bio.h"
+
+enum {
+  /**
+   * The number of locks protecting the entries; entry i is protected by
+   * lock (i % READ_CACHE_LOCKS), so neighbouring blocks, which tend to be
+   * read together, use different locks.
+   **/
+  READ_CACHE_LOCKS = 64,
+};
+
+typedef struct {
+  /** The block held, or ZERO_BLOCK if the entry is empty */
+  PhysicalBlockNumber pbn;
+  /** Whether the block has been read from the cache since it was cached */
+  bool                referenced;
+} ReadCacheEntry;
+
+struct readCache {
+  /** The number of entries */
+  unsigned int    capacity;
+  /** The locks protecting the entries and their blocks */
+  spinlock_t      locks[READ_CACHE_LOCKS];
+  /** The entries, indexed by PBN modulo the capacity */
+  ReadCacheEntry *entries;
+  /** The cached blocks, one for each entry */
+  char           *blocks;
+};
+
+/**********************************************************************/
+int makeReadCache(unsigned int capacity, ReadCache **cachePtr)
+{
+  if ((capacity == 0) || (capacity > MAX_READ_CACHE_BLOCKS)) {
+    return logErrorWithStringError(VDO_BAD_CONFIGURATION,
+                                   "read cache capacity %u is not between"
+                                   " 1 and %u", capacity,
+                                   MAX_READ_CACHE_BLOCKS);
+  }
+
+  ReadCache *cache;
+  int result = ALLOCATE(1, ReadCache, "read cache", &cache);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  result = ALLOCATE(capacity, ReadCacheEntry, "read cache entries",
+                    &cache->entries);
+  if (result != VDO_SUCCESS) {
+    freeReadCache(&cache);
+    return result;
+  }
+
+  result = ALLOCATE((size_t) capacity * VDO_BLOCK_SIZE, char,
+                    "read cache blocks", &cache->blocks);
+  if (result != VDO_SUCCESS) {
+    freeReadCache(&cache);
+    return result;
+  }
+
+  logInfo("using read cache of %u blocks", capacity);
+  cache->capacity = capacity;
+  for (unsigned int i = 0; i < READ_CACHE_LOCKS; i++) {
+    spin_lock_init(&cache->locks[i]);
+  }
+
+  *cachePtr = cache;
+  return VDO_SUCCESS;
+}
+
+/**********************************************************************/
+void freeReadCache(ReadCache **cachePtr)
+{
+  ReadCache *cache = *cachePtr;
+  if (cache == NULL) {
+    return;
+  }
+
+  FREE(cache->blocks);
+  FREE(cache->entries);
+  FREE(cache);
+  *cachePtr = NULL;
+}
+
+/**
+ * Get the entry, block, and lock for a physical block.
+ *
+ * @param [in]  cache     The cache
+ * @param [in]  pbn       The physical block number
+ * @param [out] blockPtr  A pointer to hold the entry's block
+ * @param [out] lockPtr   A pointer to hold the lock protecting the entry
+ *
+ * @return The entry which would hold the block
+ **/
+static ReadCacheEntry *getEntry(ReadCache            *cache,
+                                PhysicalBlockNumber   pbn,
+                                char                **blockPtr,
+                                spinlock_t          **lockPtr)
+{
+  unsigned int index = pbn % cache->capacity;
+  *blockPtr = &cache->blocks[(size_t) index * VDO_BLOCK_SIZE];
+  *lockPtr  = &cache->locks[index % READ_CACHE_LOCKS];
+  return &cache->entries[index];
+}
+
+/**********************************************************************/
+bool copyCachedBlock(ReadCache *cache, PhysicalBlockNumber pbn, char *buffer)
+{
+  char           *block;
+  spinlock_t     *lock;
+  ReadCacheEntry *entry = getEntry(cache, pbn, &block, &lock);
+  unsigned long   flags;
+  spin_lock_irqsave(lock, flags);
+  bool found = (entry->pbn == pbn);
+  if (found) {
+    memcpy(buffer, block, VDO_BLOCK_SIZE);
+    entry->referenced = true;
+  }
+  spin_unlock_irqrestore(lock, flags);
+  return found;
+}
+
+/**********************************************************************/
+bool copyCachedBlockToBio(ReadCache *cache, PhysicalBlockNumber pbn, BIO *bio)
+{
+  char           *block;
+  spinlock_t     *lock;
+  ReadCacheEntry *entry = getEntry(cache, pbn, &block, &lock);
+  unsigned long   flags;
+  spin_lock_irqsave(lock, flags);
+  bool found = (entry->pbn == pbn);
+  if (found) {
+    bioCopyDataOut(bio, block);
+    entry->referenced = true;
+  }
+  spin_unlock_irqrestore(lock, flags);
+  return found;
+}
+
+/**********************************************************************/
+void cacheBlock(ReadCache *cache, PhysicalBlockNumber pbn, const char *data)
+{
+  char           *block;
+  spinlock_t     *lock;
+  ReadCacheEntry *entry = getEntry(cache, pbn, &block, &lock);
+  unsigned long   flags;
+  spin_lock_irqsave(lock, flags);
+  if (entry->pbn == pbn) {
+    // The block is already cached, or was cached by a concurrent read.
+  } else if ((entry->pbn != ZERO_BLOCK) && entry->referenced) {
+    // Give the block being read from the cache a second chance.
+    entry->referenced = false;
+  } else {
+    memcpy(block, data, VDO_BLOCK_SIZE);
+    entry->pbn        = pbn;
+    entry->referenced = false;
+  }
+  spin_unlock_irqrestore(lock, flags);
+}
+
+/**********************************************************************/
+void invalidateCachedBlock(ReadCache *cache, PhysicalBlockNumber pbn)
+{
+  char           *block;
+  spinlock_t     *lock;
+  ReadCacheEntry *entry = getEntry(cache, pbn, &block, &lock);
+  unsigned long   flags;
+  spin_lock_irqsave(lock, flags);
+  if (entry->pbn == pbn) {
+    entry->pbn = ZERO_BLOCK;
+  }
+  spin_unlock_irqrestore(lock, flags);
+}
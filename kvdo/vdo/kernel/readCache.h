@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/kernel/readCache.h#1 $
+ */
+
+#ifndef READ_CACHE_H
+#define READ_CACHE_H
+
+#include "kernelTypes.h"
+
+/**
+ * A ReadCache holds copies of recently read physical blocks, so that reads
+ * of blocks shared by many logical blocks, and reads verifying dedupe
+ * advice against them, can be served from memory. A compressed block is
+ * held as it is stored, so one entry serves reads of all of its fragments.
+ *
+ * The cache is direct-mapped on the physical block number. A block which is
+ * read from the cache is given a second chance: the first read of another
+ * block which maps to its entry only clears its referenced flag, so a scan
+ * of blocks which are read once won't displace the blocks which are being
+ * read repeatedly.
+ *
+ * The contents of a physical block only change when it is written after
+ * its reference count has dropped to zero and it has been reallocated, so
+ * the entry for a block is invalidated whenever a write to the block is
+ * submitted.
+ *
+ * Blocks are cached from the CPU threads rather than from bio completion,
+ * so that the copy is never made in interrupt context, but all operations
+ * are still safe to call from it.
+ **/
+
+enum {
+  /** The most blocks a read cache may hold */
+  MAX_READ_CACHE_BLOCKS = 1 << 20,
+};
+
+/**
+ * Create a read cache.
+ *
+ * @param [in]  capacity  The number of blocks the cache may hold
+ * @param [out] cachePtr  A pointer to hold the new cache
+ *
+ * @return VDO_SUCCESS or an error
+ **/
+int makeReadCache(unsigned int capacity, ReadCache **cachePtr)
+  __attribute__((warn_unused_result));
+
+/**
+ * Free a read cache and null out the reference to it.
+ *
+ * @param cachePtr  The reference to the cache to free
+ **/
+void freeReadCache(ReadCache **cachePtr);
+
+/**
+ * Copy a physical block from the cache into a buffer.
+ *
+ * @param cache   The cache
+ * @param pbn     The physical block number
+ * @param buffer  The buffer to hold the block, VDO_BLOCK_SIZE bytes long
+ *
+ * @return <code>true</code> if the block was in the cache
+ **/
+bool copyCachedBlock(ReadCache *cache, PhysicalBlockNumber pbn, char *buffer)
+  __attribute__((warn_unused_result));
+
+/**
+ * Copy a physical block from the cache into the pages of a bio which has
+ * not been submitted.
+ *
+ * @param cache  The cache
+ * @param pbn    The physical block number
+ * @param bio    The bio to hold the block
+ *
+ * @return <code>true</code> if the block was in the cache
+ **/
+bool copyCachedBlockToBio(ReadCache *cache, PhysicalBlockNumber pbn, BIO *bio)
+  __attribute__((warn_unused_result));
+
+/**
+ * Offer the cache a copy of a physical block which has just been read.
+ *
+ * @param cache  The cache
+ * @param pbn    The physical block number
+ * @param data   The contents of the block, VDO_BLOCK_SIZE bytes long
+ **/
+void cacheBlock(ReadCache *cache, PhysicalBlockNumber pbn, const char *data);
+
+/**
+ * Invalidate any cached copy of a physical block, because the block is
+ * about to be written.
+ *
+ * @param cache  The cache
+ * @param pbn    The physical block number
+ **/
+void invalidateCachedBlock(ReadCache *cache, PhysicalBlockNumber pbn);
+
+#endif /* READ_CACHE_H */
@@ -124,6 +124,15 @@ void getKernelStats(KernelLayer *layer, KernelStatistics *stats)
   stats->dedupeAdviceTimeouts = (getEventCount(&layer->albireoTimeoutReporter)
                                  + atomic64_read(&layer->dedupeContextBusy));
   stats->flushOut             = atomic64_read(&layer->flushOut);
+  stats->compressionEarlyRejects
+    = atomic64_read(&layer->compressionEarlyRejects);
+  stats->compressionFailures  = atomic64_read(&layer->compressionFailures);
+  stats->verifyReads          = atomic64_read(&layer->verifyReads);
+  stats->verifyReadsAvoided   = atomic64_read(&layer->verifyReadsAvoided);
+  stats->readCacheHits        = atomic64_read(&layer->readCacheHits);
+  stats->readCacheMisses      = atomic64_read(&layer->readCacheMisses);
+  stats->compressedReadsCoalesced
+    = atomic64_read(&layer->compressedReadsCoalesced);
   stats->logicalBlockSize     = layer->deviceConfig->logicalBlockSize;
   copyBioStat(&stats->biosIn, &layer->biosIn);
   copyBioStat(&stats->biosInPartial, &layer->biosInPartial);
@@ -36,18 +36,22 @@
 
 #include "udsIndex.h"
 
+#include "histogram.h"
 #include "logger.h"
 #include "memoryAlloc.h"
 #include "murmur/MurmurHash3.h"
 #include "numeric.h"
 #include "stringUtils.h"
 #include "uds-block.h"
+#include "util/funnelQueue.h"
 
 /*****************************************************************************/
 
 typedef struct udsAttribute {
   struct attribute attr;
   const char *(*showString)(DedupeIndex *);
+  ssize_t (*show)(struct udsIndex *, char *);
+  ssize_t (*store)(struct udsIndex *, const char *, size_t);
 } UDSAttribute;
 
 /*****************************************************************************/
@@ -68,6 +72,25 @@ enum {
 
 /*****************************************************************************/
 
+enum {
+  // The number of power-of-two buckets of index response latencies, in
+  // jiffies, from which the adaptive timeout is chosen.
+  LATENCY_BUCKETS            = 20,
+  // The number of responses after which the timeout is chosen again.
+  LATENCY_SAMPLE_INTERVAL    = 1024,
+  // The default percentile of index response latencies to allow for. The
+  // adaptive timeout is off (the fixed albireo timeout interval is used)
+  // until a percentile is set through the timeout_percentile attribute.
+  DEFAULT_TIMEOUT_PERCENTILE = 0,
+  // The timeout is twice the upper bound of the bucket holding the latency
+  // at the target percentile.
+  TIMEOUT_LATENCY_MULTIPLE   = 2,
+  // Requests are never shed while fewer than this many are outstanding.
+  MINIMUM_SHED_DEPTH         = 2 * UDS_MAX_CHUNK_OPERATIONS,
+};
+
+/*****************************************************************************/
+
 typedef enum {
   // The UDS index is closed
   IS_CLOSED = 0,
@@ -108,6 +131,28 @@ typedef struct udsIndex {
   struct list_head   pendingHead;  // protected by pendingLock
   struct timer_list  pendingTimer; // protected by pendingLock
   bool               startedTimer; // protected by pendingLock
+  // The DataKVIOs whose requests are waiting to be started, which the
+  // udsQueue thread hands to UDS in batches.
+  FunnelQueue       *startQueue;
+  KvdoWorkItem       startItem;
+  atomic_t           startScheduled;
+  UdsRequest        *startBatch[UDS_MAX_CHUNK_OPERATIONS]; // udsQueue only
+  // This spinlock protects the recent response latencies from which the
+  // timeout and the shedding depth are chosen.
+  spinlock_t         latencyLock;
+  unsigned int       latencyCounts[LATENCY_BUCKETS]; // protected by latencyLock
+  unsigned int       latencySamples;     // protected by latencyLock
+  Jiffies            intervalStart;      // protected by latencyLock
+  unsigned int       timeoutPercentile;  // protected by latencyLock
+  Histogram         *latencyHistogram;
+  // The timeout chosen from the recent latencies, which is limited to the
+  // albireo timeout interval when it is used
+  Jiffies            timeoutJiffies;
+  // When shedding, requests are not sent to the index while this many are
+  // already outstanding, since they would be expected to time out.
+  bool               shedding;
+  unsigned int       shedDepth;
+  atomic64_t         shedRequests;
 } UDSIndex;
 
 /*****************************************************************************/
@@ -193,16 +238,91 @@ static bool decodeUDSAdvice(const UdsRequest *request, DataLocation *advice)
   return true;
 }
 
+/**
+ * Get the time an index request may wait before it is given up on.
+ *
+ * @param index  The index
+ *
+ * @return The timeout, in jiffies
+ **/
+static Jiffies getIndexTimeout(UDSIndex *index)
+{
+  return minUInt64(READ_ONCE(index->timeoutJiffies), albireoTimeoutJiffies);
+}
+
+/**
+ * Choose the timeout from the recent response latencies, allowing for the
+ * latency at the target percentile. With no target percentile, or no
+ * latencies yet, the albireo timeout interval is used as it is.
+ *
+ * @param index  The index, whose latencyLock must be held
+ **/
+static void chooseIndexTimeout(UDSIndex *index)
+{
+  uint64_t total = 0;
+  for (unsigned int i = 0; i < LATENCY_BUCKETS; i++) {
+    total += index->latencyCounts[i];
+  }
+
+  if ((index->timeoutPercentile == 0) || (total == 0)) {
+    WRITE_ONCE(index->timeoutJiffies, U64_MAX);
+    return;
+  }
+
+  uint64_t target = DIV_ROUND_UP(total * index->timeoutPercentile, 100);
+  unsigned int bucket = 0;
+  uint64_t seen = index->latencyCounts[0];
+  while ((seen < target) && (bucket < LATENCY_BUCKETS - 1)) {
+    seen += index->latencyCounts[++bucket];
+  }
+  WRITE_ONCE(index->timeoutJiffies,
+             (Jiffies) TIMEOUT_LATENCY_MULTIPLE << bucket);
+}
+
+/**
+ * Record the response latency of an index request. At the end of each
+ * sampling interval, choose the timeout and the shedding depth again, and
+ * age the recorded latencies.
+ *
+ * @param index    The index
+ * @param latency  The time from submission to response, in jiffies
+ **/
+static void recordIndexLatency(UDSIndex *index, Jiffies latency)
+{
+  enterHistogramSample(index->latencyHistogram, latency);
+  unsigned int bucket = minInt(fls64(latency), LATENCY_BUCKETS - 1);
+  spin_lock(&index->latencyLock);
+  index->latencyCounts[bucket]++;
+  index->latencySamples++;
+  Jiffies elapsed = jiffies - index->intervalStart;
+  if ((index->latencySamples >= LATENCY_SAMPLE_INTERVAL) || (elapsed >= HZ)) {
+    chooseIndexTimeout(index);
+    // A request which finds more requests ahead of it than the index answered
+    // within one timeout during this interval would be expected to time out.
+    uint64_t depth = (((uint64_t) index->latencySamples
+                       * getIndexTimeout(index)) / maxULong(elapsed, 1));
+    WRITE_ONCE(index->shedDepth,
+               maxUInt(MINIMUM_SHED_DEPTH, minUInt64(depth, UINT_MAX)));
+    for (unsigned int i = 0; i < LATENCY_BUCKETS; i++) {
+      index->latencyCounts[i] /= 2;
+    }
+    index->latencySamples = 0;
+    index->intervalStart  = jiffies;
+  }
+  spin_unlock(&index->latencyLock);
+}
+
 /*****************************************************************************/
 static void finishIndexOperation(UdsRequest *udsRequest)
 {
   DataKVIO *dataKVIO = container_of(udsRequest, DataKVIO,
                                     dedupeContext.udsRequest);
   DedupeContext *dedupeContext = &dataKVIO->dedupeContext;
+  KVIO *kvio = dataKVIOAsKVIO(dataKVIO);
+  UDSIndex *index = container_of(kvio->layer->dedupeIndex, UDSIndex, common);
+  // Late responses are recorded too, so that the timeout can grow again.
+  recordIndexLatency(index, jiffies - dedupeContext->submissionTime);
   if (compareAndSwap32(&dedupeContext->requestState, UR_BUSY, UR_IDLE)) {
-    KVIO *kvio = dataKVIOAsKVIO(dataKVIO);
-    UDSIndex *index = container_of(kvio->layer->dedupeIndex, UDSIndex, common);
-
     spin_lock_bh(&index->pendingLock);
     if (dedupeContext->isPending) {
       list_del(&dedupeContext->pendingList);
@@ -211,6 +331,8 @@ static void finishIndexOperation(UdsRequest *udsRequest)
     spin_unlock_bh(&index->pendingLock);
 
     dedupeContext->status = udsRequest->status;
+    // Only an answered request leaves its advice in the index.
+    dataKVIO->dataVIO.indexAnswered = (udsRequest->status == UDS_SUCCESS);
     if ((udsRequest->type == UDS_POST) || (udsRequest->type == UDS_QUERY)) {
       DataLocation advice;
       if (decodeUDSAdvice(udsRequest, &advice)) {
@@ -232,29 +354,62 @@ static void startExpirationTimer(UDSIndex *index, DataKVIO *dataKVIO)
   if (!index->startedTimer) {
     index->startedTimer = true;
     mod_timer(&index->pendingTimer,
-              getAlbireoTimeout(dataKVIO->dedupeContext.submissionTime));
+              getAlbireoTimeout(dataKVIO->dedupeContext.submissionTime,
+                                getIndexTimeout(index)));
   }
 }
 
 /*****************************************************************************/
-static void startIndexOperation(KvdoWorkItem *item)
+static void scheduleIndexOperations(UDSIndex *index)
 {
-  KVIO *kvio = workItemAsKVIO(item);
-  DataKVIO *dataKVIO = kvioAsDataKVIO(kvio);
-  UDSIndex *index = container_of(kvio->layer->dedupeIndex, UDSIndex, common);
-  DedupeContext *dedupeContext = &dataKVIO->dedupeContext;
+  // See scheduleBatchProcessing() for why the fence is needed.
+  smp_mb();
+  if (atomic_cmpxchg(&index->startScheduled, 0, 1) == 0) {
+    enqueueWorkQueue(index->udsQueue, &index->startItem);
+  }
+}
 
-  spin_lock_bh(&index->pendingLock);
-  list_add_tail(&dedupeContext->pendingList, &index->pendingHead);
-  dedupeContext->isPending = true;
-  startExpirationTimer(index, dataKVIO);
-  spin_unlock_bh(&index->pendingLock);
+/*****************************************************************************/
+static void startIndexOperations(KvdoWorkItem *item)
+{
+  UDSIndex *index = container_of(item, UDSIndex, startItem);
+  unsigned int count = 0;
+  FunnelQueueEntry *entry;
+  while ((count < UDS_MAX_CHUNK_OPERATIONS)
+         && ((entry = funnelQueuePoll(index->startQueue)) != NULL)) {
+    KVIO *kvio = workItemAsKVIO(container_of(entry, KvdoWorkItem,
+                                             workQueueEntryLink));
+    index->startBatch[count++]
+      = &kvioAsDataKVIO(kvio)->dedupeContext.udsRequest;
+  }
 
-  UdsRequest *udsRequest = &dedupeContext->udsRequest;
-  int status = udsStartChunkOperation(udsRequest);
-  if (status != UDS_SUCCESS) {
-    udsRequest->status = status;
-    finishIndexOperation(udsRequest);
+  if (count > 0) {
+    spin_lock_bh(&index->pendingLock);
+    for (unsigned int i = 0; i < count; i++) {
+      DataKVIO *dataKVIO = container_of(index->startBatch[i], DataKVIO,
+                                        dedupeContext.udsRequest);
+      DedupeContext *dedupeContext = &dataKVIO->dedupeContext;
+      list_add_tail(&dedupeContext->pendingList, &index->pendingHead);
+      dedupeContext->isPending = true;
+      startExpirationTimer(index, dataKVIO);
+    }
+    spin_unlock_bh(&index->pendingLock);
+
+    int status = udsStartChunkOperations(index->startBatch, count);
+    if (status != UDS_SUCCESS) {
+      for (unsigned int i = 0; i < count; i++) {
+        index->startBatch[i]->status = status;
+        finishIndexOperation(index->startBatch[i]);
+      }
+    }
+  }
+
+  // Handle any further requests in a new work item, so that a steady stream
+  // of them can't hold off index state changes on this queue.
+  atomic_set(&index->startScheduled, 0);
+  smp_mb();
+  if (!isFunnelQueueEmpty(index->startQueue)) {
+    scheduleIndexOperations(index);
   }
 }
 
@@ -271,8 +426,7 @@ static void timeoutIndexOperations(unsigned long arg)
   UDSIndex *index = (UDSIndex *) arg;
 #endif
   LIST_HEAD(expiredHead);
-  uint64_t timeoutJiffies = msecs_to_jiffies(albireoTimeoutInterval);
-  unsigned long earliestSubmissionAllowed = jiffies - timeoutJiffies;
+  unsigned long earliestSubmissionAllowed = jiffies - getIndexTimeout(index);
   spin_lock_bh(&index->pendingLock);
   index->startedTimer = false;
   while (!list_empty(&index->pendingHead)) {
@@ -310,9 +464,20 @@ static void enqueueIndexOperation(DataKVIO        *dataKVIO,
   KVIO *kvio = dataKVIOAsKVIO(dataKVIO);
   DedupeContext *dedupeContext = &dataKVIO->dedupeContext;
   UDSIndex *index = container_of(kvio->layer->dedupeIndex, UDSIndex, common);
-  dedupeContext->status         = UDS_SUCCESS;
-  dedupeContext->submissionTime = jiffies;
+  dedupeContext->status = UDS_SUCCESS;
+  if (READ_ONCE(index->shedding)
+      && (atomic_read(&index->active) >= READ_ONCE(index->shedDepth))) {
+    // The index is too far behind to answer before the request would time
+    // out, so don't wait for it.
+    atomic64_inc(&index->shedRequests);
+    invokeDedupeCallback(dataKVIO);
+    return;
+  }
+
   if (compareAndSwap32(&dedupeContext->requestState, UR_IDLE, UR_BUSY)) {
+    // The submission time of a request which has timed out is still needed
+    // when its response arrives.
+    dedupeContext->submissionTime = jiffies;
     UdsRequest *udsRequest = &dataKVIO->dedupeContext.udsRequest;
     udsRequest->chunkName = *dedupeContext->chunkName;
     udsRequest->callback  = finishIndexOperation;
@@ -323,12 +488,11 @@ static void enqueueIndexOperation(DataKVIO        *dataKVIO,
       encodeUDSAdvice(udsRequest, getDedupeAdvice(dedupeContext));
     }
 
-    setupWorkItem(&kvio->enqueueable.workItem, startIndexOperation, NULL,
-                  UDS_Q_ACTION);
-
     spin_lock(&index->stateLock);
     if (index->deduping) {
-      enqueueWorkQueue(index->udsQueue, &kvio->enqueueable.workItem);
+      funnelQueuePut(index->startQueue,
+                     &kvio->enqueueable.workItem.workQueueEntryLink);
+      scheduleIndexOperations(index);
       unsigned int active = atomic_inc_return(&index->active);
       if (active > index->maximum) {
         index->maximum = active;
@@ -449,6 +613,12 @@ static void openSession(UDSIndex *index)
           // We have an index, but it was made for some other VDO device.  We
           // will close the index and then try to create a new index.
           nextCreateFlag = true;
+        } else if (udsConfigurationGetChunkNameHash(index->configuration)
+                   != udsConfigurationGetChunkNameHash(configuration)) {
+          logError("Index chunk names were not computed with this VDO's"
+                   " hash function");
+          // None of the names in the index could ever match, so start over.
+          nextCreateFlag = true;
         }
         udsFreeConfiguration(configuration);
       }
@@ -588,6 +758,7 @@ static void freeUDSIndex(DedupeIndex *dedupeIndex)
     del_timer_sync(&index->pendingTimer);
   }
   spin_unlock_bh(&index->pendingLock);
+  freeHistogram(&index->latencyHistogram);
   kobject_put(&index->dedupeObject);
 }
 
@@ -688,6 +859,7 @@ static void udsUpdate(DataKVIO *dataKVIO)
 static void dedupeKobjRelease(struct kobject *kobj)
 {
   UDSIndex *index = container_of(kobj, UDSIndex, dedupeObject);
+  freeFunnelQueue(index->startQueue);
   FREE(index->indexName);
   FREE(index);
 }
@@ -699,7 +871,9 @@ static ssize_t dedupeStatusShow(struct kobject   *kobj,
 {
   UDSAttribute *ua = container_of(attr, UDSAttribute, attr);
   UDSIndex *index = container_of(kobj, UDSIndex, dedupeObject);
-  if (ua->showString != NULL) {
+  if (ua->show != NULL) {
+    return ua->show(index, buf);
+  } else if (ua->showString != NULL) {
     return sprintf(buf, "%s\n", ua->showString(&index->common));
   } else {
     return -EINVAL;
@@ -712,7 +886,74 @@ static ssize_t dedupeStatusStore(struct kobject   *kobj,
                                  const char       *buf,
                                  size_t            length)
 {
-  return -EINVAL;
+  UDSAttribute *ua = container_of(attr, UDSAttribute, attr);
+  UDSIndex *index = container_of(kobj, UDSIndex, dedupeObject);
+  if (ua->store != NULL) {
+    return ua->store(index, buf, length);
+  } else {
+    return -EINVAL;
+  }
+}
+
+/*****************************************************************************/
+static ssize_t timeoutShow(UDSIndex *index, char *buf)
+{
+  return sprintf(buf, "%u\n", jiffies_to_msecs(getIndexTimeout(index)));
+}
+
+/*****************************************************************************/
+static ssize_t timeoutPercentileShow(UDSIndex *index, char *buf)
+{
+  spin_lock(&index->latencyLock);
+  unsigned int percentile = index->timeoutPercentile;
+  spin_unlock(&index->latencyLock);
+  return sprintf(buf, "%u\n", percentile);
+}
+
+/*****************************************************************************/
+static ssize_t timeoutPercentileStore(UDSIndex   *index,
+                                      const char *buf,
+                                      size_t      length)
+{
+  unsigned int value;
+  if ((length > 12) || (sscanf(buf, "%u", &value) != 1) || (value > 100)) {
+    return -EINVAL;
+  }
+  spin_lock(&index->latencyLock);
+  index->timeoutPercentile = value;
+  chooseIndexTimeout(index);
+  spin_unlock(&index->latencyLock);
+  return length;
+}
+
+/*****************************************************************************/
+static ssize_t sheddingShow(UDSIndex *index, char *buf)
+{
+  return sprintf(buf, "%u\n", READ_ONCE(index->shedding) ? 1 : 0);
+}
+
+/*****************************************************************************/
+static ssize_t sheddingStore(UDSIndex *index, const char *buf, size_t length)
+{
+  unsigned int value;
+  if ((length > 12) || (sscanf(buf, "%u", &value) != 1) || (value > 1)) {
+    return -EINVAL;
+  }
+  WRITE_ONCE(index->shedding, (value == 1));
+  return length;
+}
+
+/*****************************************************************************/
+static ssize_t shedDepthShow(UDSIndex *index, char *buf)
+{
+  return sprintf(buf, "%u\n", READ_ONCE(index->shedDepth));
+}
+
+/*****************************************************************************/
+static ssize_t shedRequestsShow(UDSIndex *index, char *buf)
+{
+  return sprintf(buf, "%lld\n",
+                 (long long) atomic64_read(&index->shedRequests));
 }
 
 /*****************************************************************************/
@@ -727,8 +968,40 @@ static UDSAttribute dedupeStatusAttribute = {
   .showString = getUDSStateName,
 };
 
+static UDSAttribute dedupeTimeoutAttribute = {
+  .attr = {.name = "timeout", .mode = 0444, },
+  .show = timeoutShow,
+};
+
+static UDSAttribute dedupeTimeoutPercentileAttribute = {
+  .attr  = {.name = "timeout_percentile", .mode = 0644, },
+  .show  = timeoutPercentileShow,
+  .store = timeoutPercentileStore,
+};
+
+static UDSAttribute dedupeSheddingAttribute = {
+  .attr  = {.name = "shedding", .mode = 0644, },
+  .show  = sheddingShow,
+  .store = sheddingStore,
+};
+
+static UDSAttribute dedupeShedDepthAttribute = {
+  .attr = {.name = "shed_depth", .mode = 0444, },
+  .show = shedDepthShow,
+};
+
+static UDSAttribute dedupeShedRequestsAttribute = {
+  .attr = {.name = "shed_requests", .mode = 0444, },
+  .show = shedRequestsShow,
+};
+
 static struct attribute *dedupeAttributes[] = {
   &dedupeStatusAttribute.attr,
+  &dedupeTimeoutAttribute.attr,
+  &dedupeTimeoutPercentileAttribute.attr,
+  &dedupeSheddingAttribute.attr,
+  &dedupeShedDepthAttribute.attr,
+  &dedupeShedRequestsAttribute.attr,
   NULL,
 };
 
@@ -815,6 +1088,34 @@ int makeUDSIndex(KernelLayer *layer, DedupeIndex **indexPtr)
     return result;
   }
 
+  result = makeFunnelQueue(&index->startQueue);
+  if (result != UDS_SUCCESS) {
+    freeWorkQueue(&index->udsQueue);
+    udsFreeConfiguration(index->configuration);
+    kobject_put(&index->dedupeObject);
+    return result;
+  }
+  setupWorkItem(&index->startItem, startIndexOperations, NULL, UDS_Q_ACTION);
+  atomic_set(&index->startScheduled, 0);
+
+  index->latencyHistogram
+    = makeLogarithmicJiffiesHistogram(&index->dedupeObject, "latency",
+                                      "Dedupe Index Latency", "requests",
+                                      "response time", 5);
+  if (index->latencyHistogram == NULL) {
+    freeWorkQueue(&index->udsQueue);
+    udsFreeConfiguration(index->configuration);
+    kobject_put(&index->dedupeObject);
+    return -ENOMEM;
+  }
+  spin_lock_init(&index->latencyLock);
+  index->intervalStart     = jiffies;
+  index->timeoutPercentile = DEFAULT_TIMEOUT_PERCENTILE;
+  index->timeoutJiffies    = U64_MAX;
+  // Nothing is shed until the index has been seen to fall behind.
+  index->shedDepth         = UINT_MAX;
+  atomic64_set(&index->shedRequests, 0);
+
   index->common.dump                      = dumpUDSIndex;
   index->common.free                      = freeUDSIndex;
   index->common.getDedupeStateName        = getUDSStateName;
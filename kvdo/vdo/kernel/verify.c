@@ -23,105 +23,46 @@
 
 #include "logger.h"
 
+#include "blockDigests.h"
 #include "dataKVIO.h"
-#include "numeric.h"
-
-/**
- * Compare blocks of memory for equality.
- *
- * This assumes the blocks are likely to be large; it's not well
- * optimized for comparing just a few bytes.  This is desirable
- * because the Linux kernel memcmp() routine on x86 is not well
- * optimized for large blocks, and the performance penalty turns out
- * to be significant if you're doing lots of 4KB comparisons.
- *
- * @param pointerArgument1  first data block
- * @param pointerArgument2  second data block
- * @param length            length of the data block
- *
- * @return   true iff the two blocks are equal
- **/
-__attribute__((warn_unused_result))
-static bool memoryEqual(void   *pointerArgument1,
-                        void   *pointerArgument2,
-                        size_t  length)
-{
-  byte *pointer1 = pointerArgument1;
-  byte *pointer2 = pointerArgument2;
-  while (length >= sizeof(uint64_t)) {
-    /*
-     * GET_UNALIGNED is just for paranoia.  (1) On x86_64 it is
-     * treated the same as an aligned access.  (2) In this use case,
-     * one or both of the inputs will almost(?) always be aligned.
-     */
-    if (GET_UNALIGNED(uint64_t, pointer1)
-        != GET_UNALIGNED(uint64_t, pointer2)) {
-      return false;
-    }
-    pointer1 += sizeof(uint64_t);
-    pointer2 += sizeof(uint64_t);
-    length -= sizeof(uint64_t);
-  }
-  while (length > 0) {
-    if (*pointer1 != *pointer2) {
-      return false;
-    }
-    pointer1++;
-    pointer2++;
-    length--;
-  }
-  return true;
-}
+#include "numUtils.h"
 
 /**
  * Verify the Albireo-provided deduplication advice, and invoke a
  * callback once the answer is available.
  *
+ * The comparison is done right here in the read completion, rather than
+ * on a CPU queue thread, since a 4KB compare costs less than the queue
+ * hop would, and the block just read is as warm in the cache now as it
+ * will ever be. (For a compressed duplicate, this is already running on
+ * the CPU queue thread which uncompressed it.)
+ *
  * After we've compared the stored data with the data to be written,
  * or after we've failed to be able to do so, the stored VIO callback
  * is queued to be run in the main (kvdoReqQ) thread.
  *
- * If the advice turns out to be stale and the deduplication session
- * is still active, submit a correction.  (Currently the correction
- * must be sent before the callback can be invoked, if the dedupe
- * session is still live.)
- *
- * @param item  The workitem from the queue
- **/
-static void verifyDuplicationWork(KvdoWorkItem *item)
-{
-  DataKVIO *dataKVIO = workItemAsDataKVIO(item);
-  dataKVIOAddTraceRecord(dataKVIO, THIS_LOCATION("$F;j=dedupe;cb=verify"));
-
-  if (likely(memoryEqual(dataKVIO->dataBlock, dataKVIO->readBlock.data,
-                         VDO_BLOCK_SIZE))) {
-    // Leave dataKVIO->dataVIO.isDuplicate set to true.
-  } else {
-    dataKVIO->dataVIO.isDuplicate = false;
-  }
-
-  kvdoEnqueueDataVIOCallback(dataKVIO);
-}
-
-/**
- * Verify the Albireo-provided deduplication advice, and invoke a
- * callback once the answer is available.
- *
  * @param dataKVIO  The DataKVIO that we are looking to dedupe.
  **/
 static void verifyReadBlockCallback(DataKVIO *dataKVIO)
 {
-  dataKVIOAddTraceRecord(dataKVIO, THIS_LOCATION(NULL));
+  dataKVIOAddTraceRecord(dataKVIO, THIS_LOCATION("$F;j=dedupe;cb=verify"));
   int err = dataKVIO->readBlock.status;
   if (unlikely(err != 0)) {
     logDebug("%s: err %d", __func__, err);
     dataKVIO->dataVIO.isDuplicate = false;
-    kvdoEnqueueDataVIOCallback(dataKVIO);
-    return;
+  } else if (unlikely(!memoryEqual(dataKVIO->dataBlock,
+                                   dataKVIO->readBlock.data,
+                                   VDO_BLOCK_SIZE))) {
+    dataKVIO->dataVIO.isDuplicate = false;
+  } else if (dataKVIO->hasDigest
+             && !isCompressed(dataKVIO->readBlock.mappingState)) {
+    // The next write of this data won't need to read the block.
+    recordBlockDigest(getLayerFromDataKVIO(dataKVIO)->blockDigests,
+                      dataKVIO->dataVIO.duplicate.pbn, &dataKVIO->digest);
   }
+  // Otherwise, leave dataKVIO->dataVIO.isDuplicate set to true.
 
-  launchDataKVIOOnCPUQueue(dataKVIO, verifyDuplicationWork, NULL,
-                           CPU_Q_ACTION_COMPRESS_BLOCK);
+  kvdoEnqueueDataVIOCallback(dataKVIO);
 }
 
 /**********************************************************************/
@@ -135,6 +76,25 @@ void kvdoVerifyDuplication(DataVIO *dataVIO)
   ASSERT_LOG_ONLY(!dataVIO->isZeroBlock,
                   "zeroed block should not have advice to verify");
 
+  DataKVIO    *dataKVIO = dataVIOAsDataKVIO(dataVIO);
+  KernelLayer *layer    = getLayerFromDataKVIO(dataKVIO);
+  if (dataKVIO->hasDigest && !isCompressed(dataVIO->duplicate.state)) {
+    // The duplicate is read locked, so it can't be rewritten while its
+    // recorded digest, if any, is relied upon.
+    BlockDigestMatch match = matchBlockDigest(layer->blockDigests,
+                                              dataVIO->duplicate.pbn,
+                                              &dataKVIO->digest);
+    if (match != BLOCK_DIGEST_UNKNOWN) {
+      dataVIOAddTraceRecord(dataVIO,
+                            THIS_LOCATION("verifyDuplication;dup=digest"));
+      atomic64_inc(&layer->verifyReadsAvoided);
+      dataVIO->isDuplicate = (match == BLOCK_DIGEST_MATCH);
+      kvdoEnqueueDataVIOCallback(dataKVIO);
+      return;
+    }
+  }
+
+  atomic64_inc(&layer->verifyReads);
   TraceLocation location
     = THIS_LOCATION("verifyDuplication;dup=update(verify);io=verify");
   dataVIOAddTraceRecord(dataVIO, location);
@@ -148,5 +108,8 @@ bool kvdoCompareDataVIOs(DataVIO *first, DataVIO *second)
   dataVIOAddTraceRecord(second, THIS_LOCATION(NULL));
   DataKVIO *a = dataVIOAsDataKVIO(first);
   DataKVIO *b = dataVIOAsDataKVIO(second);
+  if (a->hasDigest && b->hasDigest) {
+    return (memcmp(&a->digest, &b->digest, sizeof(BlockDigest)) == 0);
+  }
   return memoryEqual(a->dataBlock, b->dataBlock, VDO_BLOCK_SIZE);
 }
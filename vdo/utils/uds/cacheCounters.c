@@ -51,13 +51,39 @@ void addCacheCounters(CacheCounters *stats, const CacheCounters *addend)
   addCacheCountsByPageType(&stats->firstTime, addend->firstTime);
   addCacheCountsByPageType(&stats->retried,   addend->retried);
 
-  stats->evictions   += addend->evictions;
-  stats->expirations += addend->expirations;
+  stats->evictions    += addend->evictions;
+  stats->expirations  += addend->expirations;
+  stats->victims      += addend->victims;
+  stats->victimProbes += addend->victimProbes;
+  stats->promotions   += addend->promotions;
 
   addCacheCountsByKind(&stats->sparseChapters, addend->sparseChapters);
   addCacheCountsByKind(&stats->sparseSearches, addend->sparseSearches);
 }
 
+/**********************************************************************/
+static INLINE uint64_t getCacheProbes(CacheCountsByKind counts)
+{
+  return counts.hits + counts.misses + counts.queued;
+}
+
+/**********************************************************************/
+unsigned int getPageCacheHitRate(const CacheCounters *counters)
+{
+  uint64_t hits = (counters->firstTime.indexPage.hits
+                   + counters->firstTime.recordPage.hits
+                   + counters->retried.indexPage.hits
+                   + counters->retried.recordPage.hits);
+  uint64_t probes = (getCacheProbes(counters->firstTime.indexPage)
+                     + getCacheProbes(counters->firstTime.recordPage)
+                     + getCacheProbes(counters->retried.indexPage)
+                     + getCacheProbes(counters->retried.recordPage));
+  if (probes == 0) {
+    return 0;
+  }
+  return (hits * 1000) / probes;
+}
+
 /**********************************************************************/
 void incrementCacheCounter(CacheCounters   *counters,
                            int              probeType,
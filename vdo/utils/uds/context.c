@@ -106,9 +106,18 @@ static int checkContext(UdsContext *context)
 
 /**********************************************************************/
 int getBaseContext(unsigned int contextId, UdsContext **contextPtr)
+{
+  return getBaseContextReferences(contextId, 1, contextPtr);
+}
+
+/**********************************************************************/
+int getBaseContextReferences(unsigned int   contextId,
+                             unsigned int   count,
+                             UdsContext   **contextPtr)
 {
   Session *session;
-  int result = getSession(getContextGroup(), contextId, &session);
+  int result = getSessionReferences(getContextGroup(), contextId, count,
+                                    &session);
   if (result != UDS_SUCCESS) {
     return result;
   }
@@ -116,7 +125,7 @@ int getBaseContext(unsigned int contextId, UdsContext **contextPtr)
   UdsContext *context = (UdsContext *) getSessionContents(session);
   result = checkContext(context);
   if (result != UDS_SUCCESS) {
-    releaseSession(session);
+    releaseSessionReferences(session, count);
     return result;
   }
 
@@ -130,6 +139,12 @@ void releaseBaseContext(UdsContext *context)
   releaseSession(&context->session);
 }
 
+/**********************************************************************/
+void releaseBaseContextReferences(UdsContext *context, unsigned int count)
+{
+  releaseSessionReferences(&context->session, count);
+}
+
 /**********************************************************************/
 int handleError(UdsContext *context, int errorCode)
 {
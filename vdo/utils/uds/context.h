@@ -107,6 +107,21 @@ int makeBaseContext(IndexSession *indexSession, UdsContext **contextPtr)
 int getBaseContext(unsigned int contextId, UdsContext **contextPtr)
   __attribute__((warn_unused_result));
 
+/**
+ * Get the non-type-specific underlying context for a given context, holding
+ * several references to it, one for each request of a batch.
+ *
+ * @param contextId   The id of the context making the requests
+ * @param count       The number of references to acquire
+ * @param contextPtr  A pointer to receive the base context
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+int getBaseContextReferences(unsigned int   contextId,
+                             unsigned int   count,
+                             UdsContext   **contextPtr)
+  __attribute__((warn_unused_result));
+
 /**
  * Release the non-type-specific underlying context for a given context.
  *
@@ -114,6 +129,15 @@ int getBaseContext(unsigned int contextId, UdsContext **contextPtr)
  **/
 void releaseBaseContext(UdsContext *context);
 
+/**
+ * Release several references to the non-type-specific underlying context
+ * for a given context.
+ *
+ * @param context The context to release
+ * @param count   The number of references to release
+ **/
+void releaseBaseContextReferences(UdsContext *context, unsigned int count);
+
 /**
  * Flush all outstanding requests on a given base context.
  *
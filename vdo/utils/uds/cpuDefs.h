@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/uds-releases/gloria/userLinux/uds/cpuDefs.h#1 $
+ */
+
+#ifndef LINUX_USER_CPU_DEFS_H
+#define LINUX_USER_CPU_DEFS_H 1
+
+#include "compiler.h"
+#include "typeDefs.h"
+
+/**
+ * Whether code may be compiled for the BMI1 and BMI2 bit manipulation
+ * extensions with __attribute__((target)), to be selected at run time by
+ * cpuHasBitManipulation().
+ **/
+#if defined(__x86_64__) && (defined(__clang__) || (__GNUC__ >= 5))
+#define HAVE_BIT_MANIPULATION_TARGET 1
+#else
+#define HAVE_BIT_MANIPULATION_TARGET 0
+#endif
+
+/**
+ * Check whether the CPU has the BMI1 and BMI2 bit manipulation extensions.
+ *
+ * @return true if code compiled for the extensions may be run
+ **/
+static INLINE bool cpuHasBitManipulation(void)
+{
+#if HAVE_BIT_MANIPULATION_TARGET
+  __builtin_cpu_init();
+  return (__builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2"));
+#else
+  return false;
+#endif
+}
+
+#endif /* LINUX_USER_CPU_DEFS_H */
@@ -309,6 +309,22 @@ size_t computeDeltaIndexSaveBytes(unsigned int numLists, size_t memorySize)
 int validateDeltaIndex(const DeltaIndex *deltaIndex)
   __attribute__((warn_unused_result));
 
+/**
+ * Prefetch the memory which a search of a delta list will touch. Searches
+ * of a batch of lists are best prepared in two passes: first fetch the list
+ * headers, and then, once those have had time to arrive, fetch the lists
+ * they locate. Only a mutable delta index has separate list headers, so
+ * nothing is done for an immutable one.
+ *
+ * @param deltaIndex  The delta index
+ * @param listNumber  The delta list number
+ * @param contents    False to fetch the delta list header, or true to read
+ *                    the header and fetch the delta list itself
+ **/
+void prefetchDeltaIndexList(const DeltaIndex *deltaIndex,
+                            unsigned int      listNumber,
+                            bool              contents);
+
 /**
  * Prepare to search for an entry in the specified delta list.
  *
@@ -26,4 +26,13 @@
 #define ENVIRONMENT    1 // Has environment variables
 #define GRID           0 // No grid
 
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IO_URING       1 // Has io_uring
+#endif
+#endif
+#ifndef IO_URING
+#define IO_URING       0 // No io_uring
+#endif
+
 #endif /* LINUX_USER_FEATURE_DEFS_H */
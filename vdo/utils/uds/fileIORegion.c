@@ -158,6 +158,19 @@ static int fior_getDataSize(IORegion *region,
   return getOpenFileSize(fior->fd, extent);
 }
 
+/*****************************************************************************/
+static int fior_getFileLocation(IORegion *region,
+                                off_t     offset,
+                                int      *fd,
+                                off_t    *fileOffset)
+{
+  FileIORegion *fior = asFileIORegion(region);
+
+  *fd         = fior->fd;
+  *fileOffset = offset;
+  return UDS_SUCCESS;
+}
+
 /*****************************************************************************/
 static int fior_clear(IORegion *region)
 {
@@ -267,15 +280,16 @@ int makeFileRegion(int fd, FileAccess access, IORegion **regionPtr)
   if (result != UDS_SUCCESS) {
     return result;
   }
-  fior->common.clear        = fior_clear;
-  fior->common.close        = fior_close;
-  fior->common.getBestSize  = fior_getBestSize;
-  fior->common.getBlockSize = fior_getBlockSize;
-  fior->common.getDataSize  = fior_getDataSize;
-  fior->common.getLimit     = fior_getLimit;
-  fior->common.read         = fior_read;
-  fior->common.syncContents = fior_syncContents;
-  fior->common.write        = fior_write;
+  fior->common.clear           = fior_clear;
+  fior->common.close           = fior_close;
+  fior->common.getBestSize     = fior_getBestSize;
+  fior->common.getBlockSize    = fior_getBlockSize;
+  fior->common.getDataSize     = fior_getDataSize;
+  fior->common.getFileLocation = fior_getFileLocation;
+  fior->common.getLimit        = fior_getLimit;
+  fior->common.read            = fior_read;
+  fior->common.syncContents    = fior_syncContents;
+  fior->common.write           = fior_write;
   fior->fd          = fd;
   fior->close       = false;
   fior->reading     = (access <= FU_CREATE_READ_WRITE);
@@ -25,9 +25,93 @@
 #include "indexCheckpoint.h"
 #include "indexInternals.h"
 #include "logger.h"
+#include "memoryAlloc.h"
+#include "request.h"
+#include "threads.h"
+#include "timeUtils.h"
 
 static const uint64_t NO_LAST_CHECKPOINT = UINT_MAX;
 
+enum {
+  /** The number of threads reading chapters during a replay */
+  REPLAY_READER_COUNT    = 2,
+  /** The number of chapters which may be read or replayed at once */
+  REPLAY_CHAPTER_COUNT   = 4,
+  /** The minimum interval between replay progress reports, in seconds */
+  REPLAY_REPORT_INTERVAL = 10,
+};
+
+typedef enum {
+  REPLAY_CHAPTER_FREE,      // available for a reader to claim
+  REPLAY_CHAPTER_READING,   // being read and routed by a reader
+  REPLAY_CHAPTER_READ,      // waiting for its index page map update
+  REPLAY_CHAPTER_REPLAYING, // being replayed by the zone workers
+} ReplayChapterState;
+
+/**
+ * A chapter being replayed: its pages as read from the volume, the highest
+ * delta list of each of its index pages, and its record numbers grouped by
+ * the master index zone which each record belongs to. Within each zone the
+ * records stay in the order they appear in the chapter.
+ **/
+typedef struct {
+  ReplayChapterState  state;
+  uint64_t            virtualChapter;
+  byte               *pageData;
+  unsigned int       *highestLists;
+  byte               *recordZones;
+  unsigned int       *records;
+  unsigned int       *zoneStarts;
+  unsigned int        zonesPending;
+  ChapterIndexPage    indexPage;
+} ReplayChapter;
+
+typedef struct replay Replay;
+
+/**
+ * A worker replaying the records of one master index zone.
+ **/
+typedef struct {
+  Replay       *replay;
+  unsigned int  zoneNumber;
+  Thread        thread;
+  /**
+   * A request used only to carry the zone number into volume searches, so
+   * that each worker uses its own zone's pending search counter.
+   **/
+  Request       searchRequest;
+} ReplayZone;
+
+/**
+ * The shared state of a volume replay. Reader threads read chapters ahead
+ * into a ring of buffers and route their records by zone; the replaying
+ * thread updates the index page map for each chapter in order and then
+ * hands the chapter to the zone workers, which replay their own records
+ * into their own master index zones.
+ **/
+struct replay {
+  Index         *index;
+  uint64_t       fromVCN;
+  uint64_t       uptoVCN;
+  /** Protects everything below */
+  Mutex          mutex;
+  /** Signalled whenever a chapter changes state or the replay fails */
+  CondVar        cond;
+  /** The next chapter for a reader to claim */
+  uint64_t       nextRead;
+  /** The chapters before this one may be replayed by the zone workers */
+  uint64_t       dispatched;
+  /** The number of chapters which every zone has finished */
+  uint64_t       chaptersReplayed;
+  /** The first error encountered, which stops the replay */
+  int            result;
+  ReplayChapter  chapters[REPLAY_CHAPTER_COUNT];
+  Thread         readers[REPLAY_READER_COUNT];
+  unsigned int   readerCount;
+  unsigned int   zoneWorkerCount;
+  ReplayZone    *zoneWorkers;
+};
+
 /**
  * Replay an index which was loaded from a checkpoint.
  *
@@ -568,40 +652,30 @@ int dispatchIndexRequest(Index *index, Request *request)
 }
 
 /**********************************************************************/
-static int rebuildIndexPageMap(Index *index, uint64_t vcn)
+void prefetchIndexRequests(Index         *index,
+                           Request *const requests[],
+                           unsigned int   count)
 {
-  Geometry *geometry = index->volume->geometry;
-  unsigned int chapter = mapToPhysicalChapter(geometry, vcn);
-  for (unsigned int indexPageNumber = 0;
-       indexPageNumber < geometry->indexPagesPerChapter;
-       indexPageNumber++) {
-    ChapterIndexPage *chapterIndexPage;
-    int result = getPage(index->volume, chapter, indexPageNumber,
-                         CACHE_PROBE_INDEX_FIRST, NULL, &chapterIndexPage);
-    if (result != UDS_SUCCESS) {
-      return logErrorWithStringError(result,
-                                     "failed to read index page %u"
-                                     " in chapter %u",
-                                     indexPageNumber, chapter);
+  // Fetch all the delta list headers first, since the delta lists can only
+  // be located once their headers have arrived.
+  for (unsigned int i = 0; i < count; i++) {
+    if (!requests[i]->isControlMessage) {
+      prefetchMasterIndexName(index->masterIndex, &requests[i]->hash, false);
     }
-    unsigned int highestDeltaList
-      = getChapterIndexHighestListNumber(chapterIndexPage);
-    result = updateIndexPageMap(index->volume->indexPageMap, vcn, chapter,
-                                indexPageNumber, highestDeltaList);
-    if (result != UDS_SUCCESS) {
-      return logErrorWithStringError(result,
-                                     "failed to update chapter %u index page"
-                                     " %u",
-                                     chapter, indexPageNumber);
+  }
+  for (unsigned int i = 0; i < count; i++) {
+    if (!requests[i]->isControlMessage) {
+      prefetchMasterIndexName(index->masterIndex, &requests[i]->hash, true);
     }
   }
-  return UDS_SUCCESS;
 }
 
 /**
  * Add an entry to the master index when rebuilding.
  *
  * @param index                The index to query.
+ * @param request              The request identifying the zone making the
+ *                             update, for any volume search
  * @param name                 The block name of interest.
  * @param virtualChapter       The virtual chapter number to write to the
  *                             master index
@@ -611,6 +685,7 @@ static int rebuildIndexPageMap(Index *index, uint64_t vcn)
  * @return UDS_SUCCESS or an error code
  **/
 static int replayRecord(Index              *index,
+                        Request            *request,
                         const UdsChunkName *name,
                         uint64_t            virtualChapter,
                         bool                willBeSparseChapter)
@@ -654,7 +729,7 @@ static int replayRecord(Index              *index,
        * In this case, we need to search that chapter to determine if the
        * master index entry was for the same record or a different one.
        */
-      result = searchVolumePageCache(index->volume, NULL, name,
+      result = searchVolumePageCache(index->volume, request, name,
                                      record.virtualChapter, NULL,
                                      &updateRecord);
       if (result != UDS_SUCCESS) {
@@ -705,45 +780,526 @@ void beginSave(Index *index, bool checkpoint, uint64_t openChapterNumber)
 }
 
 /**********************************************************************/
-int replayVolume(Index *index, uint64_t fromVCN)
+static INLINE ReplayChapter *getReplayChapter(Replay   *replay,
+                                              uint64_t  virtualChapter)
 {
-  int result;
-  uint64_t uptoVCN = index->newestVirtualChapter;
-  logInfo("Replaying volume from chapter %" PRIu64 " through chapter %"
-          PRIu64,
-          fromVCN, uptoVCN);
-  setMasterIndexOpenChapter(index->masterIndex, uptoVCN);
-  setMasterIndexOpenChapter(index->masterIndex, fromVCN);
+  return &replay->chapters[(virtualChapter - replay->fromVCN)
+                           % REPLAY_CHAPTER_COUNT];
+}
 
-  /*
-   * At least two cases to deal with here!
-   * - index loaded but replaying from lastCheckpoint; maybe full, maybe not
-   * - index failed to load, full rebuild
-   *   Starts empty, then dense-only, then dense-plus-sparse.
-   *   Need to sparsify while processing individual chapters.
-   */
-  IndexLookupMode oldLookupMode = index->volume->lookupMode;
-  index->volume->lookupMode = LOOKUP_FOR_REBUILD;
-  /*
-   * Go through each record page of each chapter and add the records back to
-   * the master index.  This should not cause anything to be written to either
-   * the open chapter or on disk volume.  Also skip the on disk chapter
-   * corresponding to upto, as this would have already been
-   * purged from the master index when the chapter was opened.
-   *
-   * Also, go through each index page for each chapter and rebuild the
-   * index page map.
-   */
+/**
+ * Find the name of a record in the pages of a replay chapter.
+ *
+ * @param geometry  The geometry of the volume
+ * @param chapter   The chapter, which has been read
+ * @param record    The number of the record within the chapter
+ *
+ * @return The name of the record
+ **/
+static INLINE const UdsChunkName *
+getReplayRecordName(const Geometry      *geometry,
+                    const ReplayChapter *chapter,
+                    unsigned int         record)
+{
+  unsigned int page = (geometry->indexPagesPerChapter
+                       + (record / geometry->recordsPerPage));
+  return (const UdsChunkName *)
+    &chapter->pageData[(page * geometry->bytesPerPage)
+                       + ((record % geometry->recordsPerPage)
+                          * BYTES_PER_RECORD)];
+}
+
+/**
+ * Record the first error of a replay and wake every thread so that the
+ * replay stops.
+ *
+ * @param replay  The replay, whose mutex must be held
+ * @param result  The error
+ **/
+static void failReplay(Replay *replay, int result)
+{
+  if (replay->result == UDS_SUCCESS) {
+    replay->result = result;
+  }
+  broadcastCond(&replay->cond);
+}
+
+/**
+ * Read a chapter for replay, decode its index pages, and group its record
+ * numbers by master index zone.
+ *
+ * @param replay   The replay
+ * @param chapter  The chapter, with its virtual chapter number set
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+static int readReplayChapter(Replay *replay, ReplayChapter *chapter)
+{
+  Index          *index    = replay->index;
+  const Geometry *geometry = index->volume->geometry;
+  unsigned int    physicalChapter
+    = mapToPhysicalChapter(geometry, chapter->virtualChapter);
+
+  int result = readChapterFromVolume(index->volume, chapter->virtualChapter,
+                                     chapter->pageData);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  for (unsigned int i = 0; i < geometry->indexPagesPerChapter; i++) {
+    result = initializeChapterIndexPage(&chapter->indexPage, geometry,
+                                        &chapter->pageData[i
+                                          * geometry->bytesPerPage],
+                                        index->volume->nonce);
+    if (result != UDS_SUCCESS) {
+      return logErrorWithStringError(result,
+                                     "failed to read index page %u"
+                                     " in chapter %u",
+                                     i, physicalChapter);
+    }
+    chapter->highestLists[i]
+      = getChapterIndexHighestListNumber(&chapter->indexPage);
+  }
+
+  // Count the records of each zone, then place them in chapter order.
+  unsigned int *zoneStarts = chapter->zoneStarts;
+  memset(zoneStarts, 0, (index->zoneCount + 1) * sizeof(unsigned int));
+  for (unsigned int i = 0; i < geometry->recordsPerChapter; i++) {
+    const UdsChunkName *name = getReplayRecordName(geometry, chapter, i);
+    unsigned int zone = getMasterIndexZone(index->masterIndex, name);
+    chapter->recordZones[i] = zone;
+    zoneStarts[zone + 1]++;
+  }
+  for (unsigned int zone = 0; zone < index->zoneCount; zone++) {
+    zoneStarts[zone + 1] += zoneStarts[zone];
+  }
+  for (unsigned int i = 0; i < geometry->recordsPerChapter; i++) {
+    chapter->records[zoneStarts[chapter->recordZones[i]]++] = i;
+  }
+  // Each start has advanced to the next zone's start; shift them back.
+  for (unsigned int zone = index->zoneCount; zone > 0; zone--) {
+    zoneStarts[zone] = zoneStarts[zone - 1];
+  }
+  zoneStarts[0] = 0;
+  return UDS_SUCCESS;
+}
+
+/**
+ * The body of a replay reader thread, which reads chapters into free
+ * replay buffers in chapter order until the replay is done or fails.
+ **/
+static void replayReaderThread(void *arg)
+{
+  Replay *replay = arg;
+
+  lockMutex(&replay->mutex);
+  while ((replay->result == UDS_SUCCESS)
+         && (replay->nextRead < replay->uptoVCN)) {
+    ReplayChapter *chapter = getReplayChapter(replay, replay->nextRead);
+    if (chapter->state != REPLAY_CHAPTER_FREE) {
+      waitCond(&replay->cond, &replay->mutex);
+      continue;
+    }
+
+    chapter->state          = REPLAY_CHAPTER_READING;
+    chapter->virtualChapter = replay->nextRead++;
+    unlockMutex(&replay->mutex);
+    int result = readReplayChapter(replay, chapter);
+    lockMutex(&replay->mutex);
+    if (result != UDS_SUCCESS) {
+      failReplay(replay, result);
+      break;
+    }
+    chapter->state = REPLAY_CHAPTER_READ;
+    broadcastCond(&replay->cond);
+  }
+  unlockMutex(&replay->mutex);
+}
+
+/**
+ * Replay the records of one zone from a chapter, in chapter order.
+ *
+ * @param worker   The zone worker
+ * @param chapter  The chapter to replay
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+static int replayChapterZone(ReplayZone *worker, ReplayChapter *chapter)
+{
+  Replay         *replay   = worker->replay;
+  Index          *index    = replay->index;
+  const Geometry *geometry = index->volume->geometry;
+  uint64_t        vcn      = chapter->virtualChapter;
+  bool willBeSparseChapter = isChapterSparse(geometry, replay->fromVCN,
+                                             replay->uptoVCN, vcn);
+  setMasterIndexZoneOpenChapter(index->masterIndex, worker->zoneNumber, vcn);
+
+  unsigned int end = chapter->zoneStarts[worker->zoneNumber + 1];
+  for (unsigned int i = chapter->zoneStarts[worker->zoneNumber]; i < end;
+       i++) {
+    const UdsChunkName *name
+      = getReplayRecordName(geometry, chapter, chapter->records[i]);
+    int result = replayRecord(index, &worker->searchRequest, name, vcn,
+                              willBeSparseChapter);
+    if (result != UDS_SUCCESS) {
+      char hexName[(2 * UDS_CHUNK_NAME_SIZE) + 1];
+      if (chunkNameToHex(name, hexName, sizeof(hexName)) != UDS_SUCCESS) {
+        strncpy(hexName, "<unknown>", sizeof(hexName));
+      }
+      return logUnrecoverable(result,
+                              "could not find block %s during rebuild",
+                              hexName);
+    }
+  }
+  return UDS_SUCCESS;
+}
+
+/**
+ * The body of a replay zone worker thread, which replays its zone's records
+ * from each chapter in turn as the chapters are handed to the workers.
+ **/
+static void replayZoneThread(void *arg)
+{
+  ReplayZone *worker = arg;
+  Replay     *replay = worker->replay;
+
+  for (uint64_t vcn = replay->fromVCN; vcn < replay->uptoVCN; vcn++) {
+    lockMutex(&replay->mutex);
+    while ((replay->result == UDS_SUCCESS) && (vcn >= replay->dispatched)) {
+      waitCond(&replay->cond, &replay->mutex);
+    }
+    int result = replay->result;
+    unlockMutex(&replay->mutex);
+    if (result != UDS_SUCCESS) {
+      return;
+    }
+
+    ReplayChapter *chapter = getReplayChapter(replay, vcn);
+    result = replayChapterZone(worker, chapter);
+
+    lockMutex(&replay->mutex);
+    if (result != UDS_SUCCESS) {
+      failReplay(replay, result);
+      unlockMutex(&replay->mutex);
+      return;
+    }
+    if (--chapter->zonesPending == 0) {
+      chapter->state = REPLAY_CHAPTER_FREE;
+      replay->chaptersReplayed++;
+      broadcastCond(&replay->cond);
+    }
+    unlockMutex(&replay->mutex);
+  }
+}
+
+/**
+ * Update the index page map from the index pages of a replayed chapter.
+ *
+ * @param index    The index
+ * @param chapter  The chapter which has been read
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+static int updateReplayPageMap(Index *index, const ReplayChapter *chapter)
+{
+  Geometry *geometry = index->volume->geometry;
+  unsigned int physicalChapter
+    = mapToPhysicalChapter(geometry, chapter->virtualChapter);
+  for (unsigned int i = 0; i < geometry->indexPagesPerChapter; i++) {
+    int result = updateIndexPageMap(index->volume->indexPageMap,
+                                    chapter->virtualChapter, physicalChapter,
+                                    i, chapter->highestLists[i]);
+    if (result != UDS_SUCCESS) {
+      return logErrorWithStringError(result,
+                                     "failed to update chapter %u index page"
+                                     " %u",
+                                     physicalChapter, i);
+    }
+  }
+  return UDS_SUCCESS;
+}
+
+/**
+ * Log the progress and throughput of a replay.
+ *
+ * @param replay     The replay
+ * @param chapters   The number of chapters replayed so far
+ * @param startTime  When the replay started
+ **/
+static void reportReplayProgress(const Replay *replay,
+                                 uint64_t      chapters,
+                                 AbsTime       startTime)
+{
+  const Geometry *geometry = replay->index->volume->geometry;
+  uint64_t total   = replay->uptoVCN - replay->fromVCN;
+  uint64_t records = chapters * geometry->recordsPerChapter;
+  int64_t  elapsed = relTimeToMilliseconds(
+    timeDifference(currentTime(CT_MONOTONIC), startTime));
+  uint64_t rate    = (elapsed > 0) ? (records * 1000 / elapsed) : 0;
+  logInfo("replayed %" PRIu64 " of %" PRIu64 " chapters (%" PRIu64
+          "%%), %" PRIu64 " records in %" PRId64 " ms, %" PRIu64
+          " records/s",
+          chapters, total, (total > 0) ? (chapters * 100 / total) : 100,
+          records, elapsed, rate);
+}
+
+/**********************************************************************/
+static void freeReplay(Replay *replay)
+{
+  for (unsigned int i = 0; i < REPLAY_CHAPTER_COUNT; i++) {
+    ReplayChapter *chapter = &replay->chapters[i];
+    FREE(chapter->pageData);
+    FREE(chapter->highestLists);
+    FREE(chapter->recordZones);
+    FREE(chapter->records);
+    FREE(chapter->zoneStarts);
+  }
+  FREE(replay->zoneWorkers);
+  destroyCond(&replay->cond);
+  destroyMutex(&replay->mutex);
+  FREE(replay);
+}
+
+/**********************************************************************/
+static int makeReplay(Index *index, uint64_t fromVCN, Replay **replayPtr)
+{
+  const Geometry *geometry = index->volume->geometry;
+  Replay *replay;
+  int result = ALLOCATE(1, Replay, "volume replay", &replay);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+  replay->index      = index;
+  replay->fromVCN    = fromVCN;
+  replay->uptoVCN    = index->newestVirtualChapter;
+  replay->nextRead   = fromVCN;
+  replay->dispatched = fromVCN;
+
+  result = initMutex(&replay->mutex);
+  if (result != UDS_SUCCESS) {
+    FREE(replay);
+    return result;
+  }
+  result = initCond(&replay->cond);
+  if (result != UDS_SUCCESS) {
+    destroyMutex(&replay->mutex);
+    FREE(replay);
+    return result;
+  }
+
+  for (unsigned int i = 0; i < REPLAY_CHAPTER_COUNT; i++) {
+    ReplayChapter *chapter = &replay->chapters[i];
+    result = ALLOCATE_IO_ALIGNED(geometry->bytesPerChapter, byte,
+                                 "replay chapter pages", &chapter->pageData);
+    if (result == UDS_SUCCESS) {
+      result = ALLOCATE(geometry->indexPagesPerChapter, unsigned int,
+                        "replay highest lists", &chapter->highestLists);
+    }
+    if (result == UDS_SUCCESS) {
+      result = ALLOCATE(geometry->recordsPerChapter, byte,
+                        "replay record zones", &chapter->recordZones);
+    }
+    if (result == UDS_SUCCESS) {
+      result = ALLOCATE(geometry->recordsPerChapter, unsigned int,
+                        "replay records", &chapter->records);
+    }
+    if (result == UDS_SUCCESS) {
+      result = ALLOCATE(index->zoneCount + 1, unsigned int,
+                        "replay zone starts", &chapter->zoneStarts);
+    }
+    if (result != UDS_SUCCESS) {
+      freeReplay(replay);
+      return result;
+    }
+  }
+
+  result = ALLOCATE(index->zoneCount, ReplayZone, "replay zones",
+                    &replay->zoneWorkers);
+  if (result != UDS_SUCCESS) {
+    freeReplay(replay);
+    return result;
+  }
+  for (unsigned int z = 0; z < index->zoneCount; z++) {
+    replay->zoneWorkers[z].replay                   = replay;
+    replay->zoneWorkers[z].zoneNumber               = z;
+    replay->zoneWorkers[z].searchRequest.zoneNumber = z;
+  }
+
+  *replayPtr = replay;
+  return UDS_SUCCESS;
+}
+
+/**
+ * Stop a replay, if it has not already finished, and wait for its threads.
+ *
+ * @param replay  The replay
+ * @param result  UDS_SUCCESS, or an error which should stop the replay
+ *
+ * @return The first error encountered by the replay, or UDS_SUCCESS
+ **/
+static int finishReplay(Replay *replay, int result)
+{
+  lockMutex(&replay->mutex);
+  if (result != UDS_SUCCESS) {
+    failReplay(replay, result);
+  }
+  unlockMutex(&replay->mutex);
+
+  for (unsigned int i = 0; i < replay->readerCount; i++) {
+    joinThreads(replay->readers[i]);
+  }
+  for (unsigned int z = 0; z < replay->zoneWorkerCount; z++) {
+    joinThreads(replay->zoneWorkers[z].thread);
+  }
+  return replay->result;
+}
+
+/**
+ * Hand each chapter to the zone workers in order once it has been read,
+ * first bringing the index page map up to date with it, and report progress
+ * along the way.
+ *
+ * @param replay     The replay, whose threads have been started
+ * @param startTime  When the replay started
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+static int dispatchReplayChapters(Replay *replay, AbsTime startTime)
+{
+  AbsTime lastReport = startTime;
+  for (uint64_t vcn = replay->fromVCN; vcn < replay->uptoVCN; vcn++) {
+    ReplayChapter *chapter = getReplayChapter(replay, vcn);
+    lockMutex(&replay->mutex);
+    while ((replay->result == UDS_SUCCESS)
+           && ((chapter->state != REPLAY_CHAPTER_READ)
+               || (chapter->virtualChapter != vcn))) {
+      waitCond(&replay->cond, &replay->mutex);
+    }
+    int result = replay->result;
+    uint64_t chaptersReplayed = replay->chaptersReplayed;
+    unlockMutex(&replay->mutex);
+    if (result != UDS_SUCCESS) {
+      return result;
+    }
+
+    // Only this thread updates the page map, always in chapter order.
+    result = updateReplayPageMap(replay->index, chapter);
+    if (result != UDS_SUCCESS) {
+      return logErrorWithStringError(result,
+                                     "could not rebuild index page map for"
+                                     " chapter %u",
+                                     mapToPhysicalChapter(
+                                       replay->index->volume->geometry, vcn));
+    }
+
+    lockMutex(&replay->mutex);
+    chapter->state        = REPLAY_CHAPTER_REPLAYING;
+    chapter->zonesPending = replay->zoneWorkerCount;
+    replay->dispatched    = vcn + 1;
+    broadcastCond(&replay->cond);
+    unlockMutex(&replay->mutex);
+
+    AbsTime now = currentTime(CT_MONOTONIC);
+    if (relTimeToSeconds(timeDifference(now, lastReport))
+        >= REPLAY_REPORT_INTERVAL) {
+      reportReplayProgress(replay, chaptersReplayed, startTime);
+      lastReport = now;
+    }
+  }
+  return UDS_SUCCESS;
+}
+
+/**
+ * Start the threads of a replay and replay every chapter.
+ *
+ * @param replay  The replay
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+static int runReplay(Replay *replay)
+{
+  AbsTime startTime = currentTime(CT_MONOTONIC);
+  int     result    = UDS_SUCCESS;
+  for (unsigned int z = 0; z < replay->index->zoneCount; z++) {
+    result = createThread(replayZoneThread, &replay->zoneWorkers[z],
+                          "replayZone", &replay->zoneWorkers[z].thread);
+    if (result != UDS_SUCCESS) {
+      return finishReplay(replay, result);
+    }
+    replay->zoneWorkerCount = z + 1;
+  }
+
+  for (unsigned int i = 0; i < REPLAY_READER_COUNT; i++) {
+    result = createThread(replayReaderThread, replay, "replayRead",
+                          &replay->readers[i]);
+    if (result != UDS_SUCCESS) {
+      return finishReplay(replay, result);
+    }
+    replay->readerCount = i + 1;
+  }
+
+  result = finishReplay(replay, dispatchReplayChapters(replay, startTime));
+  if (result == UDS_SUCCESS) {
+    reportReplayProgress(replay, replay->chaptersReplayed, startTime);
+  }
+  return result;
+}
+
+/**********************************************************************/
+static int rebuildIndexPageMap(Index *index, uint64_t vcn)
+{
+  Geometry *geometry = index->volume->geometry;
+  unsigned int chapter = mapToPhysicalChapter(geometry, vcn);
+  for (unsigned int indexPageNumber = 0;
+       indexPageNumber < geometry->indexPagesPerChapter;
+       indexPageNumber++) {
+    ChapterIndexPage *chapterIndexPage;
+    int result = getPage(index->volume, chapter, indexPageNumber,
+                         CACHE_PROBE_INDEX_FIRST, NULL, &chapterIndexPage);
+    if (result != UDS_SUCCESS) {
+      return logErrorWithStringError(result,
+                                     "failed to read index page %u"
+                                     " in chapter %u",
+                                     indexPageNumber, chapter);
+    }
+    unsigned int highestDeltaList
+      = getChapterIndexHighestListNumber(chapterIndexPage);
+    result = updateIndexPageMap(index->volume->indexPageMap, vcn, chapter,
+                                indexPageNumber, highestDeltaList);
+    if (result != UDS_SUCCESS) {
+      return logErrorWithStringError(result,
+                                     "failed to update chapter %u index page"
+                                     " %u",
+                                     chapter, indexPageNumber);
+    }
+  }
+  return UDS_SUCCESS;
+}
+
+/**
+ * Replay chapters one at a time on the calling thread, reading each page
+ * through the page cache. With a single master index zone there is no
+ * replay work to spread across threads, so this avoids the cost of the
+ * replay threads and their chapter buffers.
+ *
+ * @param index    The index
+ * @param fromVCN  The first chapter to replay
+ * @param uptoVCN  The chapter after the last one to replay
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+static int replayVolumeSerially(Index    *index,
+                                uint64_t  fromVCN,
+                                uint64_t  uptoVCN)
+{
   const Geometry *geometry = index->volume->geometry;
-  uint64_t oldIPMupdate = getLastUpdate(index->volume->indexPageMap);
   for (uint64_t vcn = fromVCN; vcn < uptoVCN; ++vcn) {
     bool willBeSparseChapter = isChapterSparse(index->volume->geometry,
                                                fromVCN, uptoVCN, vcn);
     unsigned int chapter = mapToPhysicalChapter(geometry, vcn);
     setMasterIndexOpenChapter(index->masterIndex, vcn);
-    result = rebuildIndexPageMap(index, vcn);
+    int result = rebuildIndexPageMap(index, vcn);
     if (result != UDS_SUCCESS) {
-      index->volume->lookupMode = oldLookupMode;
       return logErrorWithStringError(result,
                                      "could not rebuild index page map for"
                                      " chapter %u",
@@ -756,7 +1312,6 @@ int replayVolume(Index *index, uint64_t fromVCN)
       result = getPage(index->volume, chapter, recordPageNumber,
                        CACHE_PROBE_RECORD_FIRST, &recordPage, NULL);
       if (result != UDS_SUCCESS) {
-        index->volume->lookupMode = oldLookupMode;
         return logUnrecoverable(result, "could not get page %d",
                                 recordPageNumber);
       }
@@ -766,13 +1321,12 @@ int replayVolume(Index *index, uint64_t fromVCN)
         UdsChunkName name;
         memcpy(&name.name, nameBytes, UDS_CHUNK_NAME_SIZE);
 
-        result = replayRecord(index, &name, vcn, willBeSparseChapter);
+        result = replayRecord(index, NULL, &name, vcn, willBeSparseChapter);
         if (result != UDS_SUCCESS) {
           char hexName[(2 * UDS_CHUNK_NAME_SIZE) + 1];
           if (chunkNameToHex(&name, hexName, sizeof(hexName)) != UDS_SUCCESS) {
             strncpy(hexName, "<unknown>", sizeof(hexName));
           }
-          index->volume->lookupMode = oldLookupMode;
           return logUnrecoverable(result,
                                   "could not find block %s during rebuild",
                                   hexName);
@@ -780,7 +1334,65 @@ int replayVolume(Index *index, uint64_t fromVCN)
       }
     }
   }
+  return UDS_SUCCESS;
+}
+
+/**********************************************************************/
+int replayVolume(Index *index, uint64_t fromVCN)
+{
+  uint64_t uptoVCN = index->newestVirtualChapter;
+  logInfo("Replaying volume from chapter %" PRIu64 " through chapter %"
+          PRIu64,
+          fromVCN, uptoVCN);
+  setMasterIndexOpenChapter(index->masterIndex, uptoVCN);
+  setMasterIndexOpenChapter(index->masterIndex, fromVCN);
+
+  /*
+   * At least two cases to deal with here!
+   * - index loaded but replaying from lastCheckpoint; maybe full, maybe not
+   * - index failed to load, full rebuild
+   *   Starts empty, then dense-only, then dense-plus-sparse.
+   *   Need to sparsify while processing individual chapters.
+   */
+  if (fromVCN >= uptoVCN) {
+    setMasterIndexOpenChapter(index->masterIndex, uptoVCN);
+    return UDS_SUCCESS;
+  }
+
+  IndexLookupMode oldLookupMode = index->volume->lookupMode;
+  index->volume->lookupMode = LOOKUP_FOR_REBUILD;
+  /*
+   * Go through each record page of each chapter and add the records back to
+   * the master index.  This should not cause anything to be written to either
+   * the open chapter or on disk volume.  Also skip the on disk chapter
+   * corresponding to upto, as this would have already been
+   * purged from the master index when the chapter was opened.
+   *
+   * Also, go through each index page for each chapter and rebuild the
+   * index page map.
+   *
+   * With more than one master index zone, chapters are read concurrently,
+   * and the records of each chapter are replayed by one worker per zone.
+   * Each worker replays its zone's records in the same order as a serial
+   * replay would, so every zone of the master index ends up as it would
+   * have.
+   */
+  uint64_t oldIPMupdate = getLastUpdate(index->volume->indexPageMap);
+  int result;
+  if (index->zoneCount == 1) {
+    result = replayVolumeSerially(index, fromVCN, uptoVCN);
+  } else {
+    Replay *replay;
+    result = makeReplay(index, fromVCN, &replay);
+    if (result == UDS_SUCCESS) {
+      result = runReplay(replay);
+      freeReplay(replay);
+    }
+  }
   index->volume->lookupMode = oldLookupMode;
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
 
   // We also need to reap the chapter being replaced by the open chapter
   setMasterIndexOpenChapter(index->masterIndex, uptoVCN);
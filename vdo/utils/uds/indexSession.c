@@ -26,8 +26,15 @@
 #include "memoryAlloc.h"
 #include "udsState.h"
 
-/**********************************************************************/
-static void handleCallbacks(Request *request)
+/**
+ * Handle one request on the callback thread.
+ *
+ * @param request  The request to handle
+ *
+ * @return The context whose reference was held by the request and must now
+ *         be released, or NULL if there is none
+ **/
+static UdsContext *handleCallback(Request *request)
 {
   if (request->isControlMessage) {
     request->status = dispatchContextControlRequest(request);
@@ -37,7 +44,7 @@ static void handleCallbacks(Request *request)
      * request to the client thread even though this is the callback thread.
      */
     enterCallbackStage(request);
-    return;
+    return NULL;
   }
 
   if (request->status == UDS_SUCCESS) {
@@ -54,13 +61,44 @@ static void handleCallbacks(Request *request)
     UdsContext *context = request->context;
     request->found = (request->location != LOC_UNAVAILABLE);
     request->callback((UdsRequest *) request);
-    releaseBaseContext(context);
-    return;
+    return context;
   }
 
   // Should not get here, because this is either a control message or it has a
   // callback method.
   freeRequest(request);
+  return NULL;
+}
+
+/**
+ * Handle a batch of requests on the callback thread. The context references
+ * held by a run of requests from the same context are released together,
+ * rather than locking the context's session once per request.
+ *
+ * @param requests  The requests to handle
+ * @param count     The number of requests
+ **/
+static void handleCallbacks(Request **requests, unsigned int count)
+{
+  UdsContext   *context    = NULL;
+  unsigned int  references = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    UdsContext *released = handleCallback(requests[i]);
+    if (released == NULL) {
+      continue;
+    }
+    if (released != context) {
+      if (references > 0) {
+        releaseBaseContextReferences(context, references);
+      }
+      context    = released;
+      references = 0;
+    }
+    references++;
+  }
+  if (references > 0) {
+    releaseBaseContextReferences(context, references);
+  }
 }
 
 /**********************************************************************/
@@ -126,8 +164,8 @@ int makeEmptyIndexSession(IndexSession **indexSessionPtr)
     return result;
   }
 
-  result = makeRequestQueue("callbackW", &handleCallbacks,
-                            &session->callbackQueue);
+  result = makeBatchRequestQueue("callbackW", &handleCallbacks,
+                                 &session->callbackQueue);
   if (result != UDS_SUCCESS) {
     FREE(session);
     return result;
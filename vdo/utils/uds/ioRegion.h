@@ -34,15 +34,17 @@
  * constrained to the implementation's alignment restrictions.
  **/
 typedef struct ioRegion {
-  int (*clear)       (struct ioRegion *);
-  int (*close)       (struct ioRegion *);
-  int (*getBestSize) (struct ioRegion *, size_t *);
-  int (*getBlockSize)(struct ioRegion *, size_t *);
-  int (*getDataSize) (struct ioRegion *, off_t *);
-  int (*getLimit)    (struct ioRegion *, off_t *);
-  int (*read)        (struct ioRegion *, off_t, void *, size_t, size_t *);
-  int (*syncContents)(struct ioRegion *);
-  int (*write)       (struct ioRegion *, off_t, const void *, size_t, size_t);
+  int (*clear)          (struct ioRegion *);
+  int (*close)          (struct ioRegion *);
+  int (*getBestSize)    (struct ioRegion *, size_t *);
+  int (*getBlockSize)   (struct ioRegion *, size_t *);
+  int (*getDataSize)    (struct ioRegion *, off_t *);
+  int (*getFileLocation)(struct ioRegion *, off_t, int *, off_t *);
+  int (*getLimit)       (struct ioRegion *, off_t *);
+  int (*read)           (struct ioRegion *, off_t, void *, size_t, size_t *);
+  int (*syncContents)   (struct ioRegion *);
+  int (*write)          (struct ioRegion *, off_t, const void *, size_t,
+                         size_t);
 } IORegion;
 
 /**
@@ -92,6 +94,31 @@ static INLINE int getRegionBestBufferSize(IORegion *region, size_t *bufferSize)
   return region->getBestSize(region, bufferSize);
 }
 
+/**
+ * Find where a region offset lives in an open file, so that callers which
+ * drive their own asynchronous IO can address the file directly. Regions
+ * which are not backed by a file descriptor do not implement this.
+ *
+ * @param [in]  region      The IORegion.
+ * @param [in]  offset      The offset within the region.
+ * @param [out] fd          The file descriptor holding the region data.
+ * @param [out] fileOffset  The file offset corresponding to offset.
+ *
+ * @return UDS_SUCCESS, UDS_UNSUPPORTED if the region is not file backed,
+ *         or an error code
+ **/
+__attribute__((warn_unused_result))
+static INLINE int getRegionFileLocation(IORegion *region,
+                                        off_t     offset,
+                                        int      *fd,
+                                        off_t    *fileOffset)
+{
+  if (region->getFileLocation == NULL) {
+    return UDS_UNSUPPORTED;
+  }
+  return region->getFileLocation(region, offset, fd, fileOffset);
+}
+
 /**
  * Obtain the block size for the region. The block size constrains the
  * alignment of the offsets as well as the the size of the buffers used in
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/uds-releases/gloria/userLinux/uds/ioUring.h#1 $
+ */
+
+#ifndef IO_URING_H
+#define IO_URING_H 1
+
+#include <sys/uio.h>
+
+#include "compiler.h"
+#include "typeDefs.h"
+
+/**
+ * A minimal wrapper around a Linux io_uring, used to keep many reads in
+ * flight from a single thread. Only one thread may use a ring at a time.
+ **/
+typedef struct ioUring IOUring;
+
+/**
+ * A read submitted to an IOUring. The caller owns the operation and must
+ * keep it in place until it is returned by reapIOUring(); it will usually
+ * be embedded in a larger structure describing the read.
+ **/
+typedef struct ioUringOperation {
+  /** The buffer being read into */
+  struct iovec vector;
+  /** The number of bytes read, or a negative errno */
+  int          result;
+} IOUringOperation;
+
+/**
+ * Create an io_uring.
+ *
+ * @param [in]  depth    The number of operations which may be in flight
+ * @param [out] ringPtr  A pointer to hold the new ring
+ *
+ * @return UDS_SUCCESS, UDS_UNSUPPORTED if io_uring is not available on this
+ *         system, or an error code
+ **/
+int makeIOUring(unsigned int depth, IOUring **ringPtr)
+  __attribute__((warn_unused_result));
+
+/**
+ * Free an io_uring. Any operations which are still in flight should have
+ * been reaped first.
+ *
+ * @param ring  The ring to free (may be NULL)
+ **/
+void freeIOUring(IOUring *ring);
+
+/**
+ * Queue a read to be started by the next call to submitIOUring().
+ *
+ * @param ring       The ring
+ * @param fd         The descriptor from which to read
+ * @param offset     The offset into the file at which to read
+ * @param buffer     The buffer to read into
+ * @param size       The number of bytes to read
+ * @param operation  The operation which will be returned on completion
+ *
+ * @return UDS_SUCCESS, or an error code if the submission queue is full
+ **/
+int queueIOUringRead(IOUring          *ring,
+                     int               fd,
+                     off_t             offset,
+                     void             *buffer,
+                     size_t            size,
+                     IOUringOperation *operation)
+  __attribute__((warn_unused_result));
+
+/**
+ * Start all queued operations, and wait until at least the requested
+ * number of operations have completed. A wait interrupted by a signal
+ * returns successfully, so callers should reap before waiting again.
+ *
+ * @param ring         The ring
+ * @param minComplete  The number of completions to wait for
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+int submitIOUring(IOUring *ring, unsigned int minComplete)
+  __attribute__((warn_unused_result));
+
+/**
+ * Take back the most recently queued operation which has not yet been
+ * started by submitIOUring(), if there is one. This lets a caller whose
+ * submissions keep failing finish those operations some other way.
+ *
+ * @param ring  The ring
+ *
+ * @return The unstarted operation, or NULL
+ **/
+IOUringOperation *unqueueIOUring(IOUring *ring)
+  __attribute__((warn_unused_result));
+
+/**
+ * Take the next completed operation from a ring, if there is one.
+ *
+ * @param ring  The ring
+ *
+ * @return The completed operation, with its result set, or NULL
+ **/
+IOUringOperation *reapIOUring(IOUring *ring)
+  __attribute__((warn_unused_result));
+
+#endif /* IO_URING_H */
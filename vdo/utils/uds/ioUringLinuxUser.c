@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/uds-releases/gloria/userLinux/uds/ioUringLinuxUser.c#1 $
+ */
+
+#include "ioUring.h"
+
+#include "featureDefs.h"
+#include "uds-error.h"
+
+#if IO_URING
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#include "logger.h"
+#include "memoryAlloc.h"
+#include "permassert.h"
+
+/**
+ * One of the rings shared with the kernel. The pointers point into the
+ * mapped ring; the head, tail, and array fields are written by one side and
+ * read by the other, so they are accessed with acquire and release
+ * semantics.
+ **/
+typedef struct {
+  void         *map;
+  size_t        mapSize;
+  unsigned int *head;
+  unsigned int *tail;
+  unsigned int  mask;
+  unsigned int  entries;
+} SharedRing;
+
+struct ioUring {
+  int                  fd;
+  SharedRing           sq;
+  SharedRing           cq;
+  unsigned int        *sqArray;
+  struct io_uring_sqe *sqes;
+  size_t               sqesSize;
+  struct io_uring_cqe *cqes;
+  /** The number of queued entries not yet handed to the kernel */
+  unsigned int         toSubmit;
+};
+
+/**********************************************************************/
+static int mapSharedRing(int           fd,
+                         size_t        size,
+                         off_t         offset,
+                         unsigned int  headOffset,
+                         unsigned int  tailOffset,
+                         unsigned int  maskOffset,
+                         unsigned int  entriesOffset,
+                         SharedRing   *ring)
+{
+  ring->map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, offset);
+  if (ring->map == MAP_FAILED) {
+    ring->map = NULL;
+    return logErrorWithStringError(errno, "cannot map io_uring");
+  }
+  ring->mapSize = size;
+
+  byte *base    = ring->map;
+  ring->head    = (unsigned int *) (base + headOffset);
+  ring->tail    = (unsigned int *) (base + tailOffset);
+  ring->mask    = *(unsigned int *) (base + maskOffset);
+  ring->entries = *(unsigned int *) (base + entriesOffset);
+  return UDS_SUCCESS;
+}
+
+/**********************************************************************/
+static void unmapSharedRing(SharedRing *ring)
+{
+  if (ring->map != NULL) {
+    munmap(ring->map, ring->mapSize);
+  }
+}
+
+/**********************************************************************/
+int makeIOUring(unsigned int depth, IOUring **ringPtr)
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = syscall(__NR_io_uring_setup, depth, &params);
+  if (fd < 0) {
+    if ((errno == ENOSYS) || (errno == EPERM)) {
+      // Not built into this kernel, or forbidden by a seccomp filter.
+      logInfoWithStringError(errno, "io_uring is not available");
+      return UDS_UNSUPPORTED;
+    }
+    return logErrorWithStringError(errno, "cannot set up io_uring");
+  }
+
+  IOUring *ring;
+  int result = ALLOCATE(1, IOUring, "io_uring", &ring);
+  if (result != UDS_SUCCESS) {
+    close(fd);
+    return result;
+  }
+  ring->fd = fd;
+
+  size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  result = mapSharedRing(fd, sqSize, IORING_OFF_SQ_RING,
+                         params.sq_off.head, params.sq_off.tail,
+                         params.sq_off.ring_mask, params.sq_off.ring_entries,
+                         &ring->sq);
+  if (result != UDS_SUCCESS) {
+    freeIOUring(ring);
+    return result;
+  }
+  ring->sqArray = (unsigned int *) ((byte *) ring->sq.map
+                                    + params.sq_off.array);
+
+  size_t cqSize = (params.cq_off.cqes
+                   + params.cq_entries * sizeof(struct io_uring_cqe));
+  result = mapSharedRing(fd, cqSize, IORING_OFF_CQ_RING,
+                         params.cq_off.head, params.cq_off.tail,
+                         params.cq_off.ring_mask, params.cq_off.ring_entries,
+                         &ring->cq);
+  if (result != UDS_SUCCESS) {
+    freeIOUring(ring);
+    return result;
+  }
+  ring->cqes = (struct io_uring_cqe *) ((byte *) ring->cq.map
+                                        + params.cq_off.cqes);
+
+  ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    ring->sqes = NULL;
+    result = logErrorWithStringError(errno, "cannot map io_uring entries");
+    freeIOUring(ring);
+    return result;
+  }
+
+  *ringPtr = ring;
+  return UDS_SUCCESS;
+}
+
+/**********************************************************************/
+void freeIOUring(IOUring *ring)
+{
+  if (ring == NULL) {
+    return;
+  }
+
+  if (ring->sqes != NULL) {
+    munmap(ring->sqes, ring->sqesSize);
+  }
+  unmapSharedRing(&ring->cq);
+  unmapSharedRing(&ring->sq);
+  close(ring->fd);
+  FREE(ring);
+}
+
+/**********************************************************************/
+int queueIOUringRead(IOUring          *ring,
+                     int               fd,
+                     off_t             offset,
+                     void             *buffer,
+                     size_t            size,
+                     IOUringOperation *operation)
+{
+  // Only this thread moves the tail, but the kernel moves the head.
+  unsigned int tail = *ring->sq.tail;
+  unsigned int head = __atomic_load_n(ring->sq.head, __ATOMIC_ACQUIRE);
+  int result = ASSERT(tail - head < ring->sq.entries,
+                      "io_uring submission queue has room");
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  operation->vector.iov_base = buffer;
+  operation->vector.iov_len  = size;
+  operation->result          = 0;
+
+  unsigned int index = tail & ring->sq.mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  // IORING_OP_READV rather than IORING_OP_READ works on the oldest kernels.
+  sqe->opcode    = IORING_OP_READV;
+  sqe->fd        = fd;
+  sqe->off       = offset;
+  sqe->addr      = (uintptr_t) &operation->vector;
+  sqe->len       = 1;
+  sqe->user_data = (uintptr_t) operation;
+  ring->sqArray[index] = index;
+
+  __atomic_store_n(ring->sq.tail, tail + 1, __ATOMIC_RELEASE);
+  ring->toSubmit++;
+  return UDS_SUCCESS;
+}
+
+/**********************************************************************/
+int submitIOUring(IOUring *ring, unsigned int minComplete)
+{
+  unsigned int flags = (minComplete > 0) ? IORING_ENTER_GETEVENTS : 0;
+  int submitted = syscall(__NR_io_uring_enter, ring->fd, ring->toSubmit,
+                          minComplete, flags, NULL, 0);
+  if (submitted < 0) {
+    if (errno == EINTR) {
+      return UDS_SUCCESS;
+    }
+    return logErrorWithStringError(errno, "io_uring_enter failed");
+  }
+
+  ring->toSubmit -= submitted;
+  return UDS_SUCCESS;
+}
+
+/**********************************************************************/
+IOUringOperation *unqueueIOUring(IOUring *ring)
+{
+  if (ring->toSubmit == 0) {
+    return NULL;
+  }
+
+  // The kernel only consumes entries in io_uring_enter(), which is called
+  // by this thread, so unsubmitted entries at the tail can be withdrawn.
+  unsigned int tail = *ring->sq.tail - 1;
+  struct io_uring_sqe *sqe = &ring->sqes[tail & ring->sq.mask];
+  IOUringOperation *operation = (IOUringOperation *) (uintptr_t)
+    sqe->user_data;
+  __atomic_store_n(ring->sq.tail, tail, __ATOMIC_RELEASE);
+  ring->toSubmit--;
+  return operation;
+}
+
+/**********************************************************************/
+IOUringOperation *reapIOUring(IOUring *ring)
+{
+  // Only this thread moves the head, but the kernel moves the tail.
+  unsigned int head = *ring->cq.head;
+  if (head == __atomic_load_n(ring->cq.tail, __ATOMIC_ACQUIRE)) {
+    return NULL;
+  }
+
+  struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq.mask];
+  IOUringOperation *operation = (IOUringOperation *) (uintptr_t)
+    cqe->user_data;
+  operation->result = cqe->res;
+  __atomic_store_n(ring->cq.head, head + 1, __ATOMIC_RELEASE);
+  return operation;
+}
+
+#else /* IO_URING */
+
+/**********************************************************************/
+int makeIOUring(unsigned int   depth  __attribute__((unused)),
+                IOUring      **ringPtr __attribute__((unused)))
+{
+  return UDS_UNSUPPORTED;
+}
+
+/**********************************************************************/
+void freeIOUring(IOUring *ring __attribute__((unused)))
+{
+}
+
+/**********************************************************************/
+int queueIOUringRead(IOUring          *ring      __attribute__((unused)),
+                     int               fd        __attribute__((unused)),
+                     off_t             offset    __attribute__((unused)),
+                     void             *buffer    __attribute__((unused)),
+                     size_t            size      __attribute__((unused)),
+                     IOUringOperation *operation __attribute__((unused)))
+{
+  return UDS_UNSUPPORTED;
+}
+
+/**********************************************************************/
+int submitIOUring(IOUring      *ring        __attribute__((unused)),
+                  unsigned int  minComplete __attribute__((unused)))
+{
+  return UDS_UNSUPPORTED;
+}
+
+/**********************************************************************/
+IOUringOperation *unqueueIOUring(IOUring *ring __attribute__((unused)))
+{
+  return NULL;
+}
+
+/**********************************************************************/
+IOUringOperation *reapIOUring(IOUring *ring __attribute__((unused)))
+{
+  return NULL;
+}
+
+#endif /* IO_URING */
@@ -22,6 +22,7 @@
 
 #include "buffer.h"
 #include "compiler.h"
+#include "cpu.h"
 #include "errors.h"
 #include "featureDefs.h"
 #include "hashUtils.h"
@@ -968,6 +969,29 @@ static int lookupMasterIndexSampledName_005(const MasterIndex *masterIndex,
   return UDS_SUCCESS;
 }
 
+/***********************************************************************/
+/**
+ * Prefetch the master index memory which a lookup of a chunk name will
+ * touch.
+ *
+ * @param masterIndex The master index
+ * @param name        The chunk name
+ * @param contents    False to fetch the delta list header, or true to fetch
+ *                    the delta list it locates
+ **/
+static void prefetchMasterIndexName_005(const MasterIndex *masterIndex,
+                                        const UdsChunkName *name,
+                                        bool contents)
+{
+  const MasterIndex5 *mi5 = const_container_of(masterIndex, MasterIndex5,
+                                               common);
+  unsigned int deltaListNumber = extractDListNum(mi5, name);
+  if (!contents) {
+    prefetchAddress(&mi5->flushChapters[deltaListNumber], false);
+  }
+  prefetchDeltaIndexList(&mi5->deltaIndex, deltaListNumber, contents);
+}
+
 /***********************************************************************/
 /**
  * Find the master index record associated with a block name
@@ -1412,6 +1436,7 @@ int makeMasterIndex005(const Configuration *config, unsigned int numZones,
   mi5->common.isSavingMasterIndexDone       = isSavingMasterIndexDone_005;
   mi5->common.lookupMasterIndexName         = lookupMasterIndexName_005;
   mi5->common.lookupMasterIndexSampledName  = lookupMasterIndexSampledName_005;
+  mi5->common.prefetchMasterIndexName       = prefetchMasterIndexName_005;
   mi5->common.restoreDeltaListToMasterIndex = restoreDeltaListToMasterIndex_005;
   mi5->common.setMasterIndexOpenChapter     = setMasterIndexOpenChapter_005;
   mi5->common.setMasterIndexTag             = setMasterIndexTag_005;
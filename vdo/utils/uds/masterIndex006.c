@@ -543,6 +543,32 @@ static int lookupMasterIndexSampledName_006(const MasterIndex *masterIndex
                                 "%s should not be called", __func__);
 }
 
+/***********************************************************************/
+/**
+ * Prefetch the master index memory which a lookup of a chunk name will
+ * touch.
+ *
+ * The hook mutex is not needed here: only the thread of the zone which owns
+ * the name changes the delta lists being read, and that is the caller.
+ *
+ * @param masterIndex The master index
+ * @param name        The chunk name
+ * @param contents    False to fetch the delta list header, or true to fetch
+ *                    the delta list it locates
+ **/
+static void prefetchMasterIndexName_006(const MasterIndex *masterIndex,
+                                        const UdsChunkName *name,
+                                        bool contents)
+{
+  const MasterIndex6 *mi6 = const_container_of(masterIndex, MasterIndex6,
+                                               common);
+  if (isMasterIndexSample_006(masterIndex, name)) {
+    prefetchMasterIndexName(mi6->miHook, name, contents);
+  } else {
+    prefetchMasterIndexName(mi6->miNonHook, name, contents);
+  }
+}
+
 /***********************************************************************/
 /**
  * Find the master index record associated with a block name
@@ -742,6 +768,7 @@ int makeMasterIndex006(const Configuration *config, unsigned int numZones,
   mi6->common.isSavingMasterIndexDone       = isSavingMasterIndexDone_006;
   mi6->common.lookupMasterIndexName         = lookupMasterIndexName_006;
   mi6->common.lookupMasterIndexSampledName  = lookupMasterIndexSampledName_006;
+  mi6->common.prefetchMasterIndexName       = prefetchMasterIndexName_006;
   mi6->common.restoreDeltaListToMasterIndex = restoreDeltaListToMasterIndex_006;
   mi6->common.setMasterIndexOpenChapter     = setMasterIndexOpenChapter_006;
   mi6->common.setMasterIndexTag             = setMasterIndexTag_006;
@@ -10,6 +10,7 @@
 #include "MurmurHash3.h"
 
 #include "cpu.h"
+#include "permassert.h"
 
 enum { PREFETCH_ADVANCE = 512 }; // Permabit optimization in _double
 
@@ -297,42 +298,18 @@ void MurmurHash3_x86_128 ( const void * key, const int len,
 
 //-----------------------------------------------------------------------------
 
-void MurmurHash3_x64_128 ( const void * key, const int len,
-                           const uint32_t seed, void * out )
-{
-  const uint8_t * data = (const uint8_t*)key;
-  const int nblocks = len / 16;
-
-  uint64_t h1 = seed;
-  uint64_t h2 = seed;
+// Tail and finalization of MurmurHash3_x64_128, shared with the
+// multi-buffer variant below.
 
+static FORCE_INLINE void finishX64_128 ( const uint8_t * tail, const int len,
+                                         uint64_t h1, uint64_t h2, void * out )
+{
   uint64_t c1 = BIG_CONSTANT(0x87c37b91114253d5);
   uint64_t c2 = BIG_CONSTANT(0x4cf5ad432745937f);
 
-  //----------
-  // body
-
-  const uint64_t * blocks = (const uint64_t *)(data);
-
-  for(int i = 0; i < nblocks; i++)
-  {
-    uint64_t k1 = getblock64(blocks,i*2+0);
-    uint64_t k2 = getblock64(blocks,i*2+1);
-
-    k1 *= c1; k1  = ROTL64(k1,31); k1 *= c2; h1 ^= k1;
-
-    h1 = ROTL64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
-
-    k2 *= c2; k2  = ROTL64(k2,33); k2 *= c1; h2 ^= k2;
-
-    h2 = ROTL64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
-  }
-
   //----------
   // tail
 
-  const uint8_t * tail = (const uint8_t*)(data + nblocks*16);
-
   uint64_t k1 = 0;
   uint64_t k2 = 0;
 
@@ -379,6 +356,229 @@ void MurmurHash3_x64_128 ( const void * key, const int len,
 
 //-----------------------------------------------------------------------------
 
+void MurmurHash3_x64_128 ( const void * key, const int len,
+                           const uint32_t seed, void * out )
+{
+  const uint8_t * data = (const uint8_t*)key;
+  const int nblocks = len / 16;
+
+  uint64_t h1 = seed;
+  uint64_t h2 = seed;
+
+  uint64_t c1 = BIG_CONSTANT(0x87c37b91114253d5);
+  uint64_t c2 = BIG_CONSTANT(0x4cf5ad432745937f);
+
+  //----------
+  // body
+
+  const uint64_t * blocks = (const uint64_t *)(data);
+
+  for(int i = 0; i < nblocks; i++)
+  {
+    uint64_t k1 = getblock64(blocks,i*2+0);
+    uint64_t k2 = getblock64(blocks,i*2+1);
+
+    k1 *= c1; k1  = ROTL64(k1,31); k1 *= c2; h1 ^= k1;
+
+    h1 = ROTL64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
+
+    k2 *= c2; k2  = ROTL64(k2,33); k2 *= c1; h2 ^= k2;
+
+    h2 = ROTL64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+  }
+
+  finishX64_128(data + nblocks*16, len, h1, h2, out);
+}
+
+//-----------------------------------------------------------------------------
+
+/*
+ * Permabit's multi-buffer hashing.
+ *
+ * This computes MurmurHash3_x64_128 of MURMUR_MULTI_LANES keys of the same
+ * length with the same seed. Each key's hash is a long chain of dependent
+ * operations, so hashing one key at a time leaves most of the CPU idle;
+ * interleaving the chains of independent keys lets them overlap. The results
+ * are identical to hashing each key separately.
+ *
+ * The lanes are written out by hand, rather than as a loop over arrays, so
+ * that every lane's state stays in registers without relying on the
+ * compiler to unroll the loop. There are exactly four of them, so changing
+ * MURMUR_MULTI_LANES means writing out lanes to match.
+ */
+
+#define MULTI_ROUND(blocks, i, h1, h2)                                  \
+  {                                                                     \
+    uint64_t k1 = getblock64(blocks,i*2+0);                             \
+    uint64_t k2 = getblock64(blocks,i*2+1);                             \
+                                                                        \
+    k1 *= c1; k1  = ROTL64(k1,31); k1 *= c2; h1 ^= k1;                  \
+                                                                        \
+    h1 = ROTL64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;                 \
+                                                                        \
+    k2 *= c2; k2  = ROTL64(k2,33); k2 *= c1; h2 ^= k2;                  \
+                                                                        \
+    h2 = ROTL64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;                 \
+  }
+
+void MurmurHash3_x64_128_multi (const void * const *keys,
+                                const int           len,
+                                const uint32_t      seed,
+                                void * const       *outs)
+{
+  STATIC_ASSERT(MURMUR_MULTI_LANES == 4);
+
+  const int nblocks = len / 16;
+
+  uint64_t hA1 = seed;
+  uint64_t hA2 = seed;
+  uint64_t hB1 = seed;
+  uint64_t hB2 = seed;
+  uint64_t hC1 = seed;
+  uint64_t hC2 = seed;
+  uint64_t hD1 = seed;
+  uint64_t hD2 = seed;
+
+  uint64_t c1 = BIG_CONSTANT(0x87c37b91114253d5);
+  uint64_t c2 = BIG_CONSTANT(0x4cf5ad432745937f);
+
+  //----------
+  // body
+
+  const uint64_t * blocksA = (const uint64_t *) keys[0];
+  const uint64_t * blocksB = (const uint64_t *) keys[1];
+  const uint64_t * blocksC = (const uint64_t *) keys[2];
+  const uint64_t * blocksD = (const uint64_t *) keys[3];
+
+  for (int lane = 0; lane < MURMUR_MULTI_LANES; lane++)
+    {
+      prefetchRange(keys[lane], PREFETCH_ADVANCE, false);
+    }
+
+  for(int i = 0; i < nblocks; i++)
+    {
+      if ((i & 3) == 0)
+        {
+          // Prefetch each lane a cache line at a time. Prefetching can
+          // overrun the buffer, but that doesn't seem to hurt.
+          prefetchAddress(PREFETCH_ADVANCE + (const char *) &blocksA[i*2],
+                          false);
+          prefetchAddress(PREFETCH_ADVANCE + (const char *) &blocksB[i*2],
+                          false);
+          prefetchAddress(PREFETCH_ADVANCE + (const char *) &blocksC[i*2],
+                          false);
+          prefetchAddress(PREFETCH_ADVANCE + (const char *) &blocksD[i*2],
+                          false);
+        }
+
+      MULTI_ROUND(blocksA, i, hA1, hA2);
+      MULTI_ROUND(blocksB, i, hB1, hB2);
+      MULTI_ROUND(blocksC, i, hC1, hC2);
+      MULTI_ROUND(blocksD, i, hD1, hD2);
+    }
+
+  //----------
+  // tail and finalization
+
+  finishX64_128((const uint8_t *) keys[0] + nblocks*16, len, hA1, hA2,
+                outs[0]);
+  finishX64_128((const uint8_t *) keys[1] + nblocks*16, len, hB1, hB2,
+                outs[1]);
+  finishX64_128((const uint8_t *) keys[2] + nblocks*16, len, hC1, hC2,
+                outs[2]);
+  finishX64_128((const uint8_t *) keys[3] + nblocks*16, len, hD1, hD2,
+                outs[3]);
+}
+
+#undef MULTI_ROUND
+
+//-----------------------------------------------------------------------------
+
+/*
+ * Permabit's incremental copying hash.
+ *
+ * This computes MurmurHash3_x64_128 of a key presented in pieces, copying
+ * each piece as it is hashed, so that data which must be both copied and
+ * hashed is only read once. Every piece must be a multiple of 16 bytes long,
+ * so there is never a tail. Runs of zeros may be hashed without being read
+ * at all, which lets a caller copy a zero prefix while checking for zeros and
+ * only start hashing once it knows the hash is needed.
+ */
+
+void MurmurHash3_x64_128_start (MurmurHash3_x64_128_state *state,
+                                const uint32_t             seed)
+{
+  state->h1  = seed;
+  state->h2  = seed;
+  state->len = 0;
+}
+
+void MurmurHash3_x64_128_copy (MurmurHash3_x64_128_state *state,
+                               const void                *key,
+                               void                      *copy,
+                               const int                  len)
+{
+  const int nblocks = len / 16;
+
+  uint64_t h1 = state->h1;
+  uint64_t h2 = state->h2;
+
+  uint64_t c1 = BIG_CONSTANT(0x87c37b91114253d5);
+  uint64_t c2 = BIG_CONSTANT(0x4cf5ad432745937f);
+
+  const uint64_t * blocks = (const uint64_t *) key;
+  uint64_t * copyBlocks = (uint64_t *) copy;
+
+  for(int i = 0; i < nblocks; i++)
+    {
+      uint64_t k1 = getblock64(blocks,i*2+0);
+      uint64_t k2 = getblock64(blocks,i*2+1);
+      putblock64(copyBlocks, i*2+0, k1);
+      putblock64(copyBlocks, i*2+1, k2);
+
+      k1 *= c1; k1  = ROTL64(k1,31); k1 *= c2; h1 ^= k1;
+
+      h1 = ROTL64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
+
+      k2 *= c2; k2  = ROTL64(k2,33); k2 *= c1; h2 ^= k2;
+
+      h2 = ROTL64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+    }
+
+  state->h1   = h1;
+  state->h2   = h2;
+  state->len += len;
+}
+
+void MurmurHash3_x64_128_zeros (MurmurHash3_x64_128_state *state,
+                                const int                  len)
+{
+  const int nblocks = len / 16;
+
+  uint64_t h1 = state->h1;
+  uint64_t h2 = state->h2;
+
+  // A zero block mixes nothing into h1 or h2, so only the rounds remain.
+  for(int i = 0; i < nblocks; i++)
+    {
+      h1 = ROTL64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
+      h2 = ROTL64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+    }
+
+  state->h1   = h1;
+  state->h2   = h2;
+  state->len += len;
+}
+
+void MurmurHash3_x64_128_finish (const MurmurHash3_x64_128_state *state,
+                                 void                            *out)
+{
+  // The pieces are all multiples of 16 bytes, so the tail is empty.
+  finishX64_128(NULL, (int) state->len, state->h1, state->h2, out);
+}
+
+//-----------------------------------------------------------------------------
+
 /*
  * Permabit's optimized double-hashing (32-byte output).
  *
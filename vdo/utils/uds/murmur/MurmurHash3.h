@@ -39,6 +39,37 @@ void MurmurHash3_x86_128 ( const void * key, int len, uint32_t seed, void * out
 
 void MurmurHash3_x64_128 ( const void * key, int len, uint32_t seed, void * out );
 
+// The number of keys hashed together by MurmurHash3_x64_128_multi
+enum { MURMUR_MULTI_LANES = 4 };
+
+void MurmurHash3_x64_128_multi (const void * const * keys,
+                                int                  len,
+                                uint32_t             seed,
+                                void * const *       outs );
+
+// The running state of an incremental MurmurHash3_x64_128
+typedef struct {
+  uint64_t h1;
+  uint64_t h2;
+  uint64_t len;
+} MurmurHash3_x64_128_state;
+
+void MurmurHash3_x64_128_start (MurmurHash3_x64_128_state * state,
+                                uint32_t                    seed );
+
+// Hash and copy len bytes, which must be a multiple of 16
+void MurmurHash3_x64_128_copy (MurmurHash3_x64_128_state * state,
+                               const void *                key,
+                               void *                      copy,
+                               int                         len );
+
+// Hash len zero bytes, which must be a multiple of 16, without reading them
+void MurmurHash3_x64_128_zeros (MurmurHash3_x64_128_state * state,
+                                int                         len );
+
+void MurmurHash3_x64_128_finish (const MurmurHash3_x64_128_state * state,
+                                 void *                            out );
+
 void MurmurHash3_x64_128_double (const void * key,
                                  int          len,
                                  uint32_t     seed1,
@@ -38,10 +38,15 @@ typedef struct udsQueueHead UdsQueueHead;
 typedef struct cachedPage {
   /* whether this page is currently being read asynchronously */
   bool              readPending;
+  /* whether this page has been used since the replacement clock passed it */
+  bool              referenced;
+  /* the replacement queue holding this page (a PageQueueType) */
+  uint8_t           queue;
+  /* the cache indexes of the neighbors of this page in its queue */
+  uint16_t          prev;
+  uint16_t          next;
   /* if equal to numCacheEntries, the page is invalid */
   unsigned int      physicalPage;
-  /* the value of the volume clock when this page was last used */
-  int64_t           lastUsed;
   /* the cache page data */
   byte             *data;
   /* the chapter index page. This is here, even for record pages */
@@ -51,9 +56,36 @@ typedef struct cachedPage {
 enum {
   VOLUME_CACHE_MAX_ENTRIES              = (UINT16_MAX >> 1),
   VOLUME_CACHE_QUEUED_FLAG              = (1 << 15),
-  VOLUME_CACHE_DEFAULT_MAX_QUEUED_READS = 4096
+  VOLUME_CACHE_DEFAULT_MAX_QUEUED_READS = 4096,
+  VOLUME_CACHE_NO_PAGE                  = UINT16_MAX
 };
 
+/*
+ * The page replacement queues.  The cache uses the 2Q policy: a page read
+ * into the cache joins the probation queue, which is evicted in FIFO order,
+ * so that a burst of pages which are only used once cannot flush out the
+ * pages which are used repeatedly.  A page which is read again soon after
+ * being evicted from the probation queue joins the protected queue instead,
+ * which is evicted in CLOCK order.  Pages holding no valid data are reused
+ * before either.  A page being read is not in any queue.
+ */
+typedef enum pageQueueType {
+  PAGE_QUEUE_FREE = 0,
+  PAGE_QUEUE_PROBATION,
+  PAGE_QUEUE_PROTECTED,
+  PAGE_QUEUE_COUNT,
+  PAGE_QUEUE_NONE = PAGE_QUEUE_COUNT
+} PageQueueType;
+
+typedef struct pageQueue {
+  /* the cache index of the oldest page in the queue */
+  uint16_t head;
+  /* the cache index of the newest page in the queue */
+  uint16_t tail;
+  /* the number of pages in the queue */
+  uint16_t size;
+} PageQueue;
+
 typedef struct queuedRead {
   /* whether this queue entry is invalid */
   bool         invalid;
@@ -118,6 +150,16 @@ typedef struct pageCache {
   // Cache counters for stats.  This is the first field of a PageCache that is
   // not constant after the struct is initialized.
   CacheCounters   counters;
+  // The page replacement queues, indexed by PageQueueType
+  PageQueue       queues[PAGE_QUEUE_COUNT];
+  // The number of pages the probation queue holds before it must be evicted
+  uint16_t        probationTarget;
+  // A bitmap of the physical pages recently evicted from the probation queue
+  byte           *ghosts;
+  // Those physical pages, as a circular array in order of eviction
+  unsigned int   *ghostRing;
+  unsigned int    ghostRingSize;
+  unsigned int    ghostRingNext;
   /**
    * Entries are enqueued at readQueueLast.
    * To 'reserve' entries, we get the entry pointed to by readQueueLastRead
@@ -143,8 +185,6 @@ typedef struct pageCache {
   uint16_t              readQueueLast;
   // The size of the read queue
   unsigned int          readQueueMaxSize;
-  // Page access counter
-  atomic64_t            clock;
 } PageCache;
 
 /**
@@ -208,12 +248,11 @@ int findInvalidateAndMakeLeastRecent(PageCache          *cache,
                                      bool                mustFind);
 
 /**
- * Make the page the most recent in the cache
+ * Note that a page in the cache has been used, so that the replacement clock
+ * will pass over it once before evicting it.
  *
  * @param cache   the page cache
- * @param pagePtr the page to make most recent
- *
- * @return UDS_SUCCESS or an error code
+ * @param pagePtr the page which was used
  **/
 void makePageMostRecent(PageCache *cache, CachedPage *pagePtr);
 
@@ -40,6 +40,7 @@ const UdsParameterValue UDS_PARAM_FALSE = {
 
 const char *const UDS_PARALLEL_FACTOR      = "UDS_PARALLEL_FACTOR";
 const char *const UDS_VOLUME_READ_THREADS  = "UDS_VOLUME_READ_THREADS";
+const char *const UDS_VOLUME_READ_DEPTH    = "UDS_VOLUME_READ_DEPTH";
 const char *const UDS_PARAMETER_TEST_PARAM = "UDS_PARAMETER_TEST_PARAM";
 
 static int defineParameterTestParam(ParameterDefinition *);
@@ -50,6 +51,7 @@ static const struct paramDef {
 } definitions[] = {
   { &UDS_PARALLEL_FACTOR,         defineParallelFactor        },
   { &UDS_VOLUME_READ_THREADS,     defineVolumeReadThreads     },
+  { &UDS_VOLUME_READ_DEPTH,       defineVolumeReadDepth       },
   { &UDS_PARAMETER_TEST_PARAM,    defineParameterTestParam    },
 };
 
@@ -225,6 +225,109 @@ void enqueueRequest(Request *request, RequestStage nextStage)
   requestQueueEnqueue(nextQueue, request);
 }
 
+/**
+ * Release the context references held by a batch of client requests, once
+ * for each run of requests on the same context.
+ *
+ * @param requests  The requests
+ * @param count     The number of requests
+ **/
+static void releaseRequestContexts(Request **requests, unsigned int count)
+{
+  unsigned int i = 0;
+  while (i < count) {
+    UdsContext   *context = requests[i]->context;
+    unsigned int  run     = 1;
+    while (((i + run) < count) && (requests[i + run]->context == context)) {
+      run++;
+    }
+    releaseBaseContextReferences(context, run);
+    i += run;
+  }
+}
+
+/**
+ * Acquire the context references needed by a batch of client requests, once
+ * for each run of requests on the same context.
+ *
+ * @param requests  The requests
+ * @param count     The number of requests
+ *
+ * @return UDS_SUCCESS or an error code, in which case no references are held
+ **/
+static int acquireRequestContexts(Request **requests, unsigned int count)
+{
+  unsigned int i = 0;
+  while (i < count) {
+    unsigned int contextId = requests[i]->blockContext.id;
+    unsigned int run       = 1;
+    while (((i + run) < count)
+           && (requests[i + run]->blockContext.id == contextId)) {
+      run++;
+    }
+
+    UdsContext *context;
+    int result = getBaseContextReferences(contextId, run, &context);
+    if (result != UDS_SUCCESS) {
+      releaseRequestContexts(requests, i);
+      return result;
+    }
+    for (unsigned int j = i; j < (i + run); j++) {
+      requests[j]->context = context;
+    }
+    i += run;
+  }
+  return UDS_SUCCESS;
+}
+
+/**********************************************************************/
+int launchAllocatedClientRequests(Request **requests, unsigned int count)
+{
+  int result = ASSERT((count <= UDS_MAX_CHUNK_OPERATIONS),
+                      "request batch of %u is too large", count);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  result = acquireRequestContexts(requests, count);
+  if (result != UDS_SUCCESS) {
+    return sansUnrecoverable(result);
+  }
+
+  RequestQueue *queues[UDS_MAX_CHUNK_OPERATIONS];
+  for (unsigned int i = 0; i < count; i++) {
+    Request *request          = requests[i];
+    request->action           = (RequestAction) request->type;
+    request->isControlMessage = false;
+    request->unbatched        = false;
+    request->router = selectGridRouter(request->context->indexSession->grid,
+                                       &request->hash);
+    queues[i] = getNextStageQueue(request, STAGE_TRIAGE);
+    if (queues[i] == NULL) {
+      handleRequestErrors(request);
+    }
+  }
+
+  // Link the requests for each queue together in their original order, and
+  // hand each chain to its queue at once.
+  for (unsigned int i = 0; i < count; i++) {
+    RequestQueue *queue = queues[i];
+    if (queue == NULL) {
+      continue;
+    }
+    Request *last = requests[i];
+    for (unsigned int j = i + 1; j < count; j++) {
+      if (queues[j] == queue) {
+        last->requestQueueLink.next = &requests[j]->requestQueueLink;
+        last = requests[j];
+        queues[j] = NULL;
+      }
+    }
+    requestQueueEnqueueChain(queue, requests[i], last);
+  }
+  return UDS_SUCCESS;
+}
+
 /*
  * This function pointer allows unit test code to intercept the slow-lane
  * requeuing of a request.
@@ -184,6 +184,19 @@ typedef void (*RequestRestarter)(Request *);
 int launchAllocatedClientRequest(Request *request)
   __attribute__((warn_unused_result));
 
+/**
+ * Start a batch of requests from an API client on block contexts. The
+ * requests for each queue are enqueued on it together. If an error is
+ * returned, none of the requests has been started.
+ *
+ * @param requests  The requests
+ * @param count     The number of requests, at most UDS_MAX_CHUNK_OPERATIONS
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+int launchAllocatedClientRequests(Request **requests, unsigned int count)
+  __attribute__((warn_unused_result));
+
 /**
  * Make a control message and enqueue it for processing. If the message
  * is synchronous, this will wait until the request has completed before
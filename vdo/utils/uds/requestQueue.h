@@ -28,6 +28,14 @@
 /* void return value because this function will process its own errors */
 typedef void RequestQueueProcessor(Request *);
 
+/* void return value because this function will process its own errors */
+typedef void RequestQueueBatchProcessor(Request **, unsigned int);
+
+enum {
+  /** The most requests a batch processor is given at once */
+  REQUEST_QUEUE_BATCH_SIZE = 32
+};
+
 /**
  * Allocate a new request processing queue and start a worker thread to
  * consume and service requests in the queue.
@@ -43,6 +51,21 @@ int makeRequestQueue(const char             *queueName,
                      RequestQueue          **queuePtr)
   __attribute__((warn_unused_result));
 
+/**
+ * Allocate a new request processing queue and start a worker thread which
+ * services the requests in the queue in batches: each time it finds work, it
+ * hands over whichever requests (up to REQUEST_QUEUE_BATCH_SIZE) can be
+ * dequeued without waiting.
+ * @param queueName     the name of the queue and the worker thread
+ * @param processBatch  the function the worker will invoke on each batch
+ * @param queuePtr      a pointer to receive the new queue
+ * @return UDS_SUCCESS or an error code
+ **/
+int makeBatchRequestQueue(const char                  *queueName,
+                          RequestQueueBatchProcessor  *processBatch,
+                          RequestQueue               **queuePtr)
+  __attribute__((warn_unused_result));
+
 /**
  * Add a request to the end of the queue for processing by the worker thread.
  * If the requeued flag is set on the request, it will be processed before
@@ -53,6 +76,19 @@ int makeRequestQueue(const char             *queueName,
  **/
 void requestQueueEnqueue(RequestQueue *queue, Request *request);
 
+/**
+ * Add a chain of requests to the end of the queue for processing by the
+ * worker thread, with one queue operation and at most one wakeup for the
+ * whole chain. The requests must be linked together in order through their
+ * requestQueueLink fields, and none of them may be requeued requests.
+ * @param queue  the request queue that should process the requests
+ * @param first  the first request of the chain
+ * @param last   the last request of the chain
+ **/
+void requestQueueEnqueueChain(RequestQueue *queue,
+                              Request      *first,
+                              Request      *last);
+
 /**
  * Shut down the request queue worker thread, then destroy and free the queue.
  *
@@ -59,10 +59,10 @@ static int checkSessionGroupLocked(SessionGroup *group)
 }
 
 /**********************************************************************/
-static void acquireSession(Session *session)
+static void acquireSession(Session *session, unsigned int count)
 {
   lockMutex(&session->mutex);
-  session->refCount++;
+  session->refCount += count;
   unlockMutex(&session->mutex);
 }
 
@@ -81,6 +81,15 @@ static Session *searchList(SessionGroup *group, SessionID id)
 /**********************************************************************/
 int getSession(SessionGroup *group, SessionID id,
                Session **sessionPtr)
+{
+  return getSessionReferences(group, id, 1, sessionPtr);
+}
+
+/**********************************************************************/
+int getSessionReferences(SessionGroup  *group,
+                         SessionID      id,
+                         unsigned int   count,
+                         Session      **sessionPtr)
 {
   lockMutex(&group->mutex);
   int result = checkSessionGroupLocked(group);
@@ -91,7 +100,7 @@ int getSession(SessionGroup *group, SessionID id,
 
   Session *session = searchList(group, id);
   if (session != NULL) {
-    acquireSession(session);
+    acquireSession(session, count);
     *sessionPtr = session;
     result = UDS_SUCCESS;
   } else {
@@ -110,9 +119,15 @@ SessionContents getSessionContents(Session *session)
 
 /**********************************************************************/
 void releaseSession(Session *session)
+{
+  releaseSessionReferences(session, 1);
+}
+
+/**********************************************************************/
+void releaseSessionReferences(Session *session, unsigned int count)
 {
   lockMutex(&session->mutex);
-  session->refCount--;
+  session->refCount -= count;
   broadcastCond(&session->releaseCond);
   unlockMutex(&session->mutex);
 }
@@ -267,7 +282,7 @@ void shutdownSessionGroup(SessionGroup *group)
   freeFunc = group->free;
   while (!LIST_EMPTY(&group->head)) {
     session = LIST_FIRST(&group->head);
-    acquireSession(session);
+    acquireSession(session, 1);
     orphanSessionLocked(session);
     LIST_INSERT_HEAD(&tempHead, session, links);
   }
@@ -110,6 +110,15 @@ extern const UdsParameterValue UDS_PARAM_FALSE;
  *      The number of threads used to read chapters.  Although stored as an
  *      unsigned int, the validation function will accept strings as well.
  *      This parameter affect how local index sessions operate.
+ *
+ * UDS_VOLUME_READ_DEPTH
+ *      UNSIGNED INT    0-256                                   [16]
+ *      STRING          "[number]"
+ *      The number of chapter page reads which a single thread keeps in
+ *      flight using io_uring, in place of the UDS_VOLUME_READ_THREADS
+ *      threads.  Zero, or a system without io_uring, selects the read
+ *      threads instead.  This parameter is only defined where io_uring can
+ *      be used, and affects how local index sessions operate.
  **/
 
 /**
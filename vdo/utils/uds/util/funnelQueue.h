@@ -149,6 +149,35 @@ static INLINE void funnelQueuePut(FunnelQueue *queue, FunnelQueueEntry *entry)
   previous->next = entry;
 }
 
+/**
+ * Put a chain of entries on the end of the queue with a single exchange.
+ *
+ * The entries must already be linked together in order, each entry's "next"
+ * field pointing at its successor; the "next" field of the last entry will
+ * be set here. Consumers see the entries in the order of the chain, and,
+ * as with funnelQueuePut(), see none of them until the whole chain has been
+ * put.
+ *
+ * @param queue  the queue on which to place the entries
+ * @param first  the first entry of the chain
+ * @param last   the last entry of the chain
+ **/
+static INLINE void funnelQueuePutChain(FunnelQueue      *queue,
+                                       FunnelQueueEntry *first,
+                                       FunnelQueueEntry *last)
+{
+  // The barrier requirements are those of funnelQueuePut(), which applies to
+  // the entries of the chain as a group.
+  last->next = NULL;
+#pragma GCC diagnostic push
+#if __GNUC__ >= 5
+#pragma GCC diagnostic ignored "-Wdiscarded-qualifiers"
+#endif
+  FunnelQueueEntry *previous = xchg(&queue->newest, last);
+#pragma GCC diagnostic pop
+  previous->next = first;
+}
+
 /**
  * Poll a queue, removing the oldest entry if the queue is not empty. This
  * function must only be called from a single consumer thread.
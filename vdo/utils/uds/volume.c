@@ -40,9 +40,14 @@
 #include "threads.h"
 #include "volumeInternals.h"
 
+#if IO_URING
+#include "ioUring.h"
+#endif
+
 enum {
   MAX_BAD_CHAPTERS    = 100,   // max number of contiguous bad chapters
-  VOLUME_READ_THREADS = 2      // Number of reader threads
+  VOLUME_READ_THREADS = 2,     // Number of reader threads
+  VOLUME_READ_DEPTH   = 16     // Number of io_uring reads in flight
 };
 
 static const NumericValidationData validRange = {
@@ -50,24 +55,60 @@ static const NumericValidationData validRange = {
   .maxValue = MAX_VOLUME_READ_THREADS,
 };
 
+#if IO_URING
+static const NumericValidationData validDepthRange = {
+  .minValue = 0,
+  .maxValue = MAX_VOLUME_READ_DEPTH,
+};
+
+/**
+ * A page read in flight on the volume's io_uring, along with the read queue
+ * entry it will complete.
+ **/
+typedef struct pageRead {
+  IOUringOperation  operation;
+  unsigned int      queuePos;
+  UdsQueueHead      queuedRequests;
+  unsigned int      physicalPage;
+  CachedPage       *page;
+  /* The number of bytes of the page read so far */
+  size_t            bytesRead;
+} PageRead;
+
+typedef struct volumeReadRing {
+  /* The ring on which the reads are submitted */
+  IOUring       *ring;
+  /* The number of reads which have been started but not finished */
+  unsigned int   inFlight;
+  /* The number of reads available to be started */
+  unsigned int   idleCount;
+  /* The reads available to be started */
+  PageRead     **idle;
+  /* All of the reads */
+  PageRead      *reads;
+} VolumeReadRing;
+#endif /* IO_URING */
+
 /**********************************************************************/
-static UdsParameterValue getDefaultReadThreads(void)
+static UdsParameterValue getDefaultValue(const char                  *name,
+                                         const NumericValidationData *range,
+                                         unsigned int                 fallback)
 {
   UdsParameterValue value;
 #if ENVIRONMENT
-  char *env = getenv(UDS_VOLUME_READ_THREADS);
+  char *env = getenv(name);
   if (env != NULL) {
     UdsParameterValue tmp = {
       .type = UDS_PARAM_TYPE_STRING,
       .value.u_string = env,
     };
-    if (validateNumericRange(&tmp, &validRange, &value) == UDS_SUCCESS) {
+    if (validateNumericRange(&tmp, range, &value) == UDS_SUCCESS) {
       return value;
     }
   }
 #endif // ENVIRONMENT
   value.type = UDS_PARAM_TYPE_UNSIGNED_INT;
-  value.value.u_uint = VOLUME_READ_THREADS;
+  value.value.u_uint = fallback;
   return value;
 }
 
@@ -76,11 +117,29 @@ int defineVolumeReadThreads(ParameterDefinition *pd)
 {
   pd->validate       = validateNumericRange;
   pd->validationData = &validRange;
-  pd->currentValue   = getDefaultReadThreads();
+  pd->currentValue   = getDefaultValue(UDS_VOLUME_READ_THREADS, &validRange,
+                                       VOLUME_READ_THREADS);
   pd->update         = NULL;
   return UDS_SUCCESS;
 }
 
+/**********************************************************************/
+int defineVolumeReadDepth(ParameterDefinition *pd)
+{
+#if IO_URING
+  pd->validate       = validateNumericRange;
+  pd->validationData = &validDepthRange;
+  pd->currentValue   = getDefaultValue(UDS_VOLUME_READ_DEPTH, &validDepthRange,
+                                       VOLUME_READ_DEPTH);
+  pd->update         = NULL;
+  return UDS_SUCCESS;
+#else
+  // Without io_uring there is nothing to configure.
+  pd->currentValue.type = UDS_PARAM_TYPE_UNSPECIFIED;
+  return UDS_UNKNOWN_PARAMETER;
+#endif
+}
+
 /**********************************************************************/
 int formatVolume(IORegion *region, const Geometry *geometry)
 {
@@ -272,6 +331,103 @@ static int initializeIndexPage(const Volume *volume,
   return result;
 }
 
+/**
+ * Finish reading a page for a read queue entry: put the page in the cache,
+ * unless the read failed or the page was invalidated while it was being
+ * read, and then restart the requests which were waiting for it.
+ *
+ * @param volume          The volume
+ * @param queuePos        The reserved read queue entry
+ * @param queuedRequests  The requests waiting for the page
+ * @param physicalPage    The page which was read
+ * @param page            The cache page read into, or NULL if none
+ * @param invalid         Whether the entry was invalid when reserved
+ * @param result          The result of reading the page
+ **/
+static void finishPageRead(Volume       *volume,
+                           unsigned int  queuePos,
+                           UdsQueueHead *queuedRequests,
+                           unsigned int  physicalPage,
+                           CachedPage   *page,
+                           bool          invalid,
+                           int           result)
+{
+  // We hold the readThreadsMutex.
+  bool recordPage = isRecordPage(volume->geometry, physicalPage);
+
+  if (!invalid) {
+    if ((result != UDS_SUCCESS) && (page != NULL)) {
+      logWarning("Error reading page %u from volume", physicalPage);
+      cancelPageInCache(volume->pageCache, physicalPage, page);
+    }
+
+    if (result == UDS_SUCCESS) {
+      if (!volume->pageCache->readQueue[queuePos].invalid) {
+        if (!recordPage) {
+          result = initializeIndexPage(volume, physicalPage, page);
+          if (result != UDS_SUCCESS) {
+            logWarning("Error initializing chapter index page");
+            cancelPageInCache(volume->pageCache, physicalPage, page);
+          }
+        }
+
+        if (result == UDS_SUCCESS) {
+          result = putPageInCache(volume->pageCache, physicalPage, page);
+          if (result != UDS_SUCCESS) {
+            logWarning("Error putting page %u in cache", physicalPage);
+            cancelPageInCache(volume->pageCache, physicalPage, page);
+          }
+        }
+      } else {
+        logWarning("Page %u invalidated after read", physicalPage);
+        cancelPageInCache(volume->pageCache, physicalPage, page);
+        invalid = true;
+      }
+    }
+  } else {
+    logDebug("Requeuing requests for invalid page");
+  }
+
+  if (invalid) {
+    result = UDS_SUCCESS;
+    page = NULL;
+  }
+
+  while (!STAILQ_EMPTY(queuedRequests)) {
+    Request *request = STAILQ_FIRST(queuedRequests);
+    STAILQ_REMOVE_HEAD(queuedRequests, link);
+
+    /*
+     * If we've read in a record page, we're going to do an immediate search,
+     * in an attempt to speed up processing when we requeue the request, so
+     * that it doesn't have to go back into the getRecordFromZone code again.
+     * However, if we've just read in an index page, we don't want to search.
+     * We want the request to be processed again and getRecordFromZone to be
+     * run.  We have added new fields in request to allow the index code to
+     * know whether it can stop processing before getRecordFromZone is called
+     * again.
+     */
+    if ((result == UDS_SUCCESS) && (page != NULL) && recordPage) {
+      if (searchRecordPage(page->data, &request->hash, volume->geometry,
+                           &request->oldMetadata)) {
+        request->slLocation = LOC_IN_DENSE;
+      } else {
+        request->slLocation = LOC_UNAVAILABLE;
+      }
+      request->slLocationKnown = true;
+    }
+
+    // reflect any read failures in the request status
+    request->status = result;
+    restartRequest(request);
+  }
+
+  releaseReadQueueEntry(volume->pageCache, queuePos);
+
+  volume->busyReaderThreads--;
+  broadcastCond(&volume->readThreadsReadDoneCond);
+}
+
 /**********************************************************************/
 static void readThreadFunction(void *arg)
 {
@@ -292,8 +448,6 @@ static void readThreadFunction(void *arg)
 
     volume->busyReaderThreads++;
 
-    bool recordPage = isRecordPage(volume->geometry, physicalPage);
-
     CachedPage *page = NULL;
     int result = UDS_SUCCESS;
     if (!invalid) {
@@ -302,84 +456,270 @@ static void readThreadFunction(void *arg)
       if (result == UDS_SUCCESS) {
         unlockMutex(&volume->readThreadsMutex);
         result = readPageToBuffer(volume, physicalPage, page->data);
-        if (result != UDS_SUCCESS) {
-          logWarning("Error reading page %u from volume", physicalPage);
-          cancelPageInCache(volume->pageCache, physicalPage, page);
-        }
         lockMutex(&volume->readThreadsMutex);
       } else {
         logWarning("Error selecting cache victim for page read");
       }
+    }
 
-      if (result == UDS_SUCCESS) {
-        if (!volume->pageCache->readQueue[queuePos].invalid) {
-          if (!recordPage) {
-            result = initializeIndexPage(volume, physicalPage, page);
-            if (result != UDS_SUCCESS) {
-              logWarning("Error initializing chapter index page");
-              cancelPageInCache(volume->pageCache, physicalPage, page);
-            }
-          }
+    finishPageRead(volume, queuePos, &queuedRequests, physicalPage, page,
+                   invalid, result);
+  }
+  unlockMutex(&volume->readThreadsMutex);
+  logDebug("reader done");
+}
 
-          if (result == UDS_SUCCESS) {
-            result = putPageInCache(volume->pageCache, physicalPage, page);
-            if (result != UDS_SUCCESS) {
-              logWarning("Error putting page %u in cache", physicalPage);
-              cancelPageInCache(volume->pageCache, physicalPage, page);
-            }
-          }
-        } else {
-          logWarning("Page %u invalidated after read", physicalPage);
-          cancelPageInCache(volume->pageCache, physicalPage, page);
-          invalid = true;
+#if IO_URING
+/**********************************************************************/
+static void freeVolumeReadRing(VolumeReadRing *readRing)
+{
+  if (readRing == NULL) {
+    return;
+  }
+
+  freeIOUring(readRing->ring);
+  FREE(readRing->idle);
+  FREE(readRing->reads);
+  FREE(readRing);
+}
+
+/**
+ * Set up the io_uring for reading pages from a volume.
+ *
+ * @param volume       The volume
+ * @param depth        The maximum number of reads to keep in flight
+ * @param readRingPtr  A pointer to hold the new read ring
+ *
+ * @return UDS_SUCCESS, UDS_UNSUPPORTED if the volume cannot be read with
+ *         io_uring, or an error code
+ **/
+static int makeVolumeReadRing(Volume          *volume,
+                              unsigned int     depth,
+                              VolumeReadRing **readRingPtr)
+{
+  // Check that the volume can be read directly from its file.
+  int   fd;
+  off_t offset;
+  int result = getRegionFileLocation(volume->region, 0, &fd, &offset);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  VolumeReadRing *readRing;
+  result = ALLOCATE(1, VolumeReadRing, "volume read ring", &readRing);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  result = ALLOCATE(depth, PageRead, "volume page reads", &readRing->reads);
+  if (result != UDS_SUCCESS) {
+    freeVolumeReadRing(readRing);
+    return result;
+  }
+
+  result = ALLOCATE(depth, PageRead *, "idle volume page reads",
+                    &readRing->idle);
+  if (result != UDS_SUCCESS) {
+    freeVolumeReadRing(readRing);
+    return result;
+  }
+
+  result = makeIOUring(depth, &readRing->ring);
+  if (result != UDS_SUCCESS) {
+    freeVolumeReadRing(readRing);
+    return result;
+  }
+
+  for (unsigned int i = 0; i < depth; i++) {
+    readRing->idle[i] = &readRing->reads[i];
+  }
+  readRing->idleCount = depth;
+  *readRingPtr = readRing;
+  return UDS_SUCCESS;
+}
+
+/**
+ * Queue a read of the part of a page which has not been read yet on the
+ * volume's io_uring.
+ *
+ * @param volume  The volume
+ * @param read    The read
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+static int queueRingRead(Volume *volume, PageRead *read)
+{
+  size_t bytesPerPage = volume->geometry->bytesPerPage;
+  int    fd;
+  off_t  offset;
+  int result = getRegionFileLocation(volume->region,
+                                     (((off_t) read->physicalPage)
+                                      * bytesPerPage) + read->bytesRead,
+                                     &fd, &offset);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  return queueIOUringRead(volume->readRing->ring, fd, offset,
+                          read->page->data + read->bytesRead,
+                          bytesPerPage - read->bytesRead, &read->operation);
+}
+
+/**
+ * Find a cache page for a reserved read queue entry and queue a read of the
+ * page into it on the volume's io_uring.
+ *
+ * @param volume  The volume
+ * @param read    The read, with its read queue entry filled in
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+static int startRingRead(Volume *volume, PageRead *read)
+{
+  // We hold the readThreadsMutex.
+  int result = selectVictimInCache(volume->pageCache, &read->page);
+  if (result != UDS_SUCCESS) {
+    logWarning("Error selecting cache victim for page read");
+    return result;
+  }
+
+  read->bytesRead = 0;
+  return queueRingRead(volume, read);
+}
+
+/**
+ * Finish a read which has completed or failed, and make it available to be
+ * started again.
+ *
+ * @param volume  The volume
+ * @param read    The read
+ * @param result  The result of the read
+ **/
+static void finishRingRead(Volume *volume, PageRead *read, int result)
+{
+  // We hold the readThreadsMutex.
+  VolumeReadRing *readRing = volume->readRing;
+  readRing->inFlight--;
+  finishPageRead(volume, read->queuePos, &read->queuedRequests,
+                 read->physicalPage, read->page, false, result);
+  readRing->idle[readRing->idleCount++] = read;
+}
+
+/**
+ * Take back every read which the kernel has not accepted from the volume's
+ * io_uring and read those pages directly instead. This is done when a
+ * submission fails, so that a ring which keeps refusing reads can neither
+ * leave the reads queued forever nor keep the thread spinning on them.
+ *
+ * @param volume  The volume
+ **/
+static void readUnsubmittedPages(Volume *volume)
+{
+  // We hold the readThreadsMutex.
+  IOUringOperation *operation;
+  while ((operation = unqueueIOUring(volume->readRing->ring)) != NULL) {
+    PageRead *read = container_of(operation, PageRead, operation);
+    unlockMutex(&volume->readThreadsMutex);
+    int result = readPageToBuffer(volume, read->physicalPage,
+                                  read->page->data);
+    lockMutex(&volume->readThreadsMutex);
+    finishRingRead(volume, read, result);
+  }
+}
+
+/**
+ * The body of the single reader thread used when the volume is read with
+ * io_uring. Rather than doing one blocking read at a time, it starts a read
+ * for every read queue entry it can reserve, up to the ring depth, and then
+ * finishes each entry as its completion arrives. Pages queued while the
+ * thread is waiting for completions are started once a completion wakes
+ * it.
+ **/
+static void ringReadThreadFunction(void *arg)
+{
+  Volume         *volume       = arg;
+  VolumeReadRing *readRing     = volume->readRing;
+  size_t          bytesPerPage = volume->geometry->bytesPerPage;
+
+  logDebug("ring reader starting");
+  lockMutex(&volume->readThreadsMutex);
+  while (true) {
+    while ((readRing->idleCount > 0)
+           && ((volume->readerState
+                & (READER_STATE_EXIT | READER_STATE_STOP)) == 0)) {
+      PageRead *read = readRing->idle[readRing->idleCount - 1];
+      bool invalid;
+      if (!reserveReadQueueEntry(volume->pageCache, &read->queuePos,
+                                 &read->queuedRequests, &read->physicalPage,
+                                 &invalid)) {
+        break;
+      }
+
+      readRing->idleCount--;
+      volume->busyReaderThreads++;
+      read->page = NULL;
+      int result = UDS_SUCCESS;
+      if (!invalid) {
+        result = startRingRead(volume, read);
+        if (result == UDS_SUCCESS) {
+          readRing->inFlight++;
+          continue;
         }
       }
-    } else {
-      logDebug("Requeuing requests for invalid page");
+
+      finishPageRead(volume, read->queuePos, &read->queuedRequests,
+                     read->physicalPage, read->page, invalid, result);
+      readRing->idle[readRing->idleCount++] = read;
     }
 
-    if (invalid) {
-      result = UDS_SUCCESS;
-      page = NULL;
+    if (readRing->inFlight == 0) {
+      // Reads in flight must always be finished before exiting.
+      if ((volume->readerState & READER_STATE_EXIT) != 0) {
+        break;
+      }
+      waitCond(&volume->readThreadsCond, &volume->readThreadsMutex);
+      continue;
     }
 
-    while (!STAILQ_EMPTY(&queuedRequests)) {
-      Request *request = STAILQ_FIRST(&queuedRequests);
-      STAILQ_REMOVE_HEAD(&queuedRequests, link);
+    // Start the queued reads and wait for at least one read to finish.
+    unlockMutex(&volume->readThreadsMutex);
+    int result = submitIOUring(readRing->ring, 1);
+    lockMutex(&volume->readThreadsMutex);
+    if (result != UDS_SUCCESS) {
+      logWarningWithStringError(result, "error submitting volume reads");
+      readUnsubmittedPages(volume);
+    }
 
-      /*
-       * If we've read in a record page, we're going to do an immediate search,
-       * in an attempt to speed up processing when we requeue the request, so
-       * that it doesn't have to go back into the getRecordFromZone code again.
-       * However, if we've just read in an index page, we don't want to search.
-       * We want the request to be processed again and getRecordFromZone to be
-       * run.  We have added new fields in request to allow the index code to
-       * know whether it can stop processing before getRecordFromZone is called
-       * again.
-       */
-      if ((result == UDS_SUCCESS) && (page != NULL) && recordPage) {
-        if (searchRecordPage(page->data, &request->hash, volume->geometry,
-                             &request->oldMetadata)) {
-          request->slLocation = LOC_IN_DENSE;
-        } else {
-          request->slLocation = LOC_UNAVAILABLE;
+    IOUringOperation *operation;
+    while ((operation = reapIOUring(readRing->ring)) != NULL) {
+      PageRead *read = container_of(operation, PageRead, operation);
+      result = UDS_SUCCESS;
+      if (operation->result < 0) {
+        result = -operation->result;
+      } else if (operation->result == 0) {
+        result = UDS_CORRUPT_FILE;
+      } else {
+        read->bytesRead += operation->result;
+        if (read->bytesRead < bytesPerPage) {
+          // As readBufferAtOffset() does, go back for the rest of the page.
+          result = queueRingRead(volume, read);
+          if (result == UDS_SUCCESS) {
+            continue;
+          }
         }
-        request->slLocationKnown = true;
+      }
+      if (result != UDS_SUCCESS) {
+        logWarningWithStringError(result, "error reading physical page %u",
+                                  read->physicalPage);
       }
 
-      // reflect any read failures in the request status
-      request->status = result;
-      restartRequest(request);
+      finishRingRead(volume, read, result);
     }
-
-    releaseReadQueueEntry(volume->pageCache, queuePos);
-
-    volume->busyReaderThreads--;
-    broadcastCond(&volume->readThreadsReadDoneCond);
   }
   unlockMutex(&volume->readThreadsMutex);
-  logDebug("reader done");
+  logDebug("ring reader done");
 }
+#endif /* IO_URING */
 
 /**********************************************************************/
 static int readPageLocked(Volume        *volume,
@@ -702,6 +1042,25 @@ int searchCachedRecordPage(Volume             *volume,
   return UDS_SUCCESS;
 }
 
+/**********************************************************************/
+int readChapterFromVolume(const Volume *volume,
+                          uint64_t      virtualChapter,
+                          byte          pageData[])
+{
+  Geometry *geometry = volume->geometry;
+  unsigned int physicalChapter = mapToPhysicalChapter(geometry,
+                                                      virtualChapter);
+  int result = readFromRegion(volume->region,
+                              offsetForChapter(geometry, physicalChapter),
+                              pageData, geometry->bytesPerChapter, NULL);
+  if (result != UDS_SUCCESS) {
+    return logWarningWithStringError(result,
+                                     "error reading physical chapter %u",
+                                     physicalChapter);
+  }
+  return UDS_SUCCESS;
+}
+
 /**********************************************************************/
 int readChapterIndexFromVolume(const Volume     *volume,
                                uint64_t          virtualChapter,
@@ -1328,6 +1687,33 @@ int makeVolume(const Configuration  *config,
     return result;
   }
 
+  void (*readerFunction)(void *) = readThreadFunction;
+#if IO_URING
+  unsigned int readDepth = VOLUME_READ_DEPTH;
+  if ((udsGetParameter(UDS_VOLUME_READ_DEPTH, &value) == UDS_SUCCESS) &&
+      (value.type == UDS_PARAM_TYPE_UNSIGNED_INT)) {
+    readDepth = value.value.u_uint;
+  }
+  // Every read in flight holds a read queue entry and a cache page.
+  if (readDepth >= readQueueMaxSize) {
+    readDepth = readQueueMaxSize - 1;
+  }
+  if (readDepth > volume->pageCache->numCacheEntries / 2) {
+    readDepth = volume->pageCache->numCacheEntries / 2;
+  }
+  if (readDepth > 0) {
+    result = makeVolumeReadRing(volume, readDepth, &volume->readRing);
+    if (result == UDS_SUCCESS) {
+      logDebug("reading volume pages with io_uring, depth %u", readDepth);
+      readerFunction    = ringReadThreadFunction;
+      volumeReadThreads = 1;
+    } else {
+      logInfo("io_uring unavailable, using %u volume read threads",
+              volumeReadThreads);
+    }
+  }
+#endif /* IO_URING */
+
   // Start the reader threads.  If this allocation succeeds, freeVolume knows
   // that it needs to try and stop those threads.
   result = ALLOCATE(volumeReadThreads, Thread, "reader threads",
@@ -1337,7 +1723,7 @@ int makeVolume(const Configuration  *config,
     return result;
   }
   for (unsigned int i = 0; i < volumeReadThreads; i++) {
-    result = createThread(readThreadFunction, (void *) volume, "reader",
+    result = createThread(readerFunction, (void *) volume, "reader",
                           &volume->readerThreads[i]);
     if (result != UDS_SUCCESS) {
       freeVolume(volume);
@@ -1371,6 +1757,10 @@ void freeVolume(Volume *volume)
     FREE(volume->readerThreads);
     volume->readerThreads = NULL;
   }
+#if IO_URING
+  freeVolumeReadRing(volume->readRing);
+  volume->readRing = NULL;
+#endif /* IO_URING */
 
   if (volume->region != NULL) {
     int result = syncAndCloseRegion(&volume->region, "index volume");
@@ -1384,6 +1774,14 @@ void freeVolume(Volume *volume)
   destroyCond(&volume->readThreadsReadDoneCond);
   destroyMutex(&volume->readThreadsMutex);
   freeIndexPageMap(volume->indexPageMap);
+  if (volume->pageCache != NULL) {
+    const CacheCounters *counters = &volume->pageCache->counters;
+    unsigned int hitRate = getPageCacheHitRate(counters);
+    logDebug("page cache hit rate %u.%u%%, %" PRIu64 " pages reused after %"
+             PRIu64 " probes, %" PRIu64 " pages protected",
+             hitRate / 10, hitRate % 10, counters->victims,
+             counters->victimProbes, counters->promotions);
+  }
   freePageCache(volume->pageCache);
   freeRadixSorter(volume->radixSorter);
   freeSparseCache(volume->sparseCache);
@@ -36,7 +36,8 @@
 #include "util/radixSort.h"
 
 enum {
-  MAX_VOLUME_READ_THREADS = 16
+  MAX_VOLUME_READ_THREADS = 16,
+  MAX_VOLUME_READ_DEPTH   = 256
 };
 
 typedef enum {
@@ -104,6 +105,8 @@ typedef struct volume {
   IndexLookupMode        lookupMode;
   /* Number of read threads to use (run-time parameter) */
   unsigned int           numReadThreads;
+  /* The io_uring reads in flight, or NULL if each reader does one read */
+  struct volumeReadRing *readRing;
 } Volume;
 
 /**
@@ -312,6 +315,22 @@ int writeChapter(Volume                 *volume,
                  const UdsChunkRecord    records[])
   __attribute__((warn_unused_result));
 
+/**
+ * Read all the pages of a chapter from the volume, bypassing the page
+ * cache.
+ *
+ * @param [in]  volume          the volume containing the chapter
+ * @param [in]  virtualChapter  the virtual chapter number of the chapter
+ * @param [out] pageData        an IO aligned buffer to receive every page
+ *                              of the chapter
+ *
+ * @return UDS_SUCCESS or an error code
+ **/
+int readChapterFromVolume(const Volume *volume,
+                          uint64_t      virtualChapter,
+                          byte          pageData[])
+  __attribute__((warn_unused_result));
+
 /**
  * Read all the index pages for a chapter from the volume and initialize an
  * array of ChapterIndexPages to represent them.
@@ -0,0 +1,530 @@
+//-----------------------------------------------------------------------------
+// XXH3 was designed by Yann Collet as part of xxHash, which is distributed
+// under the BSD 2-Clause License. This is an independent implementation of
+// the 128-bit variant with the default secret and no seed.
+//
+// Only portable scalar code is used so that the kernel can use it without
+// saving vector state. Each 64-byte stripe is eight independent 32x32->64
+// multiply-adds rather than MurmurHash3's serial chain of 64-bit multiplies
+// and rotates, so it is a little faster than MurmurHash3_x64_128 even as
+// scalar code, and much faster where the compiler can vectorize the stripe
+// loop.
+
+#include "XXH3.h"
+
+#ifdef __KERNEL__
+# include <linux/string.h>
+#else // defined(__KERNEL__)
+# include <string.h>
+#endif // !defined(__KERNEL__)
+
+#define FORCE_INLINE __attribute__((always_inline)) inline
+
+//-----------------------------------------------------------------------------
+// Constants
+
+#define PRIME32_1 0x9E3779B1U
+#define PRIME32_2 0x85EBCA77U
+#define PRIME32_3 0xC2B2AE3DU
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define PRIME_MX1 0x165667919E3779F9ULL
+#define PRIME_MX2 0x9FB21C651E98DF25ULL
+
+enum {
+  STRIPE_LEN           = 64,
+  SECRET_CONSUME_RATE  = 8,
+  ACC_NB               = STRIPE_LEN / sizeof(uint64_t),
+  SECRET_SIZE          = 192,
+  SECRET_SIZE_MIN      = 136,
+  SECRET_MERGEACCS     = 11,
+  SECRET_LASTACC       = 7,
+  MIDSIZE_MAX          = XXH3_MIDSIZE_MAX,
+  MIDSIZE_STARTOFFSET  = 3,
+  MIDSIZE_LASTOFFSET   = 17,
+  STRIPES_PER_BLOCK    = (SECRET_SIZE - STRIPE_LEN) / SECRET_CONSUME_RATE,
+  BLOCK_LEN            = STRIPE_LEN * STRIPES_PER_BLOCK,
+};
+
+// The default secret, which xxHash takes from FARSH.
+static const uint8_t SECRET[SECRET_SIZE] __attribute__((aligned(64))) = {
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe,
+  0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+  0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+  0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+  0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78,
+  0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e,
+  0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+  0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+  0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+  0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e,
+  0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f,
+  0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+  0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+  0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+  0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3,
+  0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49,
+  0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+  0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+  0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+  0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28,
+  0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+typedef struct {
+  uint64_t low64;
+  uint64_t high64;
+} Hash128;
+
+//-----------------------------------------------------------------------------
+// Block read and write - XXH3 is defined in terms of little-endian values,
+// and its input may be unaligned
+
+static FORCE_INLINE uint32_t readLE32 ( const uint8_t * p )
+{
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  return value;
+#elif __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return __builtin_bswap32(value);
+#else
+#error "can't figure out byte order"
+#endif
+}
+
+static FORCE_INLINE uint64_t readLE64 ( const uint8_t * p )
+{
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  return value;
+#elif __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return __builtin_bswap64(value);
+#else
+#error "can't figure out byte order"
+#endif
+}
+
+static FORCE_INLINE void writeLE64 ( uint8_t * p, uint64_t value )
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64(value);
+#endif
+  memcpy(p, &value, sizeof(value));
+}
+
+//-----------------------------------------------------------------------------
+// Arithmetic helpers
+
+static FORCE_INLINE uint32_t rotl32 ( uint32_t x, int r )
+{
+  return (x << r) | (x >> (32 - r));
+}
+
+static FORCE_INLINE uint64_t xorshift64 ( uint64_t v, int shift )
+{
+  return v ^ (v >> shift);
+}
+
+static FORCE_INLINE Hash128 mult64to128 ( uint64_t lhs, uint64_t rhs )
+{
+  Hash128 result;
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 uint128;
+  uint128 product = (uint128) lhs * rhs;
+  result.low64  = (uint64_t) product;
+  result.high64 = (uint64_t) (product >> 64);
+#else
+  // Schoolbook multiplication of the 32-bit halves, for 32-bit machines.
+  uint64_t loLo  = (uint64_t) (uint32_t) lhs * (uint32_t) rhs;
+  uint64_t hiLo  = (lhs >> 32) * (uint32_t) rhs;
+  uint64_t loHi  = (uint64_t) (uint32_t) lhs * (rhs >> 32);
+  uint64_t hiHi  = (lhs >> 32) * (rhs >> 32);
+  uint64_t cross = (loLo >> 32) + (uint32_t) hiLo + loHi;
+  result.low64  = (cross << 32) | (uint32_t) loLo;
+  result.high64 = (hiLo >> 32) + (cross >> 32) + hiHi;
+#endif
+  return result;
+}
+
+static FORCE_INLINE uint64_t mul128fold64 ( uint64_t lhs, uint64_t rhs )
+{
+  Hash128 product = mult64to128(lhs, rhs);
+  return product.low64 ^ product.high64;
+}
+
+//-----------------------------------------------------------------------------
+// Finalization mixes
+
+static FORCE_INLINE uint64_t xxh64Avalanche ( uint64_t h )
+{
+  h ^= h >> 33;
+  h *= PRIME64_2;
+  h ^= h >> 29;
+  h *= PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+static FORCE_INLINE uint64_t avalanche ( uint64_t h )
+{
+  h = xorshift64(h, 37);
+  h *= PRIME_MX1;
+  return xorshift64(h, 32);
+}
+
+//-----------------------------------------------------------------------------
+// Short inputs (at most 16 bytes)
+
+static FORCE_INLINE Hash128 hash1to3 ( const uint8_t * input, size_t len )
+{
+  uint8_t c1 = input[0];
+  uint8_t c2 = input[len >> 1];
+  uint8_t c3 = input[len - 1];
+  uint32_t combinedl = ((uint32_t) c1 << 16) | ((uint32_t) c2 << 24)
+                       | ((uint32_t) c3 << 0) | ((uint32_t) len << 8);
+  uint32_t combinedh = rotl32(__builtin_bswap32(combinedl), 13);
+  uint64_t bitflipl  = readLE32(SECRET) ^ readLE32(SECRET + 4);
+  uint64_t bitfliph  = readLE32(SECRET + 8) ^ readLE32(SECRET + 12);
+  Hash128 h;
+  h.low64  = xxh64Avalanche((uint64_t) combinedl ^ bitflipl);
+  h.high64 = xxh64Avalanche((uint64_t) combinedh ^ bitfliph);
+  return h;
+}
+
+static FORCE_INLINE Hash128 hash4to8 ( const uint8_t * input, size_t len )
+{
+  uint32_t inputLo = readLE32(input);
+  uint32_t inputHi = readLE32(input + len - 4);
+  uint64_t input64 = inputLo + ((uint64_t) inputHi << 32);
+  uint64_t bitflip = readLE64(SECRET + 16) ^ readLE64(SECRET + 24);
+  Hash128 m = mult64to128(input64 ^ bitflip, PRIME64_1 + (len << 2));
+  m.high64 += (m.low64 << 1);
+  m.low64  ^= (m.high64 >> 3);
+  m.low64   = xorshift64(m.low64, 35);
+  m.low64  *= PRIME_MX2;
+  m.low64   = xorshift64(m.low64, 28);
+  m.high64  = avalanche(m.high64);
+  return m;
+}
+
+static FORCE_INLINE Hash128 hash9to16 ( const uint8_t * input, size_t len )
+{
+  uint64_t bitflipl = readLE64(SECRET + 32) ^ readLE64(SECRET + 40);
+  uint64_t bitfliph = readLE64(SECRET + 48) ^ readLE64(SECRET + 56);
+  uint64_t inputLo  = readLE64(input);
+  uint64_t inputHi  = readLE64(input + len - 8);
+  Hash128 m = mult64to128(inputLo ^ inputHi ^ bitflipl, PRIME64_1);
+  m.low64  += (uint64_t) (len - 1) << 54;
+  inputHi  ^= bitfliph;
+  m.high64 += inputHi + (uint64_t) (uint32_t) inputHi * (PRIME32_2 - 1);
+  m.low64  ^= __builtin_bswap64(m.high64);
+
+  Hash128 h = mult64to128(m.low64, PRIME64_2);
+  h.high64 += m.high64 * PRIME64_2;
+  h.low64   = avalanche(h.low64);
+  h.high64  = avalanche(h.high64);
+  return h;
+}
+
+static Hash128 hash0to16 ( const uint8_t * input, size_t len )
+{
+  if (len > 8) {
+    return hash9to16(input, len);
+  }
+  if (len >= 4) {
+    return hash4to8(input, len);
+  }
+  if (len > 0) {
+    return hash1to3(input, len);
+  }
+  Hash128 h;
+  h.low64  = xxh64Avalanche(readLE64(SECRET + 64) ^ readLE64(SECRET + 72));
+  h.high64 = xxh64Avalanche(readLE64(SECRET + 80) ^ readLE64(SECRET + 88));
+  return h;
+}
+
+//-----------------------------------------------------------------------------
+// Medium inputs (17 to 240 bytes)
+
+static FORCE_INLINE uint64_t mix16B ( const uint8_t * input,
+                                      const uint8_t * secret,
+                                      uint64_t        seed )
+{
+  return mul128fold64(readLE64(input) ^ (readLE64(secret) + seed),
+                      readLE64(input + 8) ^ (readLE64(secret + 8) - seed));
+}
+
+static FORCE_INLINE Hash128 mix32B ( Hash128         acc,
+                                     const uint8_t * input1,
+                                     const uint8_t * input2,
+                                     const uint8_t * secret,
+                                     uint64_t        seed )
+{
+  acc.low64  += mix16B(input1, secret, seed);
+  acc.low64  ^= readLE64(input2) + readLE64(input2 + 8);
+  acc.high64 += mix16B(input2, secret + 16, seed);
+  acc.high64 ^= readLE64(input1) + readLE64(input1 + 8);
+  return acc;
+}
+
+static FORCE_INLINE Hash128 finishMidsize ( Hash128 acc, size_t len )
+{
+  Hash128 h;
+  h.low64  = avalanche(acc.low64 + acc.high64);
+  h.high64 = (acc.low64 * PRIME64_1) + (acc.high64 * PRIME64_4)
+             + (len * PRIME64_2);
+  h.high64 = 0 - avalanche(h.high64);
+  return h;
+}
+
+static Hash128 hash17to128 ( const uint8_t * input, size_t len )
+{
+  Hash128 acc = { .low64 = len * PRIME64_1, .high64 = 0 };
+  if (len > 32) {
+    if (len > 64) {
+      if (len > 96) {
+        acc = mix32B(acc, input + 48, input + len - 64, SECRET + 96, 0);
+      }
+      acc = mix32B(acc, input + 32, input + len - 48, SECRET + 64, 0);
+    }
+    acc = mix32B(acc, input + 16, input + len - 32, SECRET + 32, 0);
+  }
+  acc = mix32B(acc, input, input + len - 16, SECRET, 0);
+  return finishMidsize(acc, len);
+}
+
+static Hash128 hash129to240 ( const uint8_t * input, size_t len )
+{
+  Hash128 acc = { .low64 = len * PRIME64_1, .high64 = 0 };
+  size_t i;
+  for (i = 32; i < 160; i += 32) {
+    acc = mix32B(acc, input + i - 32, input + i - 16, SECRET + i - 32, 0);
+  }
+  acc.low64  = avalanche(acc.low64);
+  acc.high64 = avalanche(acc.high64);
+  for (i = 160; i <= len; i += 32) {
+    acc = mix32B(acc, input + i - 32, input + i - 16,
+                 SECRET + MIDSIZE_STARTOFFSET + i - 160, 0);
+  }
+  acc = mix32B(acc, input + len - 16, input + len - 32,
+               SECRET + SECRET_SIZE_MIN - MIDSIZE_LASTOFFSET - 16, 0);
+  return finishMidsize(acc, len);
+}
+
+//-----------------------------------------------------------------------------
+// Long inputs (more than 240 bytes)
+
+static FORCE_INLINE void accumulate512 ( uint64_t      * acc,
+                                         const uint8_t * input,
+                                         const uint8_t * secret )
+{
+  for (size_t lane = 0; lane < ACC_NB; lane++) {
+    uint64_t dataVal = readLE64(input + lane * 8);
+    uint64_t dataKey = dataVal ^ readLE64(secret + lane * 8);
+    acc[lane ^ 1] += dataVal;
+    acc[lane] += (uint64_t) (uint32_t) dataKey * (dataKey >> 32);
+  }
+}
+
+static FORCE_INLINE void accumulate ( uint64_t      * acc,
+                                      const uint8_t * input,
+                                      size_t          stripes )
+{
+  for (size_t n = 0; n < stripes; n++) {
+    accumulate512(acc, input + n * STRIPE_LEN,
+                  SECRET + n * SECRET_CONSUME_RATE);
+  }
+}
+
+static FORCE_INLINE void scramble ( uint64_t * acc )
+{
+  const uint8_t * secret = SECRET + SECRET_SIZE - STRIPE_LEN;
+  for (size_t lane = 0; lane < ACC_NB; lane++) {
+    uint64_t acc64 = xorshift64(acc[lane], 47);
+    acc64 ^= readLE64(secret + lane * 8);
+    acc[lane] = acc64 * PRIME32_1;
+  }
+}
+
+static FORCE_INLINE uint64_t mergeAccs ( const uint64_t * acc,
+                                         const uint8_t  * secret,
+                                         uint64_t         start )
+{
+  uint64_t result = start;
+  for (size_t i = 0; i < 4; i++) {
+    result += mul128fold64(acc[2 * i] ^ readLE64(secret + 16 * i),
+                           acc[2 * i + 1] ^ readLE64(secret + 16 * i + 8));
+  }
+  return avalanche(result);
+}
+
+static FORCE_INLINE void initAccs ( uint64_t * acc )
+{
+  acc[0] = PRIME32_3;
+  acc[1] = PRIME64_1;
+  acc[2] = PRIME64_2;
+  acc[3] = PRIME64_3;
+  acc[4] = PRIME64_4;
+  acc[5] = PRIME32_2;
+  acc[6] = PRIME64_5;
+  acc[7] = PRIME32_1;
+}
+
+static FORCE_INLINE Hash128 finishLong ( uint64_t      * acc,
+                                         const uint8_t * lastStripe,
+                                         size_t          len )
+{
+  accumulate512(acc, lastStripe,
+                SECRET + SECRET_SIZE - STRIPE_LEN - SECRET_LASTACC);
+
+  Hash128 h;
+  h.low64  = mergeAccs(acc, SECRET + SECRET_MERGEACCS, len * PRIME64_1);
+  h.high64 = mergeAccs(acc,
+                       SECRET + SECRET_SIZE - (ACC_NB * sizeof(uint64_t))
+                       - SECRET_MERGEACCS,
+                       ~(len * PRIME64_2));
+  return h;
+}
+
+static Hash128 hashLong ( const uint8_t * input, size_t len )
+{
+  uint64_t acc[ACC_NB];
+  initAccs(acc);
+
+  size_t blocks = (len - 1) / BLOCK_LEN;
+  for (size_t n = 0; n < blocks; n++) {
+    accumulate(acc, input + n * BLOCK_LEN, STRIPES_PER_BLOCK);
+    scramble(acc);
+  }
+
+  // The last partial block, and then the last stripe, which may overlap it.
+  size_t stripes = ((len - 1) - (BLOCK_LEN * blocks)) / STRIPE_LEN;
+  accumulate(acc, input + blocks * BLOCK_LEN, stripes);
+  return finishLong(acc, input + len - STRIPE_LEN, len);
+}
+
+//-----------------------------------------------------------------------------
+
+void XXH3_128bits ( const void * key, size_t len, void * out )
+{
+  const uint8_t * input = (const uint8_t *) key;
+  Hash128 h;
+  if (len <= 16) {
+    h = hash0to16(input, len);
+  } else if (len <= 128) {
+    h = hash17to128(input, len);
+  } else if (len <= MIDSIZE_MAX) {
+    h = hash129to240(input, len);
+  } else {
+    h = hashLong(input, len);
+  }
+
+  writeLE64((uint8_t *) out, h.low64);
+  writeLE64((uint8_t *) out + 8, h.high64);
+}
+
+//-----------------------------------------------------------------------------
+// Incremental hashing of keys which are a whole number of stripes long. Every
+// stripe is accumulated as soon as it arrives, with each block's scramble put
+// off until the next block starts. Accumulation is just addition, so finishing
+// can take the last stripe back out and accumulate it as hashLong would.
+
+static const uint8_t ZERO_STRIPE[STRIPE_LEN] __attribute__((aligned(64)));
+
+static FORCE_INLINE void takeStripes ( XXH3_128bits_state * state,
+                                       const uint8_t *      input,
+                                       size_t               stride,
+                                       size_t               stripes )
+{
+  // Work on a local copy of the accumulators, which the compiler can keep in
+  // registers since the input can't alias it.
+  uint64_t acc[ACC_NB];
+  memcpy(acc, state->acc, sizeof(acc));
+  size_t taken = state->stripes;
+  while (stripes > 0) {
+    size_t n = taken % STRIPES_PER_BLOCK;
+    if ((n == 0) && (taken > 0)) {
+      scramble(acc);
+    }
+    size_t run = STRIPES_PER_BLOCK - n;
+    if (run > stripes) {
+      run = stripes;
+    }
+    if (run == STRIPES_PER_BLOCK) {
+      // A whole block, which the compiler can unroll as hashLong's are.
+      for (size_t i = 0; i < STRIPES_PER_BLOCK; i++) {
+        accumulate512(acc, input + i * stride,
+                      SECRET + i * SECRET_CONSUME_RATE);
+      }
+    } else {
+      for (size_t i = 0; i < run; i++) {
+        accumulate512(acc, input + i * stride,
+                      SECRET + (n + i) * SECRET_CONSUME_RATE);
+      }
+    }
+    input   += run * stride;
+    taken   += run;
+    stripes -= run;
+  }
+  memcpy(state->acc, acc, sizeof(acc));
+  state->stripes = taken;
+}
+
+void XXH3_128bits_start ( XXH3_128bits_state * state )
+{
+  initAccs(state->acc);
+  state->stripes = 0;
+  state->last    = NULL;
+}
+
+void XXH3_128bits_copy ( XXH3_128bits_state * state,
+                         const void *         key,
+                         void *               copy,
+                         size_t               len )
+{
+  if (len == 0) {
+    return;
+  }
+  memcpy(copy, key, len);
+  takeStripes(state, (const uint8_t *) copy, STRIPE_LEN, len / STRIPE_LEN);
+  state->last = (const uint8_t *) copy + len - STRIPE_LEN;
+}
+
+void XXH3_128bits_zeros ( XXH3_128bits_state * state, size_t len )
+{
+  if (len == 0) {
+    return;
+  }
+  takeStripes(state, ZERO_STRIPE, 0, len / STRIPE_LEN);
+  state->last = ZERO_STRIPE;
+}
+
+void XXH3_128bits_finish ( const XXH3_128bits_state * state, void * out )
+{
+  uint64_t acc[ACC_NB];
+  memcpy(acc, state->acc, sizeof(acc));
+
+  // Take back the last stripe, which was accumulated as an ordinary one.
+  size_t n = (state->stripes - 1) % STRIPES_PER_BLOCK;
+  const uint8_t * secret = SECRET + n * SECRET_CONSUME_RATE;
+  for (size_t lane = 0; lane < ACC_NB; lane++) {
+    uint64_t dataVal = readLE64(state->last + lane * 8);
+    uint64_t dataKey = dataVal ^ readLE64(secret + lane * 8);
+    acc[lane ^ 1] -= dataVal;
+    acc[lane] -= (uint64_t) (uint32_t) dataKey * (dataKey >> 32);
+  }
+
+  Hash128 h = finishLong(acc, state->last, state->stripes * STRIPE_LEN);
+  writeLE64((uint8_t *) out, h.low64);
+  writeLE64((uint8_t *) out + 8, h.high64);
+}
@@ -0,0 +1,59 @@
+//-----------------------------------------------------------------------------
+// XXH3 was designed by Yann Collet as part of xxHash, which is distributed
+// under the BSD 2-Clause License. This is an independent implementation of
+// the 128-bit variant with the default secret and no seed; its results are
+// identical to those of XXH3_128bits() from the reference library.
+
+#ifndef _XXH3_H_
+#define _XXH3_H_
+
+//-----------------------------------------------------------------------------
+// Platform-specific functions and macros
+
+#ifdef __KERNEL__
+# include <linux/types.h>
+#else // defined(__KERNEL__)
+# include <stddef.h>
+# include <stdint.h>
+#endif // !defined(__KERNEL__)
+
+//-----------------------------------------------------------------------------
+
+// Hash len bytes of key into the 16 bytes at out. The low 64 bits of the
+// hash are stored first, and each half is stored little-endian, which is the
+// same layout MurmurHash3_x64_128 uses (and the reverse of the reference
+// library's canonical XXH128 form).
+void XXH3_128bits ( const void * key, size_t len, void * out );
+
+// The longest key XXH3 hashes without striping it. The incremental hash
+// below only takes keys longer than this.
+#define XXH3_MIDSIZE_MAX 240
+
+// The running state of an incremental XXH3_128bits. The last stripe of a key
+// is hashed differently from the others, so the most recent stripe is read
+// again from the copy (or from a static zero stripe) when finishing; the key
+// itself need not outlive each call, but the copy must.
+typedef struct {
+  uint64_t        acc[8];
+  uint64_t        stripes;
+  const uint8_t * last;
+} XXH3_128bits_state;
+
+void XXH3_128bits_start ( XXH3_128bits_state * state );
+
+// Hash and copy len bytes, which must be a multiple of 64
+void XXH3_128bits_copy ( XXH3_128bits_state * state,
+                         const void *         key,
+                         void *               copy,
+                         size_t               len );
+
+// Hash len zero bytes, which must be a multiple of 64, without reading them
+void XXH3_128bits_zeros ( XXH3_128bits_state * state, size_t len );
+
+// Store the hash of everything taken so far, which must be more than
+// XXH3_MIDSIZE_MAX bytes, exactly as XXH3_128bits would
+void XXH3_128bits_finish ( const XXH3_128bits_state * state, void * out );
+
+//-----------------------------------------------------------------------------
+
+#endif // _XXH3_H_
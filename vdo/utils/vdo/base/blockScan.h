@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/base/blockScan.h#1 $
+ */
+
+#ifndef BLOCK_SCAN_H
+#define BLOCK_SCAN_H
+
+#include "murmur/MurmurHash3.h"
+#include "uds.h"
+#include "xxhash/XXH3.h"
+
+#include "types.h"
+
+/**
+ * A BlockScan copies the data of a block as it arrives, in whatever segments
+ * it arrives in, and in the same pass checks whether the data are all zeroes
+ * and, if they are not, computes their chunk name. Hashing only starts at the
+ * first non-zero data, so copying a zero block costs no more than checking
+ * it. Segments which the incremental hash can't take are just copied, and the
+ * copy is checked and hashed at the end while it is still in cache; so are
+ * blocks too short for the striped form of XXH3 which its incremental hash
+ * computes.
+ **/
+typedef struct {
+  /** The start of the buffer being copied into */
+  char                      *start;
+  /** The next byte of the buffer to copy into */
+  char                      *next;
+  /** The hash function for the chunk name */
+  UdsChunkNameHash           function;
+  /** The seed for the hash, if it is MurmurHash3 */
+  uint32_t                   seed;
+  /** The number of leading zero bytes not yet hashed */
+  unsigned int               zeroBytes;
+  /** Whether all of the data copied so far are zeroes */
+  bool                       allZeros;
+  /** Whether the data are being hashed as they are copied */
+  bool                       streaming;
+  /** The size of the units the hash takes, which every segment must be */
+  unsigned int               unitSize;
+  /** The incremental hash of the data, once they aren't all zeroes */
+  union {
+    MurmurHash3_x64_128_state murmur;
+    XXH3_128bits_state        xxh3;
+  }                          hash;
+} BlockScan;
+
+/**
+ * Start scanning a block.
+ *
+ * @param scan         The scan to start
+ * @param destination  The buffer to copy the block into
+ * @param function     The hash function for the chunk name
+ * @param seed         The seed for the hash, if it is MurmurHash3
+ **/
+void startBlockScan(BlockScan        *scan,
+                    char             *destination,
+                    UdsChunkNameHash  function,
+                    uint32_t          seed);
+
+/**
+ * Copy, check and hash the next segment of a block.
+ *
+ * @param scan    The scan
+ * @param source  The segment
+ * @param length  The length of the segment
+ **/
+void scanBlockSegment(BlockScan *scan, const char *source, unsigned int length);
+
+/**
+ * Finish scanning a block.
+ *
+ * @param [in]  scan  The scan
+ * @param [out] hash  Where to store the 16-byte chunk name, which is only
+ *                    computed if the data are not all zeroes
+ *
+ * @return <code>true</code> if the data are all zeroes
+ **/
+bool finishBlockScan(BlockScan *scan, void *hash)
+  __attribute__((warn_unused_result));
+
+#endif // BLOCK_SCAN_H
@@ -46,6 +46,7 @@ typedef enum __attribute__((packed)) {
   GENERATION_FLUSHED_COMPLETION,
   HEARTBEAT_COMPLETION,
   LOCK_COUNTER_COMPLETION,
+  PACKER_COMPLETION,
   PARTITION_COPY_COMPLETION,
   READ_ONLY_MODE_COMPLETION,
   READ_ONLY_REBUILD_COMPLETION,
@@ -183,6 +184,21 @@ void resetCompletion(VDOCompletion *completion);
  **/
 void invokeCallback(VDOCompletion *completion);
 
+/**
+ * Invoke the callback of a completion on its callback thread once a delay has
+ * passed. The completion is always enqueued, even when called from the
+ * callback thread.
+ *
+ * @param completion  The completion to invoke
+ * @param delay       The minimum time to wait, in microseconds
+ *
+ * @return <code>true</code> if the callback has been scheduled, or
+ *         <code>false</code> if the completion is not enqueueable or its
+ *         layer can not delay callbacks
+ **/
+bool invokeCallbackDelayed(VDOCompletion *completion, uint64_t delay)
+  __attribute__((warn_unused_result));
+
 /**
  * Continue processing a completion by setting the current result and calling
  * invokeCallback().
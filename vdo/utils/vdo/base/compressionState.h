@@ -116,4 +116,55 @@ void setCompressionDone(DataVIO *dataVIO);
  **/
 bool cancelCompression(DataVIO *dataVIO);
 
+/**
+ * Add a DataVIO whose block was compressed together with that of a leading
+ * DataVIO to the leader's compression unit. The member's block will be the
+ * next block of the unit.
+ *
+ * @param leader  The DataVIO holding the compressed data for the unit
+ * @param member  The DataVIO to add
+ **/
+void addToCompressionUnit(DataVIO *leader, DataVIO *member);
+
+/**
+ * Remove a member from the compression unit it belongs to. The slot for its
+ * block in the unit remains, but no longer belongs to any DataVIO.
+ *
+ * @param member  The DataVIO to remove
+ **/
+void removeFromCompressionUnit(DataVIO *member);
+
+/**
+ * Remove the first member from the compression unit led by a DataVIO.
+ *
+ * @param leader  The leader of the unit
+ *
+ * @return The removed member, or <code>NULL</code> if the unit has no
+ *         members left
+ **/
+DataVIO *removeFirstCompressionUnitMember(DataVIO *leader)
+  __attribute__((warn_unused_result));
+
+/**
+ * Get the number of compressed block slots a DataVIO's compressed data will
+ * occupy, which is the size of the unit if it leads a compression unit.
+ *
+ * @param dataVIO  The DataVIO
+ *
+ * @return The number of slots needed
+ **/
+uint8_t getCompressionUnitBlocks(const DataVIO *dataVIO)
+  __attribute__((warn_unused_result));
+
+/**
+ * Check whether a DataVIO is a member, other than the leader, of a
+ * compression unit.
+ *
+ * @param dataVIO  The DataVIO
+ *
+ * @return <code>true</code> if another DataVIO leads the DataVIO's unit
+ **/
+bool isCompressionUnitMember(const DataVIO *dataVIO)
+  __attribute__((warn_unused_result));
+
 #endif /* COMPRESSION_STATE_H */
@@ -282,8 +282,8 @@ void attemptLogicalBlockLock(VDOCompletion *completion)
   // lock holders in the packer.
   if (!isReadDataVIO(lockHolder) && cancelCompression(lockHolder)) {
     dataVIO->compression.lockHolder = lockHolder;
-    launchPackerCallback(dataVIO, removeLockHolderFromPacker,
-                         THIS_LOCATION("$F;cb=removeLockHolderFromPacker"));
+    launchLockHolderCallback(dataVIO, removeLockHolderFromPacker,
+                             THIS_LOCATION("$F;cb=removeLockHolderFromPacker"));
   }
 }
 
@@ -30,9 +30,11 @@
 #include "hashZone.h"
 #include "journalPoint.h"
 #include "logicalZone.h"
+#include "packer.h"
 #include "referenceOperation.h"
 #include "ringNode.h"
 #include "threadConfig.h"
+#include "timeUtils.h"
 #include "trace.h"
 #include "types.h"
 #include "vdoPageCache.h"
@@ -124,24 +126,53 @@ typedef struct {
    * This field should be accessed through the getCompressionState() and
    * setCompressionState() methods. It should not be accessed directly.
    */
-  Atomic32       state;
+  Atomic32         state;
 
   /* The compressed size of this block */
-  uint16_t       size;
+  uint16_t         size;
+
+  /* The algorithm which produced the compressed form of this block */
+  CompressionCodec codec;
 
   /* The packer input or output bin slot which holds the enclosing DataVIO */
-  SlotNumber     slot;
+  SlotNumber       slot;
+
+  /* The packer zone to which the enclosing DataVIO has been sent */
+  Packer          *packer;
 
   /* The packer input bin to which the enclosing DataVIO has been assigned */
-  InputBin      *bin;
+  InputBin        *bin;
+
+  /* When the enclosing DataVIO was put in its packer input bin */
+  AbsTime          binArrival;
 
   /* A pointer to the compressed form of this block */
-  char          *data;
+  char            *data;
 
   /*
    * A VIO which is blocked in the packer while holding a lock this VIO needs.
    */
-  DataVIO       *lockHolder;
+  DataVIO         *lockHolder;
+
+  /*
+   * If this VIO's block was compressed together with those of other VIOs, the
+   * number of blocks in the unit if this VIO leads it (its data is the whole
+   * unit's), or zero if another VIO leads it.
+   */
+  uint8_t          unitBlocks;
+
+  /* The position of this VIO's block within its compression unit */
+  uint8_t          unitIndex;
+
+  /* The VIO leading the compression unit which includes this VIO's block */
+  DataVIO         *unitLeader;
+
+  /*
+   * The next member of a compression unit, in a list headed by the unit's
+   * leader. Members do not proceed on their own once compressed; they go
+   * wherever their leader goes until they are packed or released.
+   */
+  DataVIO         *unitNext;
 
 } CompressionState;
 
@@ -179,6 +210,9 @@ struct dataVIO {
   /* Whether this VIO write is a duplicate */
   bool                 isDuplicate;
 
+  /* Whether the dedupe index answered this VIO's last query or update */
+  bool                 indexAnswered;
+
   /*
    * Whether this VIO has received an allocation (needs to be atomic so it can
    * be examined from threads not in the allocation zone).
@@ -839,13 +873,14 @@ static inline void launchJournalCallback(DataVIO       *dataVIO,
 }
 
 /**
- * Check that a DataVIO is running on the packer thread
+ * Check that a DataVIO is running on the thread of the packer zone to which
+ * it has been sent
  *
  * @param dataVIO  The DataVIO in question
  **/
 static inline void assertInPackerZone(DataVIO *dataVIO)
 {
-  ThreadID expected = getPackerZoneThread(getThreadConfigFromDataVIO(dataVIO));
+  ThreadID expected = getPackerThreadID(dataVIO->compression.packer);
   ThreadID threadID = getCallbackThreadID();
   ASSERT_LOG_ONLY((expected == threadID),
                   "DataVIO for logical block %" PRIu64
@@ -854,7 +889,8 @@ static inline void assertInPackerZone(DataVIO *dataVIO)
 }
 
 /**
- * Set a callback as a packer operation.
+ * Set a callback as a packer operation. The packer field of the DataVIO's
+ * compression state must already have been set.
  *
  * @param dataVIO   The DataVIO with which to set the callback
  * @param callback  The callback to set
@@ -865,7 +901,7 @@ static inline void setPackerCallback(DataVIO       *dataVIO,
                                      TraceLocation  location)
 {
   setCallback(dataVIOAsCompletion(dataVIO), callback,
-              getPackerZoneThread(getThreadConfigFromDataVIO(dataVIO)));
+              getPackerThreadID(dataVIO->compression.packer));
   dataVIOAddTraceRecord(dataVIO, location);
 }
 
@@ -884,6 +920,26 @@ static inline void launchPackerCallback(DataVIO       *dataVIO,
   invokeCallback(dataVIOAsCompletion(dataVIO));
 }
 
+/**
+ * Set a callback as an operation in the packer zone holding the DataVIO's
+ * lock holder, and invoke it immediately. The compression of the lock holder
+ * must have been canceled while it was waiting in the packer.
+ *
+ * @param dataVIO   The DataVIO with which to set the callback
+ * @param callback  The callback to set
+ * @param location  The tracing info for the call site
+ **/
+static inline void launchLockHolderCallback(DataVIO       *dataVIO,
+                                            VDOAction     *callback,
+                                            TraceLocation  location)
+{
+  DataVIO *lockHolder = dataVIO->compression.lockHolder;
+  setCallback(dataVIOAsCompletion(dataVIO), callback,
+              getPackerThreadID(lockHolder->compression.packer));
+  dataVIOAddTraceRecord(dataVIO, location);
+  invokeCallback(dataVIOAsCompletion(dataVIO));
+}
+
 /**
  * Check whether the advice received from Albireo is a valid data location,
  * and if it is, accept it as the location of a potential duplicate of the
@@ -0,0 +1,1001 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/base/deflate.c#1 $
+ */
+
+#include "deflate.h"
+
+#include "numeric.h"
+
+enum {
+  /** The farthest back a match may refer */
+  WINDOW_SIZE            = 32768,
+  WINDOW_MASK            = WINDOW_SIZE - 1,
+  /** The shortest and longest matches which can be encoded */
+  MIN_MATCH_LENGTH       = 3,
+  MAX_MATCH_LENGTH       = 258,
+  /** The number of bits of hash used to find earlier matches */
+  HASH_BITS              = 13,
+  /** The most earlier positions to examine when looking for a match */
+  MAX_CHAIN_LENGTH       = 16,
+  /** A match long enough that a longer one is not worth looking for */
+  GOOD_MATCH_LENGTH      = 32,
+  /** The sizes of the alphabets */
+  LITERAL_LENGTH_SYMBOLS = 288,
+  DISTANCE_SYMBOLS       = 32,
+  CODE_LENGTH_SYMBOLS    = 19,
+  /** The number of length and distance codes which may appear in a stream */
+  LENGTH_CODE_COUNT      = 29,
+  DISTANCE_CODE_COUNT    = 30,
+  /** The most literal/length and distance codes in a dynamic block */
+  MAX_LITERAL_CODES      = 286,
+  MAX_DISTANCE_CODES     = 30,
+  /** The literal/length symbol which ends a block */
+  END_OF_BLOCK           = 256,
+  /** The first literal/length symbol for a match length */
+  FIRST_LENGTH_SYMBOL    = 257,
+  /** The longest Huffman code */
+  MAX_CODE_BITS          = 15,
+  /** The length of the codes resolved by a single table lookup */
+  FAST_BITS              = 9,
+  /** The bits in a fast table entry which hold the code length */
+  FAST_LENGTH_MASK       = 0xf,
+  FAST_SYMBOL_SHIFT      = 4,
+};
+
+/** The block types, as they appear in the block header */
+typedef enum {
+  BLOCK_STORED  = 0,
+  BLOCK_FIXED   = 1,
+  BLOCK_DYNAMIC = 2,
+} BlockType;
+
+/** The base length of each length code */
+static const uint16_t LENGTH_BASES[LENGTH_CODE_COUNT] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+
+/** The number of extra bits following each length code */
+static const uint8_t LENGTH_EXTRA_BITS[LENGTH_CODE_COUNT] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+
+/** The base distance of each distance code */
+static const uint16_t DISTANCE_BASES[DISTANCE_CODE_COUNT] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289,
+  16385, 24577,
+};
+
+/** The number of extra bits following each distance code */
+static const uint8_t DISTANCE_EXTRA_BITS[DISTANCE_CODE_COUNT] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+/** The order in which code length code lengths are sent */
+static const uint8_t CODE_LENGTH_ORDER[CODE_LENGTH_SYMBOLS] = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+/** The bit-reversed fixed Huffman code of each literal/length symbol */
+static const uint16_t FIXED_LITERAL_CODES[LITERAL_LENGTH_SYMBOLS] = {
+  0x00c, 0x08c, 0x04c, 0x0cc, 0x02c, 0x0ac, 0x06c, 0x0ec,
+  0x01c, 0x09c, 0x05c, 0x0dc, 0x03c, 0x0bc, 0x07c, 0x0fc,
+  0x002, 0x082, 0x042, 0x0c2, 0x022, 0x0a2, 0x062, 0x0e2,
+  0x012, 0x092, 0x052, 0x0d2, 0x032, 0x0b2, 0x072, 0x0f2,
+  0x00a, 0x08a, 0x04a, 0x0ca, 0x02a, 0x0aa, 0x06a, 0x0ea,
+  0x01a, 0x09a, 0x05a, 0x0da, 0x03a, 0x0ba, 0x07a, 0x0fa,
+  0x006, 0x086, 0x046, 0x0c6, 0x026, 0x0a6, 0x066, 0x0e6,
+  0x016, 0x096, 0x056, 0x0d6, 0x036, 0x0b6, 0x076, 0x0f6,
+  0x00e, 0x08e, 0x04e, 0x0ce, 0x02e, 0x0ae, 0x06e, 0x0ee,
+  0x01e, 0x09e, 0x05e, 0x0de, 0x03e, 0x0be, 0x07e, 0x0fe,
+  0x001, 0x081, 0x041, 0x0c1, 0x021, 0x0a1, 0x061, 0x0e1,
+  0x011, 0x091, 0x051, 0x0d1, 0x031, 0x0b1, 0x071, 0x0f1,
+  0x009, 0x089, 0x049, 0x0c9, 0x029, 0x0a9, 0x069, 0x0e9,
+  0x019, 0x099, 0x059, 0x0d9, 0x039, 0x0b9, 0x079, 0x0f9,
+  0x005, 0x085, 0x045, 0x0c5, 0x025, 0x0a5, 0x065, 0x0e5,
+  0x015, 0x095, 0x055, 0x0d5, 0x035, 0x0b5, 0x075, 0x0f5,
+  0x00d, 0x08d, 0x04d, 0x0cd, 0x02d, 0x0ad, 0x06d, 0x0ed,
+  0x01d, 0x09d, 0x05d, 0x0dd, 0x03d, 0x0bd, 0x07d, 0x0fd,
+  0x013, 0x113, 0x093, 0x193, 0x053, 0x153, 0x0d3, 0x1d3,
+  0x033, 0x133, 0x0b3, 0x1b3, 0x073, 0x173, 0x0f3, 0x1f3,
+  0x00b, 0x10b, 0x08b, 0x18b, 0x04b, 0x14b, 0x0cb, 0x1cb,
+  0x02b, 0x12b, 0x0ab, 0x1ab, 0x06b, 0x16b, 0x0eb, 0x1eb,
+  0x01b, 0x11b, 0x09b, 0x19b, 0x05b, 0x15b, 0x0db, 0x1db,
+  0x03b, 0x13b, 0x0bb, 0x1bb, 0x07b, 0x17b, 0x0fb, 0x1fb,
+  0x007, 0x107, 0x087, 0x187, 0x047, 0x147, 0x0c7, 0x1c7,
+  0x027, 0x127, 0x0a7, 0x1a7, 0x067, 0x167, 0x0e7, 0x1e7,
+  0x017, 0x117, 0x097, 0x197, 0x057, 0x157, 0x0d7, 0x1d7,
+  0x037, 0x137, 0x0b7, 0x1b7, 0x077, 0x177, 0x0f7, 0x1f7,
+  0x00f, 0x10f, 0x08f, 0x18f, 0x04f, 0x14f, 0x0cf, 0x1cf,
+  0x02f, 0x12f, 0x0af, 0x1af, 0x06f, 0x16f, 0x0ef, 0x1ef,
+  0x01f, 0x11f, 0x09f, 0x19f, 0x05f, 0x15f, 0x0df, 0x1df,
+  0x03f, 0x13f, 0x0bf, 0x1bf, 0x07f, 0x17f, 0x0ff, 0x1ff,
+  0x000, 0x040, 0x020, 0x060, 0x010, 0x050, 0x030, 0x070,
+  0x008, 0x048, 0x028, 0x068, 0x018, 0x058, 0x038, 0x078,
+  0x004, 0x044, 0x024, 0x064, 0x014, 0x054, 0x034, 0x074,
+  0x003, 0x083, 0x043, 0x0c3, 0x023, 0x0a3, 0x063, 0x0e3,
+};
+
+/** The length code index of each match length, less MIN_MATCH_LENGTH */
+static const uint8_t LENGTH_INDICES[MAX_MATCH_LENGTH - MIN_MATCH_LENGTH + 1] = {
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  8,  9,  9, 10, 10, 11, 11,
+  12, 12, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14, 15, 15, 15, 15,
+  16, 16, 16, 16, 16, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17,
+  18, 18, 18, 18, 18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19,
+  20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 20,
+  21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21, 21,
+  22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22, 22,
+  23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23, 23,
+  24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24,
+  24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24, 24,
+  25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25,
+  25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25, 25,
+  26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26,
+  26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26,
+  27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27,
+  27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 28,
+};
+
+/** The bit-reversed fixed Huffman code of each distance code */
+static const uint8_t FIXED_DISTANCE_CODES[DISTANCE_CODE_COUNT] = {
+  0x00, 0x10, 0x08, 0x18, 0x04, 0x14, 0x0c, 0x1c,
+  0x02, 0x12, 0x0a, 0x1a, 0x06, 0x16, 0x0e, 0x1e,
+  0x01, 0x11, 0x09, 0x19, 0x05, 0x15, 0x0d, 0x1d,
+  0x03, 0x13, 0x0b, 0x1b, 0x07, 0x17,
+};
+
+/** The scratch space for compression. */
+typedef struct {
+  /** The most recent position, plus one, with each hash, or zero if none */
+  uint16_t head[1 << HASH_BITS];
+  /**
+   * The previous position, plus one, with the same hash as each position in
+   * the window, or zero if none
+   **/
+  uint16_t previous[WINDOW_SIZE];
+} Deflater;
+
+/** A canonical Huffman code, arranged for decoding. */
+typedef struct {
+  /** The number of codes of each length */
+  uint16_t count[MAX_CODE_BITS + 1];
+  /** The symbols, in code order */
+  uint16_t symbols[LITERAL_LENGTH_SYMBOLS];
+  /**
+   * For each value of the next FAST_BITS bits of input, the symbol shifted
+   * by FAST_SYMBOL_SHIFT and the code length, if the code is no longer than
+   * FAST_BITS, or zero otherwise
+   **/
+  uint16_t fast[1 << FAST_BITS];
+} HuffmanCode;
+
+/** The scratch space for uncompression. */
+typedef struct {
+  /** The literal/length code of the current block */
+  HuffmanCode literals;
+  /** The distance code of the current block */
+  HuffmanCode distances;
+  /** The code lengths of a dynamic block */
+  uint8_t     lengths[MAX_LITERAL_CODES + MAX_DISTANCE_CODES];
+} Inflater;
+
+/** A stream of bits being written, least significant bit first. */
+typedef struct {
+  /** The next byte of the output buffer */
+  uint8_t      *next;
+  /** The end of the output buffer */
+  uint8_t      *end;
+  /** Bits not yet written to the output buffer */
+  uint64_t      bits;
+  /** The number of bits in the bits field */
+  unsigned int  count;
+  /** Whether the output buffer has been overrun */
+  bool          overflow;
+} BitWriter;
+
+/** A stream of bits being read, least significant bit first. */
+typedef struct {
+  /** The next byte of the input buffer */
+  const uint8_t *next;
+  /** The end of the input buffer */
+  const uint8_t *end;
+  /** Bits read from the input buffer but not yet consumed */
+  uint64_t       bits;
+  /** The number of bits in the bits field */
+  unsigned int   count;
+} BitReader;
+
+/** An output buffer being filled by uncompression. */
+typedef struct {
+  /** The start of the buffer */
+  uint8_t *start;
+  /** The next byte to fill */
+  uint8_t *next;
+  /** The end of the buffer */
+  uint8_t *end;
+} Output;
+
+/**********************************************************************/
+size_t getDeflateContextSize(void)
+{
+  return sizeof(Deflater);
+}
+
+/**********************************************************************/
+size_t getInflateContextSize(void)
+{
+  return sizeof(Inflater);
+}
+
+/**
+ * Append bits to a bit stream.
+ *
+ * @param writer  The stream
+ * @param value   The bits to append, least significant first
+ * @param count   The number of bits to append, at most 32
+ **/
+static inline void putBits(BitWriter *writer, uint32_t value,
+                           unsigned int count)
+{
+  writer->bits  |= ((uint64_t) value) << writer->count;
+  writer->count += count;
+  if (writer->count < 32) {
+    return;
+  }
+
+  // Write out whole bytes, leaving fewer than eight bits buffered.
+  while (writer->count >= 8) {
+    if (writer->next == writer->end) {
+      writer->overflow = true;
+      writer->count    = 0;
+      return;
+    }
+
+    *writer->next++  = (uint8_t) writer->bits;
+    writer->bits   >>= 8;
+    writer->count   -= 8;
+  }
+}
+
+/**
+ * Write all the bits buffered in a bit stream, padding the last byte with
+ * zero bits.
+ *
+ * @param writer  The stream
+ **/
+static void flushBits(BitWriter *writer)
+{
+  while ((writer->count > 0) && !writer->overflow) {
+    if (writer->next == writer->end) {
+      writer->overflow = true;
+      return;
+    }
+
+    *writer->next++  = (uint8_t) writer->bits;
+    writer->bits   >>= 8;
+    writer->count    = ((writer->count > 8) ? (writer->count - 8) : 0);
+  }
+}
+
+/**
+ * Get the length of the fixed Huffman code for a literal/length symbol.
+ *
+ * @param symbol  The symbol
+ *
+ * @return The number of bits in the symbol's code
+ **/
+static inline unsigned int getFixedCodeLength(unsigned int symbol)
+{
+  if (symbol < 144) {
+    return 8;
+  } else if (symbol < 256) {
+    return 9;
+  } else if (symbol < 280) {
+    return 7;
+  }
+  return 8;
+}
+
+/**
+ * Write a literal/length symbol using the fixed Huffman code.
+ *
+ * @param writer  The stream
+ * @param symbol  The symbol to write
+ **/
+static inline void putFixedSymbol(BitWriter *writer, unsigned int symbol)
+{
+  putBits(writer, FIXED_LITERAL_CODES[symbol], getFixedCodeLength(symbol));
+}
+
+/**
+ * Get the distance code for a match distance.
+ *
+ * @param distance  The distance, from 1 to WINDOW_SIZE
+ *
+ * @return The distance code
+ **/
+static inline unsigned int getDistanceCode(unsigned int distance)
+{
+  unsigned int offset = distance - 1;
+  if (offset < 4) {
+    return offset;
+  }
+
+  // Each pair of codes above the first four covers a power of two.
+  unsigned int log = 31 - __builtin_clz(offset);
+  return (2 * log) + ((offset >> (log - 1)) & 1);
+}
+
+/**
+ * Write a match using the fixed Huffman codes.
+ *
+ * @param writer    The stream
+ * @param length    The length of the match
+ * @param distance  The distance back to the matching data
+ **/
+static inline void putFixedMatch(BitWriter    *writer,
+                                 unsigned int  length,
+                                 unsigned int  distance)
+{
+  unsigned int index = LENGTH_INDICES[length - MIN_MATCH_LENGTH];
+  putFixedSymbol(writer, FIRST_LENGTH_SYMBOL + index);
+  putBits(writer, length - LENGTH_BASES[index], LENGTH_EXTRA_BITS[index]);
+
+  unsigned int code = getDistanceCode(distance);
+  putBits(writer, FIXED_DISTANCE_CODES[code], 5);
+  putBits(writer, distance - DISTANCE_BASES[code], DISTANCE_EXTRA_BITS[code]);
+}
+
+/**
+ * Hash the three bytes at a position.
+ *
+ * @param data  The bytes to hash
+ *
+ * @return The hash
+ **/
+static inline unsigned int hashPosition(const uint8_t *data)
+{
+  uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+  return (value * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/**
+ * Record a position in the hash chains.
+ *
+ * @param deflater  The compression state
+ * @param data      The data being compressed
+ * @param position  The position to record
+ *
+ * @return The previous position, plus one, with the same hash, or zero
+ **/
+static inline unsigned int insertPosition(Deflater      *deflater,
+                                          const uint8_t *data,
+                                          unsigned int   position)
+{
+  unsigned int hash     = hashPosition(data + position);
+  unsigned int previous = deflater->head[hash];
+  deflater->previous[position & WINDOW_MASK] = previous;
+  deflater->head[hash] = position + 1;
+  return previous;
+}
+
+/**
+ * Count the matching bytes at the start of two buffers.
+ *
+ * @param a          The first buffer
+ * @param b          The second buffer
+ * @param maxLength  The most bytes to compare
+ *
+ * @return The number of leading bytes which are the same
+ **/
+static inline unsigned int getMatchLength(const uint8_t *a,
+                                          const uint8_t *b,
+                                          unsigned int   maxLength)
+{
+  unsigned int length = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // Compare a word at a time; the first differing bit locates the mismatch.
+  while ((length + sizeof(uint64_t)) <= maxLength) {
+    uint64_t wordA, wordB;
+    memcpy(&wordA, a + length, sizeof(wordA));
+    memcpy(&wordB, b + length, sizeof(wordB));
+    if (wordA != wordB) {
+      return length + (__builtin_ctzll(wordA ^ wordB) / 8);
+    }
+    length += sizeof(uint64_t);
+  }
+#endif
+  while ((length < maxLength) && (a[length] == b[length])) {
+    length++;
+  }
+  return length;
+}
+
+/**
+ * Find the longest match for the data at a position among the earlier
+ * positions with the same hash.
+ *
+ * @param [in]  deflater     The compression state
+ * @param [in]  data         The data being compressed
+ * @param [in]  position     The position to match
+ * @param [in]  candidate    The most recent earlier position, plus one, with
+ *                           the same hash, or zero if there is none
+ * @param [in]  maxLength    The longest match allowed
+ * @param [out] distancePtr  A pointer to hold the distance of the match
+ *
+ * @return The length of the longest match found
+ **/
+static unsigned int findMatch(const Deflater *deflater,
+                              const uint8_t  *data,
+                              unsigned int    position,
+                              unsigned int    candidate,
+                              unsigned int    maxLength,
+                              unsigned int   *distancePtr)
+{
+  unsigned int bestLength = 0;
+  for (unsigned int chain = 0;
+       (candidate != 0) && (chain < MAX_CHAIN_LENGTH);
+       chain++) {
+    unsigned int match = candidate - 1;
+    if ((position - match) > WINDOW_SIZE) {
+      break;
+    }
+
+    // Only a match which gets the byte after the best so far can be longer.
+    if (data[match + bestLength] == data[position + bestLength]) {
+      unsigned int length = getMatchLength(data + match, data + position,
+                                           maxLength);
+      if (length > bestLength) {
+        bestLength   = length;
+        *distancePtr = position - match;
+        if ((length == maxLength) || (length >= GOOD_MATCH_LENGTH)) {
+          break;
+        }
+      }
+    }
+
+    // The chain only ever goes back; a later position means the window
+    // slot has been reused.
+    unsigned int next = deflater->previous[match & WINDOW_MASK];
+    if (next >= candidate) {
+      break;
+    }
+    candidate = next;
+  }
+
+  return bestLength;
+}
+
+/**********************************************************************/
+int deflateCompress(void       *context,
+                    const char *source,
+                    int         sourceSize,
+                    char       *destination,
+                    int         destinationSize)
+{
+  if ((sourceSize < 0) || (sourceSize > DEFLATE_MAX_INPUT_SIZE)
+      || (destinationSize <= 0)) {
+    return 0;
+  }
+
+  Deflater *deflater = context;
+  memset(deflater->head, 0, sizeof(deflater->head));
+
+  const uint8_t *data  = (const uint8_t *) source;
+  unsigned int   limit = sourceSize;
+  BitWriter writer = {
+    .next = (uint8_t *) destination,
+    .end  = (uint8_t *) destination + destinationSize,
+  };
+
+  // A single final block of fixed Huffman codes.
+  putBits(&writer, 1, 1);
+  putBits(&writer, BLOCK_FIXED, 2);
+
+  unsigned int position = 0;
+  while ((position < limit) && !writer.overflow) {
+    unsigned int remaining = limit - position;
+    unsigned int length    = 0;
+    unsigned int distance  = 0;
+    if (remaining >= MIN_MATCH_LENGTH) {
+      unsigned int candidate = insertPosition(deflater, data, position);
+      unsigned int maxLength = minInt(remaining, MAX_MATCH_LENGTH);
+      length = findMatch(deflater, data, position, candidate, maxLength,
+                         &distance);
+    }
+
+    if (length < MIN_MATCH_LENGTH) {
+      putFixedSymbol(&writer, data[position++]);
+      continue;
+    }
+
+    putFixedMatch(&writer, length, distance);
+
+    // Record the positions within the match so later data can refer to them.
+    unsigned int end = position + length;
+    for (position++; position < end; position++) {
+      if ((limit - position) >= MIN_MATCH_LENGTH) {
+        insertPosition(deflater, data, position);
+      }
+    }
+  }
+
+  putFixedSymbol(&writer, END_OF_BLOCK);
+  flushBits(&writer);
+  if (writer.overflow) {
+    return 0;
+  }
+
+  return writer.next - (uint8_t *) destination;
+}
+
+/**
+ * Read bits into the bit buffer of a stream, as far as it will hold them.
+ *
+ * @param reader  The stream
+ **/
+static inline void refillBits(BitReader *reader)
+{
+  if ((reader->end - reader->next) >= (ptrdiff_t) sizeof(uint64_t)) {
+    // Load a whole word, keeping as many of its bytes as fit.
+    uint64_t word;
+    memcpy(&word, reader->next, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    reader->bits  |= word << reader->count;
+    reader->next  += (63 - reader->count) / 8;
+    reader->count |= 56;
+    return;
+  }
+
+  while ((reader->count <= 56) && (reader->next < reader->end)) {
+    reader->bits  |= ((uint64_t) *reader->next++) << reader->count;
+    reader->count += 8;
+  }
+}
+
+/**
+ * Consume bits from a stream.
+ *
+ * @param [in]  reader    The stream
+ * @param [in]  count     The number of bits to consume, at most 16
+ * @param [out] valuePtr  A pointer to hold the bits, least significant first
+ *
+ * @return <code>true</code> unless the stream ran out of bits
+ **/
+static inline bool getBits(BitReader    *reader,
+                           unsigned int  count,
+                           unsigned int *valuePtr)
+{
+  if (reader->count < count) {
+    refillBits(reader);
+    if (reader->count < count) {
+      return false;
+    }
+  }
+
+  *valuePtr       = reader->bits & ((1U << count) - 1);
+  reader->bits  >>= count;
+  reader->count  -= count;
+  return true;
+}
+
+/**
+ * Reverse the order of the low bits of a value.
+ *
+ * @param value  The value
+ * @param count  The number of bits to reverse
+ *
+ * @return The reversed bits
+ **/
+static inline unsigned int reverseBits(unsigned int value, unsigned int count)
+{
+  unsigned int reversed = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    reversed = (reversed << 1) | ((value >> i) & 1);
+  }
+  return reversed;
+}
+
+/**
+ * Build a canonical Huffman code for decoding from the code length of each
+ * symbol. Incomplete codes are allowed, since a stream may legitimately use
+ * one for distances, but over-subscribed codes are not.
+ *
+ * @param code         The code to build
+ * @param lengths      The code length of each symbol, zero if it is unused
+ * @param symbolCount  The number of symbols
+ *
+ * @return <code>true</code> if the code is valid
+ **/
+static bool buildHuffmanCode(HuffmanCode   *code,
+                             const uint8_t *lengths,
+                             unsigned int   symbolCount)
+{
+  memset(code->count, 0, sizeof(code->count));
+  for (unsigned int symbol = 0; symbol < symbolCount; symbol++) {
+    code->count[lengths[symbol]]++;
+  }
+  code->count[0] = 0;
+
+  int left = 1;
+  uint16_t offsets[MAX_CODE_BITS + 1];
+  offsets[1] = 0;
+  for (unsigned int length = 1; length <= MAX_CODE_BITS; length++) {
+    left = (left << 1) - code->count[length];
+    if (left < 0) {
+      return false;
+    }
+    if (length < MAX_CODE_BITS) {
+      offsets[length + 1] = offsets[length] + code->count[length];
+    }
+  }
+
+  for (unsigned int symbol = 0; symbol < symbolCount; symbol++) {
+    if (lengths[symbol] != 0) {
+      code->symbols[offsets[lengths[symbol]]++] = symbol;
+    }
+  }
+
+  // Assign canonical codes in order, filling in the fast table for the
+  // short ones.
+  memset(code->fast, 0, sizeof(code->fast));
+  unsigned int next  = 0;
+  unsigned int index = 0;
+  for (unsigned int length = 1; length <= FAST_BITS; length++) {
+    for (unsigned int i = 0; i < code->count[length]; i++) {
+      uint16_t entry = ((code->symbols[index++] << FAST_SYMBOL_SHIFT)
+                        | length);
+      for (unsigned int bits = reverseBits(next++, length);
+           bits < (1 << FAST_BITS);
+           bits += (1 << length)) {
+        code->fast[bits] = entry;
+      }
+    }
+    next <<= 1;
+  }
+
+  return true;
+}
+
+/**
+ * Decode one symbol from a stream.
+ *
+ * @param reader  The stream
+ * @param code    The code to decode with
+ *
+ * @return The symbol, or -1 if the stream does not hold a valid code
+ **/
+static inline int decodeSymbol(BitReader *reader, const HuffmanCode *code)
+{
+  if (reader->count < MAX_CODE_BITS) {
+    refillBits(reader);
+  }
+
+  uint16_t entry = code->fast[reader->bits & ((1 << FAST_BITS) - 1)];
+  unsigned int length = entry & FAST_LENGTH_MASK;
+  if ((length != 0) && (length <= reader->count)) {
+    reader->bits  >>= length;
+    reader->count  -= length;
+    return entry >> FAST_SYMBOL_SHIFT;
+  }
+
+  // Walk the canonical code a bit at a time, as for a long code.
+  int      value = 0;
+  int      first = 0;
+  int      index = 0;
+  uint64_t bits  = reader->bits;
+  for (length = 1;
+       (length <= MAX_CODE_BITS) && (length <= reader->count);
+       length++) {
+    value |= bits & 1;
+    bits >>= 1;
+    int count = code->count[length];
+    if ((value - count) < first) {
+      reader->bits  >>= length;
+      reader->count  -= length;
+      return code->symbols[index + (value - first)];
+    }
+    index  += count;
+    first   = (first + count) << 1;
+    value <<= 1;
+  }
+
+  return -1;
+}
+
+/**
+ * Copy a stored block to the output.
+ *
+ * @param reader  The stream, positioned after the block header
+ * @param output  The output buffer
+ *
+ * @return <code>true</code> if the block was copied
+ **/
+static bool inflateStoredBlock(BitReader *reader, Output *output)
+{
+  // The block's length is aligned to the next byte boundary.
+  unsigned int skip = reader->count & 7;
+  reader->bits  >>= skip;
+  reader->count  -= skip;
+
+  unsigned int length, complement;
+  if (!getBits(reader, 16, &length) || !getBits(reader, 16, &complement)
+      || (length != (~complement & 0xffff))
+      || (length > (unsigned int) (output->end - output->next))) {
+    return false;
+  }
+
+  // Some of the data may already be in the bit buffer.
+  for (; (length > 0) && (reader->count >= 8); length--) {
+    *output->next++   = (uint8_t) reader->bits;
+    reader->bits    >>= 8;
+    reader->count    -= 8;
+  }
+
+  // A whole-word refill may also have left bits of the byte at next above
+  // the count; the copy below moves past that byte, so drop them.
+  reader->bits &= ((uint64_t) 1 << reader->count) - 1;
+
+  if (length > (unsigned int) (reader->end - reader->next)) {
+    return false;
+  }
+
+  memcpy(output->next, reader->next, length);
+  output->next += length;
+  reader->next += length;
+  return true;
+}
+
+/**
+ * Decode the compressed data of a fixed or dynamic block.
+ *
+ * @param inflater  The uncompression state, holding the block's codes
+ * @param reader    The stream, positioned at the block's data
+ * @param output    The output buffer
+ *
+ * @return <code>true</code> if the block was decoded
+ **/
+static bool inflateCodes(const Inflater *inflater,
+                         BitReader      *reader,
+                         Output         *output)
+{
+  for (;;) {
+    int symbol = decodeSymbol(reader, &inflater->literals);
+    if (symbol < 0) {
+      return false;
+    }
+
+    if (symbol < END_OF_BLOCK) {
+      if (output->next == output->end) {
+        return false;
+      }
+      *output->next++ = symbol;
+      continue;
+    }
+
+    if (symbol == END_OF_BLOCK) {
+      return true;
+    }
+
+    unsigned int index = symbol - FIRST_LENGTH_SYMBOL;
+    unsigned int extra;
+    if ((index >= LENGTH_CODE_COUNT)
+        || !getBits(reader, LENGTH_EXTRA_BITS[index], &extra)) {
+      return false;
+    }
+    unsigned int length = LENGTH_BASES[index] + extra;
+
+    symbol = decodeSymbol(reader, &inflater->distances);
+    if ((symbol < 0) || (symbol >= DISTANCE_CODE_COUNT)
+        || !getBits(reader, DISTANCE_EXTRA_BITS[symbol], &extra)) {
+      return false;
+    }
+    unsigned int distance = DISTANCE_BASES[symbol] + extra;
+
+    if ((distance > (unsigned int) (output->next - output->start))
+        || (length > (unsigned int) (output->end - output->next))) {
+      return false;
+    }
+
+    const uint8_t *from = output->next - distance;
+    if (distance >= length) {
+      memcpy(output->next, from, length);
+      output->next += length;
+    } else {
+      // The match overlaps the data it produces.
+      for (unsigned int i = 0; i < length; i++) {
+        *output->next++ = *from++;
+      }
+    }
+  }
+}
+
+/**
+ * Set up the codes of a fixed Huffman block.
+ *
+ * @param inflater  The uncompression state
+ *
+ * @return <code>true</code> if the codes were built
+ **/
+static bool buildFixedCodes(Inflater *inflater)
+{
+  uint8_t *lengths = inflater->lengths;
+  for (unsigned int symbol = 0; symbol < LITERAL_LENGTH_SYMBOLS; symbol++) {
+    lengths[symbol] = getFixedCodeLength(symbol);
+  }
+  if (!buildHuffmanCode(&inflater->literals, lengths,
+                        LITERAL_LENGTH_SYMBOLS)) {
+    return false;
+  }
+
+  memset(lengths, 5, DISTANCE_SYMBOLS);
+  return buildHuffmanCode(&inflater->distances, lengths, DISTANCE_SYMBOLS);
+}
+
+/**
+ * Read the code descriptions of a dynamic Huffman block and set up its
+ * codes.
+ *
+ * @param inflater  The uncompression state
+ * @param reader    The stream, positioned after the block header
+ *
+ * @return <code>true</code> if the codes were valid
+ **/
+static bool buildDynamicCodes(Inflater *inflater, BitReader *reader)
+{
+  unsigned int literalCount, distanceCount, codeLengthCount;
+  if (!getBits(reader, 5, &literalCount)
+      || !getBits(reader, 5, &distanceCount)
+      || !getBits(reader, 4, &codeLengthCount)) {
+    return false;
+  }
+  literalCount    += FIRST_LENGTH_SYMBOL;
+  distanceCount   += 1;
+  codeLengthCount += 4;
+  if ((literalCount > MAX_LITERAL_CODES)
+      || (distanceCount > MAX_DISTANCE_CODES)) {
+    return false;
+  }
+
+  // The code lengths are themselves Huffman coded; the distance code is
+  // free to hold that code while the lengths are read.
+  uint8_t *lengths = inflater->lengths;
+  memset(lengths, 0, CODE_LENGTH_SYMBOLS);
+  for (unsigned int i = 0; i < codeLengthCount; i++) {
+    unsigned int length;
+    if (!getBits(reader, 3, &length)) {
+      return false;
+    }
+    lengths[CODE_LENGTH_ORDER[i]] = length;
+  }
+  if (!buildHuffmanCode(&inflater->distances, lengths, CODE_LENGTH_SYMBOLS)) {
+    return false;
+  }
+
+  unsigned int total = literalCount + distanceCount;
+  unsigned int index = 0;
+  while (index < total) {
+    int symbol = decodeSymbol(reader, &inflater->distances);
+    if (symbol < 0) {
+      return false;
+    }
+
+    if (symbol < 16) {
+      lengths[index++] = symbol;
+      continue;
+    }
+
+    // Symbols 16 to 18 repeat the previous length, or zero.
+    uint8_t      length = 0;
+    unsigned int repeat;
+    bool         valid;
+    if (symbol == 16) {
+      if (index == 0) {
+        return false;
+      }
+      length = lengths[index - 1];
+      valid  = getBits(reader, 2, &repeat);
+      repeat += 3;
+    } else if (symbol == 17) {
+      valid   = getBits(reader, 3, &repeat);
+      repeat += 3;
+    } else {
+      valid   = getBits(reader, 7, &repeat);
+      repeat += 11;
+    }
+
+    if (!valid || ((index + repeat) > total)) {
+      return false;
+    }
+    memset(lengths + index, length, repeat);
+    index += repeat;
+  }
+
+  // A block which can't end is no use.
+  if (lengths[END_OF_BLOCK] == 0) {
+    return false;
+  }
+
+  return (buildHuffmanCode(&inflater->literals, lengths, literalCount)
+          && buildHuffmanCode(&inflater->distances, lengths + literalCount,
+                              distanceCount));
+}
+
+/**********************************************************************/
+int deflateUncompress(void       *context,
+                      const char *source,
+                      int         sourceSize,
+                      char       *destination,
+                      int         destinationSize)
+{
+  if ((sourceSize < 0) || (destinationSize < 0)) {
+    return -1;
+  }
+
+  Inflater *inflater = context;
+  BitReader reader = {
+    .next = (const uint8_t *) source,
+    .end  = (const uint8_t *) source + sourceSize,
+  };
+  Output output = {
+    .start = (uint8_t *) destination,
+    .next  = (uint8_t *) destination,
+    .end   = (uint8_t *) destination + destinationSize,
+  };
+
+  unsigned int final;
+  do {
+    unsigned int type;
+    if (!getBits(&reader, 1, &final) || !getBits(&reader, 2, &type)) {
+      return -1;
+    }
+
+    bool decoded;
+    switch (type) {
+    case BLOCK_STORED:
+      decoded = inflateStoredBlock(&reader, &output);
+      break;
+
+    case BLOCK_FIXED:
+      decoded = (buildFixedCodes(inflater)
+                 && inflateCodes(inflater, &reader, &output));
+      break;
+
+    case BLOCK_DYNAMIC:
+      decoded = (buildDynamicCodes(inflater, &reader)
+                 && inflateCodes(inflater, &reader, &output));
+      break;
+
+    default:
+      decoded = false;
+    }
+
+    if (!decoded) {
+      return -1;
+    }
+  } while (!final);
+
+  return output.next - output.start;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/base/deflate.h#1 $
+ */
+
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+#include "common.h"
+
+/**
+ * A software implementation of DEFLATE (RFC 1951). Streams are read and
+ * written raw, without a zlib or gzip wrapper, which is the format produced
+ * and consumed by the kernel's "deflate" crypto transform and the hardware
+ * deflate engines behind it. Any fragment compressed by one may therefore be
+ * uncompressed by the other.
+ *
+ * Compression uses a single block of fixed Huffman codes, which is what
+ * hardware engines emit in their static mode. Uncompression accepts stored,
+ * fixed and dynamic Huffman blocks.
+ *
+ * Neither operation keeps state between calls, but each needs scratch space
+ * too large for the kernel stack, which the caller must supply.
+ **/
+
+enum {
+  /** The largest buffer which may be compressed */
+  DEFLATE_MAX_INPUT_SIZE = 65535,
+};
+
+/**
+ * Get the size of the scratch space needed by deflateCompress().
+ *
+ * @return The number of bytes of context needed for compression
+ **/
+size_t getDeflateContextSize(void)
+  __attribute__((warn_unused_result));
+
+/**
+ * Get the size of the scratch space needed by deflateUncompress().
+ *
+ * @return The number of bytes of context needed for uncompression
+ **/
+size_t getInflateContextSize(void)
+  __attribute__((warn_unused_result));
+
+/**
+ * Compress a buffer into a raw deflate stream. This never writes past the
+ * end of the destination buffer.
+ *
+ * @param context          Scratch space of at least getDeflateContextSize()
+ *                         bytes
+ * @param source           The data to compress
+ * @param sourceSize       The size of the data, at most
+ *                         DEFLATE_MAX_INPUT_SIZE
+ * @param destination      The buffer to hold the compressed data
+ * @param destinationSize  The size of the destination buffer
+ *
+ * @return The size of the compressed data, or 0 if it would not fit in the
+ *         destination buffer
+ **/
+int deflateCompress(void       *context,
+                    const char *source,
+                    int         sourceSize,
+                    char       *destination,
+                    int         destinationSize)
+  __attribute__((warn_unused_result));
+
+/**
+ * Uncompress a raw deflate stream. This never writes past the end of the
+ * destination buffer, and so is safe against malformed input.
+ *
+ * @param context          Scratch space of at least getInflateContextSize()
+ *                         bytes
+ * @param source           The compressed data
+ * @param sourceSize       The size of the compressed data
+ * @param destination      The buffer to hold the uncompressed data
+ * @param destinationSize  The size of the destination buffer
+ *
+ * @return The size of the uncompressed data, or a negative value if the
+ *         stream is malformed or its data would not fit in the destination
+ **/
+int deflateUncompress(void       *context,
+                      const char *source,
+                      int         sourceSize,
+                      char       *destination,
+                      int         destinationSize)
+  __attribute__((warn_unused_result));
+
+#endif // DEFLATE_H
@@ -47,6 +47,8 @@ struct flusher {
   SequenceNumber  notifyGeneration;
   /** The logical zone to notify next */
   LogicalZone    *logicalZoneToNotify;
+  /** The packer zone to notify next */
+  Packer         *packerToNotify;
   /** The ID of the thread on which flush requests should be made */
   ThreadID        threadID;
 };
@@ -87,7 +89,7 @@ int makeFlusher(VDO *vdo)
   }
 
   vdo->flusher->vdo      = vdo;
-  vdo->flusher->threadID = getPackerZoneThread(getThreadConfig(vdo));
+  vdo->flusher->threadID = getPackerZoneThread(getThreadConfig(vdo), 0);
   return initializeEnqueueableCompletion(&vdo->flusher->completion,
                                          FLUSH_NOTIFICATION_COMPLETION,
                                          vdo->layer);
@@ -145,17 +147,26 @@ static void finishNotification(VDOCompletion *completion)
 }
 
 /**
- * Flush the packer now that all of the logical and physical zones have been
- * notified of the new flush request. This callback is registered in
- * incrementGeneration().
+ * Flush a packer zone now that all of the logical zones, and any preceding
+ * packer zones, have been notified of the new flush request. If there are
+ * more packer zones, go on to the next one, otherwise, finish the
+ * notification. This callback is registered both in incrementGeneration()
+ * and in itself.
  *
  * @param completion  The flusher completion
  **/
 static void flushPackerCallback(VDOCompletion *completion)
 {
   Flusher *flusher = asFlusher(completion);
-  incrementPackerFlushGeneration(flusher->vdo->packer);
-  launchCallback(completion, finishNotification, flusher->threadID);
+  incrementPackerFlushGeneration(flusher->packerToNotify);
+  flusher->packerToNotify = getNextPacker(flusher->packerToNotify);
+  if (flusher->packerToNotify == NULL) {
+    launchCallback(completion, finishNotification, flusher->threadID);
+    return;
+  }
+
+  launchCallback(completion, flushPackerCallback,
+                 getPackerThreadID(flusher->packerToNotify));
 }
 
 /**
@@ -173,7 +184,9 @@ static void incrementGeneration(VDOCompletion *completion)
   flusher->logicalZoneToNotify
     = getNextLogicalZone(flusher->logicalZoneToNotify);
   if (flusher->logicalZoneToNotify == NULL) {
-    launchCallback(completion, flushPackerCallback, flusher->threadID);
+    flusher->packerToNotify = flusher->vdo->packers[0];
+    launchCallback(completion, flushPackerCallback,
+                   getPackerThreadID(flusher->packerToNotify));
     return;
   }
 
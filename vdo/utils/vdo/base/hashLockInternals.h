@@ -80,6 +80,12 @@ struct hashLock {
   /** True if the UDS index should be updated with new advice */
   bool           updateAdvice;
 
+  /**
+   * True if the index answered the lock's last query or update, so that it
+   * holds the advice which was sent with it
+   **/
+  bool           indexAnswered;
+
   /** True if the advice has been verified to be a true duplicate */
   bool           verified;
 
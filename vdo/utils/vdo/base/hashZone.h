@@ -107,6 +107,48 @@ int acquireHashLockFromZone(HashZone            *zone,
  **/
 void returnHashLockToZone(HashZone *zone, HashLock **lockPtr);
 
+/**
+ * Look up the dedupe advice cached for a chunk name, counting the lookup as a
+ * hit or a miss in the zone statistics. Cached advice is only a candidate
+ * location, which must be verified like advice from the index. An entry
+ * which has answered several lookups since the index last confirmed it is
+ * reported as a miss, so that the name is sent to the index again and stays
+ * in it. Must only be called from the hash zone thread.
+ *
+ * @param [in]  zone    The hash zone responsible for the chunk name
+ * @param [in]  name    The chunk name to look up
+ * @param [out] advice  A pointer to receive the cached location, if any
+ *
+ * @return <code>true</code> if advice was cached for the chunk name
+ **/
+bool getCachedAdvice(HashZone           *zone,
+                     const UdsChunkName *name,
+                     ZonedPBN           *advice)
+  __attribute__((warn_unused_result));
+
+/**
+ * Remember the location of a block as the dedupe advice for its chunk name,
+ * displacing whatever advice was cached in its place. This should only be
+ * done when the index holds the same advice. Must only be called from the
+ * hash zone thread.
+ *
+ * @param zone      The hash zone responsible for the chunk name
+ * @param name      The chunk name of the block
+ * @param location  The location of the block
+ **/
+void cacheAdvice(HashZone           *zone,
+                 const UdsChunkName *name,
+                 ZonedPBN            location);
+
+/**
+ * Discard any dedupe advice cached for a chunk name, because it proved to be
+ * stale. Must only be called from the hash zone thread.
+ *
+ * @param zone  The hash zone responsible for the chunk name
+ * @param name  The chunk name whose advice is stale
+ **/
+void forgetCachedAdvice(HashZone *zone, const UdsChunkName *name);
+
 /**
  * Increment the valid advice count in the hash zone statistics.
  * Must only be called from the hash zone thread.
@@ -201,4 +201,149 @@ static inline uint64_t computeBucketCount(uint64_t objectCount,
   return quotient;
 }
 
+/**
+ * Compare blocks of memory for equality.
+ *
+ * This assumes the blocks are likely to be large; it's not well
+ * optimized for comparing just a few bytes.  This is desirable
+ * because the Linux kernel memcmp() routine on x86 is not well
+ * optimized for large blocks, and the performance penalty turns out
+ * to be significant if you're doing lots of 4KB comparisons.
+ *
+ * Blocks being verified almost always match, so the common case is a
+ * full-length compare. The words of each 64-byte chunk are compared
+ * together, so there is just one branch per chunk and the loads can all be
+ * in flight at once; a mismatch is still caught within a chunk of where it
+ * occurs. (Vector registers would be wider, but using them in the kernel
+ * costs a kernel_fpu_begin() per call.)
+ *
+ * @param pointerArgument1  first data block
+ * @param pointerArgument2  second data block
+ * @param length            length of the data block
+ *
+ * @return   true iff the two blocks are equal
+ **/
+__attribute__((warn_unused_result))
+static inline bool memoryEqual(const void *pointerArgument1,
+                               const void *pointerArgument2,
+                               size_t      length)
+{
+  const byte *pointer1 = pointerArgument1;
+  const byte *pointer2 = pointerArgument2;
+  while (length >= 8 * sizeof(uint64_t)) {
+    // Written out in full, since the compiler won't unroll a loop here.
+    uint64_t difference
+      = ((GET_UNALIGNED(uint64_t, pointer1)
+          ^ GET_UNALIGNED(uint64_t, pointer2))
+         | (GET_UNALIGNED(uint64_t, pointer1 + 1 * sizeof(uint64_t))
+            ^ GET_UNALIGNED(uint64_t, pointer2 + 1 * sizeof(uint64_t)))
+         | (GET_UNALIGNED(uint64_t, pointer1 + 2 * sizeof(uint64_t))
+            ^ GET_UNALIGNED(uint64_t, pointer2 + 2 * sizeof(uint64_t)))
+         | (GET_UNALIGNED(uint64_t, pointer1 + 3 * sizeof(uint64_t))
+            ^ GET_UNALIGNED(uint64_t, pointer2 + 3 * sizeof(uint64_t)))
+         | (GET_UNALIGNED(uint64_t, pointer1 + 4 * sizeof(uint64_t))
+            ^ GET_UNALIGNED(uint64_t, pointer2 + 4 * sizeof(uint64_t)))
+         | (GET_UNALIGNED(uint64_t, pointer1 + 5 * sizeof(uint64_t))
+            ^ GET_UNALIGNED(uint64_t, pointer2 + 5 * sizeof(uint64_t)))
+         | (GET_UNALIGNED(uint64_t, pointer1 + 6 * sizeof(uint64_t))
+            ^ GET_UNALIGNED(uint64_t, pointer2 + 6 * sizeof(uint64_t)))
+         | (GET_UNALIGNED(uint64_t, pointer1 + 7 * sizeof(uint64_t))
+            ^ GET_UNALIGNED(uint64_t, pointer2 + 7 * sizeof(uint64_t))));
+    if (difference != 0) {
+      return false;
+    }
+    pointer1 += 8 * sizeof(uint64_t);
+    pointer2 += 8 * sizeof(uint64_t);
+    length -= 8 * sizeof(uint64_t);
+  }
+  while (length >= sizeof(uint64_t)) {
+    /*
+     * GET_UNALIGNED is just for paranoia.  (1) On x86_64 it is
+     * treated the same as an aligned access.  (2) In this use case,
+     * one or both of the inputs will almost(?) always be aligned.
+     */
+    if (GET_UNALIGNED(uint64_t, pointer1)
+        != GET_UNALIGNED(uint64_t, pointer2)) {
+      return false;
+    }
+    pointer1 += sizeof(uint64_t);
+    pointer2 += sizeof(uint64_t);
+    length -= sizeof(uint64_t);
+  }
+  while (length > 0) {
+    if (*pointer1 != *pointer2) {
+      return false;
+    }
+    pointer1++;
+    pointer2++;
+    length--;
+  }
+  return true;
+}
+
+/**
+ * The function determines whether a buffer contains all zeroes.
+ *
+ * @param buffer  The buffer to check
+ * @param length  The length of the buffer
+ *
+ * @return true is all zeroes, false otherwise
+ **/
+__attribute__((warn_unused_result))
+static inline bool isAllZeros(const char *buffer, unsigned int length)
+{
+  /*
+   * Handle expected common case of even the first word being nonzero,
+   * without getting into the more expensive (for one iteration) loop
+   * below.
+   */
+  if (likely(length >= sizeof(uint64_t))) {
+    if (GET_UNALIGNED(uint64_t, buffer) != 0) {
+      return false;
+    }
+
+    unsigned int wordCount = length / sizeof(uint64_t);
+
+    // Unroll to process 64 bytes at a time
+    unsigned int chunkCount = wordCount / 8;
+    while (chunkCount-- > 0) {
+      uint64_t word0 = GET_UNALIGNED(uint64_t, buffer);
+      uint64_t word1 = GET_UNALIGNED(uint64_t, buffer + 1 * sizeof(uint64_t));
+      uint64_t word2 = GET_UNALIGNED(uint64_t, buffer + 2 * sizeof(uint64_t));
+      uint64_t word3 = GET_UNALIGNED(uint64_t, buffer + 3 * sizeof(uint64_t));
+      uint64_t word4 = GET_UNALIGNED(uint64_t, buffer + 4 * sizeof(uint64_t));
+      uint64_t word5 = GET_UNALIGNED(uint64_t, buffer + 5 * sizeof(uint64_t));
+      uint64_t word6 = GET_UNALIGNED(uint64_t, buffer + 6 * sizeof(uint64_t));
+      uint64_t word7 = GET_UNALIGNED(uint64_t, buffer + 7 * sizeof(uint64_t));
+      uint64_t or = (word0 | word1 | word2 | word3
+                     | word4 | word5 | word6 | word7);
+      // Prevent compiler from using 8*(cmp;jne).
+      __asm__ __volatile__ ("" : : "g" (or));
+      if (or != 0) {
+        return false;
+      }
+      buffer += 8 * sizeof(uint64_t);
+    }
+    wordCount %= 8;
+
+    // Unroll to process 8 bytes at a time.
+    // (Is this still worthwhile?)
+    while (wordCount-- > 0) {
+      if (GET_UNALIGNED(uint64_t, buffer) != 0) {
+        return false;
+      }
+      buffer += sizeof(uint64_t);
+    }
+    length %= sizeof(uint64_t);
+    // Fall through to finish up anything left over.
+  }
+
+  while (length-- > 0) {
+    if (*buffer++ != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 #endif // NUM_UTILS_H
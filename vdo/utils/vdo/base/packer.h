@@ -33,25 +33,45 @@ enum {
   DEFAULT_PACKER_OUTPUT_BINS = 256,
 };
 
+/**
+ * A Packer packs the compressed data of DataVIOs into compressed blocks. A
+ * VDO has one or more packers, each of which is a zone with its own thread,
+ * bins, and flush generation. Each compressed DataVIO is sent to the zone
+ * selected by its chunk name, and the zones are linked in zone order so that
+ * requests which must visit every zone may be passed from one to the next.
+ **/
 typedef struct packer Packer;
 
 /**
- * Make a new block packer.
+ * Make a new block packer zone.
  *
  * @param [in]  layer           The physical layer to which compressed blocks
  *                              will be written
+ * @param [in]  zoneNumber      The number of the packer zone
+ * @param [in]  nextPacker      The next packer zone, or NULL if this is the
+ *                              last one
  * @param [in]  inputBinCount   The number of partial bins to keep in memory
  * @param [in]  outputBinCount  The number of compressed blocks that can be
  *                              written concurrently
  * @param [in]  threadConfig    The thread configuration of the VDO
+ * @param [in]  maxAge          The longest time, in microseconds, a partial
+ *                              bin may wait for more data, or 0 for no limit
+ * @param [in]  agePolicy       How to release a bin which has waited that long
+ * @param [in]  codecTable      Whether to leave room in each compressed
+ *                              block for the version 2.0 codec table
  * @param [out] packerPtr       A pointer to hold the new packer
  *
  * @return VDO_SUCCESS or an error
  **/
 int makePacker(PhysicalLayer       *layer,
+               ZoneCount            zoneNumber,
+               Packer              *nextPacker,
                BlockCount           inputBinCount,
                BlockCount           outputBinCount,
                const ThreadConfig  *threadConfig,
+               uint64_t             maxAge,
+               PackerAgePolicy      agePolicy,
+               bool                 codecTable,
                Packer             **packerPtr)
   __attribute__((warn_unused_result));
 
@@ -79,7 +99,17 @@ bool isSufficientlyCompressible(DataVIO *dataVIO)
  *
  * @return The packer's thread ID
  **/
-ThreadID getPackerThreadID(Packer *packer);
+ThreadID getPackerThreadID(const Packer *packer);
+
+/**
+ * Get the next packer zone.
+ *
+ * @param packer  The packer
+ *
+ * @return The next packer zone, or NULL if this is the last one
+ **/
+Packer *getNextPacker(const Packer *packer)
+  __attribute__((warn_unused_result));
 
 /**
  * Get the current statistics from the packer.
@@ -109,6 +139,16 @@ void attemptPacking(DataVIO *dataVIO);
  **/
 void flushPacker(Packer *packer);
 
+/**
+ * Request that a packer zone flush, as flushPacker() does, from a thread
+ * other than the packer's own. The flush will be done asynchronously on the
+ * packer's thread. If a previous request has not yet been acted upon, this
+ * request is merged with it.
+ *
+ * @param packer  The packer to flush
+ **/
+void requestPackerFlush(Packer *packer);
+
 /**
  * Remove a lock holder from the packer.
  *
@@ -129,10 +169,12 @@ void incrementPackerFlushGeneration(Packer *packer);
 
 /**
  * Close the packer. Prevent any more VIOs from entering the packer and then
- * flush.
+ * flush. Once this zone has closed, the close is passed on to the next
+ * packer zone, and the completion is finished when the last zone has closed.
  *
  * @param packer            The packer to flush
- * @param completion        The completion to finish when the packer is closed
+ * @param completion        The completion to finish when the packer and all
+ *                          of the zones after it are closed
  **/
 void closePacker(Packer *packer, VDOCompletion *completion);
 
@@ -27,6 +27,7 @@
 #include "atomic.h"
 #include "compressedBlock.h"
 #include "header.h"
+#include "timeUtils.h"
 #include "waitQueue.h"
 
 /**
@@ -41,14 +42,28 @@
  * been canceled and removed from their input bin by the packer. These DataVIOs
  * need to wait for the canceller to rendezvous with them (VDO-2809) and so
  * they sit in this special bin.
+ *
+ * If the packer has a maximum age, a batch which has waited that long for
+ * its bin to fill is released, either to be written as it is, or to have its
+ * DataVIOs written uncompressed.
  **/
 struct inputBin {
   /** List links for Packer.sortedBins */
   RingNode    ring;
   /** The number of items in the bin */
   SlotNumber  slotsUsed;
+  /**
+   * The number of compressed block slots the items need, which is more than
+   * the number of items if any of them leads a multi-block compression unit
+   **/
+  SlotNumber  fragmentSlots;
   /** The number of compressed block bytes remaining in the current batch */
   size_t      freeSpace;
+  /**
+   * When the first DataVIO of the current batch arrived; this is not updated
+   * if that DataVIO is removed, so the batch may be released a little early
+   **/
+  AbsTime     oldestArrival;
   /** The current partial batch of DataVIOs, waiting for more */
   DataVIO    *incoming[];
 };
@@ -62,6 +77,8 @@ struct inputBin {
 typedef struct {
   /** List links for Packer.outputBins */
   RingNode         ring;
+  /** The packer zone which owns the bin */
+  Packer          *packer;
   /** The storage for encoding the compressed block representation */
   CompressedBlock *block;
   /** The AllocatingVIO wrapping the compressed block for writing */
@@ -74,20 +91,52 @@ typedef struct {
 
 /**
  * A counted array holding a batch of DataVIOs that should be packed into an
- * output bin.
+ * output bin. The members of any compression unit in the batch are not in
+ * the array; they follow their leader.
  **/
 typedef struct {
   size_t   slotsUsed;
+  /** The number of DataVIOs in the batch, including unit members */
+  size_t   dataVIOCount;
+  /**
+   * The DataVIO whose compressed data is in each slot, or NULL for the
+   * additional slots of a compression unit
+   **/
   DataVIO *slots[MAX_COMPRESSION_SLOTS];
 } OutputBatch;
 
+enum {
+  /** The number of buckets in the histogram of packer residence times */
+  PACKER_RESIDENCE_BUCKET_COUNT = 6,
+};
+
 struct packer {
+  /** The completion for passing a close request on to the next zone */
+  VDOCompletion   completion;
+  /** The completion for flush requests from other threads */
+  VDOCompletion   flushCompletion;
+  /** Whether a flush request from another thread is outstanding */
+  AtomicBool      flushRequested;
+  /** The completion for releasing bins which have reached the maximum age */
+  VDOCompletion   ageCompletion;
+  /** Whether a check for bins which have reached the maximum age is pending */
+  bool            ageCheckScheduled;
+  /** The longest a bin may wait, in microseconds, or 0 if there is no limit */
+  uint64_t        maxAge;
+  /** How to release a bin which has reached the maximum age */
+  PackerAgePolicy agePolicy;
+  /** The number of this packer zone */
+  ZoneCount       zoneNumber;
+  /** The next packer zone, or NULL if this is the last one */
+  Packer         *nextPacker;
   /** The ID of the packer's callback thread */
   ThreadID        threadID;
   /** A request to close the packer */
   VDOCompletion  *closeRequest;
   /** The number of input bins */
   BlockCount      size;
+  /** Whether compressed blocks have room for the version 2.0 codec table */
+  bool            codecTable;
   /** The block size minus header size */
   size_t          binDataSize;
   /** The number of compression slots */
@@ -120,6 +169,10 @@ struct packer {
   Atomic64        blocksWritten;
   /** Number of DataVIOs that are pending in the packer */
   Atomic64        fragmentsPending;
+  /** Number of bins released because they reached the maximum age */
+  Atomic64        binsAgedOut;
+  /** Histogram of the time DataVIOs waited in input bins */
+  Atomic64        residence[PACKER_RESIDENCE_BUCKET_COUNT];
 
   /** Queue of batched DataVIOs waiting to be packed */
   WaitQueue       batchedDataVIOs;
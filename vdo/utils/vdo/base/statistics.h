@@ -24,7 +24,9 @@
 #include "types.h"
 
 enum {
-  STATISTICS_VERSION = 30,
+  STATISTICS_VERSION = 31,
+  /** The number of logical regions reported in the statistics */
+  COMPRESSION_REGIONS_REPORTED = 16,
 };
 
 typedef struct {
@@ -64,6 +66,25 @@ typedef struct {
   CommitStatistics blocks;
 } RecoveryJournalStatistics;
 
+/**
+ * A histogram of the time compressed fragments spent waiting in packer bins
+ * before being written or released.
+ **/
+typedef struct {
+  /** Number of fragments which waited less than 100 microseconds */
+  uint64_t under100us;
+  /** Number of fragments which waited less than 1 millisecond */
+  uint64_t under1ms;
+  /** Number of fragments which waited less than 10 milliseconds */
+  uint64_t under10ms;
+  /** Number of fragments which waited less than 100 milliseconds */
+  uint64_t under100ms;
+  /** Number of fragments which waited less than 1 second */
+  uint64_t under1s;
+  /** Number of fragments which waited 1 second or more */
+  uint64_t atLeast1s;
+} PackerResidenceStatistics;
+
 /** The statistics for the compressed block packer. */
 typedef struct {
   /** Number of compressed data items written since startup */
@@ -72,8 +93,38 @@ typedef struct {
   uint64_t compressedBlocksWritten;
   /** Number of VIOs that are pending in the packer */
   uint64_t compressedFragmentsInPacker;
+  /** Number of bins released because they reached the maximum age */
+  uint64_t binsAgedOut;
+  /** Time spent by fragments waiting in packer bins */
+  PackerResidenceStatistics residence;
 } PackerStatistics;
 
+/** The compression history of one logical region. */
+typedef struct {
+  /** The index of the region in the table of regions */
+  uint64_t region;
+  /** Number of writes to the region which were eligible for compression */
+  uint64_t hits;
+  /** Number of writes to the region which bypassed compression */
+  uint64_t bypassed;
+  /** Number of writes to the region which compressed well enough to pack */
+  uint64_t compressible;
+} CompressionRegionStatistics;
+
+/** The statistics for skipping compression in poorly compressing regions. */
+typedef struct {
+  /** Number of logical regions currently bypassing compression */
+  uint64_t regionsBypassing;
+  /** Number of times a region began bypassing compression */
+  uint64_t bypassesStarted;
+  /** Number of writes which bypassed compression */
+  uint64_t blocksBypassed;
+  /** Number of writes compressed to probe a bypassing region */
+  uint64_t probes;
+  /** The regions with the most hits, busiest first */
+  CompressionRegionStatistics regions[COMPRESSION_REGIONS_REPORTED];
+} CompressionBypassStatistics;
+
 /** The statistics for the slab journals. */
 typedef struct {
   /** Number of times the on-disk journal was full */
@@ -154,6 +205,10 @@ typedef struct {
   uint64_t concurrentDataMatches;
   /** Number of writes whose hash collided with an in-flight write */
   uint64_t concurrentHashCollisions;
+  /** Number of index queries answered by the advice cache */
+  uint64_t adviceCacheHits;
+  /** Number of index queries which had to be sent to the index */
+  uint64_t adviceCacheMisses;
 } HashLockStatistics;
 
 /** Counts of error conditions in VDO. */
@@ -198,6 +253,8 @@ struct vdoStatistics {
   uint8_t recoveryPercentage;
   /** The statistics for the compressed block packer */
   PackerStatistics packer;
+  /** The statistics for skipping compression in poorly compressing regions */
+  CompressionBypassStatistics compressionBypass;
   /** Counters for events in the block allocator */
   BlockAllocatorStatistics allocator;
   /** Counters for events in the recovery journal */
@@ -31,6 +31,7 @@
 static int allocateThreadConfig(ZoneCount      logicalZoneCount,
                                 ZoneCount      physicalZoneCount,
                                 ZoneCount      hashZoneCount,
+                                ZoneCount      packerZoneCount,
                                 ZoneCount      baseThreadCount,
                                 ThreadConfig **configPtr)
 {
@@ -61,9 +62,17 @@ static int allocateThreadConfig(ZoneCount      logicalZoneCount,
     return result;
   }
 
+  result = ALLOCATE(packerZoneCount, ThreadID, "packer thread array",
+                    &config->packerThreads);
+  if (result != VDO_SUCCESS) {
+    freeThreadConfig(&config);
+    return result;
+  }
+
   config->logicalZoneCount  = logicalZoneCount;
   config->physicalZoneCount = physicalZoneCount;
   config->hashZoneCount     = hashZoneCount;
+  config->packerZoneCount   = packerZoneCount;
   config->baseThreadCount   = baseThreadCount;
 
   *configPtr = config;
@@ -84,6 +93,7 @@ static void assignThreadIDs(ThreadID   threadIDs[],
 int makeThreadConfig(ZoneCount      logicalZoneCount,
                      ZoneCount      physicalZoneCount,
                      ZoneCount      hashZoneCount,
+                     ZoneCount      packerZoneCount,
                      ThreadConfig **configPtr)
 {
   if ((logicalZoneCount == 0)
@@ -106,10 +116,19 @@ int makeThreadConfig(ZoneCount      logicalZoneCount,
                                    logicalZoneCount, MAX_LOGICAL_ZONES);
   }
 
+  if ((packerZoneCount == 0) || (packerZoneCount > MAX_PACKER_ZONES)) {
+    return logErrorWithStringError(VDO_BAD_CONFIGURATION,
+                                   "Packer zone count %u must be between 1 "
+                                   "and %u",
+                                   packerZoneCount, MAX_PACKER_ZONES);
+  }
+
   ThreadConfig *config;
-  ThreadCount total = logicalZoneCount + physicalZoneCount + hashZoneCount + 2;
+  ThreadCount total = (logicalZoneCount + physicalZoneCount + hashZoneCount
+                       + packerZoneCount + 1);
   int result = allocateThreadConfig(logicalZoneCount, physicalZoneCount,
-                                    hashZoneCount, total, &config);
+                                    hashZoneCount, packerZoneCount, total,
+                                    &config);
   if (result != VDO_SUCCESS) {
     return result;
   }
@@ -117,7 +136,7 @@ int makeThreadConfig(ZoneCount      logicalZoneCount,
   ThreadID id = 0;
   config->adminThread   = id;
   config->journalThread = id++;
-  config->packerThread  = id++;
+  assignThreadIDs(config->packerThreads, packerZoneCount, &id);
   assignThreadIDs(config->logicalThreads, logicalZoneCount, &id);
   assignThreadIDs(config->physicalThreads, physicalZoneCount, &id);
   assignThreadIDs(config->hashZoneThreads, hashZoneCount, &id);
@@ -137,9 +156,18 @@ int makeZeroThreadConfig(ThreadConfig **configPtr)
     return result;
   }
 
+  // There is always a packer, even when there are no threads to run it on.
+  result = ALLOCATE(1, ThreadID, "packer thread array",
+                    &config->packerThreads);
+  if (result != VDO_SUCCESS) {
+    freeThreadConfig(&config);
+    return result;
+  }
+
   config->logicalZoneCount  = 0;
   config->physicalZoneCount = 0;
   config->hashZoneCount     = 0;
+  config->packerZoneCount   = 1;
   config->baseThreadCount   = 0;
   *configPtr                = config;
   return VDO_SUCCESS;
@@ -149,7 +177,7 @@ int makeZeroThreadConfig(ThreadConfig **configPtr)
 int makeOneThreadConfig(ThreadConfig **configPtr)
 {
   ThreadConfig *config;
-  int result = allocateThreadConfig(1, 1, 1, 1, &config);
+  int result = allocateThreadConfig(1, 1, 1, 1, 1, &config);
   if (result != VDO_SUCCESS) {
     return result;
   }
@@ -157,6 +185,7 @@ int makeOneThreadConfig(ThreadConfig **configPtr)
   config->logicalThreads[0]  = 0;
   config->physicalThreads[0] = 0;
   config->hashZoneThreads[0] = 0;
+  config->packerThreads[0]   = 0;
   *configPtr = config;
   return VDO_SUCCESS;
 }
@@ -168,6 +197,7 @@ int copyThreadConfig(const ThreadConfig *oldConfig, ThreadConfig **configPtr)
   int result = allocateThreadConfig(oldConfig->logicalZoneCount,
                                     oldConfig->physicalZoneCount,
                                     oldConfig->hashZoneCount,
+                                    oldConfig->packerZoneCount,
                                     oldConfig->baseThreadCount,
                                     &config);
   if (result != VDO_SUCCESS) {
@@ -176,7 +206,6 @@ int copyThreadConfig(const ThreadConfig *oldConfig, ThreadConfig **configPtr)
 
   config->adminThread   = oldConfig->adminThread;
   config->journalThread = oldConfig->journalThread;
-  config->packerThread  = oldConfig->packerThread;
   for (ZoneCount i = 0; i < config->logicalZoneCount; i++) {
     config->logicalThreads[i] = oldConfig->logicalThreads[i];
   }
@@ -186,6 +215,9 @@ int copyThreadConfig(const ThreadConfig *oldConfig, ThreadConfig **configPtr)
   for (ZoneCount i = 0; i < config->hashZoneCount; i++) {
     config->hashZoneThreads[i] = oldConfig->hashZoneThreads[i];
   }
+  for (ZoneCount i = 0; i < config->packerZoneCount; i++) {
+    config->packerThreads[i] = oldConfig->packerThreads[i];
+  }
 
   *configPtr = config;
   return VDO_SUCCESS;
@@ -204,6 +236,7 @@ void freeThreadConfig(ThreadConfig **configPtr)
   FREE(config->logicalThreads);
   FREE(config->physicalThreads);
   FREE(config->hashZoneThreads);
+  FREE(config->packerThreads);
   FREE(config);
 }
 
@@ -243,7 +276,9 @@ void getVDOThreadName(const ThreadConfig *threadConfig,
     // Theoretically this could be different from the journal thread.
     snprintf(buffer, bufferLength, "adminQ");
     return;
-  } else if (threadID == threadConfig->packerThread) {
+  } else if ((threadConfig->packerZoneCount == 1)
+             && (threadID == threadConfig->packerThreads[0])) {
+    // Keep the historical name when there is only one packer zone.
     snprintf(buffer, bufferLength, "packerQ");
     return;
   }
@@ -262,6 +297,11 @@ void getVDOThreadName(const ThreadConfig *threadConfig,
                         threadID, "hashQ", buffer, bufferLength)) {
     return;
   }
+  if (getZoneThreadName(threadConfig->packerThreads,
+                        threadConfig->packerZoneCount,
+                        threadID, "packerQ", buffer, bufferLength)) {
+    return;
+  }
 
   // Some sort of misconfiguration?
   snprintf(buffer, bufferLength, "reqQ%d", threadID);
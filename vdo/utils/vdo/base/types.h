@@ -41,6 +41,17 @@ typedef uint16_t BlockSize;
  **/
 typedef uint8_t CompressedFragmentCount;
 
+/**
+ * The algorithm used to compress a fragment. These values are recorded in
+ * compressed blocks, so existing values must never be changed or reused.
+ **/
+typedef enum {
+  COMPRESSION_CODEC_LZ4     = 0,
+  COMPRESSION_CODEC_DEFLATE = 1,
+  COMPRESSION_CODEC_ZSTD    = 2,
+  COMPRESSION_CODEC_COUNT,
+} CompressionCodec;
+
 /**
  * A CRC-32 checksum
  **/
@@ -266,6 +277,16 @@ typedef enum {
                         ///< underlying device
 } WritePolicy;
 
+/**
+ * The possible ways to release a packer bin which has reached its maximum age.
+ **/
+typedef enum {
+  PACKER_AGE_POLICY_WRITE,         ///< The fragments already in the bin are
+                                   ///< written as a compressed block.
+  PACKER_AGE_POLICY_UNCOMPRESSED,  ///< The fragments in the bin are abandoned
+                                   ///< and their data is written uncompressed.
+} PackerAgePolicy;
+
 typedef enum {
   ZONE_TYPE_JOURNAL,
   ZONE_TYPE_LOGICAL,
@@ -357,6 +378,20 @@ typedef struct vdoLoadConfig {
   WritePolicy           writePolicy;
   /** the maximum age of a dirty block map page in recovery journal blocks */
   BlockCount            maximumAge;
+  /** the maximum time in microseconds a packer bin may wait, 0 for no limit */
+  uint64_t              packerMaxAge;
+  /** how to release a packer bin which has reached the maximum time */
+  PackerAgePolicy       packerAgePolicy;
+  /**
+   * the percentage of recent compression attempts in a logical region which
+   * must fail for writes to the region to skip compression, 0 to never skip
+   **/
+  unsigned int          compressionBypassThreshold;
+  /**
+   * whether compressed blocks may hold fragments other than single LZ4
+   * blocks, and so need room for the version 2.0 codec table
+   **/
+  bool                  compressedCodecTable;
 } VDOLoadConfig;
 
 /**
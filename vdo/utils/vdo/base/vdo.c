@@ -157,14 +157,23 @@ int makeVDO(PhysicalLayer *layer, VDO **vdoPtr)
 void destroyVDO(VDO *vdo)
 {
   freeFlusher(&vdo->flusher);
-  freePacker(&vdo->packer);
+
+  const ThreadConfig *threadConfig = getThreadConfig(vdo);
+  if (vdo->packers != NULL) {
+    for (ZoneCount zone = 0; zone < threadConfig->packerZoneCount; zone++) {
+      freePacker(&vdo->packers[zone]);
+    }
+  }
+  FREE(vdo->packers);
+  vdo->packers = NULL;
+  freeCompressionHistory(&vdo->compressionHistory);
+
   freeRecoveryJournal(&vdo->recoveryJournal);
   freeSlabDepot(&vdo->depot);
   freeVDOLayout(&vdo->layout);
   freeSuperBlock(&vdo->superBlock);
   freeBlockMap(&vdo->blockMap);
 
-  const ThreadConfig *threadConfig = getThreadConfig(vdo);
   if (vdo->hashZones != NULL) {
     for (ZoneCount zone = 0; zone < threadConfig->hashZoneCount; zone++) {
       freeHashZone(&vdo->hashZones[zone]);
@@ -760,9 +769,12 @@ bool setVDOCompressing(VDO *vdo, bool enableCompression)
   bool stateChanged = compareAndSwapBool(&vdo->compressing, !enableCompression,
                                          enableCompression);
   if (stateChanged && !enableCompression) {
-    // Flushing the packer is asynchronous, but we don't care when it
+    // Flushing the packers is asynchronous, but we don't care when it
     // finishes.
-    flushPacker(vdo->packer);
+    const ThreadConfig *threadConfig = getThreadConfig(vdo);
+    for (ZoneCount zone = 0; zone < threadConfig->packerZoneCount; zone++) {
+      requestPackerFlush(vdo->packers[zone]);
+    }
   }
 
   logInfo("compression is %s", (enableCompression ? "enabled" : "disabled"));
@@ -822,6 +834,38 @@ static HashLockStatistics getHashLockStatistics(const VDO *vdo)
     totals.dedupeAdviceStale        += stats.dedupeAdviceStale;
     totals.concurrentDataMatches    += stats.concurrentDataMatches;
     totals.concurrentHashCollisions += stats.concurrentHashCollisions;
+    totals.adviceCacheHits          += stats.adviceCacheHits;
+    totals.adviceCacheMisses        += stats.adviceCacheMisses;
+  }
+
+  return totals;
+}
+
+/**
+ * Tally the packer statistics from all the packer zones.
+ *
+ * @param vdo  The vdo to query
+ *
+ * @return The sum of the packer statistics from all packer zones
+ **/
+static PackerStatistics getVDOPackerStatistics(const VDO *vdo)
+{
+  PackerStatistics totals;
+  memset(&totals, 0, sizeof(totals));
+
+  const ThreadConfig *threadConfig = getThreadConfig(vdo);
+  for (ZoneCount zone = 0; zone < threadConfig->packerZoneCount; zone++) {
+    PackerStatistics stats = getPackerStatistics(vdo->packers[zone]);
+    totals.compressedFragmentsWritten  += stats.compressedFragmentsWritten;
+    totals.compressedBlocksWritten     += stats.compressedBlocksWritten;
+    totals.compressedFragmentsInPacker += stats.compressedFragmentsInPacker;
+    totals.binsAgedOut                 += stats.binsAgedOut;
+    totals.residence.under100us        += stats.residence.under100us;
+    totals.residence.under1ms          += stats.residence.under1ms;
+    totals.residence.under10ms         += stats.residence.under10ms;
+    totals.residence.under100ms        += stats.residence.under100ms;
+    totals.residence.under1s           += stats.residence.under1s;
+    totals.residence.atLeast1s         += stats.residence.atLeast1s;
   }
 
   return totals;
@@ -875,7 +919,9 @@ void getVDOStatistics(const VDO *vdo, VDOStatistics *stats)
   stats->logicalBlocksUsed  = getJournalLogicalBlocksUsed(journal);
   stats->allocator          = getDepotBlockAllocatorStatistics(depot);
   stats->journal            = getRecoveryJournalStatistics(journal);
-  stats->packer             = getPackerStatistics(vdo->packer);
+  stats->packer             = getVDOPackerStatistics(vdo);
+  getCompressionBypassStatistics(vdo->compressionHistory,
+                                 &stats->compressionBypass);
   stats->slabJournal        = getDepotSlabJournalStatistics(depot);
   stats->slabSummary        = getSlabSummaryStatistics(getSlabSummary(depot));
   stats->refCounts          = getDepotRefCountsStatistics(depot);
@@ -987,10 +1033,14 @@ void dumpVDOStatus(const VDO *vdo)
 {
   dumpFlusher(vdo->flusher);
   dumpRecoveryJournalStatistics(vdo->recoveryJournal);
-  dumpPacker(vdo->packer);
   dumpSlabDepot(vdo->depot);
 
   const ThreadConfig *threadConfig = getThreadConfig(vdo);
+  for (ZoneCount zone = 0; zone < threadConfig->packerZoneCount; zone++) {
+    dumpPacker(vdo->packers[zone]);
+  }
+  dumpCompressionHistory(vdo->compressionHistory);
+
   for (ZoneCount zone = 0; zone < threadConfig->logicalZoneCount; zone++) {
     dumpLogicalZone(vdo->logicalZones[zone]);
   }
@@ -1056,6 +1106,18 @@ HashZone *selectHashZone(const VDO *vdo, const UdsChunkName *name)
   return vdo->hashZones[(hash * getThreadConfig(vdo)->hashZoneCount) >> 8];
 }
 
+/**********************************************************************/
+Packer *selectPacker(const VDO *vdo, const UdsChunkName *name)
+{
+  /*
+   * Use a fragment of the chunk name as a hash code, as selectHashZone()
+   * does, but a different byte of it so that the packer zone a block is sent
+   * to is independent of its hash zone.
+   */
+  uint32_t hash = name->name[1];
+  return vdo->packers[(hash * getThreadConfig(vdo)->packerZoneCount) >> 8];
+}
+
 /**********************************************************************/
 int getPhysicalZone(const VDO            *vdo,
                     PhysicalBlockNumber   pbn,
@@ -418,8 +418,42 @@ static int decodeVDO(VDO *vdo, bool validateConfig)
     }
   }
 
-  return makePacker(vdo->layer, DEFAULT_PACKER_INPUT_BINS,
-                    DEFAULT_PACKER_OUTPUT_BINS, threadConfig, &vdo->packer);
+  result = ALLOCATE(threadConfig->packerZoneCount, Packer *, __func__,
+                    &vdo->packers);
+  if (result != VDO_SUCCESS) {
+    return result;
+  }
+
+  // The output bins, and so the number of compressed block writes which may
+  // be outstanding, are divided among the packer zones, while each zone gets
+  // the full number of input bins.
+  BlockCount outputBins
+    = DEFAULT_PACKER_OUTPUT_BINS / threadConfig->packerZoneCount;
+
+  // Allocate in reverse zone number order so we can pass each packer zone's
+  // successor to the zone's constructor.
+  Packer *packer = NULL;
+  for (int index = threadConfig->packerZoneCount - 1; index >= 0; index--) {
+    int result = makePacker(vdo->layer, index, packer,
+                            DEFAULT_PACKER_INPUT_BINS, outputBins,
+                            threadConfig, vdo->loadConfig.packerMaxAge,
+                            vdo->loadConfig.packerAgePolicy,
+                            vdo->loadConfig.compressedCodecTable, &packer);
+    if (result != VDO_SUCCESS) {
+      return result;
+    }
+    vdo->packers[index] = packer;
+  }
+
+  if (vdo->loadConfig.compressionBypassThreshold > 0) {
+    result = makeCompressionHistory(vdo->loadConfig.compressionBypassThreshold,
+                                    &vdo->compressionHistory);
+    if (result != VDO_SUCCESS) {
+      return result;
+    }
+  }
+
+  return VDO_SUCCESS;
 }
 
 /**
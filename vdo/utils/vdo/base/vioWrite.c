@@ -670,6 +670,42 @@ static void addRecoveryJournalEntryForCompression(VDOCompletion *completion)
   journalIncrement(dataVIO, getDuplicateLock(dataVIO));
 }
 
+/**
+ * Prepare the members of the compression unit led by a DataVIO to go to the
+ * packer along with their leader. Members which may no longer be packed are
+ * removed from the unit and sent on to be written uncompressed. If the leader
+ * itself is not going to the packer, all of its members are released. The
+ * result of compressing the unit is recorded for each member's block.
+ *
+ * @param leader       The DataVIO leading the unit
+ * @param compressed   Whether the unit compressed well enough to be packed
+ * @param leaderPacks  Whether the leader is going to the packer
+ **/
+static void prepareCompressionUnit(DataVIO *leader,
+                                   bool     compressed,
+                                   bool     leaderPacks)
+{
+  CompressionHistory *history = getVDOFromDataVIO(leader)->compressionHistory;
+  DataVIO *member = leader->compression.unitNext;
+  while (member != NULL) {
+    DataVIO *next = member->compression.unitNext;
+    recordCompressionResult(history, member->logical.lbn, compressed);
+    if (leaderPacks && mayPackDataVIO(member)) {
+      // Members are packed by the leader's packer zone, whichever zone their
+      // own chunk names select.
+      member->compression.packer = leader->compression.packer;
+      setJournalCallback(member, addRecoveryJournalEntryForCompression,
+                         THIS_LOCATION("$F;cb=update(compress)"));
+      member->lastAsyncOperation = PACK_COMPRESSED_BLOCK;
+    } else {
+      removeFromCompressionUnit(member);
+      setCompressionDone(member);
+      abortDeduplication(member);
+    }
+    member = next;
+  }
+}
+
 /**
  * Attempt to pack the compressed DataVIO into a block. This is the callback
  * registered in compressData().
@@ -684,11 +720,16 @@ static void packCompressedData(VDOCompletion *completion)
   // XXX this is a callback, so there should probably be an error check here
   // even if we think compression can't currently return one.
 
+  bool compressed = isSufficientlyCompressible(dataVIO);
+  recordCompressionResult(getVDOFromDataVIO(dataVIO)->compressionHistory,
+                          dataVIO->logical.lbn, compressed);
   if (!mayPackDataVIO(dataVIO)) {
+    prepareCompressionUnit(dataVIO, compressed, false);
     abortDeduplication(dataVIO);
     return;
   }
 
+  prepareCompressionUnit(dataVIO, compressed, true);
   setJournalCallback(dataVIO, addRecoveryJournalEntryForCompression,
                      THIS_LOCATION("$F;cb=update(compress)"));
   dataVIO->lastAsyncOperation = PACK_COMPRESSED_BLOCK;
@@ -705,7 +746,18 @@ void compressData(DataVIO *dataVIO)
     return;
   }
 
+  VDO *vdo = getVDOFromDataVIO(dataVIO);
+  if (shouldBypassCompression(vdo->compressionHistory,
+                              dataVIO->logical.lbn)) {
+    // Recent writes near this block have not been compressing, so don't
+    // spend the time to compress this one.
+    setCompressionDone(dataVIO);
+    abortDeduplication(dataVIO);
+    return;
+  }
+
   dataVIO->lastAsyncOperation = COMPRESS_DATA;
+  dataVIO->compression.packer = selectPacker(vdo, &dataVIO->chunkName);
   setPackerCallback(dataVIO, packCompressedData, THIS_LOCATION("$F;cb=pack"));
   dataVIOAsCompletion(dataVIO)->layer->compressDataVIO(dataVIO);
 }
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/BlockScan_t1.c#1 $
+ */
+
+/**
+ * Check that a BlockScan copies each block exactly, finds whether it is all
+ * zeroes, and computes the same chunk name as hashing the whole block at
+ * once, however the block is split into segments. The blocks come from a
+ * sample file, with zero prefixes of every length written over some of
+ * them. Then compare the throughput of scanning each block of the sample in
+ * one pass against copying, checking, and hashing it in separate passes.
+ *
+ * Usage: BlockScan_t1 <sample.gz>
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blockScan.h"
+#include "constants.h"
+#include "murmur/MurmurHash3.h"
+#include "numUtils.h"
+#include "xxhash/XXH3.h"
+
+#include "testUtils.h"
+
+enum {
+  /** The size of the sectors a bio is most often split into */
+  SECTOR_SIZE    = 512,
+  /** The number of different splits of each block to check */
+  SPLITS         = 8,
+  /** The minimum time to run each benchmark for, in nanoseconds */
+  BENCHMARK_TIME = 500 * 1000 * 1000,
+};
+
+static const uint32_t SEED = 0x62ea60be;
+
+/**
+ * Hash a whole block at once.
+ *
+ * @param function  The hash function
+ * @param block     The block
+ * @param hash      The 16-byte hash to fill in
+ **/
+static void hashBlock(UdsChunkNameHash  function,
+                      const char       *block,
+                      uint8_t          *hash)
+{
+  if (function == UDS_CHUNK_NAME_XXH3) {
+    XXH3_128bits(block, VDO_BLOCK_SIZE, hash);
+  } else {
+    MurmurHash3_x64_128(block, VDO_BLOCK_SIZE, SEED, hash);
+  }
+}
+
+/**
+ * Scan a block in random segments. Usually every segment is a whole number
+ * of sectors, as it is in a bio; sometimes the segments are any length.
+ *
+ * @param function  The hash function
+ * @param block     The block to scan
+ * @param copy      The buffer to copy the block into
+ * @param hash      The 16-byte hash to fill in
+ *
+ * @return <code>true</code> if the scan found the block to be all zeroes
+ **/
+static bool scanInSegments(UdsChunkNameHash  function,
+                           const char       *block,
+                           char             *copy,
+                           uint8_t          *hash)
+{
+  unsigned int unit = (((nextRandom() % 4) == 0) ? 1 : SECTOR_SIZE);
+  BlockScan scan;
+  startBlockScan(&scan, copy, function, SEED);
+  unsigned int offset = 0;
+  while (offset < VDO_BLOCK_SIZE) {
+    unsigned int units   = (VDO_BLOCK_SIZE - offset) / unit;
+    unsigned int segment = (1 + (nextRandom() % units)) * unit;
+    scanBlockSegment(&scan, block + offset, segment);
+    offset += segment;
+  }
+  return finishBlockScan(&scan, hash);
+}
+
+/**
+ * Check the scans of a block, split in several different ways, against the
+ * block itself.
+ *
+ * @param function  The hash function
+ * @param block     The block
+ **/
+static void checkBlock(UdsChunkNameHash function, const char *block)
+{
+  static char copy[VDO_BLOCK_SIZE];
+  bool    zero = isAllZeros(block, VDO_BLOCK_SIZE);
+  uint8_t expected[16];
+  hashBlock(function, block, expected);
+  for (unsigned int split = 0; split < SPLITS; split++) {
+    memset(copy, 0xff, VDO_BLOCK_SIZE);
+    uint8_t hash[16];
+    CHECK(scanInSegments(function, block, copy, hash) == zero);
+    CHECK(memcmp(copy, block, VDO_BLOCK_SIZE) == 0);
+    CHECK(zero || (memcmp(hash, expected, sizeof(hash)) == 0));
+  }
+}
+
+/**
+ * Check scanning every block of a sample, as well as blocks of zeroes
+ * ending at every offset followed by the rest of a sample block.
+ *
+ * @param function  The hash function
+ * @param data      The sample blocks
+ * @param blocks    The number of sample blocks
+ **/
+static void checkScans(UdsChunkNameHash  function,
+                       const char       *data,
+                       size_t            blocks)
+{
+  for (size_t i = 0; i < blocks; i++) {
+    checkBlock(function, data + (i * VDO_BLOCK_SIZE));
+  }
+
+  static char block[VDO_BLOCK_SIZE];
+  for (unsigned int zeros = 0; zeros <= VDO_BLOCK_SIZE; zeros++) {
+    const char *sample = data + ((zeros % blocks) * VDO_BLOCK_SIZE);
+    memset(block, 0, zeros);
+    memcpy(block + zeros, sample + zeros, VDO_BLOCK_SIZE - zeros);
+    if (zeros < VDO_BLOCK_SIZE) {
+      // Make sure the zeroes end exactly here.
+      block[zeros] |= 1;
+    }
+    checkBlock(function, block);
+  }
+}
+
+/**
+ * Time copying, checking and hashing every block of a sample.
+ *
+ * @param name      The name to report
+ * @param function  The hash function
+ * @param fused     Whether to use a single BlockScan pass rather than
+ *                  separate passes
+ * @param data      The sample blocks
+ * @param blocks    The number of sample blocks
+ **/
+static void benchmarkScan(const char       *name,
+                          UdsChunkNameHash  function,
+                          bool              fused,
+                          const char       *data,
+                          size_t            blocks)
+{
+  static char copy[VDO_BLOCK_SIZE];
+  uint8_t  hash[16];
+  uint64_t zeroBlocks = 0;
+  uint64_t scans      = 0;
+  uint64_t start      = nowNanoseconds();
+  uint64_t elapsed;
+  do {
+    for (size_t i = 0; i < blocks; i++) {
+      const char *block = data + (i * VDO_BLOCK_SIZE);
+      // Keep the compiler from hoisting any of the work out of the loop.
+      __asm__ __volatile__("" : : : "memory");
+      if (fused) {
+        BlockScan scan;
+        startBlockScan(&scan, copy, function, SEED);
+        scanBlockSegment(&scan, block, VDO_BLOCK_SIZE);
+        zeroBlocks += finishBlockScan(&scan, hash);
+      } else {
+        memcpy(copy, block, VDO_BLOCK_SIZE);
+        if (isAllZeros(copy, VDO_BLOCK_SIZE)) {
+          zeroBlocks++;
+        } else {
+          hashBlock(function, copy, hash);
+        }
+      }
+    }
+    scans += blocks;
+    elapsed = nowNanoseconds() - start;
+  } while (elapsed < BENCHMARK_TIME);
+  CHECK(zeroBlocks < scans);
+  reportRate(name, scans, scans * VDO_BLOCK_SIZE, elapsed);
+}
+
+/**********************************************************************/
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <sample.gz>\n", argv[0]);
+    return 2;
+  }
+
+  char   *data;
+  size_t  blocks;
+  readSampleBlocks(argv[1], VDO_BLOCK_SIZE, &data, &blocks);
+  CHECK(blocks > 0);
+
+  checkScans(UDS_CHUNK_NAME_MURMUR3, data, blocks);
+  checkScans(UDS_CHUNK_NAME_XXH3, data, blocks);
+  printf("BlockScan_t1: %zu sample and %u zero-prefixed blocks match\n",
+         blocks, VDO_BLOCK_SIZE + 1);
+
+  benchmarkScan("MurmurHash3, separate passes", UDS_CHUNK_NAME_MURMUR3, false,
+                data, blocks);
+  benchmarkScan("MurmurHash3, BlockScan", UDS_CHUNK_NAME_MURMUR3, true, data,
+                blocks);
+  benchmarkScan("XXH3, separate passes", UDS_CHUNK_NAME_XXH3, false, data,
+                blocks);
+  benchmarkScan("XXH3, BlockScan", UDS_CHUNK_NAME_XXH3, true, data, blocks);
+
+  free(data);
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/CompressionHistory_t1.c#1 $
+ */
+
+/**
+ * Check that a compression history starts bypassing a region which stops
+ * compressing, and that it counts the hits, bypasses and compressible writes
+ * of each region in its statistics.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "compressionHistory.h"
+#include "constants.h"
+#include "statusCodes.h"
+
+#include "testUtils.h"
+
+enum {
+  THRESHOLD            = 50,
+  INCOMPRESSIBLE_HITS  = 256,
+  COMPRESSIBLE_HITS    = 300,
+  COMPRESSIBLE_REGION  = 5,
+};
+
+/**
+ * Write to a region a number of times, recording the given result for every
+ * write which is not bypassed.
+ *
+ * @param history     The compression history
+ * @param region      The region to write to
+ * @param writes      The number of writes
+ * @param compressed  Whether the writes which are compressed compress
+ *
+ * @return The number of writes which bypassed compression
+ **/
+static uint64_t writeRegion(CompressionHistory *history,
+                            unsigned int        region,
+                            unsigned int        writes,
+                            bool                compressed)
+{
+  uint64_t bypassed = 0;
+  for (unsigned int i = 0; i < writes; i++) {
+    LogicalBlockNumber lbn = ((region * BLOCK_MAP_ENTRIES_PER_PAGE)
+                              + (nextRandom() % BLOCK_MAP_ENTRIES_PER_PAGE));
+    if (shouldBypassCompression(history, lbn)) {
+      bypassed++;
+    } else {
+      recordCompressionResult(history, lbn, compressed);
+    }
+  }
+  return bypassed;
+}
+
+/**********************************************************************/
+int main(int argc __attribute__((unused)),
+         char *argv[] __attribute__((unused)))
+{
+  CompressionHistory *history;
+  CHECK(makeCompressionHistory(THRESHOLD, &history) == VDO_SUCCESS);
+
+  uint64_t bypassed = writeRegion(history, 0, INCOMPRESSIBLE_HITS, false);
+  CHECK(bypassed > 0);
+  CHECK(writeRegion(history, COMPRESSIBLE_REGION, COMPRESSIBLE_HITS, true)
+        == 0);
+
+  CompressionBypassStatistics stats;
+  getCompressionBypassStatistics(history, &stats);
+  CHECK(stats.regionsBypassing == 1);
+  CHECK(stats.bypassesStarted == 1);
+  CHECK(stats.blocksBypassed == bypassed);
+  CHECK(stats.probes > 0);
+
+  // The busiest region is reported first.
+  CHECK(stats.regions[0].region == COMPRESSIBLE_REGION);
+  CHECK(stats.regions[0].hits == COMPRESSIBLE_HITS);
+  CHECK(stats.regions[0].bypassed == 0);
+  CHECK(stats.regions[0].compressible == COMPRESSIBLE_HITS);
+
+  CHECK(stats.regions[1].region == 0);
+  CHECK(stats.regions[1].hits == INCOMPRESSIBLE_HITS);
+  CHECK(stats.regions[1].bypassed == bypassed);
+  CHECK(stats.regions[1].compressible == 0);
+
+  // Regions which have never been written are not reported.
+  for (unsigned int i = 2; i < COMPRESSION_REGIONS_REPORTED; i++) {
+    CHECK(stats.regions[i].hits == 0);
+  }
+
+  // The statistics of a missing history are all zero.
+  getCompressionBypassStatistics(NULL, &stats);
+  CHECK(stats.regions[0].hits == 0);
+
+  printf("CompressionHistory_t1: %" PRIu64 " of %u writes bypassed\n",
+         bypassed, INCOMPRESSIBLE_HITS);
+  freeCompressionHistory(&history);
+  return 0;
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/CompressionUnit_t1.c#1 $
+ */
+
+/**
+ * Check that compressed blocks holding multi-block compression units, whose
+ * extra blocks are recorded as continuation slots in the version 2.0 codec
+ * table, decode back to the data which was packed into them.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compressedBlock.h"
+#include "constants.h"
+#include "lz4.h"
+#include "statusCodes.h"
+
+#include "testUtils.h"
+
+enum {
+  MAX_UNIT_BLOCKS = 4,
+  TRIALS          = 20000,
+};
+
+typedef struct {
+  /** The slot holding the unit's data */
+  unsigned int head;
+  /** The number of blocks in the unit */
+  unsigned int blocks;
+  /** The uncompressed blocks of the unit */
+  char         data[MAX_UNIT_BLOCKS * VDO_BLOCK_SIZE];
+} PackedUnit;
+
+static void *lz4Context;
+
+/**
+ * Fill a block with data which compresses well but not trivially: a few
+ * random runs scattered over a repeating pattern.
+ *
+ * @param block  The block to fill
+ **/
+static void fillBlock(char *block)
+{
+  byte pattern = nextRandom();
+  for (unsigned int i = 0; i < VDO_BLOCK_SIZE; i++) {
+    block[i] = pattern + (i % 7);
+  }
+
+  unsigned int runs = 1 + (nextRandom() % 4);
+  for (unsigned int run = 0; run < runs; run++) {
+    unsigned int offset = nextRandom() % (VDO_BLOCK_SIZE - 32);
+    for (unsigned int i = 0; i < 32; i++) {
+      block[offset + i] = nextRandom();
+    }
+  }
+}
+
+/**
+ * Check that every block of a unit can be found from its own slot.
+ *
+ * @param buffer  The compressed block, as it would be written
+ * @param unit    The unit to check
+ **/
+static void checkUnit(char *buffer, const PackedUnit *unit)
+{
+  static char uncompressed[MAX_UNIT_BLOCKS * VDO_BLOCK_SIZE];
+  for (unsigned int i = 0; i < unit->blocks; i++) {
+    CompressedFragment fragment;
+    int result = getCompressedBlockFragment(getStateForSlot(unit->head + i),
+                                            buffer, VDO_BLOCK_SIZE,
+                                            &fragment);
+    CHECK(result == VDO_SUCCESS);
+    CHECK(fragment.codec == COMPRESSION_CODEC_LZ4);
+    CHECK(fragment.unitBlocks == unit->blocks);
+    CHECK(fragment.unitIndex == i);
+
+    int size = LZ4_uncompress_unknownOutputSize(buffer + fragment.offset,
+                                                uncompressed, fragment.size,
+                                                sizeof(uncompressed));
+    CHECK(size == (int) (unit->blocks * VDO_BLOCK_SIZE));
+    CHECK(memcmp(uncompressed + (fragment.unitIndex * VDO_BLOCK_SIZE),
+                 unit->data + (i * VDO_BLOCK_SIZE), VDO_BLOCK_SIZE) == 0);
+  }
+}
+
+/**
+ * Pack a compressed block with units of random sizes, then check that each
+ * slot decodes to its own block.
+ *
+ * @param buffer     A buffer big enough for a CompressedBlock being packed
+ * @param units      Space for the units packed
+ * @param maxBlocks  The largest unit to pack
+ *
+ * @return Whether the block held any multi-block unit
+ **/
+static bool packAndCheck(char         *buffer,
+                         PackedUnit   *units,
+                         unsigned int  maxBlocks)
+{
+  static char compressed[MAX_UNIT_BLOCKS * VDO_BLOCK_SIZE];
+  CompressedBlock *block    = (CompressedBlock *) buffer;
+  size_t           capacity = VDO_BLOCK_SIZE - sizeof(CompressedBlock);
+  size_t           used     = 0;
+  unsigned int     count    = 0;
+  bool             hasUnits = false;
+
+  resetCompressedBlock(block);
+  for (unsigned int slot = 0; slot < MAX_COMPRESSION_SLOTS;) {
+    PackedUnit *unit = &units[count];
+    unit->head   = slot;
+    unit->blocks = 1 + (nextRandom() % maxBlocks);
+    if (unit->blocks > MAX_COMPRESSION_SLOTS - slot) {
+      unit->blocks = MAX_COMPRESSION_SLOTS - slot;
+    }
+    for (unsigned int i = 0; i < unit->blocks; i++) {
+      fillBlock(unit->data + (i * VDO_BLOCK_SIZE));
+    }
+
+    int size = LZ4_compress_ctx_limitedOutput(lz4Context, unit->data,
+                                              compressed,
+                                              unit->blocks * VDO_BLOCK_SIZE,
+                                              capacity - used);
+    if (size <= 0) {
+      break;
+    }
+
+    putCompressedBlockFragment(block, slot, used, compressed, size,
+                               COMPRESSION_CODEC_LZ4);
+    for (unsigned int i = 1; i < unit->blocks; i++) {
+      putCompressedBlockContinuation(block, slot + i);
+    }
+    hasUnits = hasUnits || (unit->blocks > 1);
+    used += size;
+    slot += unit->blocks;
+    count++;
+  }
+
+  finishCompressedBlock(block, used);
+  // Anything past the first block is never written.
+  memset(buffer + VDO_BLOCK_SIZE, 0xff, sizeof(CompressedBlock));
+
+  CHECK(count > 0);
+  for (unsigned int i = 0; i < count; i++) {
+    checkUnit(buffer, &units[i]);
+  }
+
+  return hasUnits;
+}
+
+/**
+ * Check that slots which do not describe a valid unit are rejected.
+ *
+ * @param buffer  A buffer big enough for a CompressedBlock being packed
+ **/
+static void checkInvalidUnits(char *buffer)
+{
+  CompressedBlock *block = (CompressedBlock *) buffer;
+  CompressedFragment fragment;
+  char data[16];
+  memset(data, 0, sizeof(data));
+
+  // A continuation with no unit before it.
+  resetCompressedBlock(block);
+  putCompressedBlockContinuation(block, 0);
+  putCompressedBlockFragment(block, 1, 0, data, sizeof(data),
+                             COMPRESSION_CODEC_LZ4);
+  finishCompressedBlock(block, sizeof(data));
+  CHECK(getCompressedBlockFragment(getStateForSlot(0), buffer,
+                                   VDO_BLOCK_SIZE, &fragment)
+        == VDO_INVALID_FRAGMENT);
+  CHECK(getCompressedBlockFragment(getStateForSlot(1), buffer,
+                                   VDO_BLOCK_SIZE, &fragment)
+        == VDO_SUCCESS);
+
+  // A continuation which claims data of its own.
+  resetCompressedBlock(block);
+  putCompressedBlockFragment(block, 0, 0, data, sizeof(data),
+                             COMPRESSION_CODEC_LZ4);
+  putCompressedBlockContinuation(block, 1);
+  block->header.fields.sizes[1][0] = 1;
+  finishCompressedBlock(block, sizeof(data));
+  CHECK(getCompressedBlockFragment(getStateForSlot(1), buffer,
+                                   VDO_BLOCK_SIZE, &fragment)
+        == VDO_INVALID_FRAGMENT);
+
+  // A unit running up to the last slot.
+  resetCompressedBlock(block);
+  unsigned int last = MAX_COMPRESSION_SLOTS - 1;
+  putCompressedBlockFragment(block, last - 1, 0, data, sizeof(data),
+                             COMPRESSION_CODEC_LZ4);
+  putCompressedBlockContinuation(block, last);
+  finishCompressedBlock(block, sizeof(data));
+  CHECK(getCompressedBlockFragment(getStateForSlot(last), buffer,
+                                   VDO_BLOCK_SIZE, &fragment)
+        == VDO_SUCCESS);
+  CHECK((fragment.unitBlocks == 2) && (fragment.unitIndex == 1));
+}
+
+/**********************************************************************/
+int main(int argc __attribute__((unused)),
+         char *argv[] __attribute__((unused)))
+{
+  lz4Context = malloc(LZ4_context_size());
+  char       *buffer = malloc(2 * VDO_BLOCK_SIZE);
+  PackedUnit *units  = malloc(MAX_COMPRESSION_SLOTS * sizeof(PackedUnit));
+  CHECK((lz4Context != NULL) && (buffer != NULL) && (units != NULL));
+
+  // Blocks of single fragments only are written in the version 1.0 format,
+  // and must still decode as units of one block.
+  for (unsigned int trial = 0; trial < TRIALS / 10; trial++) {
+    CHECK(!packAndCheck(buffer, units, 1));
+  }
+
+  unsigned int withUnits = 0;
+  for (unsigned int trial = 0; trial < TRIALS; trial++) {
+    withUnits += packAndCheck(buffer, units, MAX_UNIT_BLOCKS);
+  }
+  CHECK(withUnits > 0);
+
+  checkInvalidUnits(buffer);
+
+  printf("CompressionUnit_t1: %u blocks packed, %u with multi-block units\n",
+         TRIALS + (TRIALS / 10), withUnits);
+  free(units);
+  free(buffer);
+  free(lz4Context);
+  return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/Deflate_t1.c#1 $
+ */
+
+/**
+ * Round-trip every block of a sample file through deflateCompress() and
+ * deflateUncompress(), and report the throughput of each. Since the streams
+ * must be interchangeable with other raw deflate implementations, each block
+ * is also checked against zlib in both directions: zlib must inflate what
+ * deflateCompress() produced, and deflateUncompress() must inflate what zlib
+ * produced at every level, including stored and dynamic Huffman blocks,
+ * and streams which mix all three kinds of block.
+ *
+ * Usage: Deflate_t1 <sample.gz>
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "constants.h"
+#include "deflate.h"
+
+#include "testUtils.h"
+
+enum {
+  /** The size of a compression unit of adjacent blocks to try as well */
+  UNIT_SIZE = 4 * VDO_BLOCK_SIZE,
+};
+
+/**
+ * Compress a buffer into a raw deflate stream with zlib.
+ *
+ * @param level            The zlib compression level
+ * @param source           The data to compress
+ * @param sourceSize       The size of the data
+ * @param destination      The buffer to hold the compressed data
+ * @param destinationSize  The size of the destination buffer
+ *
+ * @return The size of the compressed data
+ **/
+static int zlibCompress(int         level,
+                        const char *source,
+                        int         sourceSize,
+                        char       *destination,
+                        int         destinationSize)
+{
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  CHECK(deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) == Z_OK);
+  stream.next_in   = (Bytef *) (uintptr_t) source;
+  stream.avail_in  = sourceSize;
+  stream.next_out  = (Bytef *) destination;
+  stream.avail_out = destinationSize;
+  CHECK(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+  int size = stream.total_out;
+  deflateEnd(&stream);
+  return size;
+}
+
+/**
+ * Compress adjacent blocks into a single raw deflate stream with zlib,
+ * ending a deflate block after each and cycling through stored, dynamic
+ * Huffman, and fixed Huffman blocks, so that a block of each kind is
+ * followed by one of another kind.
+ *
+ * @param source           The data to compress
+ * @param blockCount       The number of blocks of data
+ * @param destination      The buffer to hold the compressed data
+ * @param destinationSize  The size of the destination buffer
+ *
+ * @return The size of the compressed data
+ **/
+static int zlibCompressMixed(const char *source,
+                             int         blockCount,
+                             char       *destination,
+                             int         destinationSize)
+{
+  static const int LEVELS[]     = { 0, 6, 6 };
+  static const int STRATEGIES[] = { Z_DEFAULT_STRATEGY, Z_DEFAULT_STRATEGY,
+                                    Z_FIXED };
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  CHECK(deflateInit2(&stream, LEVELS[0], Z_DEFLATED, -MAX_WBITS, 8,
+                     STRATEGIES[0]) == Z_OK);
+  stream.next_out  = (Bytef *) destination;
+  stream.avail_out = destinationSize;
+  for (int i = 0; i < blockCount; i++) {
+    if (i > 0) {
+      CHECK(deflateParams(&stream, LEVELS[i % 3], STRATEGIES[i % 3])
+            == Z_OK);
+    }
+    stream.next_in  = (Bytef *) (uintptr_t) (source + (i * VDO_BLOCK_SIZE));
+    stream.avail_in = VDO_BLOCK_SIZE;
+    if (i < blockCount - 1) {
+      CHECK(deflate(&stream, Z_BLOCK) == Z_OK);
+      CHECK(stream.avail_in == 0);
+    } else {
+      CHECK(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+    }
+  }
+  int size = stream.total_out;
+  deflateEnd(&stream);
+  return size;
+}
+
+/**
+ * Uncompress a raw deflate stream with zlib.
+ *
+ * @param source           The compressed data
+ * @param sourceSize       The size of the compressed data
+ * @param destination      The buffer to hold the uncompressed data
+ * @param destinationSize  The size of the destination buffer
+ *
+ * @return The size of the uncompressed data
+ **/
+static int zlibUncompress(const char *source,
+                          int         sourceSize,
+                          char       *destination,
+                          int         destinationSize)
+{
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  CHECK(inflateInit2(&stream, -MAX_WBITS) == Z_OK);
+  stream.next_in   = (Bytef *) (uintptr_t) source;
+  stream.avail_in  = sourceSize;
+  stream.next_out  = (Bytef *) destination;
+  stream.avail_out = destinationSize;
+  CHECK(inflate(&stream, Z_FINISH) == Z_STREAM_END);
+  int size = stream.total_out;
+  inflateEnd(&stream);
+  return size;
+}
+
+/**********************************************************************/
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <sample.gz>\n", argv[0]);
+    return 2;
+  }
+
+  char   *data;
+  size_t  blocks;
+  readSampleBlocks(argv[1], VDO_BLOCK_SIZE, &data, &blocks);
+
+  void *deflateContext = malloc(getDeflateContextSize());
+  void *inflateContext = malloc(getInflateContextSize());
+  char *compressed     = malloc(2 * UNIT_SIZE);
+  char *uncompressed   = malloc(UNIT_SIZE);
+  int  *sizes          = malloc(blocks * sizeof(int));
+  char *streams        = malloc(blocks * VDO_BLOCK_SIZE);
+  CHECK((deflateContext != NULL) && (inflateContext != NULL)
+        && (compressed != NULL) && (uncompressed != NULL)
+        && (sizes != NULL) && (streams != NULL));
+
+  // Compress every block as the compressor would, into at most a block.
+  uint64_t compressedBytes = 0;
+  size_t   compressible    = 0;
+  uint64_t start           = nowNanoseconds();
+  for (size_t i = 0; i < blocks; i++) {
+    sizes[i] = deflateCompress(deflateContext, data + (i * VDO_BLOCK_SIZE),
+                               VDO_BLOCK_SIZE, streams + (i * VDO_BLOCK_SIZE),
+                               VDO_BLOCK_SIZE);
+    CHECK((sizes[i] >= 0) && (sizes[i] <= VDO_BLOCK_SIZE));
+    if (sizes[i] > 0) {
+      compressedBytes += sizes[i];
+      compressible++;
+    }
+  }
+  uint64_t compressTime = nowNanoseconds() - start;
+  CHECK(compressible > 0);
+
+  start = nowNanoseconds();
+  for (size_t i = 0; i < blocks; i++) {
+    if (sizes[i] == 0) {
+      continue;
+    }
+    int size = deflateUncompress(inflateContext,
+                                 streams + (i * VDO_BLOCK_SIZE), sizes[i],
+                                 uncompressed, VDO_BLOCK_SIZE);
+    CHECK(size == VDO_BLOCK_SIZE);
+    CHECK(memcmp(uncompressed, data + (i * VDO_BLOCK_SIZE),
+                 VDO_BLOCK_SIZE) == 0);
+  }
+  uint64_t uncompressTime = nowNanoseconds() - start;
+
+  // Check interchangeability with zlib, block by block.
+  for (size_t i = 0; i < blocks; i++) {
+    const char *block = data + (i * VDO_BLOCK_SIZE);
+    if (sizes[i] > 0) {
+      CHECK(zlibUncompress(streams + (i * VDO_BLOCK_SIZE), sizes[i],
+                           uncompressed, VDO_BLOCK_SIZE) == VDO_BLOCK_SIZE);
+      CHECK(memcmp(uncompressed, block, VDO_BLOCK_SIZE) == 0);
+    }
+
+    for (int level = 0; level <= 9; level++) {
+      int size = zlibCompress(level, block, VDO_BLOCK_SIZE, compressed,
+                              2 * UNIT_SIZE);
+      CHECK(deflateUncompress(inflateContext, compressed, size, uncompressed,
+                              VDO_BLOCK_SIZE) == VDO_BLOCK_SIZE);
+      CHECK(memcmp(uncompressed, block, VDO_BLOCK_SIZE) == 0);
+      // A destination one byte short must be refused, not overrun.
+      CHECK(deflateUncompress(inflateContext, compressed, size, uncompressed,
+                              VDO_BLOCK_SIZE - 1) < 0);
+    }
+  }
+
+  // Round-trip runs of adjacent blocks, as compression units would be.
+  for (size_t i = 0; (i + (UNIT_SIZE / VDO_BLOCK_SIZE)) <= blocks; i++) {
+    const char *unit = data + (i * VDO_BLOCK_SIZE);
+    int size = deflateCompress(deflateContext, unit, UNIT_SIZE, compressed,
+                               2 * UNIT_SIZE);
+    CHECK(size > 0);
+    CHECK(deflateUncompress(inflateContext, compressed, size, uncompressed,
+                            UNIT_SIZE) == UNIT_SIZE);
+    CHECK(memcmp(uncompressed, unit, UNIT_SIZE) == 0);
+
+    // Blocks after a stored block must decode as well as the first.
+    size = zlibCompressMixed(unit, UNIT_SIZE / VDO_BLOCK_SIZE, compressed,
+                             2 * UNIT_SIZE);
+    CHECK(deflateUncompress(inflateContext, compressed, size, uncompressed,
+                            UNIT_SIZE) == UNIT_SIZE);
+    CHECK(memcmp(uncompressed, unit, UNIT_SIZE) == 0);
+  }
+
+  printf("Deflate_t1: %zu blocks, %zu compressible, ratio %.3f\n", blocks,
+         compressible,
+         (double) compressedBytes / ((double) compressible * VDO_BLOCK_SIZE));
+  reportRate("deflateCompress", blocks, blocks * VDO_BLOCK_SIZE,
+             compressTime);
+  reportRate("deflateUncompress", compressible,
+             compressible * VDO_BLOCK_SIZE, uncompressTime);
+
+  free(streams);
+  free(sizes);
+  free(uncompressed);
+  free(compressed);
+  free(inflateContext);
+  free(deflateContext);
+  free(data);
+  return 0;
+}
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/DeltaIndex_t1.c#1 $
+ */
+
+/**
+ * Check that getDeltaIndexEntry(), which skips through a delta list with
+ * skipDeltaEntries(), finds exactly the entry that stepping through the list
+ * with nextDeltaIndexEntry() finds, and compare the speed of the two.
+ *
+ * A delta index is populated with random entries, some of them collisions.
+ * Each search is run both ways from the same saved list offset, and the
+ * resulting entries and saved offsets are compared field by field.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "deltaIndex.h"
+#include "errors.h"
+
+#include "testUtils.h"
+
+enum {
+  NUM_LISTS        = 1024,
+  MEAN_DELTA       = 4096,
+  PAYLOAD_BITS     = 10,
+  ENTRIES          = 256 * 1024,
+  /** The range of keys in each list */
+  KEY_RANGE        = (ENTRIES / NUM_LISTS) * MEAN_DELTA,
+  /** One insert in this many collides with the previous one in its list */
+  COLLISION_RATE   = 32,
+  MEMORY_SIZE      = 16 * 1024 * 1024,
+  SEARCHES         = 1000000,
+  /** How long to run each benchmark, in nanoseconds */
+  BENCHMARK_TIME   = 500 * 1000 * 1000,
+};
+
+typedef struct {
+  unsigned int list;
+  unsigned int key;
+  byte         name[COLLISION_BYTES];
+} Record;
+
+typedef int Search(const DeltaIndex *deltaIndex,
+                   unsigned int      listNumber,
+                   unsigned int      key,
+                   const byte       *name,
+                   DeltaIndexEntry  *deltaEntry);
+
+static Record records[ENTRIES];
+
+/**
+ * Search a delta list the way getDeltaIndexEntry() did before it could skip
+ * entries: one nextDeltaIndexEntry() call at a time.
+ *
+ * @param deltaIndex  The delta index
+ * @param listNumber  The delta list to search
+ * @param key         The key to search for
+ * @param name        The name to match among collisions
+ * @param deltaEntry  The entry to fill in
+ *
+ * @return UDS_SUCCESS or an error
+ **/
+static int stepToEntry(const DeltaIndex *deltaIndex,
+                       unsigned int      listNumber,
+                       unsigned int      key,
+                       const byte       *name,
+                       DeltaIndexEntry  *deltaEntry)
+{
+  int result = startDeltaIndexSearch(deltaIndex, listNumber, key, false,
+                                     deltaEntry);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+  do {
+    result = nextDeltaIndexEntry(deltaEntry);
+    if (result != UDS_SUCCESS) {
+      return result;
+    }
+  } while (!deltaEntry->atEnd && (key > deltaEntry->key));
+
+  result = rememberDeltaIndexOffset(deltaEntry);
+  if (result != UDS_SUCCESS) {
+    return result;
+  }
+
+  if (!deltaEntry->atEnd && (key == deltaEntry->key)) {
+    DeltaIndexEntry collisionEntry = *deltaEntry;
+    for (;;) {
+      result = nextDeltaIndexEntry(&collisionEntry);
+      if (result != UDS_SUCCESS) {
+        return result;
+      }
+      if (collisionEntry.atEnd || !collisionEntry.isCollision) {
+        break;
+      }
+      byte collisionName[COLLISION_BYTES];
+      result = getDeltaEntryCollision(&collisionEntry, collisionName);
+      if (result != UDS_SUCCESS) {
+        return result;
+      }
+      if (memcmp(collisionName, name, COLLISION_BYTES) == 0) {
+        *deltaEntry = collisionEntry;
+        break;
+      }
+    }
+  }
+  return UDS_SUCCESS;
+}
+
+/**********************************************************************/
+static int skipToEntry(const DeltaIndex *deltaIndex,
+                       unsigned int      listNumber,
+                       unsigned int      key,
+                       const byte       *name,
+                       DeltaIndexEntry  *deltaEntry)
+{
+  return getDeltaIndexEntry(deltaIndex, listNumber, key, name, false,
+                            deltaEntry);
+}
+
+/**
+ * Fill a name with random bytes.
+ *
+ * @param name  The name to fill
+ **/
+static void randomName(byte *name)
+{
+  for (unsigned int i = 0; i < COLLISION_BYTES; i++) {
+    name[i] = nextRandom();
+  }
+}
+
+/**
+ * Populate a delta index with random entries.
+ *
+ * @param deltaIndex  The delta index to populate
+ *
+ * @return The number of collision entries added
+ **/
+static unsigned int populateIndex(DeltaIndex *deltaIndex)
+{
+  unsigned int collisions = 0;
+  for (unsigned int i = 0; i < ENTRIES; i++) {
+    Record *record = &records[i];
+    record->list = nextRandom() % NUM_LISTS;
+    record->key  = nextRandom() % KEY_RANGE;
+    if ((i > 0) && ((nextRandom() % COLLISION_RATE) == 0)) {
+      record->list = records[i - 1].list;
+      record->key  = records[i - 1].key;
+    }
+    randomName(record->name);
+
+    DeltaIndexEntry entry;
+    CHECK(getDeltaIndexEntry(deltaIndex, record->list, record->key,
+                             record->name, false, &entry)
+          == UDS_SUCCESS);
+    bool collides = (!entry.atEnd && (entry.key == record->key));
+    CHECK(putDeltaIndexEntry(&entry, record->key,
+                             nextRandom() % (1 << PAYLOAD_BITS),
+                             (collides ? record->name : NULL))
+          == UDS_SUCCESS);
+    if (collides) {
+      collisions++;
+    }
+  }
+  return collisions;
+}
+
+/**
+ * Check that two searches found the same entry.
+ *
+ * @param expected  The entry found by stepping through the list
+ * @param actual    The entry found by skipping through it
+ **/
+static void checkSameEntry(const DeltaIndexEntry *expected,
+                           const DeltaIndexEntry *actual)
+{
+  CHECK(expected->key == actual->key);
+  CHECK(expected->atEnd == actual->atEnd);
+  CHECK(expected->isCollision == actual->isCollision);
+  CHECK(expected->listOverflow == actual->listOverflow);
+  CHECK(expected->valueBits == actual->valueBits);
+  CHECK(expected->entryBits == actual->entryBits);
+  CHECK(expected->deltaZone == actual->deltaZone);
+  CHECK(expected->deltaList == actual->deltaList);
+  CHECK(expected->listNumber == actual->listNumber);
+  CHECK(expected->offset == actual->offset);
+  CHECK(expected->delta == actual->delta);
+  if (!expected->atEnd) {
+    CHECK(getDeltaEntryValue(expected) == getDeltaEntryValue(actual));
+  }
+}
+
+/**
+ * Search the index both ways for existing and random keys, from the same
+ * saved list offsets, and check that the results match.
+ *
+ * @param deltaIndex  The delta index
+ * @param searches    The number of searches
+ **/
+static void checkSearches(const DeltaIndex *deltaIndex, unsigned int searches)
+{
+  for (unsigned int i = 0; i < searches; i++) {
+    unsigned int list;
+    unsigned int key;
+    byte         name[COLLISION_BYTES];
+    if ((nextRandom() % 2) == 0) {
+      const Record *record = &records[nextRandom() % ENTRIES];
+      list = record->list;
+      key  = record->key;
+      memcpy(name, record->name, COLLISION_BYTES);
+    } else {
+      list = nextRandom() % NUM_LISTS;
+      key  = nextRandom() % (KEY_RANGE + MEAN_DELTA);
+      randomName(name);
+    }
+
+    // Find the list header, and save where its last search stopped.
+    DeltaIndexEntry expected;
+    memset(&expected, 0, sizeof(expected));
+    CHECK(startDeltaIndexSearch(deltaIndex, list, 0, false, &expected)
+          == UDS_SUCCESS);
+    DeltaList *deltaList = expected.deltaList;
+    DeltaList  saved     = *deltaList;
+
+    CHECK(stepToEntry(deltaIndex, list, key, name, &expected)
+          == UDS_SUCCESS);
+    DeltaList stepped = *deltaList;
+
+    *deltaList = saved;
+    DeltaIndexEntry actual;
+    memset(&actual, 0, sizeof(actual));
+    CHECK(skipToEntry(deltaIndex, list, key, name, &actual) == UDS_SUCCESS);
+    checkSameEntry(&expected, &actual);
+    CHECK(deltaList->saveKey == stepped.saveKey);
+    CHECK(deltaList->saveOffset == stepped.saveOffset);
+  }
+}
+
+/**
+ * Measure how fast a search finds random keys.
+ *
+ * @param label       The name to report
+ * @param search      The search function
+ * @param deltaIndex  The delta index
+ **/
+static void benchmarkSearch(const char       *label,
+                            Search           *search,
+                            const DeltaIndex *deltaIndex)
+{
+  byte     name[COLLISION_BYTES];
+  uint64_t found    = 0;
+  uint64_t searches = 0;
+  uint64_t start    = nowNanoseconds();
+  uint64_t elapsed;
+  memset(name, 0, sizeof(name));
+  do {
+    for (unsigned int i = 0; i < 10000; i++) {
+      DeltaIndexEntry entry;
+      CHECK(search(deltaIndex, nextRandom() % NUM_LISTS,
+                   nextRandom() % KEY_RANGE, name, &entry)
+            == UDS_SUCCESS);
+      found += entry.atEnd ? 0 : 1;
+    }
+    searches += 10000;
+    elapsed = nowNanoseconds() - start;
+  } while (elapsed < BENCHMARK_TIME);
+  CHECK(found > 0);
+  reportRate(label, searches, 0, elapsed);
+}
+
+/**********************************************************************/
+int main(int argc __attribute__((unused)),
+         char *argv[] __attribute__((unused)))
+{
+  DeltaIndex deltaIndex;
+  CHECK(initializeDeltaIndex(&deltaIndex, 1, NUM_LISTS, MEAN_DELTA,
+                             PAYLOAD_BITS, MEMORY_SIZE)
+        == UDS_SUCCESS);
+  unsigned int collisions = populateIndex(&deltaIndex);
+  checkSearches(&deltaIndex, SEARCHES);
+  printf("DeltaIndex_t1: %u entries (%u collisions), %u searches match\n",
+         ENTRIES, collisions, SEARCHES);
+
+  benchmarkSearch("delta list search, stepping", stepToEntry, &deltaIndex);
+  benchmarkSearch("delta list search, skipping", skipToEntry, &deltaIndex);
+  uninitializeDeltaIndex(&deltaIndex);
+  return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/LZ4_t1.c#1 $
+ */
+
+/**
+ * Compare the LZ4 decoder, with its fast path for short sequences, against
+ * the same decoder built without it (lz4Reference.o, compiled from lz4.c
+ * with LZ4_NO_FAST_DECODE), and report the speed of each.
+ *
+ * Every block of a sample file, at both 1K and 4K, is compressed and must
+ * decode identically with each decoder. Then the compressed streams are
+ * fuzzed: corrupted, truncated, or extended, and decoded into output
+ * buffers of random sizes. Both decoders must return the same result, and
+ * the same output for a stream which decodes, and neither may write past the
+ * end of its output buffer.
+ *
+ * Usage: LZ4_t1 <sample.gz> [fuzz iterations]
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+#include "lz4.h"
+
+#include "testUtils.h"
+
+/** The reference decoder, built from lz4.c without the fast path */
+int referenceUncompress(const char *source,
+                        char       *dest,
+                        int         isize,
+                        int         maxOutputSize);
+
+enum {
+  DEFAULT_FUZZ_ITERATIONS = 1000000,
+  /** Bytes after an output buffer which must never be written */
+  GUARD_SIZE              = 64,
+  GUARD_BYTE              = 0xa5,
+  /** How long to run each benchmark, in nanoseconds */
+  BENCHMARK_TIME          = 500 * 1000 * 1000,
+};
+
+typedef struct {
+  size_t  count;
+  size_t  blockSize;
+  int    *sizes;
+  char   *streams;
+} CompressedSet;
+
+typedef int Decoder(const char *source, char *dest, int isize, int maxSize);
+
+/**
+ * Compress every block of the sample data.
+ *
+ * @param data       The sample data
+ * @param length     The length of the data
+ * @param blockSize  The size of the blocks to compress
+ * @param set        The set of compressed blocks to fill in
+ **/
+static void compressBlocks(const char    *data,
+                           size_t         length,
+                           size_t         blockSize,
+                           CompressedSet *set)
+{
+  void *context = malloc(LZ4_context_size());
+  set->blockSize = blockSize;
+  set->count     = length / blockSize;
+  set->sizes     = malloc(set->count * sizeof(int));
+  set->streams   = malloc(set->count * blockSize);
+  CHECK((context != NULL) && (set->sizes != NULL) && (set->streams != NULL));
+  for (size_t i = 0; i < set->count; i++) {
+    set->sizes[i]
+      = LZ4_compress_ctx_limitedOutput(context, data + (i * blockSize),
+                                       set->streams + (i * blockSize),
+                                       blockSize, blockSize);
+  }
+  free(context);
+}
+
+/**
+ * Decode every compressed block with both decoders and check the results.
+ *
+ * @param data  The sample data
+ * @param set   The compressed blocks
+ **/
+static void checkBlocks(const char *data, const CompressedSet *set)
+{
+  char *fast      = malloc(set->blockSize);
+  char *reference = malloc(set->blockSize);
+  CHECK((fast != NULL) && (reference != NULL));
+  for (size_t i = 0; i < set->count; i++) {
+    if (set->sizes[i] <= 0) {
+      continue;
+    }
+    const char *stream = set->streams + (i * set->blockSize);
+    CHECK(LZ4_uncompress_unknownOutputSize(stream, fast, set->sizes[i],
+                                           set->blockSize)
+          == (int) set->blockSize);
+    CHECK(referenceUncompress(stream, reference, set->sizes[i],
+                              set->blockSize)
+          == (int) set->blockSize);
+    CHECK(memcmp(fast, data + (i * set->blockSize), set->blockSize) == 0);
+    CHECK(memcmp(reference, fast, set->blockSize) == 0);
+  }
+  free(reference);
+  free(fast);
+}
+
+/**
+ * Decode one stream into a guarded, pre-filled buffer.
+ *
+ * @param decoder  The decoder to use
+ * @param stream   The stream to decode
+ * @param size     The size of the stream
+ * @param output   The output buffer, of outSize plus GUARD_SIZE bytes
+ * @param outSize  The size of the output buffer given to the decoder
+ * @param fill     The byte to fill the output buffer with first
+ *
+ * @return The decoder's result
+ **/
+static int decodeGuarded(Decoder       *decoder,
+                         const char    *stream,
+                         int            size,
+                         char          *output,
+                         int            outSize,
+                         unsigned char  fill)
+{
+  memset(output, fill, outSize);
+  memset(output + outSize, GUARD_BYTE, GUARD_SIZE);
+  int result = decoder(stream, output, size, outSize);
+  for (int i = 0; i < GUARD_SIZE; i++) {
+    CHECK((unsigned char) output[outSize + i] == GUARD_BYTE);
+  }
+  return result;
+}
+
+/**
+ * Fuzz both decoders with damaged streams and compare their behavior.
+ *
+ * @param set         The compressed blocks to damage
+ * @param iterations  The number of damaged streams to try
+ *
+ * @return The number of damaged streams which still decoded
+ **/
+static unsigned long fuzzDecoders(const CompressedSet *set,
+                                  unsigned long        iterations)
+{
+  size_t maxStream = 2 * set->blockSize;
+  char *stream     = malloc(maxStream);
+  char *fast       = malloc(set->blockSize + GUARD_SIZE);
+  char *reference  = malloc(set->blockSize + GUARD_SIZE);
+  char *refilled   = malloc(set->blockSize + GUARD_SIZE);
+  CHECK((stream != NULL) && (fast != NULL) && (reference != NULL)
+        && (refilled != NULL));
+
+  unsigned long decoded = 0;
+  for (unsigned long n = 0; n < iterations; n++) {
+    size_t i = nextRandom() % set->count;
+    if (set->sizes[i] <= 0) {
+      continue;
+    }
+
+    int size = set->sizes[i];
+    memcpy(stream, set->streams + (i * set->blockSize), size);
+    switch (nextRandom() % 4) {
+    case 0:
+      // Flip a few random bytes.
+      for (unsigned int flips = 1 + (nextRandom() % 4); flips > 0; flips--) {
+        stream[nextRandom() % size] ^= 1 + (nextRandom() % 255);
+      }
+      break;
+
+    case 1:
+      // Truncate the stream.
+      size = nextRandom() % size;
+      break;
+
+    case 2:
+      // Append random bytes.
+      {
+        int extra = 1 + (nextRandom() % (maxStream - size));
+        for (int j = 0; j < extra; j++) {
+          stream[size + j] = nextRandom();
+        }
+        size += extra;
+      }
+      break;
+
+    default:
+      // Leave the stream intact, but give it too little room.
+      break;
+    }
+
+    int outSize = set->blockSize;
+    if ((nextRandom() % 2) == 0) {
+      outSize = nextRandom() % (set->blockSize + 1);
+    }
+
+    int fastResult = decodeGuarded(LZ4_uncompress_unknownOutputSize, stream,
+                                   size, fast, outSize, 0);
+    int referenceResult = decodeGuarded(referenceUncompress, stream, size,
+                                        reference, outSize, 0);
+    CHECK(fastResult == referenceResult);
+    if (fastResult < 0) {
+      continue;
+    }
+
+    decoded++;
+    // A damaged stream may copy from output bytes which were never written
+    // (a zero match offset, say), and the decoders leave different bytes
+    // there. Only compare output which does not depend on them.
+    CHECK(decodeGuarded(referenceUncompress, stream, size, refilled, outSize,
+                        0xff)
+          == referenceResult);
+    if (memcmp(reference, refilled, fastResult) == 0) {
+      CHECK(memcmp(fast, reference, fastResult) == 0);
+    }
+  }
+
+  free(refilled);
+  free(reference);
+  free(fast);
+  free(stream);
+  return decoded;
+}
+
+/**
+ * Measure how fast a decoder decodes a set of compressed blocks.
+ *
+ * @param name     The name to report
+ * @param decoder  The decoder
+ * @param set      The compressed blocks
+ **/
+static void benchmarkDecoder(const char          *name,
+                             Decoder             *decoder,
+                             const CompressedSet *set)
+{
+  char *output = malloc(set->blockSize);
+  CHECK(output != NULL);
+  uint64_t blocks = 0;
+  uint64_t start  = nowNanoseconds();
+  uint64_t elapsed;
+  do {
+    for (size_t i = 0; i < set->count; i++) {
+      if (set->sizes[i] > 0) {
+        CHECK(decoder(set->streams + (i * set->blockSize), output,
+                      set->sizes[i], set->blockSize)
+              == (int) set->blockSize);
+        blocks++;
+      }
+    }
+    elapsed = nowNanoseconds() - start;
+  } while (elapsed < BENCHMARK_TIME);
+
+  char label[64];
+  snprintf(label, sizeof(label), "%s, %zu byte blocks", name,
+           set->blockSize);
+  reportRate(label, blocks, blocks * set->blockSize, elapsed);
+  free(output);
+}
+
+/**********************************************************************/
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <sample.gz> [fuzz iterations]\n", argv[0]);
+    return 2;
+  }
+  unsigned long iterations = ((argc > 2)
+                              ? strtoul(argv[2], NULL, 0)
+                              : DEFAULT_FUZZ_ITERATIONS);
+
+  char   *data;
+  size_t  blocks;
+  readSampleBlocks(argv[1], VDO_BLOCK_SIZE, &data, &blocks);
+
+  size_t blockSizes[] = { 1024, VDO_BLOCK_SIZE };
+  for (unsigned int i = 0; i < 2; i++) {
+    CompressedSet set;
+    compressBlocks(data, blocks * VDO_BLOCK_SIZE, blockSizes[i], &set);
+    checkBlocks(data, &set);
+    unsigned long decoded = fuzzDecoders(&set, iterations);
+    printf("LZ4_t1: %zu byte blocks: %lu fuzzed streams, %lu decoded\n",
+           blockSizes[i], iterations, decoded);
+    benchmarkDecoder("LZ4 fast decode", LZ4_uncompress_unknownOutputSize,
+                     &set);
+    benchmarkDecoder("LZ4 reference decode", referenceUncompress, &set);
+    free(set.sizes);
+    free(set.streams);
+  }
+
+  free(data);
+  return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/MemoryEqual_t1.c#1 $
+ */
+
+/**
+ * Check memoryEqual(), which verifies dedupe advice, against memcmp() and
+ * report how many 4K compares per second each of them does.
+ *
+ * Every block compared differs in at most one byte. Each possible offset of
+ * the difference is checked, from each combination of buffer alignments, and
+ * so are lengths which are not multiples of the 64-byte chunk.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "constants.h"
+#include "numUtils.h"
+
+#include "testUtils.h"
+
+enum {
+  /** The largest misalignment of the buffers checked */
+  MAX_SKEW       = 8,
+  /** The longest short length checked */
+  MAX_SHORT      = 256,
+  /** How long to run each benchmark, in nanoseconds */
+  BENCHMARK_TIME = 500 * 1000 * 1000,
+};
+
+static byte buffer1[VDO_BLOCK_SIZE + MAX_SKEW];
+static byte buffer2[VDO_BLOCK_SIZE + MAX_SKEW];
+
+/**
+ * Check memoryEqual() on two copies of the same data, with and without a
+ * difference at each offset.
+ *
+ * @param skew1   The offset of the first copy in its buffer
+ * @param skew2   The offset of the second copy in its buffer
+ * @param length  The length of the data
+ **/
+static void checkLength(unsigned int skew1,
+                        unsigned int skew2,
+                        size_t       length)
+{
+  byte *block1 = buffer1 + skew1;
+  byte *block2 = buffer2 + skew2;
+  for (size_t i = 0; i < length; i++) {
+    block1[i] = nextRandom();
+  }
+  memcpy(block2, block1, length);
+  CHECK(memoryEqual(block1, block2, length));
+
+  for (size_t offset = 0; offset < length; offset++) {
+    byte flip = 1 + (nextRandom() % 255);
+    block2[offset] ^= flip;
+    CHECK(!memoryEqual(block1, block2, length));
+    CHECK(!memoryEqual(block2, block1, length));
+    block2[offset] ^= flip;
+  }
+  CHECK(memoryEqual(block1, block2, length));
+}
+
+/**
+ * Time a compare function on a pair of 4K blocks.
+ *
+ * @param name     The name to report
+ * @param compare  The compare function, returning true if the blocks match
+ * @param offset   The offset of a difference, or VDO_BLOCK_SIZE for none
+ **/
+static void benchmarkCompare(const char *name,
+                             bool (*compare)(const void *, const void *),
+                             size_t offset)
+{
+  memcpy(buffer2, buffer1, VDO_BLOCK_SIZE);
+  if (offset < VDO_BLOCK_SIZE) {
+    buffer2[offset] ^= 1;
+  }
+
+  bool     expected = (offset == VDO_BLOCK_SIZE);
+  uint64_t compares = 0;
+  uint64_t start    = nowNanoseconds();
+  uint64_t elapsed;
+  do {
+    for (unsigned int i = 0; i < 1000; i++) {
+      // Keep the compiler from hoisting the compare out of the loop.
+      __asm__ __volatile__("" : : : "memory");
+      CHECK(compare(buffer1, buffer2) == expected);
+    }
+    compares += 1000;
+    elapsed = nowNanoseconds() - start;
+  } while (elapsed < BENCHMARK_TIME);
+
+  char label[64];
+  if (expected) {
+    snprintf(label, sizeof(label), "%s, equal", name);
+  } else {
+    snprintf(label, sizeof(label), "%s, differ at %zu", name, offset);
+  }
+  reportRate(label, compares, compares * VDO_BLOCK_SIZE, elapsed);
+}
+
+/**********************************************************************/
+static bool compareMemoryEqual(const void *block1, const void *block2)
+{
+  return memoryEqual(block1, block2, VDO_BLOCK_SIZE);
+}
+
+/**********************************************************************/
+static bool compareMemcmp(const void *block1, const void *block2)
+{
+  return (memcmp(block1, block2, VDO_BLOCK_SIZE) == 0);
+}
+
+/**********************************************************************/
+int main(int argc __attribute__((unused)),
+         char *argv[] __attribute__((unused)))
+{
+  for (unsigned int skew1 = 0; skew1 < MAX_SKEW; skew1 += 3) {
+    for (unsigned int skew2 = 0; skew2 < MAX_SKEW; skew2 += 5) {
+      checkLength(skew1, skew2, VDO_BLOCK_SIZE);
+    }
+  }
+  for (size_t length = 0; length <= MAX_SHORT; length++) {
+    checkLength(length % MAX_SKEW, 0, length);
+  }
+  printf("MemoryEqual_t1: every mismatch offset from 0 to %u detected\n",
+         VDO_BLOCK_SIZE - 1);
+
+  for (unsigned int i = 0; i < VDO_BLOCK_SIZE; i++) {
+    buffer1[i] = nextRandom();
+  }
+  size_t offsets[] = { VDO_BLOCK_SIZE, VDO_BLOCK_SIZE / 2, 0 };
+  for (unsigned int i = 0; i < 3; i++) {
+    benchmarkCompare("memoryEqual", compareMemoryEqual, offsets[i]);
+    benchmarkCompare("memcmp", compareMemcmp, offsets[i]);
+  }
+  return 0;
+}
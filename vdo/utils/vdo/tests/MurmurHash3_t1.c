@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/MurmurHash3_t1.c#1 $
+ */
+
+/**
+ * Check that the incremental MurmurHash3_x64_128, which bio.c uses to copy,
+ * zero-check and hash written data in one pass, and the multi-buffer form
+ * used to hash batches of blocks both produce the same hashes as the one-shot
+ * MurmurHash3_x64_128.
+ *
+ * Each trial splits a random buffer, some of whose pieces are zero, into
+ * random pieces which are hashed with MurmurHash3_x64_128_copy() or, for the
+ * zero pieces, MurmurHash3_x64_128_zeros(), and checks the copy as well as the
+ * hash.
+ **/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "constants.h"
+#include "murmur/MurmurHash3.h"
+
+#include "testUtils.h"
+
+enum {
+  /** The alignment of every piece of an incremental hash */
+  PIECE_SIZE  = 16,
+  MAX_LENGTH  = 2 * VDO_BLOCK_SIZE,
+  TRIALS      = 100000,
+  SEED        = 0x62ea60be,
+};
+
+/**
+ * Fill a buffer with random bytes and runs of zeros, in pieces of
+ * PIECE_SIZE bytes.
+ *
+ * @param buffer  The buffer to fill
+ * @param length  The length of the buffer, a multiple of PIECE_SIZE
+ **/
+static void fillBuffer(uint8_t *buffer, int length)
+{
+  for (int offset = 0; offset < length; offset += PIECE_SIZE) {
+    bool zero = ((nextRandom() % 4) == 0);
+    for (int i = 0; i < PIECE_SIZE; i++) {
+      buffer[offset + i] = (zero ? 0 : nextRandom());
+    }
+  }
+}
+
+/**
+ * Check whether a piece of a buffer is all zeros.
+ *
+ * @param piece   The piece
+ * @param length  The length of the piece
+ *
+ * @return <code>true</code> if the piece is all zeros
+ **/
+static bool isZero(const uint8_t *piece, int length)
+{
+  for (int i = 0; i < length; i++) {
+    if (piece[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Hash a buffer incrementally in random pieces, copying each nonzero piece
+ * and skipping each zero one as bioCopyDataInAndHash() does.
+ *
+ * @param buffer  The buffer to hash
+ * @param copy    The buffer to copy into, which must be zero
+ * @param length  The length of the buffer, a multiple of PIECE_SIZE
+ * @param hash    The hash to fill in
+ **/
+static void hashInPieces(const uint8_t *buffer,
+                         uint8_t       *copy,
+                         int            length,
+                         uint8_t        hash[16])
+{
+  MurmurHash3_x64_128_state state;
+  MurmurHash3_x64_128_start(&state, SEED);
+  int offset = 0;
+  while (offset < length) {
+    int pieces = (length - offset) / PIECE_SIZE;
+    int piece  = (1 + (nextRandom() % pieces)) * PIECE_SIZE;
+    if (isZero(buffer + offset, piece) && ((nextRandom() % 2) == 0)) {
+      MurmurHash3_x64_128_zeros(&state, piece);
+    } else {
+      MurmurHash3_x64_128_copy(&state, buffer + offset, copy + offset, piece);
+    }
+    offset += piece;
+  }
+  MurmurHash3_x64_128_finish(&state, hash);
+}
+
+/**
+ * Check the incremental hash against the one-shot hash.
+ *
+ * @param trials  The number of buffers to check
+ **/
+static void checkIncremental(unsigned int trials)
+{
+  static uint8_t buffer[MAX_LENGTH];
+  static uint8_t copy[MAX_LENGTH];
+  for (unsigned int trial = 0; trial < trials; trial++) {
+    int length = (nextRandom() % ((MAX_LENGTH / PIECE_SIZE) + 1)) * PIECE_SIZE;
+    fillBuffer(buffer, length);
+    memset(copy, 0, length);
+
+    uint8_t expected[16];
+    uint8_t actual[16];
+    MurmurHash3_x64_128(buffer, length, SEED, expected);
+    hashInPieces(buffer, copy, length, actual);
+    CHECK(memcmp(expected, actual, sizeof(actual)) == 0);
+    CHECK(memcmp(buffer, copy, length) == 0);
+  }
+}
+
+/**
+ * Check the multi-buffer hash against the one-shot hash, for lengths which
+ * need not be multiples of PIECE_SIZE.
+ *
+ * @param trials  The number of sets of buffers to check
+ **/
+static void checkMulti(unsigned int trials)
+{
+  static uint8_t buffers[MURMUR_MULTI_LANES][MAX_LENGTH];
+  for (unsigned int trial = 0; trial < trials; trial++) {
+    int length = nextRandom() % (MAX_LENGTH + 1);
+    const void *keys[MURMUR_MULTI_LANES];
+    uint8_t     hashes[MURMUR_MULTI_LANES][16];
+    void       *outs[MURMUR_MULTI_LANES];
+    for (unsigned int lane = 0; lane < MURMUR_MULTI_LANES; lane++) {
+      for (int i = 0; i < length; i++) {
+        buffers[lane][i] = nextRandom();
+      }
+      keys[lane] = buffers[lane];
+      outs[lane] = hashes[lane];
+    }
+
+    MurmurHash3_x64_128_multi(keys, length, SEED, outs);
+    for (unsigned int lane = 0; lane < MURMUR_MULTI_LANES; lane++) {
+      uint8_t expected[16];
+      MurmurHash3_x64_128(buffers[lane], length, SEED, expected);
+      CHECK(memcmp(expected, hashes[lane], sizeof(expected)) == 0);
+    }
+  }
+}
+
+/**********************************************************************/
+int main(int argc __attribute__((unused)),
+         char *argv[] __attribute__((unused)))
+{
+  checkIncremental(TRIALS);
+  checkMulti(TRIALS / 10);
+  printf("MurmurHash3_t1: %u incremental and %u multi-buffer hashes match\n",
+         TRIALS, TRIALS / 10);
+  return 0;
+}
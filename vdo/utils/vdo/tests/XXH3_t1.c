@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/XXH3_t1.c#1 $
+ */
+
+/**
+ * Check XXH3_128bits against known answers from the reference xxHash
+ * library, and compare its speed with MurmurHash3_x64_128, the other chunk
+ * name hash, on the 4K blocks of a sample file.
+ *
+ * The known answers are the reference library's XXH3_128bits() of prefixes
+ * of its sanity test buffer, at lengths chosen to exercise each of its code
+ * paths (0, 1-3, 4-8, 9-16, 17-128, 129-240 bytes, and the long loop with
+ * and without a partial stripe and a partial block).
+ *
+ * The incremental XXH3_128bits_copy() and XXH3_128bits_zeros(), which bio.c
+ * uses to copy, zero-check and hash written data in one pass, are checked
+ * against the known answers which are whole stripes long, and against the
+ * one-shot hash of random buffers with runs of zero stripes.
+ *
+ * Usage: XXH3_t1 <sample.gz>
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+#include "murmur/MurmurHash3.h"
+#include "xxhash/XXH3.h"
+
+#include "testUtils.h"
+
+enum {
+  /** The length of the reference library's sanity test buffer we use */
+  SANITY_LENGTH  = 12345,
+  /** The misalignments at which each known answer is checked */
+  MAX_SKEW       = 8,
+  /** How long to run each benchmark, in nanoseconds */
+  BENCHMARK_TIME = 500 * 1000 * 1000,
+  /** The alignment of every piece of an incremental hash */
+  STRIPE_SIZE    = 64,
+  /** The longest buffer hashed incrementally in the random trials */
+  MAX_LENGTH     = 2 * VDO_BLOCK_SIZE,
+  /** The number of random buffers hashed incrementally */
+  TRIALS         = 10000,
+};
+
+typedef struct {
+  size_t   length;
+  uint64_t low;
+  uint64_t high;
+} KnownAnswer;
+
+static const KnownAnswer KNOWN_ANSWERS[] = {
+  {     0, 0x6001c324468d497fULL, 0x99aa06d3014798d8ULL },
+  {     1, 0xc44bdff4074eecdbULL, 0xa6cd5e9392000f6aULL },
+  {     2, 0x7a9978044cb8a8bbULL, 0x76750c3c7bf95668ULL },
+  {     3, 0x54247382a8d6b94dULL, 0x20efc49ff02422eaULL },
+  {     4, 0x2e7d8d6876a39fe9ULL, 0x970d585ac632bf8eULL },
+  {     8, 0x64c69cab4bb21dc5ULL, 0x47a7f080d82bb456ULL },
+  {     9, 0xed7ccbc501eb7501ULL, 0x564ef6078950d457ULL },
+  {    16, 0x562980258a998629ULL, 0xc68c368ecf8a9c05ULL },
+  {    17, 0xabbc12d11973d7dbULL, 0x955fa78643ed3669ULL },
+  {    32, 0x278410a17595e3f9ULL, 0x98fc6458710dc2e8ULL },
+  {    64, 0xefdb6a44690721a9ULL, 0x6d90e81a9b0fd622ULL },
+  {    96, 0xe9324473ea9afebeULL, 0xd9d0b885f56c93f1ULL },
+  {   128, 0xebb15e34a7fb5ab1ULL, 0x39992220e045260aULL },
+  {   129, 0x86c9e3bc8f0a3b5cULL, 0x03815fc91f1b30b6ULL },
+  {   160, 0x737126c8d7c09ceeULL, 0xba5d218964b622adULL },
+  {   200, 0xeb060f1bb3126f5aULL, 0xe76ff4780fe18439ULL },
+  {   240, 0x5c9aae94c8ebe5a0ULL, 0xaa4202daa2769dc8ULL },
+  {   241, 0xc5a639ecd2030e5eULL, 0x99a80ecf0ecfc647ULL },
+  {   255, 0xe98f979f4ed8a197ULL, 0x961375c87e09efbcULL },
+  {   256, 0x55de574ad89d0ac5ULL, 0x8b1c66091423d288ULL },
+  {   511, 0x8089715b163e7fc0ULL, 0x9f7619cb8d250f0dULL },
+  {   512, 0x617e49599013cb6bULL, 0x18d2d110dcc9bca1ULL },
+  {  1024, 0xdd85c9b5c1109c5cULL, 0x0d30d24071c64c57ULL },
+  {  1025, 0xd870c0fa13211c6aULL, 0xfd3ee4fe7f2954c6ULL },
+  {  2048, 0xdd59e2c3a5f038e0ULL, 0xf736557fd47073a5ULL },
+  {  2240, 0x6e73a90539cf2948ULL, 0xccb134fbfa7ce49dULL },
+  {  2367, 0xcb37aeb9e5d361edULL, 0xe89c0f6ff369b427ULL },
+  {  2368, 0x7bf80846ceb7121fULL, 0x7670107c41f0b6a8ULL },
+  {  4096, 0xe91206429d1f48f9ULL, 0xb9cfaea2ca5626a4ULL },
+  {  4097, 0xdac80d543e339451ULL, 0x0c6a7a5f1d0bbb1aULL },
+  {  8192, 0xd63690a28889a350ULL, 0x8a3f76fa124fdefeULL },
+  { 12345, 0xee11dee873bf4750ULL, 0x0d183f40dceb913eULL },
+};
+
+typedef void ChunkNameHash(const void *data, size_t length, void *name);
+
+/**
+ * Fill a buffer the way the reference library's sanity tests do.
+ *
+ * @param buffer  The buffer to fill
+ * @param length  The length of the buffer
+ **/
+static void fillSanityBuffer(uint8_t *buffer, size_t length)
+{
+  uint64_t generator = 2654435761U;
+  for (size_t i = 0; i < length; i++) {
+    buffer[i] = generator >> 56;
+    generator *= 11400714785074694797ULL;
+  }
+}
+
+/**
+ * Decode a little-endian 64-bit word.
+ *
+ * @param bytes  The bytes of the word
+ *
+ * @return The word
+ **/
+static uint64_t getLittleEndian64(const uint8_t *bytes)
+{
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; i--) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+/**
+ * Check XXH3_128bits against every known answer at several alignments.
+ **/
+static void checkKnownAnswers(void)
+{
+  static uint8_t sanity[SANITY_LENGTH];
+  static uint8_t buffer[SANITY_LENGTH + MAX_SKEW];
+  fillSanityBuffer(sanity, SANITY_LENGTH);
+  size_t count = sizeof(KNOWN_ANSWERS) / sizeof(KNOWN_ANSWERS[0]);
+  for (size_t i = 0; i < count; i++) {
+    const KnownAnswer *answer = &KNOWN_ANSWERS[i];
+    for (unsigned int skew = 0; skew < MAX_SKEW; skew++) {
+      memcpy(buffer + skew, sanity, answer->length);
+      uint8_t name[16];
+      XXH3_128bits(buffer + skew, answer->length, name);
+      CHECK(getLittleEndian64(name) == answer->low);
+      CHECK(getLittleEndian64(name + 8) == answer->high);
+    }
+  }
+  printf("XXH3_t1: %zu known answers match\n", count);
+}
+
+/**
+ * Check whether a piece of a buffer is all zeros.
+ *
+ * @param piece   The piece
+ * @param length  The length of the piece
+ *
+ * @return <code>true</code> if the piece is all zeros
+ **/
+static bool isZero(const uint8_t *piece, size_t length)
+{
+  for (size_t i = 0; i < length; i++) {
+    if (piece[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Hash a buffer incrementally in random pieces of whole stripes, copying
+ * each piece or, for some of the zero pieces, skipping it.
+ *
+ * @param buffer  The buffer to hash
+ * @param copy    The buffer to copy into, which must be zero
+ * @param length  The length of the buffer, a multiple of STRIPE_SIZE
+ * @param hash    The hash to fill in
+ **/
+static void hashInPieces(const uint8_t *buffer,
+                         uint8_t       *copy,
+                         size_t         length,
+                         uint8_t        hash[16])
+{
+  XXH3_128bits_state state;
+  XXH3_128bits_start(&state);
+  size_t offset = 0;
+  while (offset < length) {
+    size_t stripes = (length - offset) / STRIPE_SIZE;
+    size_t piece   = (1 + (nextRandom() % stripes)) * STRIPE_SIZE;
+    if (isZero(buffer + offset, piece) && ((nextRandom() % 2) == 0)) {
+      XXH3_128bits_zeros(&state, piece);
+    } else {
+      XXH3_128bits_copy(&state, buffer + offset, copy + offset, piece);
+    }
+    offset += piece;
+  }
+  XXH3_128bits_finish(&state, hash);
+}
+
+/**
+ * Check the incremental hash against the known answers it can compute, and
+ * against the one-shot hash of random buffers.
+ **/
+static void checkIncremental(void)
+{
+  static uint8_t sanity[SANITY_LENGTH];
+  static uint8_t copy[SANITY_LENGTH];
+  fillSanityBuffer(sanity, SANITY_LENGTH);
+  size_t count = sizeof(KNOWN_ANSWERS) / sizeof(KNOWN_ANSWERS[0]);
+  for (size_t i = 0; i < count; i++) {
+    const KnownAnswer *answer = &KNOWN_ANSWERS[i];
+    if ((answer->length <= XXH3_MIDSIZE_MAX)
+        || ((answer->length % STRIPE_SIZE) != 0)) {
+      continue;
+    }
+    memset(copy, 0, answer->length);
+    uint8_t name[16];
+    hashInPieces(sanity, copy, answer->length, name);
+    CHECK(getLittleEndian64(name) == answer->low);
+    CHECK(getLittleEndian64(name + 8) == answer->high);
+    CHECK(memcmp(sanity, copy, answer->length) == 0);
+  }
+
+  static uint8_t buffer[MAX_LENGTH];
+  size_t minStripes = (XXH3_MIDSIZE_MAX / STRIPE_SIZE) + 1;
+  size_t maxStripes = MAX_LENGTH / STRIPE_SIZE;
+  for (unsigned int trial = 0; trial < TRIALS; trial++) {
+    size_t stripes
+      = minStripes + (nextRandom() % (maxStripes - minStripes + 1));
+    size_t length = stripes * STRIPE_SIZE;
+    for (size_t offset = 0; offset < length; offset += STRIPE_SIZE) {
+      bool zero = ((nextRandom() % 4) == 0);
+      for (size_t j = 0; j < STRIPE_SIZE; j++) {
+        buffer[offset + j] = (zero ? 0 : nextRandom());
+      }
+    }
+    memset(copy, 0, length);
+
+    uint8_t expected[16];
+    uint8_t actual[16];
+    XXH3_128bits(buffer, length, expected);
+    hashInPieces(buffer, copy, length, actual);
+    CHECK(memcmp(expected, actual, sizeof(actual)) == 0);
+    CHECK(memcmp(buffer, copy, length) == 0);
+  }
+  printf("XXH3_t1: incremental hashes match\n");
+}
+
+/**********************************************************************/
+static void hashMurmur3(const void *data, size_t length, void *name)
+{
+  MurmurHash3_x64_128(data, length, 0, name);
+}
+
+/**
+ * Measure how fast a hash names the blocks of the sample data.
+ *
+ * @param label   The name of the hash
+ * @param hash    The hash function
+ * @param data    The sample data
+ * @param blocks  The number of blocks of sample data
+ **/
+static void benchmarkHash(const char    *label,
+                          ChunkNameHash *hash,
+                          const char    *data,
+                          size_t         blocks)
+{
+  uint8_t  name[16];
+  uint64_t hashed = 0;
+  uint64_t start  = nowNanoseconds();
+  uint64_t elapsed;
+  do {
+    for (size_t i = 0; i < blocks; i++) {
+      hash(data + (i * VDO_BLOCK_SIZE), VDO_BLOCK_SIZE, name);
+      // Keep the compiler from discarding the hashes.
+      __asm__ __volatile__("" : : "r"(name) : "memory");
+    }
+    hashed += blocks;
+    elapsed = nowNanoseconds() - start;
+  } while (elapsed < BENCHMARK_TIME);
+  reportRate(label, hashed, hashed * VDO_BLOCK_SIZE, elapsed);
+}
+
+/**********************************************************************/
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <sample.gz>\n", argv[0]);
+    return 2;
+  }
+
+  checkKnownAnswers();
+  checkIncremental();
+
+  char   *data;
+  size_t  blocks;
+  readSampleBlocks(argv[1], VDO_BLOCK_SIZE, &data, &blocks);
+  benchmarkHash("MurmurHash3_x64_128", hashMurmur3, data, blocks);
+  benchmarkHash("XXH3_128bits", XXH3_128bits, data, blocks);
+  free(data);
+  return 0;
+}
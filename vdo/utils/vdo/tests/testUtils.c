@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/testUtils.c#1 $
+ */
+
+#include "testUtils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+/**********************************************************************/
+void checkFailed(const char *file, int line, const char *condition)
+{
+  fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+  exit(1);
+}
+
+/**********************************************************************/
+void readSampleBlocks(const char  *path,
+                      size_t       blockSize,
+                      char       **dataPtr,
+                      size_t      *blocksPtr)
+{
+  gzFile file = gzopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "cannot open sample data %s\n", path);
+    exit(1);
+  }
+
+  size_t capacity = 1 << 20;
+  size_t length   = 0;
+  char  *data     = malloc(capacity);
+  CHECK(data != NULL);
+  for (;;) {
+    if (capacity - length < blockSize) {
+      capacity *= 2;
+      data = realloc(data, capacity);
+      CHECK(data != NULL);
+    }
+    int bytes = gzread(file, data + length, capacity - length);
+    CHECK(bytes >= 0);
+    if (bytes == 0) {
+      break;
+    }
+    length += bytes;
+  }
+  gzclose(file);
+
+  size_t blocks = (length + blockSize - 1) / blockSize;
+  memset(data + length, 0, (blocks * blockSize) - length);
+  *dataPtr   = data;
+  *blocksPtr = blocks;
+}
+
+/**********************************************************************/
+uint64_t nowNanoseconds(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t) now.tv_sec * 1000000000) + now.tv_nsec;
+}
+
+/**********************************************************************/
+void reportRate(const char *what,
+                uint64_t    count,
+                uint64_t    bytes,
+                uint64_t    nanoseconds)
+{
+  double seconds = (nanoseconds > 0) ? (nanoseconds / 1e9) : 1e-9;
+  if (bytes > 0) {
+    printf("%-40s %12.0f ops/s %10.1f MB/s\n", what, count / seconds,
+           bytes / seconds / (1 << 20));
+  } else {
+    printf("%-40s %12.0f ops/s\n", what, count / seconds);
+  }
+}
+
+/**********************************************************************/
+uint64_t nextRandom(void)
+{
+  // xorshift64*, which is plenty for generating test data.
+  static uint64_t state = 0x9e3779b97f4a7c15ULL;
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545f4914f6cdd1dULL;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2018 Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA. 
+ *
+ * $Id: //eng/vdo-releases/aluminum/src/c++/vdo/tests/testUtils.h#1 $
+ */
+
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Check a condition, and if it does not hold, report the failure and exit
+ * the test with a failing status.
+ *
+ * @param condition  The condition which must hold
+ **/
+#define CHECK(condition)                                    \
+  do {                                                      \
+    if (!(condition)) {                                     \
+      checkFailed(__FILE__, __LINE__, #condition);          \
+    }                                                       \
+  } while (0)
+
+/**
+ * Report a failed check and exit the test. Called by CHECK().
+ *
+ * @param file       The source file of the check
+ * @param line       The line of the check
+ * @param condition  The text of the condition which did not hold
+ **/
+void checkFailed(const char *file, int line, const char *condition)
+  __attribute__((noreturn));
+
+/**
+ * Read a gzip-compressed sample file, such as the Calgary corpus tarball in
+ * the benchmark directory, into memory. The data is padded with zeros to a
+ * whole number of blocks.
+ *
+ * @param [in]  path       The name of the sample file
+ * @param [in]  blockSize  The size of a block
+ * @param [out] dataPtr    A pointer to hold the data, which must be freed
+ * @param [out] blocksPtr  A pointer to hold the number of blocks read
+ **/
+void readSampleBlocks(const char  *path,
+                      size_t       blockSize,
+                      char       **dataPtr,
+                      size_t      *blocksPtr);
+
+/**
+ * Get the current value of the monotonic clock.
+ *
+ * @return The current time in nanoseconds
+ **/
+uint64_t nowNanoseconds(void);
+
+/**
+ * Report the rate at which some work was done.
+ *
+ * @param what         A description of the work
+ * @param count        The number of operations done
+ * @param bytes        The number of bytes processed, or 0 if not relevant
+ * @param nanoseconds  The time the work took
+ **/
+void reportRate(const char *what,
+                uint64_t    count,
+                uint64_t    bytes,
+                uint64_t    nanoseconds);
+
+/**
+ * Get a pseudo-random number, from a generator which always starts in the
+ * same state so that failures can be reproduced.
+ *
+ * @return The next number in the sequence
+ **/
+uint64_t nextRandom(void);
+
+#endif /* TEST_UTILS_H */
@@ -126,6 +126,18 @@ static int parseMem(char *string, uint32_t *sizePtr)
   return UDS_SUCCESS;
 }
 
+static int parseChunkNameHash(const char *string, uint8_t *hashPtr)
+{
+  if (strcmp(string, "murmur3") == 0) {
+    *hashPtr = UDS_CHUNK_NAME_MURMUR3;
+  } else if (strcmp(string, "xxh3") == 0) {
+    *hashPtr = UDS_CHUNK_NAME_XXH3;
+  } else {
+    return -EINVAL;
+  }
+  return UDS_SUCCESS;
+}
+
 /**********************************************************************/
 int parseIndexConfig(UdsConfigStrings *configStrings,
                      IndexConfig      *configPtr)
@@ -158,6 +170,15 @@ int parseIndexConfig(UdsConfigStrings *configStrings,
     config.sparse = (strcmp(configStrings->sparse, "0") != 0);
   }
 
+  config.chunkNameHash = UDS_CHUNK_NAME_MURMUR3;
+  if (configStrings->chunkNameHash != NULL) {
+    int result = parseChunkNameHash(configStrings->chunkNameHash,
+                                    &config.chunkNameHash);
+    if (result != UDS_SUCCESS) {
+      return result;
+    }
+  }
+
   *configPtr = config;
   return VDO_SUCCESS;
 }
@@ -31,6 +31,7 @@ typedef struct {
   char *sparse;
   char *memorySize;
   char *checkpointFrequency;
+  char *chunkNameHash;
 } UdsConfigStrings;
 
 /**
@@ -88,6 +88,12 @@ static const char helpString[] =
   "    --uds-checkpoint-frequency=<frequency>\n"
   "       Specify the frequency of checkpoints. The default is never.\n"
   "\n"
+  "    --uds-chunk-name-hash=<hash>\n"
+  "       Specify the hash function used to name data blocks for\n"
+  "       deduplication, either murmur3 or xxh3. The default is murmur3;\n"
+  "       a VDO formatted with xxh3 cannot be started by versions which\n"
+  "       predate the option.\n"
+  "\n"
   "    --uds-memory-size=<gigabytes>\n"
   "       Specify the amount of memory, in gigabytes, to devote to the\n"
   "       index. Accepted options are .25, .5, .75, and all positive\n"
@@ -110,13 +116,14 @@ static struct option options[] = {
   { "logical-size",             required_argument, NULL, 'l' },
   { "slab-bits",                required_argument, NULL, 'S' },
   { "uds-checkpoint-frequency", required_argument, NULL, 'c' },
+  { "uds-chunk-name-hash",      required_argument, NULL, 'H' },
   { "uds-memory-size",          required_argument, NULL, 'm' },
   { "uds-sparse",               no_argument,       NULL, 's' },
   { "verbose",                  no_argument,       NULL, 'v' },
   { "version",                  no_argument,       NULL, 'V' },
   { NULL,                       0,                 NULL,  0  },
 };
-static char optionString[] = "fhil:S:c:m:svV";
+static char optionString[] = "fhil:S:c:H:m:svV";
 
 static void usage(const char *progname, const char *usageOptionsString)
 {
@@ -170,6 +177,10 @@ int main(int argc, char *argv[])
       configStrings.checkpointFrequency = optarg;
       break;
 
+    case 'H':
+      configStrings.chunkNameHash = optarg;
+      break;
+
     case 'm':
       configStrings.memorySize = optarg;
       break;
@@ -93,6 +93,20 @@ class KernelStatistics(StatStruct):
       Uint64Field("dedupeAdviceTimeouts"),
       # Number of flush requests submitted to the storage device
       Uint64Field("flushOut"),
+      # Number of blocks not compressed because a sample looked random
+      Uint64Field("compressionEarlyRejects"),
+      # Number of compression attempts which failed to shrink the block
+      Uint64Field("compressionFailures"),
+      # Number of dedupe candidates verified by reading the block
+      Uint64Field("verifyReads"),
+      # Number of dedupe candidates verified by block digest without a read
+      Uint64Field("verifyReadsAvoided"),
+      # Number of data block reads served by the read cache
+      Uint64Field("readCacheHits"),
+      # Number of data block reads which missed the read cache
+      Uint64Field("readCacheMisses"),
+      # Number of compressed block reads which waited for another read
+      Uint64Field("compressedReadsCoalesced"),
       # Logical block size
       Uint64Field("logicalBlockSize", display = False),
       FloatField("writeAmplificationRatio", derived = "round(($biosMeta[\"write\"] + $biosOut[\"write\"]) // float($biosIn[\"write\"]), 2) if $biosIn[\"write\"] > 0 else 0.00"),
@@ -119,7 +133,7 @@ class KernelStatistics(StatStruct):
       IndexStatistics("index"),
     ], procFile="kernel_stats", procRoot="vdo", **kwargs)
 
-  statisticsVersion = 30
+  statisticsVersion = 31
 
   def sample(self, device):
     sample = super(KernelStatistics, self).sample(device)
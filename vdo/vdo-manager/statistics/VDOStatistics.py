@@ -68,6 +68,25 @@ class RecoveryJournalStatistics(StatStruct):
       CommitStatistics("blocks", labelPrefix = "blocks"),
     ], labelPrefix="journal", procRoot="vdo", **kwargs)
 
+# A histogram of the time compressed fragments spent waiting in packer bins
+# before being written or released.
+class PackerResidenceStatistics(StatStruct):
+  def __init__(self, name="PackerResidenceStatistics", **kwargs):
+    super(PackerResidenceStatistics, self).__init__(name, [
+      # Number of fragments which waited less than 100 microseconds
+      Uint64Field("under100us", label = "under 100us"),
+      # Number of fragments which waited less than 1 millisecond
+      Uint64Field("under1ms", label = "under 1ms"),
+      # Number of fragments which waited less than 10 milliseconds
+      Uint64Field("under10ms", label = "under 10ms"),
+      # Number of fragments which waited less than 100 milliseconds
+      Uint64Field("under100ms", label = "under 100ms"),
+      # Number of fragments which waited less than 1 second
+      Uint64Field("under1s", label = "under 1s"),
+      # Number of fragments which waited 1 second or more
+      Uint64Field("atLeast1s", label = "at least 1s"),
+    ], procRoot="vdo", **kwargs)
+
 # The statistics for the compressed block packer.
 class PackerStatistics(StatStruct):
   def __init__(self, name="PackerStatistics", **kwargs):
@@ -78,8 +97,42 @@ class PackerStatistics(StatStruct):
       Uint64Field("compressedBlocksWritten"),
       # Number of VIOs that are pending in the packer
       Uint64Field("compressedFragmentsInPacker"),
+      # Number of bins released because they reached the maximum age
+      Uint64Field("binsAgedOut"),
+      # Time spent by fragments waiting in packer bins
+      PackerResidenceStatistics("residence", labelPrefix = "residence"),
     ], procRoot="vdo", **kwargs)
 
+# The compression history of one logical region.
+class CompressionRegionStatistics(StatStruct):
+  def __init__(self, name="CompressionRegionStatistics", **kwargs):
+    super(CompressionRegionStatistics, self).__init__(name, [
+      # The index of the region in the table of regions
+      Uint64Field("region"),
+      # Number of writes to the region which were eligible for compression
+      Uint64Field("hits"),
+      # Number of writes to the region which bypassed compression
+      Uint64Field("bypassed"),
+      # Number of writes to the region which compressed well enough to pack
+      Uint64Field("compressible"),
+    ], procRoot="vdo", **kwargs)
+
+# The statistics for skipping compression in poorly compressing regions.
+class CompressionBypassStatistics(StatStruct):
+  def __init__(self, name="CompressionBypassStatistics", **kwargs):
+    super(CompressionBypassStatistics, self).__init__(name, [
+      # Number of logical regions currently bypassing compression
+      Uint64Field("regionsBypassing"),
+      # Number of times a region began bypassing compression
+      Uint64Field("bypassesStarted"),
+      # Number of writes which bypassed compression
+      Uint64Field("blocksBypassed"),
+      # Number of writes compressed to probe a bypassing region
+      Uint64Field("probes"),
+      # The regions with the most hits, busiest first
+      CompressionRegionStatistics("regions", length = 16),
+    ], labelPrefix="compression bypass", procRoot="vdo", **kwargs)
+
 # The statistics for the slab journals.
 class SlabJournalStatistics(StatStruct):
   def __init__(self, name="SlabJournalStatistics", **kwargs):
@@ -170,6 +223,10 @@ class HashLockStatistics(StatStruct):
       Uint64Field("concurrentDataMatches"),
       # Number of writes whose hash collided with an in-flight write
       Uint64Field("concurrentHashCollisions"),
+      # Number of index queries answered by the advice cache
+      Uint64Field("adviceCacheHits"),
+      # Number of index queries which had to be sent to the index
+      Uint64Field("adviceCacheMisses"),
     ], procRoot="vdo", **kwargs)
 
 # Counts of error conditions in VDO.
@@ -224,6 +281,8 @@ class VDOStatistics(StatStruct):
       Uint8Field("recoveryPercentage", label = "recovery progress (%)", available = "$inRecoveryMode"),
       # The statistics for the compressed block packer
       PackerStatistics("packer"),
+      # The statistics for skipping compression in poorly compressing regions
+      CompressionBypassStatistics("compressionBypass"),
       # Counters for events in the block allocator
       BlockAllocatorStatistics("allocator"),
       # Counters for events in the recovery journal
@@ -242,7 +301,7 @@ class VDOStatistics(StatStruct):
       ErrorStatistics("errors"),
     ], procFile="dedupe_stats", procRoot="vdo", **kwargs)
 
-  statisticsVersion = 30
+  statisticsVersion = 31
 
   def sample(self, device):
     sample = super(VDOStatistics, self).sample(device)